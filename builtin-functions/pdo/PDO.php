@@ -9,6 +9,13 @@ class PDO {
      */
     const ATTR_TIMEOUT = 2;
 
+    /**
+     * Enables or disables emulation of prepared statements, pass it to PDO::prepare() options.
+     * pgSQL statements are prepared on the server side by default, MySQL ones are always emulated.
+     * @link https://php.net/manual/en/pdo.constants.php#pdo.constants.attr-emulate-prepares
+     */
+    const ATTR_EMULATE_PREPARES = 20;
+
     public function __construct(
         string $dsn,
         ?string $username = null,
@@ -22,12 +29,13 @@ class PDO {
     /** @kphp-extern-func-info resumable */
     public function exec(string $statement): int|false;
 
+    public function prepare(string $query, array $options = []): ?PDOStatement;
+
     public function errorCode(): ?string;
     public function errorInfo(): (int|string)[];
 
 //     These methods are not supported yet:
 //
-//     public function prepare(string $query, array $options = []): ?PDOStatement;
 //     public function beginTransaction(): bool;
 //     public function commit(): bool;
 
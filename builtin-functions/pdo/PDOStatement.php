@@ -8,12 +8,14 @@ class PDOStatement {
      */
     public string $queryString;
 
+    /** @kphp-extern-func-info resumable */
+    public function execute(?array $params = null): bool;
+
     public function fetch(): mixed;      // TODO: only default behaviour supported
     public function fetchAll(): mixed[]; // TODO: only default behaviour supported
 
 //     These methods are not supported yet:
 //
-//     public function execute(?array $params = null): bool;
 //     public bindColumn(
 //         string|int $column,
 //         mixed &$var,
@@ -41,6 +41,23 @@ if(KPHP_TESTS)
     endif()
 endif()
 
+if(KPHP_BENCHMARKS)
+    find_package(benchmark QUIET)
+
+    if(NOT benchmark_FOUND)
+        handle_missing_library("benchmark")
+        set(BENCHMARK_ENABLE_TESTING OFF CACHE INTERNAL "")
+        set(BENCHMARK_ENABLE_INSTALL OFF CACHE INTERNAL "")
+        FetchContent_Declare(
+                benchmark
+                GIT_REPOSITORY https://github.com/google/benchmark.git
+                GIT_TAG        v1.8.3
+        )
+        FetchContent_MakeAvailable(benchmark)
+        message(STATUS "---------------------")
+    endif()
+endif()
+
 find_library(KPHP_TIMELIB kphp-timelib)
 if(KPHP_TIMELIB)
     add_library(kphp-timelib STATIC IMPORTED ${KPHP_TIMELIB})
@@ -31,5 +31,8 @@ cmake_print_variables(PDO_DRIVER_PGSQL)
 option(KPHP_TESTS "Build the tests" ON)
 cmake_print_variables(KPHP_TESTS)
 
+option(KPHP_BENCHMARKS "Build the benchmarks of runtime primitives" OFF)
+cmake_print_variables(KPHP_BENCHMARKS)
+
 option(KPHP_CUSTOM_CMAKE "Use CMakeLists.txt of custom php project" OFF)
 cmake_print_variables(KPHP_CUSTOM_CMAKE)
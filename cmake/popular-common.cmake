@@ -17,6 +17,7 @@ prepend(POPULAR_COMMON_SOURCES ${COMMON_DIR}/
         crc32c.cpp
         options.cpp
         kernel-version.cpp
+        huge-pages.cpp
         secure-bzero.cpp
         crc32_${CMAKE_SYSTEM_PROCESSOR}.cpp
         crc32c_${CMAKE_SYSTEM_PROCESSOR}.cpp
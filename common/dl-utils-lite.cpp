@@ -223,6 +223,12 @@ mem_info_t get_self_mem_stats() {
     if (strncmp (st, "RssShmem", 8) == 0) {
       x = &info.rss_shmem;
     }
+    if (strncmp (st, "VmPTE", 5) == 0) {
+      x = &info.page_tables;
+    }
+    if (strncmp (st, "HugetlbPages", 12) == 0) {
+      x = &info.hugetlb;
+    }
     if (x) {
       while (st < s && *st != ' ' && *st != '\t') {
         st++;
@@ -57,6 +57,8 @@ struct mem_info_t {
   uint32_t rss;
   uint32_t rss_file;
   uint32_t rss_shmem;
+  uint32_t page_tables;
+  uint32_t hugetlb;
 };
 
 mem_info_t get_self_mem_stats();
@@ -0,0 +1,187 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2023 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "common/huge-pages.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "common/kprintf.h"
+#include "common/options.h"
+#include "common/stats/provider.h"
+#include "common/wrappers/memory-utils.h"
+
+#ifndef MADV_POPULATE_WRITE
+  #define MADV_POPULATE_WRITE 23
+#endif
+
+namespace {
+
+enum class HugePagesMode {
+  disabled,
+  thp,
+  hugetlb
+};
+
+struct HugePagesStats {
+  uint64_t thp_regions{0};
+  uint64_t thp_bytes{0};
+  uint64_t hugetlb_regions{0};
+  uint64_t hugetlb_bytes{0};
+  uint64_t hugetlb_fallbacks{0};
+  uint64_t madvise_failures{0};
+};
+
+HugePagesMode huge_pages_mode = HugePagesMode::disabled;
+size_t prefault_memory_size = 0;
+HugePagesStats huge_pages_stats;
+
+size_t round_up_to_huge_page(size_t size) noexcept {
+  return (size + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+}
+
+void *mmap_or_die(size_t size, int flags) noexcept {
+  void *mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+  assert(mem);
+  assert(mem != MAP_FAILED);
+  return mem;
+}
+
+// the huge pages can be used only in the aligned ranges, so the region is mapped with a margin and trimmed
+void *mmap_aligned_to_huge_page(size_t size, int flags) noexcept {
+  auto *mem = static_cast<char *>(mmap_or_die(size + HUGE_PAGE_SIZE, flags));
+  auto *aligned = reinterpret_cast<char *>(round_up_to_huge_page(reinterpret_cast<uintptr_t>(mem)));
+  if (aligned != mem) {
+    munmap(mem, aligned - mem);
+  }
+  if (const size_t tail = mem + size + HUGE_PAGE_SIZE - (aligned + size)) {
+    munmap(aligned + size, tail);
+  }
+  return aligned;
+}
+
+void *mmap_huge_pages(size_t size, int flags, bool *is_hugetlb) noexcept {
+  if (huge_pages_mode == HugePagesMode::disabled) {
+    return mmap_or_die(size, flags);
+  }
+
+  size = round_up_to_huge_page(size);
+#if !defined(__APPLE__)
+  if (huge_pages_mode == HugePagesMode::hugetlb) {
+    void *mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags | MAP_HUGETLB, -1, 0);
+    if (mem != MAP_FAILED) {
+      ++huge_pages_stats.hugetlb_regions;
+      huge_pages_stats.hugetlb_bytes += size;
+      if (is_hugetlb) {
+        *is_hugetlb = true;
+      }
+      return mem;
+    }
+    kprintf("Can't map %zu bytes with hugetlb pages, falling back to transparent huge pages: %m\n", size);
+    ++huge_pages_stats.hugetlb_fallbacks;
+  }
+#endif
+
+  void *mem = mmap_aligned_to_huge_page(size, flags);
+#if !defined(__APPLE__)
+  if (our_madvise(mem, size, MADV_HUGEPAGE) == 0) {
+    ++huge_pages_stats.thp_regions;
+    huge_pages_stats.thp_bytes += size;
+    return mem;
+  }
+  kprintf("Can't madvise %zu bytes with MADV_HUGEPAGE: %m\n", size);
+#endif
+  ++huge_pages_stats.madvise_failures;
+  return mem;
+}
+
+} // namespace
+
+OPTION_PARSER(OPT_GENERIC, "huge-pages", required_argument,
+              "back the large memory regions (script memory, instance cache, confdata, job workers messages) with huge pages: "
+              "'thp' for transparent huge pages or 'hugetlb' for the reserved ones (falls back to 'thp' if they run out)") {
+  if (!strcmp(optarg, "thp")) {
+    huge_pages_mode = HugePagesMode::thp;
+  } else if (!strcmp(optarg, "hugetlb")) {
+    huge_pages_mode = HugePagesMode::hugetlb;
+  } else {
+    kprintf("--huge-pages option: unknown mode '%s', 'thp' or 'hugetlb' are expected\n", optarg);
+    return -1;
+  }
+#if defined(__APPLE__)
+  kprintf("--huge-pages option: huge pages are not available on macOS, the option is ignored\n");
+  huge_pages_mode = HugePagesMode::disabled;
+#endif
+  return 0;
+}
+
+OPTION_PARSER(OPT_GENERIC, "prefault-memory", required_argument,
+              "pre-fault this amount of the script memory at the worker start, so the first requests don't take the page faults (default: 0)") {
+  const long long size = parse_memory_limit(optarg);
+  if (size < 0) {
+    kprintf("--prefault-memory option: couldn't parse argument\n");
+    return -1;
+  }
+  prefault_memory_size = static_cast<size_t>(size);
+  return 0;
+}
+
+STATS_PROVIDER(huge_pages, 1000) {
+  if (huge_pages_mode == HugePagesMode::disabled) {
+    return;
+  }
+  stats->add_gauge_stat("huge_pages.thp_regions", huge_pages_stats.thp_regions);
+  stats->add_gauge_stat("huge_pages.thp_bytes", huge_pages_stats.thp_bytes);
+  stats->add_gauge_stat("huge_pages.hugetlb_regions", huge_pages_stats.hugetlb_regions);
+  stats->add_gauge_stat("huge_pages.hugetlb_bytes", huge_pages_stats.hugetlb_bytes);
+  stats->add_gauge_stat("huge_pages.hugetlb_fallbacks", huge_pages_stats.hugetlb_fallbacks);
+  stats->add_gauge_stat("huge_pages.madvise_failures", huge_pages_stats.madvise_failures);
+}
+
+bool huge_pages_enabled() noexcept {
+  return huge_pages_mode != HugePagesMode::disabled;
+}
+
+size_t huge_pages_granularity() noexcept {
+  return huge_pages_enabled() ? HUGE_PAGE_SIZE : static_cast<size_t>(getpagesize());
+}
+
+void *mmap_shared_huge_pages(size_t size) noexcept {
+  return mmap_huge_pages(size, MAP_SHARED | MAP_ANONYMOUS, nullptr);
+}
+
+void *mmap_private_huge_pages(size_t size, bool *is_hugetlb) noexcept {
+  if (is_hugetlb) {
+    *is_hugetlb = false;
+  }
+  return mmap_huge_pages(size, MAP_PRIVATE | MAP_ANONYMOUS, is_hugetlb);
+}
+
+void munmap_huge_pages(void *mem, size_t size) noexcept {
+  munmap(mem, huge_pages_enabled() ? round_up_to_huge_page(size) : size);
+}
+
+bool prefault_memory_enabled() noexcept {
+  return prefault_memory_size != 0;
+}
+
+void prefault_private_memory(void *mem, size_t size) noexcept {
+  size = std::min(size, prefault_memory_size);
+  if (!size) {
+    return;
+  }
+  if (our_madvise(mem, size, MADV_POPULATE_WRITE) != 0) {
+    // the kernel is older than 5.14, so the pages are touched one by one
+    const auto page_size = static_cast<size_t>(getpagesize());
+    for (size_t offset = 0; offset < size; offset += page_size) {
+      volatile char *page = static_cast<char *>(mem) + offset;
+      *page = *page;
+    }
+  }
+}
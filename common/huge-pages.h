@@ -0,0 +1,30 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2023 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include <cstddef>
+
+// Large memory regions (script memory, instance cache, confdata, job workers messages) may be backed with huge pages,
+// it's turned on by the --huge-pages option:
+//   thp     - transparent huge pages, the regions are aligned to the huge page size and advised with MADV_HUGEPAGE
+//             (the shared regions also require /sys/kernel/mm/transparent_hugepage/shmem_enabled to be 'advise' or 'always');
+//   hugetlb - the reserved huge pages (vm.nr_hugepages), the thp mode is used as a fallback if there are not enough of them.
+// The region sizes are rounded up to the huge page size, so they must be unmapped with munmap_huge_pages().
+
+constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+bool huge_pages_enabled() noexcept;
+
+// the granularity of madvise(MADV_DONTNEED/MADV_FREE) calls that doesn't split the huge pages
+size_t huge_pages_granularity() noexcept;
+
+void *mmap_shared_huge_pages(size_t size) noexcept;
+// sets is_hugetlb if the region is backed with the reserved huge pages, they don't support MADV_FREE
+void *mmap_private_huge_pages(size_t size, bool *is_hugetlb = nullptr) noexcept;
+void munmap_huge_pages(void *mem, size_t size) noexcept;
+
+// pre-faults the first --prefault-memory bytes of a private region, so the worker doesn't take the page faults on requests
+void prefault_private_memory(void *mem, size_t size) noexcept;
+bool prefault_memory_enabled() noexcept;
@@ -107,6 +107,7 @@ inline int accept4(int sockfd, struct sockaddr *addr, socklen_t *addrlen, int fl
 
 #define PR_SET_PDEATHSIG 1
 #define PR_SET_DUMPABLE 4
+#define PR_SET_CHILD_SUBREAPER 36
 
 inline int prctl(int, unsigned long) noexcept {
   errno = EINVAL;
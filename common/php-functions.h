@@ -5,6 +5,7 @@
 #pragma once
 
 #include <climits>
+#include <cstdint>
 #include <cstring>
 #include <cctype>
 #include <limits>
@@ -54,7 +55,12 @@ public:
     // used as a reference counter for communication with job workers
     // data is located in shared memory;
     // hard reset without the destructor calls is implied
-    for_job_worker_communication
+    for_job_worker_communication,
+
+    // used as a reference counter for the strings fetched in place from the rpc answers;
+    // data is located in script memory and is readonly;
+    // it's freed with the script memory at the end of the request
+    for_rpc_answer
   };
 
   // wrapping this into a class helps avoid the global namespace pollution
@@ -69,23 +75,81 @@ private:
   extra_ref_cnt_value value_;
 };
 
-inline int64_t string_hash(const char *p, size_t l) __attribute__ ((always_inline)) ubsan_supp("alignment");
+namespace string_hash_impl {
 
-int64_t string_hash(const char *p, size_t l) {
-  constexpr uint64_t HASH_MUL = 1915239017;
-  uint64_t hash = 2147483648U;
+// wyhash (public domain, by Wang Yi): the 64x64->128 multiplication is fast on both x86_64 and aarch64,
+// and the result is the same on every platform, which is required since the compiler precomputes hashes of the constant keys
+constexpr uint64_t SECRET[4] = {0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL, 0x8ebc6af09c88c6e3ULL, 0x589965cc75374cc3ULL};
 
-  size_t prev = (l & 3);
-  for (size_t i = 0; i < prev; i++) {
-    hash = hash * HASH_MUL + p[i];
-  }
+inline uint64_t mix(uint64_t a, uint64_t b) {
+  const __uint128_t r = static_cast<__uint128_t>(a) * b;
+  return static_cast<uint64_t>(r) ^ static_cast<uint64_t>(r >> 64);
+}
+
+inline uint64_t read8(const char *p) {
+  uint64_t v = 0;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline uint64_t read4(const char *p) {
+  uint32_t v = 0;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline uint64_t read_small(const char *p, size_t l) {
+  return (static_cast<uint64_t>(static_cast<uint8_t>(p[0])) << 16) |
+         (static_cast<uint64_t>(static_cast<uint8_t>(p[l >> 1])) << 8) |
+         static_cast<uint64_t>(static_cast<uint8_t>(p[l - 1]));
+}
+
+} // namespace string_hash_impl
 
-  const auto *p_uint = reinterpret_cast<const uint32_t *>(p + prev);
-  l >>= 2;
-  while (l-- > 0) {
-    hash = hash * HASH_MUL + *p_uint++;
+inline int64_t string_hash(const char *p, size_t l) __attribute__ ((always_inline));
+
+// Note: the hash isn't persisted anywhere, but it's precomputed by the compiler for the constant keys (arrays, shapes, switch),
+// so the generated code depends on it; changing it changes php_lib_version and requires the full site recompilation
+int64_t string_hash(const char *p, size_t l) {
+  using namespace string_hash_impl;
+  uint64_t seed = mix(SECRET[0], SECRET[1]);
+  uint64_t a = 0;
+  uint64_t b = 0;
+  if (l <= 16) {
+    if (l >= 4) {
+      a = (read4(p) << 32) | read4(p + ((l >> 3) << 2));
+      b = (read4(p + l - 4) << 32) | read4(p + l - 4 - ((l >> 3) << 2));
+    } else if (l > 0) {
+      a = read_small(p, l);
+    }
+  } else {
+    size_t i = l;
+    if (i > 48) {
+      // three independent lanes to keep the multipliers busy on long keys
+      uint64_t seed1 = seed;
+      uint64_t seed2 = seed;
+      do {
+        seed = mix(read8(p) ^ SECRET[1], read8(p + 8) ^ seed);
+        seed1 = mix(read8(p + 16) ^ SECRET[2], read8(p + 24) ^ seed1);
+        seed2 = mix(read8(p + 32) ^ SECRET[3], read8(p + 40) ^ seed2);
+        p += 48;
+        i -= 48;
+      } while (i > 48);
+      seed ^= seed1 ^ seed2;
+    }
+    while (i > 16) {
+      seed = mix(read8(p) ^ SECRET[1], read8(p + 8) ^ seed);
+      i -= 16;
+      p += 16;
+    }
+    a = read8(p + i - 16);
+    b = read8(p + i - 8);
   }
-  const auto result = static_cast<int64_t>(hash);
+
+  a ^= SECRET[1];
+  b ^= seed;
+  const __uint128_t r = static_cast<__uint128_t>(a) * b;
+  const auto result = static_cast<int64_t>(mix(static_cast<uint64_t>(r) ^ SECRET[0] ^ l, static_cast<uint64_t>(r >> 64) ^ SECRET[1]));
   // to ensure that there is no way to get the -9223372036854775808L during code generation
   return (result != std::numeric_limits<int64_t>::min()) * result;
 }
@@ -232,13 +296,27 @@ bool php_try_to_int(const char *s, size_t l, int64_t *val) {
   return true;
 }
 
+// raw string representation matches the runtime string::string_inner layout:
+// the cached string_hash() of the data, size, capacity and reference counter
+constexpr int STRING_RAW_HEADER_SIZE = sizeof(int64_t) + 3 * sizeof(int);
+
 //returns len of raw string representation or -1 on error
 inline int string_raw_len(int src_len) {
-  if (src_len < 0 || src_len >= (1 << 30) - 13) {
+  if (src_len < 0 || src_len >= (1 << 30) - STRING_RAW_HEADER_SIZE - 1) {
     return -1;
   }
 
-  return src_len + 13;
+  return src_len + STRING_RAW_HEADER_SIZE + 1;
+}
+
+//writes raw string header to dest and returns a pointer to the string data
+inline char *string_raw_init_header(char *dest, int len, int ref_count, int64_t hash) {
+  memcpy(dest, &hash, sizeof(hash));
+  int *dest_int = reinterpret_cast <int *> (dest + sizeof(hash));
+  dest_int[0] = len;
+  dest_int[1] = len;
+  dest_int[2] = ref_count;
+  return dest + STRING_RAW_HEADER_SIZE;
 }
 
 //returns len of raw string representation and writes it to dest or returns -1 on error
@@ -247,12 +325,10 @@ inline int string_raw(char *dest, int dest_len, const char *src, int src_len) {
   if (raw_len == -1 || raw_len > dest_len) {
     return -1;
   }
-  int *dest_int = reinterpret_cast <int *> (dest);
-  dest_int[0] = src_len;
-  dest_int[1] = src_len;
-  dest_int[2] = ExtraRefCnt::for_global_const;
-  memcpy(dest + 3 * sizeof(int), src, src_len);
-  dest[3 * sizeof(int) + src_len] = '\0';
+  // raw strings are placed in read only memory, so the hash is precomputed
+  char *data = string_raw_init_header(dest, src_len, ExtraRefCnt::for_global_const, string_hash(src, src_len));
+  memcpy(data, src, src_len);
+  data[src_len] = '\0';
 
   return raw_len;
 }
@@ -9,10 +9,12 @@
 
 #pragma pack(push, 1)
 
+// supported_compression_version is the last field, it's sent only if the corresponding flag is set
 struct RpcDestActorFlagsHeaders {
   int op{-1};
   long long actor_id{-1};
   int flags{-1};
+  int supported_compression_version{-1};
 };
 
 struct RpcDestActorHeaders {
@@ -23,6 +25,7 @@ struct RpcDestActorHeaders {
 struct RpcDestFlagsHeaders {
   int op{-1};
   int flags{-1};
+  int supported_compression_version{-1};
 };
 
 union RpcExtraHeaders {
@@ -44,4 +47,5 @@ struct RpcHeaders {
 
 #pragma pack(pop)
 
-size_t fill_extra_headers_if_needed(RpcExtraHeaders &extra_headers, uint32_t function_magic, int actor_id, bool ignore_answer);
+size_t fill_extra_headers_if_needed(RpcExtraHeaders &extra_headers, uint32_t function_magic, int actor_id, bool ignore_answer,
+                                    int supported_compression_version = 0);
@@ -18,7 +18,8 @@ struct tl_in_methods : vk::not_copyable {
   virtual void fetch_mark() noexcept = 0;
   virtual void fetch_mark_restore() noexcept = 0;
   virtual void fetch_mark_delete() noexcept = 0;
-  virtual int decompress(int version) noexcept = 0;
+  // returns the decompressed size or -1 on failure
+  virtual int decompress(int version, int max_size) noexcept = 0;
   virtual ~tl_in_methods() = default;
 };
 
@@ -79,27 +79,34 @@ struct zstd_decompression_extra_t {
   ZSTD_DStream *zstd_stream;
   char *buffer;
   size_t buf_len;
+  int max_size;
+  // the bytes expected to finish the current frame, zero if the frame is complete
+  size_t frame_remaining;
 };
 
 static inline int tl_raw_msg_zstd_decompress(void *_extra, const void *data, int len) {
   auto *extra = static_cast<zstd_decompression_extra_t *>(_extra);
-  ZSTD_outBuffer output = {.dst = extra->buffer, .size = extra->buf_len, .pos = 0};
   ZSTD_inBuffer input = {.src = data, .size = (size_t)len, .pos = 0};
-  while (input.pos < input.size) {
-    while (true) {
-      ZSTD_decompressStream(extra->zstd_stream, &output, &input);
-      rwm_push_data(extra->raw_out, output.dst, (int)output.pos);
-      bool end = output.pos < output.size;
-      output.pos = 0;
-      if (end) {
-        break;
-      }
+  while (true) {
+    ZSTD_outBuffer output = {.dst = extra->buffer, .size = extra->buf_len, .pos = 0};
+    const size_t input_pos = input.pos;
+    extra->frame_remaining = ZSTD_decompressStream(extra->zstd_stream, &output, &input);
+    if (ZSTD_isError(extra->frame_remaining) || output.pos > static_cast<size_t>(extra->max_size - extra->raw_out->total_bytes)) {
+      return -1;
+    }
+    if (output.pos == 0 && input.pos == input_pos && input.pos < input.size) {
+      // no progress, the data is corrupted
+      return -1;
+    }
+    rwm_push_data(extra->raw_out, output.dst, (int)output.pos);
+    // everything decodable is flushed, when the output buffer isn't full
+    if (input.pos == input.size && output.pos < output.size) {
+      return 0;
     }
   }
-  return 0;
 }
 
-static void rwm_zstd_decompress(raw_message_t &in) {
+static bool rwm_zstd_decompress(raw_message_t &in, int max_size) {
   raw_message_t out;
   rwm_init(&out, 0);
   static ZSTD_DStream *zstd_stream = nullptr;
@@ -113,13 +120,20 @@ static void rwm_zstd_decompress(raw_message_t &in) {
     out_buf = static_cast<char *>(malloc(buf_len));
   }
   ZSTD_initDStream(zstd_stream);
-  zstd_decompression_extra_t extra = {.raw_out = &out, .zstd_stream = zstd_stream, .buffer = out_buf, .buf_len = buf_len};
+  zstd_decompression_extra_t extra = {.raw_out = &out, .zstd_stream = zstd_stream, .buffer = out_buf, .buf_len = buf_len,
+                                      .max_size = max_size, .frame_remaining = 0};
   int len = 0;
-  rwm_fetch_data(&in, &len, sizeof(int));
-  rwm_process(&in, len, tl_raw_msg_zstd_decompress, &extra);
+  bool ok = rwm_fetch_data(&in, &len, sizeof(int)) == sizeof(int) && 0 < len && len <= in.total_bytes
+            && rwm_process(&in, len, tl_raw_msg_zstd_decompress, &extra) == len
+            && extra.frame_remaining == 0;
 
   rwm_free(&in);
+  if (!ok) {
+    rwm_free(&out);
+    rwm_init(&out, 0);
+  }
   rwm_steal(&in, &out);
+  return ok;
 }
 
 void compress_rwm(raw_message_t &rwm, int version) noexcept {
@@ -139,18 +153,17 @@ void compress_rwm(raw_message_t &rwm, int version) noexcept {
   }
 }
 
-void decompress_rwm(raw_message_t &in, int version) noexcept {
+bool decompress_rwm(raw_message_t &in, int version, int max_size) noexcept {
   assert(version <= COMPRESSION_VERSION_MAX);
   assert(in.magic == RM_INIT_MAGIC);
   switch (version) {
     case COMPRESSION_VERSION_TEST_XOR: {
       rwm_fork_deep(&in);
       rwm_transform_from_offset(&in, in.total_bytes, 0, rwm_do_xor_compress, nullptr);
-      break;
+      return in.total_bytes <= max_size;
     }
     case COMPRESSION_VERSION_ZSTD: {
-      rwm_zstd_decompress(in);
-      break;
+      return rwm_zstd_decompress(in, max_size);
     }
     default:
       assert(0);
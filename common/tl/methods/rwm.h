@@ -12,7 +12,8 @@
 #include "net/net-msg.h"
 
 void compress_rwm(raw_message_t &rwm, int version) noexcept;
-void decompress_rwm(raw_message_t &rwm, int version) noexcept;
+// returns false if the data is corrupted or is decompressed to more than max_size bytes, the message is emptied then
+bool decompress_rwm(raw_message_t &rwm, int version, int max_size) noexcept;
 
 struct tl_in_methods_raw_msg final : tl_in_methods {
   raw_message in{};
@@ -58,9 +59,8 @@ struct tl_in_methods_raw_msg final : tl_in_methods {
       rwm_free(&mark);
     }
   }
-  int decompress(int version) noexcept override {
-    decompress_rwm(in, version);
-    return in.total_bytes;
+  int decompress(int version, int max_size) noexcept override {
+    return decompress_rwm(in, version, max_size) ? in.total_bytes : -1;
   }
 
   ~tl_in_methods_raw_msg() noexcept override {
@@ -47,7 +47,7 @@ struct tl_in_methods_str final : tl_in_methods {
   void fetch_mark_delete() noexcept  override {
     mark = nullptr;
   }
-  int decompress(int) noexcept override {
+  int decompress(int, int) noexcept override {
     assert(0 && "decompress not implemented for str");
   }
 };
@@ -209,10 +209,15 @@ void tl_compress_written(int version) {
   tlio->out_pos = new_size;
 }
 
-void tl_decompress_remaining(int version) {
-  int new_size = tlio->in_methods->decompress(version);
-  assert(new_size % 4 == 0);
+bool tl_decompress_remaining(int version, int max_size) {
+  int new_size = tlio->in_methods->decompress(version, max_size);
+  if (new_size < 0 || new_size % 4 != 0) {
+    tlio->in_remaining = 0;
+    tl_fetch_set_error_format(TL_ERROR_HEADER, "Can't decompress the data of the compression version %d", version);
+    return false;
+  }
   tlio->in_remaining = new_size;
+  return true;
 }
 
 void tl_fetch_raw_data(void *buf, int size) {
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <functional>
+#include <limits>
 #include <memory>
 #include <string>
 #include <optional>
@@ -32,7 +33,8 @@ void tl_fetch_set_error(int errnum, const char *s);
 void tl_setup_result_header(const struct tl_query_header_t *header);
 
 void tl_compress_written(int version);
-void tl_decompress_remaining(int version);
+// the corrupted data and the data decompressed to more than max_size bytes set TL_ERROR_HEADER
+bool tl_decompress_remaining(int version, int max_size = std::numeric_limits<int>::max());
 
 int tl_fetch_check(int nbytes);
 
@@ -123,7 +123,7 @@ bool tl_fetch_query_header(tl_query_header_t *header) {
   return true;
 }
 
-static int tl_fetch_query_answer_flags(tl_query_answer_header_t *header) {
+int tl_fetch_query_answer_flags(tl_query_answer_header_t *header) {
   namespace flag = vk::tl::common::rpc_req_result_extra_flags;
   int flags = tl_fetch_int();
   if (tl_fetch_error()) {
@@ -216,6 +216,42 @@ static int tl_fetch_query_answer_flags(tl_query_answer_header_t *header) {
   return 0;
 }
 
+bool tl_fetch_packed_query_answer_header(std::string &unpacked_header, int max_unpacked_size) {
+  namespace flag = vk::tl::common::rpc_req_result_extra_flags;
+  const int64_t packed_len = tl_fetch_unread();
+  tl_query_answer_header_t header{};
+  tl_fetch_mark();
+  tl_fetch_int();
+  tl_fetch_query_answer_flags(&header);
+  const int64_t header_len = packed_len - tl_fetch_unread();
+  if (tl_fetch_error() || header.compression_version <= COMPRESSION_VERSION_NONE || header.compression_version > COMPRESSION_VERSION_MAX) {
+    tl_fetch_mark_delete();
+    return false;
+  }
+  tl_fetch_mark_restore();
+  unpacked_header.resize(header_len);
+  tl_fetch_raw_data(&unpacked_header[0], static_cast<int>(header_len));
+  if (!tl_decompress_remaining(header.compression_version, max_unpacked_size)) {
+    return false;
+  }
+
+  const int other_flags = header.flags & ~flag::compression_version;
+  if (!other_flags) {
+    unpacked_header.clear();
+    return true;
+  }
+  // the compression version goes right after the fixed size fields
+  size_t compression_version_offset = 2 * sizeof(int);
+  compression_version_offset += (header.flags & flag::binlog_pos) ? sizeof(long long) : 0;
+  compression_version_offset += (header.flags & flag::binlog_time) ? sizeof(long long) : 0;
+  compression_version_offset += (header.flags & flag::engine_pid) ? sizeof(process_id) : 0;
+  compression_version_offset += (header.flags & flag::request_size) ? 2 * sizeof(int) : 0;
+  compression_version_offset += (header.flags & flag::failed_subqueries) ? sizeof(int) : 0;
+  memcpy(&unpacked_header[sizeof(int)], &other_flags, sizeof(other_flags));
+  unpacked_header.erase(compression_version_offset, sizeof(int));
+  return true;
+}
+
 bool tl_fetch_query_answer_header(tl_query_answer_header_t *header) {
   assert (header);
   int op = tl_fetch_int();
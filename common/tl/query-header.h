@@ -56,6 +56,11 @@ struct tl_query_answer_header_t {
 
 bool tl_fetch_query_header(tl_query_header_t *header);
 bool tl_fetch_query_answer_header(tl_query_answer_header_t *header);
+// fetches the flags of reqResultHeader and the fields they turn on, returns -1 on error
+int tl_fetch_query_answer_flags(tl_query_answer_header_t *header);
+// fetches reqResultHeader with the compression_version flag and unpacks the rest of the answer up to max_unpacked_size bytes,
+// the header is rewritten without the compression version, it's left empty if there are no other flags in it
+bool tl_fetch_packed_query_answer_header(std::string &unpacked_header, int max_unpacked_size);
 void tl_store_header(const tl_query_header_t *header);
 void tl_store_answer_header(const tl_query_answer_header_t *header);
 
@@ -5,6 +5,7 @@
 #include "compiler/code-gen/declarations.h"
 
 #include "common/algorithms/compare.h"
+#include "common/algorithms/hashes.h"
 
 #include "compiler/code-gen/common.h"
 #include "compiler/code-gen/files/json-encoder-tags.h"
@@ -943,12 +944,41 @@ void ClassDeclaration::compile_accept_visitor_methods(CodeGenerator &W, ClassPtr
   compile_accept_json_visitor(W, klass);
 }
 
+// the hash of serialization tags and types of the class fields including the nested classes;
+// it's used to reject the data serialized by the binary with another class layout (e.g. the instance cache snapshot)
+static size_t calc_msgpack_layout_hash(ClassPtr klass, std::unordered_set<ClassPtr> &visited) {
+  size_t hash = vk::std_hash(klass->name);
+  if (!visited.emplace(klass).second) {
+    return hash;
+  }
+
+  klass->members.for_each([&](const ClassMemberInstanceField &field) {
+    if (field.serialization_tag == -1) {
+      return;
+    }
+    const TypeData *type = tinf::get_type(field.var);
+    vk::hash_combine(hash, field.serialization_tag);
+    vk::hash_combine(hash, vk::std_hash(type_out(type)));
+
+    std::unordered_set<ClassPtr> inner_classes;
+    type->get_all_class_types_inside(inner_classes);
+    std::vector<ClassPtr> sorted_inner_classes{inner_classes.begin(), inner_classes.end()};
+    std::sort(sorted_inner_classes.begin(), sorted_inner_classes.end(), [](ClassPtr a, ClassPtr b) { return a->name < b->name; });
+    for (ClassPtr inner_class : sorted_inner_classes) {
+      vk::hash_combine(hash, calc_msgpack_layout_hash(inner_class, visited));
+    }
+  });
+  return hash;
+}
+
 void ClassDeclaration::compile_msgpack_declarations(CodeGenerator &W, ClassPtr klass) {
   if (!klass->is_serializable) {
     return;
   }
 
+  std::unordered_set<ClassPtr> visited;
   W << NL;
+  W << "static constexpr uint64_t MSGPACK_LAYOUT_HASH = " << static_cast<uint64_t>(calc_msgpack_layout_hash(klass, visited)) << "ULL;" << NL;
   W << "void msgpack_pack(vk::msgpack::packer<string_buffer> &packer) const noexcept;" << NL << NL;
   W << "void msgpack_unpack(const vk::msgpack::object &msgpack_o);" << NL;
 }
@@ -1192,6 +1222,49 @@ void ClassMembersDefinition::compile_msgpack_deserialize(CodeGenerator &W, Class
     << END << NL;
 }
 
+bool GlobalVarsDirtyGroups::is_tracked(VarPtr var) {
+  // the builtin globals are written by the runtime, so they are reset unconditionally
+  return !var->is_builtin_global();
+}
+
+size_t GlobalVarsDirtyGroups::get_group(VarPtr var) {
+  return vk::std_hash(var->name) % GROUPS_COUNT;
+}
+
+std::set<size_t> GlobalVarsDirtyGroups::get_function_groups(FunctionPtr function) {
+  std::set<size_t> groups;
+  const auto add_groups = [&groups](const std::vector<VarPtr> &vars) {
+    for (VarPtr var : vars) {
+      if (is_tracked(var)) {
+        groups.emplace(get_group(var));
+      }
+    }
+  };
+  add_groups(function->global_var_ids);
+  add_groups(function->static_var_ids);
+  return groups;
+}
+
+GlobalVarsDirtyGroupsDeclaration::GlobalVarsDirtyGroupsDeclaration(FunctionPtr function) :
+  function(function) {
+}
+
+void GlobalVarsDirtyGroupsDeclaration::compile(CodeGenerator &W) const {
+  if (!GlobalVarsDirtyGroups::get_function_groups(function).empty()) {
+    W << "extern bool " << GlobalVarsDirtyGroups::ARRAY_NAME << "[" << GlobalVarsDirtyGroups::GROUPS_COUNT << "];" << NL;
+  }
+}
+
+GlobalVarsDirtyGroupsMarks::GlobalVarsDirtyGroupsMarks(FunctionPtr function) :
+  function(function) {
+}
+
+void GlobalVarsDirtyGroupsMarks::compile(CodeGenerator &W) const {
+  for (size_t group : GlobalVarsDirtyGroups::get_function_groups(function)) {
+    W << GlobalVarsDirtyGroups::ARRAY_NAME << "[" << group << "] = false;" << NL;
+  }
+}
+
 StaticLibraryRunGlobal::StaticLibraryRunGlobal(gen_out_style style) :
   style(style) {
 }
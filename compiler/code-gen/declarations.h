@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <set>
 #include <string>
 #include <vector>
 
@@ -158,6 +159,30 @@ private:
   static void compile_msgpack_deserialize(CodeGenerator &W, ClassPtr klass);
 };
 
+// Globals and statics are split into the dirty groups by their names.
+// A function marks the groups of the vars it uses as dirty on each call, and only the dirty groups are reset after the request,
+// so the reset cost depends on the code executed by the request rather than on the program size.
+struct GlobalVarsDirtyGroups {
+  static constexpr size_t GROUPS_COUNT = 4096;
+  static constexpr const char *ARRAY_NAME = "global_vars_clean_groups";
+
+  static bool is_tracked(VarPtr var);
+  static size_t get_group(VarPtr var);
+  static std::set<size_t> get_function_groups(FunctionPtr function);
+};
+
+struct GlobalVarsDirtyGroupsDeclaration {
+  FunctionPtr function;
+  explicit GlobalVarsDirtyGroupsDeclaration(FunctionPtr function);
+  void compile(CodeGenerator &W) const;
+};
+
+struct GlobalVarsDirtyGroupsMarks {
+  FunctionPtr function;
+  explicit GlobalVarsDirtyGroupsMarks(FunctionPtr function);
+  void compile(CodeGenerator &W) const;
+};
+
 struct StaticLibraryRunGlobal {
   gen_out_style style;
   explicit StaticLibraryRunGlobal(gen_out_style style);
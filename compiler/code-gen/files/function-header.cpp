@@ -56,6 +56,7 @@ void FunctionH::compile(CodeGenerator &W) const {
     declare_global_vars(function, W);
     declare_const_vars(function, W);
     declare_static_vars(function, W);
+    W << GlobalVarsDirtyGroupsDeclaration(function);
     W << UnlockComments();
     W << function->root << NL;
     W << LockComments();
@@ -53,6 +53,7 @@ void FunctionCpp::compile(CodeGenerator &W) const {
   declare_global_vars(function, W);
   declare_const_vars(function, W);
   declare_static_vars(function, W);
+  W << GlobalVarsDirtyGroupsDeclaration(function);
 
   W << UnlockComments();
   W << function->root << NL;
@@ -4,6 +4,9 @@
 
 #include "compiler/code-gen/files/vars-reset.h"
 
+#include <map>
+#include <vector>
+
 #include "compiler/code-gen/common.h"
 #include "compiler/code-gen/declarations.h"
 #include "compiler/code-gen/includes.h"
@@ -31,6 +34,15 @@ void GlobalVarsReset::declare_extern_for_init_val(VertexPtr v, std::set<VarPtr>
   }
 }
 
+void GlobalVarsReset::compile_var_reset(VarPtr var, CodeGenerator &W) {
+  W << "hard_reset_var(" << VarName(var);
+  //FIXME: brk and comments
+  if (var->init_val) {
+    W << ", " << var->init_val;
+  }
+  W << ");" << NL;
+}
+
 void GlobalVarsReset::compile_part(FunctionPtr func, const std::set<VarPtr> &used_vars, int part_i, CodeGenerator &W) {
   IncludesCollector includes;
   for (auto var : used_vars) {
@@ -46,19 +58,30 @@ void GlobalVarsReset::compile_part(FunctionPtr func, const std::set<VarPtr> &use
       declare_extern_for_init_val(var->init_val, externed_vars, W);
     }
   }
+  W << "extern bool " << GlobalVarsDirtyGroups::ARRAY_NAME << "[" << GlobalVarsDirtyGroups::GROUPS_COUNT << "];" << NL;
 
   FunctionSignatureGenerator(W) << "void " << GlobalVarsResetFuncName(func, part_i) << " " << BEGIN;
+  std::map<size_t, std::vector<VarPtr>> dirty_groups;
   for (auto var : used_vars) {
     if (G->settings().is_static_lib_mode() && var->is_builtin_global()) {
       continue;
     }
 
-    W << "hard_reset_var(" << VarName(var);
-    //FIXME: brk and comments
-    if (var->init_val) {
-      W << ", " << var->init_val;
+    if (GlobalVarsDirtyGroups::is_tracked(var)) {
+      dirty_groups[GlobalVarsDirtyGroups::get_group(var)].emplace_back(var);
+    } else {
+      compile_var_reset(var, W);
+    }
+  }
+
+  for (const auto &group : dirty_groups) {
+    // the group is marked as clean before the reset, so it stays dirty if a destructor called by the reset writes it
+    W << "if (!" << GlobalVarsDirtyGroups::ARRAY_NAME << "[" << group.first << "]) " << BEGIN;
+    W << GlobalVarsDirtyGroups::ARRAY_NAME << "[" << group.first << "] = true;" << NL;
+    for (auto var : group.second) {
+      compile_var_reset(var, W);
     }
-    W << ");" << NL;
+    W << END << NL;
   }
 
   W << END;
@@ -68,6 +91,8 @@ void GlobalVarsReset::compile_part(FunctionPtr func, const std::set<VarPtr> &use
 
 void GlobalVarsReset::compile_func(FunctionPtr func, int parts_n, CodeGenerator &W) {
   W << OpenNamespace();
+  // zero initialized, so all the groups are reset on the first call
+  W << "bool " << GlobalVarsDirtyGroups::ARRAY_NAME << "[" << GlobalVarsDirtyGroups::GROUPS_COUNT << "];" << NL << NL;
   FunctionSignatureGenerator(W) << "void " << GlobalVarsResetFuncName(func) << " " << BEGIN;
 
   for (int i = 0; i < parts_n; i++) {
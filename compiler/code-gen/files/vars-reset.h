@@ -14,6 +14,8 @@ struct GlobalVarsReset : CodeGenRootCmd {
 
   void compile(CodeGenerator &W) const final;
 
+  static void compile_var_reset(VarPtr var, CodeGenerator &W);
+
   static void compile_part(FunctionPtr func, const std::set<VarPtr> &used_vars, int part_i, CodeGenerator &W);
 
   static void compile_func(FunctionPtr func, int parts_n, CodeGenerator &W);
@@ -1385,6 +1385,7 @@ void compile_function_resumable(VertexAdaptor<op_function> func_root, CodeGenera
   } else {
     FunctionSignatureGenerator(W).set_final() << "bool run()" << BEGIN;
   }
+  W << GlobalVarsDirtyGroupsMarks(func);
   W << "RESUMABLE_BEGIN" << NL << Indent(+2);
   if (func->kphp_tracing) {
     TracingAutogen::codegen_runtime_func_guard_start(W, func);
@@ -1434,6 +1435,7 @@ void compile_function(VertexAdaptor<op_function> func_root, CodeGenerator &W) {
   }
 
   W << FunctionDeclaration(func, false) << " " << BEGIN;
+  W << GlobalVarsDirtyGroupsMarks(func);
 
   if (func->kphp_tracing) {
     TracingAutogen::codegen_runtime_func_guard_declaration(W, func);
@@ -200,6 +200,9 @@ struct connection {
   double last_query_sent_time;
   double last_response_time;
   double last_query_timeout;
+  // the rpc queries of the running script, which are waiting for the answers on this connection, and their smoothed response time
+  int rpc_queries_in_flight;
+  double rpc_avg_response_time;
   event_timer_t timer;
   event_timer_t write_timer;
   int limit_per_write, limit_per_sec;
@@ -0,0 +1,90 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2023 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <memory>
+#include <vector>
+
+#include "common/crc32.h"
+#include "common/crc32c.h"
+#include "net/net-msg.h"
+#include "net/net-tcp-rpc-common.h"
+
+namespace {
+
+struct rpc_connection_t {
+  explicit rpc_connection_t(crc32_partial_func_t crc32_partial) {
+    rwm_init(&c->out, 0);
+    TCP_RPC_DATA(c.get())->custom_crc_partial = crc32_partial;
+    TCP_RPC_DATA(c.get())->out_packet_num = 5;
+  }
+
+  ~rpc_connection_t() {
+    rwm_free(&c->out);
+  }
+
+  std::vector<uint8_t> take_out() {
+    std::vector<uint8_t> out(c->out.total_bytes);
+    EXPECT_EQ(rwm_fetch_data(&c->out, out.data(), static_cast<int>(out.size())), static_cast<int>(out.size()));
+    return out;
+  }
+
+  std::unique_ptr<connection> c{new connection{}};
+};
+
+std::vector<int> make_packet(int ints) {
+  std::vector<int> packet(ints);
+  for (int i = 0; i < ints; ++i) {
+    packet[i] = i * 2654435761u;
+  }
+  return packet;
+}
+
+void send_with_raw_message(connection *c, std::vector<int> &packet) {
+  raw_message_t raw;
+  const int len = static_cast<int>(packet.size() * sizeof(int));
+  rwm_create(&raw, packet.data(), len);
+  tcp_rpc_conn_send(c, &raw, 0);
+}
+
+} // namespace
+
+// tcp_rpc_conn_send_data() computes the crc over the contiguous data and appends it to the output tail,
+// the bytes on the wire must be the same as tcp_rpc_conn_send() makes through the raw message
+TEST(net_tcp_rpc_common, send_data_matches_raw_message_send) {
+  for (crc32_partial_func_t crc32_partial : {crc32_partial, crc32c_partial}) {
+    // the larger packets span several msg buffers
+    for (int ints : {0, 1, 3, 64, 1000, 10000}) {
+      rpc_connection_t raw_sender{crc32_partial};
+      rpc_connection_t data_sender{crc32_partial};
+      for (int packets = 0; packets < 3; ++packets) {
+        auto packet = make_packet(ints + packets);
+        send_with_raw_message(raw_sender.c.get(), packet);
+        tcp_rpc_conn_send_data(data_sender.c.get(), static_cast<int>(packet.size() * sizeof(int)), packet.data());
+      }
+
+      ASSERT_EQ(TCP_RPC_DATA(data_sender.c.get())->out_packet_num, TCP_RPC_DATA(raw_sender.c.get())->out_packet_num);
+      const auto expected = raw_sender.take_out();
+      const auto actual = data_sender.take_out();
+      ASSERT_EQ(actual, expected) << "packet size " << ints * sizeof(int);
+    }
+  }
+}
+
+TEST(net_tcp_rpc_common, send_data_framing) {
+  rpc_connection_t sender{crc32c_partial};
+  auto packet = make_packet(4);
+  tcp_rpc_conn_send_data(sender.c.get(), static_cast<int>(packet.size() * sizeof(int)), packet.data());
+
+  const auto out = sender.take_out();
+  ASSERT_EQ(out.size(), 8 + packet.size() * sizeof(int) + 4);
+  const int *header = reinterpret_cast<const int *>(out.data());
+  ASSERT_EQ(header[0], static_cast<int>(out.size()));
+  ASSERT_EQ(header[1], 5);
+  ASSERT_EQ(memcmp(out.data() + 8, packet.data(), packet.size() * sizeof(int)), 0);
+  unsigned crc = 0;
+  memcpy(&crc, out.data() + out.size() - 4, sizeof(crc));
+  ASSERT_EQ(crc, compute_crc32c(out.data(), out.size() - 4));
+}
@@ -43,11 +43,19 @@ void tcp_rpc_conn_send (struct connection *c, raw_message_t *raw, int flags) {
   rwm_union (&c->out, &r);
 }
 
+// The data is contiguous, so the crc is computed over it directly instead of walking through the raw message parts,
+// and the packet is appended to the tail buffer of the connection output, so the small packets share the buffers and the iovec entries.
 void tcp_rpc_conn_send_data (struct connection *c, int len, void *Q) {
+  vkprintf (3, "%s: sending message of size %d to conn fd=%d\n", __func__, len, c->fd);
   assert (!(len & 3));
-  raw_message_t r;
-  assert (rwm_create (&r, Q, len) == len);
-  tcp_rpc_conn_send (c, &r, 0);
+  int H[2];
+  H[0] = len + 12;
+  H[1] = TCP_RPC_DATA(c)->out_packet_num ++;
+  crc32_partial_func_t crc32_partial = TCP_RPC_DATA(c)->custom_crc_partial;
+  unsigned crc32 = ~crc32_partial (Q, len, crc32_partial (H, sizeof (H), -1));
+  assert (rwm_push_data (&c->out, H, sizeof (H)) == sizeof (H));
+  assert (rwm_push_data (&c->out, Q, len) == len);
+  assert (rwm_push_data (&c->out, &crc32, sizeof (crc32)) == sizeof (crc32));
 }
 
 void net_rpc_send_ping (struct connection *c, long long ping_id) {
@@ -1,6 +1,7 @@
 prepend(NET_TESTS_SOURCES ${BASE_DIR}/net/
         net-aes-keys-test.cpp
         net-msg-test.cpp
+        net-tcp-rpc-common-test.cpp
         net-test.cpp
         time-slice-test.cpp)
 
@@ -83,7 +83,7 @@ void init_script_allocator(void *buffer, size_t script_mem_size, size_t oom_hand
   php_assert(!is_malloc_replaced());
 
   CriticalSectionGuard lock;
-  dealer.current_script_resource().init(buffer, script_mem_size, oom_handling_mem_size);
+  dealer.current_script_resource().init(buffer, script_mem_size, oom_handling_mem_size, true);
   script_allocator_enabled = true;
   query_num++;
 }
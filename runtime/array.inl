@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cmath>
 #include <type_traits>
 
 #include "common/algorithms/fastmod.h"
@@ -99,6 +101,98 @@ void sort(T *begin_init, T *end_init, const T1 &compare) {
   }
 }
 
+// for smaller arrays the eight passes of radix sort don't pay off
+constexpr int64_t RADIX_SORT_MIN_SIZE = 4096;
+
+// maps the values to unsigned keys with the same order
+inline uint64_t radix_sort_key(int64_t value) {
+  // flipping the sign bit makes the unsigned order match the signed one
+  return static_cast<uint64_t>(value) ^ (1ULL << 63);
+}
+
+inline uint64_t radix_sort_key(double value) {
+  uint64_t bits = 0;
+  memcpy(&bits, &value, sizeof(bits));
+  // the negative values are ordered backwards by their bits and go before the positive ones
+  return (bits >> 63) ? ~bits : bits | (1ULL << 63);
+}
+
+inline bool radix_sort_is_applicable(int64_t) {
+  return true;
+}
+
+inline bool radix_sort_is_applicable(double value) {
+  // NaN isn't ordered with anything, the order is defined by the comparison sort then
+  return !std::isnan(value);
+}
+
+// LSD radix sort of int64_t or double values, skips the passes where all the values share the same byte;
+// returns false and leaves the values untouched if they can't be sorted this way
+// or if the scratch buffer doesn't fit in the script memory, the comparison sort is used then;
+// the values equal for the comparison sort are identical, except for -0.0 and 0.0 which it leaves in no particular order
+template<class T>
+bool radix_sort(T *begin, T *end, bool descending) {
+  const int64_t n = end - begin;
+  const size_t buffer_size = n * sizeof(T);
+  // the comparison sort doesn't need any memory, so the radix one mustn't bring sort() to OOM
+  const auto &memory_stats = get_script_memory_stats();
+  if (memory_stats.memory_used + 2 * buffer_size > memory_stats.memory_limit) {
+    return false;
+  }
+
+  constexpr int passes = sizeof(T);
+  uint32_t counts[passes][256] = {};
+  for (const T *it = begin; it != end; ++it) {
+    if (!radix_sort_is_applicable(*it)) {
+      return false;
+    }
+    const uint64_t key = radix_sort_key(*it);
+    for (int pass = 0; pass < passes; ++pass) {
+      counts[pass][(key >> (8 * pass)) & 0xFF]++;
+    }
+  }
+
+  auto *buffer = static_cast<T *>(allocate(buffer_size));
+  if (unlikely(!buffer)) {
+    return false;
+  }
+  T *from = begin;
+  T *to = buffer;
+  for (int pass = 0; pass < passes; ++pass) {
+    uint32_t *count = counts[pass];
+    if (static_cast<int64_t>(count[(radix_sort_key(*from) >> (8 * pass)) & 0xFF]) == n) {
+      continue;
+    }
+
+    uint32_t offset = 0;
+    for (int byte = 0; byte < 256; ++byte) {
+      const uint32_t c = count[byte];
+      count[byte] = offset;
+      offset += c;
+    }
+    for (const T *it = from; it != from + n; ++it) {
+      to[count[(radix_sort_key(*it) >> (8 * pass)) & 0xFF]++] = *it;
+    }
+    std::swap(from, to);
+  }
+
+  if (from != begin) {
+    memcpy(begin, from, buffer_size);
+  }
+  deallocate(buffer, buffer_size);
+
+  if (descending) {
+    std::reverse(begin, end);
+  }
+  return true;
+}
+
+// Comparators that define a plain ascending (1) or descending (-1) order on int64_t or double
+// may be replaced with radix sort, see array<T>::sort
+template<class T1>
+struct radix_sort_order : std::integral_constant<int, 0> {
+};
+
 } // namespace dl
 
 template<class T>
@@ -1905,11 +1999,17 @@ void array<T>::sort(const T1 &compare, bool renumber) {
       mutate_if_vector_shared();
     }
 
+    T *begin = reinterpret_cast<T *>(p->int_entries);
+    if constexpr (vk::is_type_in_list<T, int64_t, double>{} && dl::radix_sort_order<T1>::value != 0) {
+      if (n >= dl::RADIX_SORT_MIN_SIZE && dl::radix_sort(begin, begin + n, dl::radix_sort_order<T1>::value < 0)) {
+        return;
+      }
+    }
+
     const auto elements_cmp =
       [&compare](const T &lhs, const T &rhs) {
         return compare(lhs, rhs) > 0;
       };
-    T *begin = reinterpret_cast<T *>(p->int_entries);
     dl::sort<T, decltype(elements_cmp)>(begin, begin + n, elements_cmp);
     return;
   }
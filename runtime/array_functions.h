@@ -1362,6 +1362,26 @@ struct sort_compare_natural {
   }
 };
 
+namespace dl {
+
+template<>
+struct radix_sort_order<sort_compare<int64_t>> : std::integral_constant<int, 1> {
+};
+
+template<>
+struct radix_sort_order<sort_compare<double>> : std::integral_constant<int, 1> {
+};
+
+template<>
+struct radix_sort_order<sort_compare_numeric<int64_t>> : std::integral_constant<int, 1> {
+};
+
+template<>
+struct radix_sort_order<sort_compare_numeric<double>> : std::integral_constant<int, 1> {
+};
+
+} // namespace dl
+
 template<class T>
 void f$sort(array<T> &a, int64_t flag) {
   switch (flag) {
@@ -1404,6 +1424,26 @@ struct rsort_compare_string {
   }
 };
 
+namespace dl {
+
+template<>
+struct radix_sort_order<rsort_compare<int64_t>> : std::integral_constant<int, -1> {
+};
+
+template<>
+struct radix_sort_order<rsort_compare<double>> : std::integral_constant<int, -1> {
+};
+
+template<>
+struct radix_sort_order<rsort_compare_numeric<int64_t>> : std::integral_constant<int, -1> {
+};
+
+template<>
+struct radix_sort_order<rsort_compare_numeric<double>> : std::integral_constant<int, -1> {
+};
+
+} // namespace dl
+
 template<class T>
 void f$rsort(array<T> &a, int64_t flag) {
   switch (flag) {
@@ -34,6 +34,11 @@ public:
     return acquired_sample_->get_confdata();
   }
 
+  const mixed *find_confdata_value(const string &key) const noexcept {
+    php_assert(acquired_sample_);
+    return acquired_sample_->find_value(key);
+  }
+
   bool is_initialized() const noexcept {
     return global_manager_.is_initialized();
   }
@@ -96,16 +101,14 @@ mixed f$confdata_get_value(const string &key) noexcept {
   const auto &local_manager = ConfdataLocalManager::get();
   ConfdataKeyMaker key_maker;
   key_maker.update(key.c_str(), static_cast<int16_t>(key.size()), local_manager.get_predefined_wildcards());
-  const auto &confdata_storage = local_manager.get_confdata_storage();
-  auto it = confdata_storage.find(key_maker.get_first_key());
-  if (it != confdata_storage.end()) {
+  if (const mixed *first_key_value = local_manager.find_confdata_value(key_maker.get_first_key())) {
     // if key doesn't contain prefixes
     if (key_maker.get_first_key_type() == ConfdataFirstKeyType::simple_key) {
-      return it->second;
+      return *first_key_value;
     }
     // it must be an array (we loaded it this way)
-    php_assert(it->second.is_array());
-    if (const auto *value = it->second.as_array().find_value(key_maker.get_second_key())) {
+    php_assert(first_key_value->is_array());
+    if (const auto *value = first_key_value->as_array().find_value(key_maker.get_second_key())) {
       return *value;
     }
   }
@@ -128,14 +131,14 @@ array<mixed> f$confdata_get_values_by_any_wildcard(const string &wildcard) noexc
   // wildcard has a form of '\w+\..*' or '\w+\.\w+\..*' and contains a predefined prefix
   if (key_maker.update(wildcard.c_str(), static_cast<int16_t>(wildcard.size()), predefined_wildcards) != ConfdataFirstKeyType::simple_key) {
     // the first key is '\w+\.' or '\w+\.\w+\.'
-    auto it = confdata_storage.find(key_maker.get_first_key());
-    if (it == confdata_storage.end()) {
+    const mixed *first_key_value = local_manager.find_confdata_value(key_maker.get_first_key());
+    if (!first_key_value) {
       return {};
     }
 
     // it must be an array (we loaded it this way)
-    php_assert(it->second.is_array());
-    const auto &second_key_array = it->second.as_array();
+    php_assert(first_key_value->is_array());
+    const auto &second_key_array = first_key_value->as_array();
 
     // if the second key is an empty string; i.e. the first key is an entire prefix ('\w+\.' or '\w+\.\w+\.' or predefined)
     if (key_maker.get_second_key().is_string() && key_maker.get_second_key().as_string().empty()) {
@@ -203,17 +206,15 @@ array<mixed> f$confdata_get_values_by_predefined_wildcard(const string &wildcard
   }
 
   const auto &local_manager = ConfdataLocalManager::get();
-  const auto &confdata_storage = local_manager.get_confdata_storage();
   const vk::string_view wildcard_view{wildcard.c_str(), wildcard.size()};
   if (local_manager.get_predefined_wildcards().detect_first_key_type(wildcard_view) == ConfdataFirstKeyType::simple_key) {
     php_warning("Trying to get elements by non predefined wildcard '%s'", wildcard.c_str());
     return {};
   }
 
-  const auto elements_it = confdata_storage.find(wildcard);
-  if (elements_it != confdata_storage.end()) {
-    php_assert(elements_it->second.is_array());
-    return elements_it->second.as_array();
+  if (const mixed *elements = local_manager.find_confdata_value(wildcard)) {
+    php_assert(elements->is_array());
+    return elements->as_array();
   }
   return {};
 }
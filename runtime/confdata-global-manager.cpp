@@ -4,7 +4,8 @@
 
 #include "runtime/confdata-global-manager.h"
 
-#include "common/wrappers/memory-utils.h"
+#include "common/huge-pages.h"
+#include "common/kprintf.h"
 #include "runtime/php_assert.h"
 
 namespace {
@@ -32,6 +33,54 @@ void recursively_destroy_confdata_element(mixed &element) noexcept {
 
 } // namespace
 
+bool ConfdataHashIndex::build(const confdata_sample_storage &confdata, memory_resource::unsynchronized_pool_resource &resource) noexcept {
+  php_assert(!entries_);
+  if (confdata.empty()) {
+    return true;
+  }
+  // the load factor is kept under 0.5 to make the probe sequences short
+  size_t capacity = 8;
+  while (capacity < confdata.size() * 2) {
+    capacity <<= 1;
+  }
+  auto *entries = static_cast<Entry *>(resource.allocate0(capacity * sizeof(Entry)));
+  if (!entries) {
+    return false;
+  }
+
+  const size_t mask = capacity - 1;
+  for (const auto &element : confdata) {
+    const int64_t hash = element.first.hash();
+    size_t slot = static_cast<size_t>(hash) & mask;
+    while (entries[slot].element) {
+      slot = (slot + 1) & mask;
+    }
+    entries[slot] = Entry{hash, &element};
+  }
+  entries_ = entries;
+  mask_ = mask;
+  return true;
+}
+
+void ConfdataHashIndex::clear(memory_resource::unsynchronized_pool_resource &resource) noexcept {
+  if (entries_) {
+    resource.deallocate(entries_, (mask_ + 1) * sizeof(Entry));
+    entries_ = nullptr;
+    mask_ = 0;
+  }
+}
+
+const mixed *ConfdataHashIndex::find_value(const string &key) const noexcept {
+  const int64_t hash = key.hash();
+  for (size_t slot = static_cast<size_t>(hash) & mask_; entries_[slot].element; slot = (slot + 1) & mask_) {
+    const Entry &entry = entries_[slot];
+    if (entry.hash == hash && entry.element->first == key) {
+      return &entry.element->second;
+    }
+  }
+  return nullptr;
+}
+
 void ConfdataSample::init(memory_resource::unsynchronized_pool_resource &resource) noexcept {
   php_assert(!resource_);
   php_assert(!confdata_storage_);
@@ -39,15 +88,34 @@ void ConfdataSample::init(memory_resource::unsynchronized_pool_resource &resourc
   auto *mem = resource_->allocate(sizeof(*confdata_storage_));
   php_assert(mem);
   confdata_storage_ = new(mem) confdata_sample_storage{confdata_sample_storage::allocator_type{*resource_}};
+  // the index is shared with the workers as the storage is
+  mem = resource_->allocate(sizeof(*hash_index_));
+  php_assert(mem);
+  hash_index_ = new(mem) ConfdataHashIndex{};
 }
 
 void ConfdataSample::reset(confdata_sample_storage &&new_confdata) noexcept {
   clear();
   *confdata_storage_ = std::move(new_confdata);
+  auto &stats = ConfdataGlobalManager::get().get_hash_index_stats();
+  if (hash_index_->build(*confdata_storage_, *resource_)) {
+    ++stats.built;
+  } else {
+    // without the index the lookups use the ordered map
+    static bool fallback_logged = false;
+    if (!fallback_logged) {
+      kprintf("Can't build confdata hash index for %zu elements, there is not enough confdata memory; the lookups fall back to the map\n",
+              confdata_storage_->size());
+      fallback_logged = true;
+    }
+    ++stats.failed;
+  }
+  stats.bytes = hash_index_->get_memory_usage();
 }
 
 void ConfdataSample::clear() noexcept {
   php_assert(confdata_storage_);
+  hash_index_->clear(*resource_);
   confdata_storage_->clear();
 
   if (garbage_) {
@@ -74,8 +142,11 @@ void ConfdataSample::destroy() noexcept {
     clear();
     confdata_storage_->~map();
     resource_->deallocate(confdata_storage_, sizeof(*confdata_storage_));
+    hash_index_->~ConfdataHashIndex();
+    resource_->deallocate(hash_index_, sizeof(*hash_index_));
 
     confdata_storage_ = nullptr;
+    hash_index_ = nullptr;
     resource_ = nullptr;
   }
 }
@@ -96,7 +167,7 @@ ConfdataGlobalManager &ConfdataGlobalManager::get() noexcept {
 void ConfdataGlobalManager::init(size_t confdata_memory_limit,
                                  std::unordered_set<vk::string_view> &&predefined_wilrdcards,
                                  std::unique_ptr<re2::RE2> &&blacklist_pattern) noexcept {
-  resource_.init(mmap_shared(confdata_memory_limit), confdata_memory_limit);
+  resource_.init(mmap_shared_huge_pages(confdata_memory_limit), confdata_memory_limit);
   confdata_samples_.init(resource_);
   predefined_wildcards_.set_wildcards(std::move(predefined_wilrdcards));
   key_blacklist_.set_blacklist(std::move(blacklist_pattern));
@@ -105,7 +176,7 @@ void ConfdataGlobalManager::init(size_t confdata_memory_limit,
 ConfdataGlobalManager::~ConfdataGlobalManager() noexcept {
   if (confdata_samples_.is_initial_process() && is_initialized()) {
     confdata_samples_.destroy();
-    munmap(resource_.memory_begin(), resource_.get_memory_stats().memory_limit);
+    munmap_huge_pages(resource_.memory_begin(), resource_.get_memory_stats().memory_limit);
     resource_.init(nullptr, 0);
   }
 }
@@ -27,6 +27,42 @@ struct ConfdataGarbageNode {
   ConfdataGarbageDestroyWay destroy_way;
 };
 
+// The open addressing hash index of the confdata sample for the point lookups, the ordered map is kept for the wildcard scans.
+// The entries keep the key hashes, so a probe doesn't touch the keys with the other hashes.
+class ConfdataHashIndex : vk::not_copyable {
+public:
+  // returns false if there is no memory for the index, then it stays empty
+  bool build(const confdata_sample_storage &confdata, memory_resource::unsynchronized_pool_resource &resource) noexcept;
+  void clear(memory_resource::unsynchronized_pool_resource &resource) noexcept;
+
+  bool is_built() const noexcept {
+    return entries_;
+  }
+
+  size_t get_memory_usage() const noexcept {
+    return entries_ ? (mask_ + 1) * sizeof(Entry) : 0;
+  }
+
+  const mixed *find_value(const string &key) const noexcept;
+
+private:
+  struct Entry {
+    int64_t hash;
+    const confdata_sample_storage::value_type *element;
+  };
+
+  Entry *entries_{nullptr};
+  size_t mask_{0};
+};
+
+struct ConfdataHashIndexStats {
+  size_t built{0};
+  // the samples, which lookups fall back to the ordered map, because there was no confdata memory for the index
+  size_t failed{0};
+  // the memory taken by the index of the last sample
+  size_t bytes{0};
+};
+
 class ConfdataSample : vk::not_copyable {
 public:
   void init(memory_resource::unsynchronized_pool_resource &resource) noexcept;
@@ -40,9 +76,18 @@ public:
     return *confdata_storage_;
   }
 
+  const mixed *find_value(const string &key) const noexcept {
+    if (hash_index_->is_built()) {
+      return hash_index_->find_value(key);
+    }
+    const auto it = confdata_storage_->find(key);
+    return it != confdata_storage_->end() ? &it->second : nullptr;
+  }
+
 private:
   memory_resource::unsynchronized_pool_resource *resource_{nullptr};
   confdata_sample_storage *confdata_storage_{nullptr};
+  ConfdataHashIndex *hash_index_{nullptr};
   std::forward_list<ConfdataGarbageNode> *garbage_{nullptr};
 };
 
@@ -100,6 +145,10 @@ public:
     return key_blacklist_;
   }
 
+  ConfdataHashIndexStats &get_hash_index_stats() noexcept {
+    return hash_index_stats_;
+  }
+
   ~ConfdataGlobalManager() noexcept;
 
 private:
@@ -109,4 +158,5 @@ private:
 
   ConfdataPredefinedWildcards predefined_wildcards_;
   ConfdataKeyBlacklist key_blacklist_;
+  ConfdataHashIndexStats hash_index_stats_;
 };
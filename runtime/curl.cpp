@@ -44,6 +44,64 @@ constexpr int64_t BAD_CURL_OPTION = static_cast<int>(CURL_LAST) + static_cast<in
 
 size_t curl_write(char *data, size_t size, size_t nmemb, void *userdata);
 
+// Per worker libcurl share object, it keeps the connection cache, TLS sessions and DNS entries in the heap,
+// so warm keep-alive connections survive curl_close() and the script memory reset.
+// Workers are single threaded, hence no lock callbacks are set.
+class CurlShare : vk::not_copyable {
+public:
+  CURLSH *get_handle() noexcept {
+    if (!share_handle_ && max_connections_ > 0 && !init_failed_) {
+      dl::CriticalSectionGuard critical_section;
+      share_handle_ = curl_share_init();
+      if (share_handle_) {
+#if LIBCURL_VERSION_NUM >= 0x073900
+        curl_share_setopt(share_handle_, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+#endif
+        curl_share_setopt(share_handle_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+        curl_share_setopt(share_handle_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+      } else {
+        init_failed_ = true;
+        php_warning("Could not initialize curl share handle, connections won't be reused between requests");
+      }
+    }
+    return share_handle_;
+  }
+
+  long get_max_connections() const noexcept {
+    return max_connections_;
+  }
+
+  long get_max_idle_time() const noexcept {
+    return max_idle_time_sec_;
+  }
+
+  void set_max_connections(long max_connections) noexcept {
+    max_connections_ = max_connections;
+  }
+
+  void set_max_idle_time(long max_idle_time_sec) noexcept {
+    max_idle_time_sec_ = max_idle_time_sec;
+  }
+
+private:
+  CurlShare() = default;
+
+  CURLSH *share_handle_{nullptr};
+  bool init_failed_{false};
+  long max_connections_{16};
+  long max_idle_time_sec_{60};
+
+  friend class vk::singleton<CurlShare>;
+};
+
+void on_curl_transfer_done(CURL *easy_handle, CURLcode result) noexcept {
+  long new_connections = 0;
+  if (dl::critical_section_call([&] { return curl_easy_getinfo(easy_handle, CURLINFO_NUM_CONNECTS, &new_connections); }) != CURLE_OK) {
+    return;
+  }
+  vk::singleton<CurlConnectionsStats>::get().on_transfer_done(new_connections, result == CURLE_OK);
+}
+
 class BaseContext : vk::not_copyable {
 public:
   int uniq_id{0};
@@ -137,6 +195,14 @@ public:
     set_option(CURLOPT_MAXREDIRS, 20L);
     set_option(CURLOPT_NOSIGNAL, 1L);
     set_option(CURLOPT_PRIVATE, reinterpret_cast<void *>(self_id));
+    auto &share = vk::singleton<CurlShare>::get();
+    if (CURLSH *share_handle = share.get_handle()) {
+      set_option(CURLOPT_SHARE, share_handle);
+      set_option(CURLOPT_MAXCONNECTS, share.get_max_connections());
+#if LIBCURL_VERSION_NUM >= 0x074100
+      set_option(CURLOPT_MAXAGE_CONN, share.get_max_idle_time());
+#endif
+    }
 
     // Always disabled FILE and SCP
     set_option(CURLOPT_PROTOCOLS, static_cast<long>(CURLPROTO_ALL & ~(CURLPROTO_FILE | CURLPROTO_SCP)));
@@ -673,6 +739,7 @@ mixed f$curl_exec(curl_easy easy_id) noexcept {
 
   easy_context->cleanup_for_next_request();
   easy_context->error_num = dl::critical_section_call(curl_easy_perform, easy_context->easy_handle);
+  on_curl_transfer_done(easy_context->easy_handle, static_cast<CURLcode>(easy_context->error_num));
 
   if (easy_context->error_num != CURLE_OK && easy_context->error_num != CURLE_PARTIAL_FILE) {
     if (kphp_tracing::is_turned_on()) {
@@ -905,6 +972,9 @@ Optional<array<int64_t>> f$curl_multi_info_read(curl_multi multi_id, int64_t &ms
       array<int64_t> result{array_size{0, 3, false}};
       result.set_value(string{"msg"}, static_cast<int64_t>(msg->msg));
       result.set_value(string{"result"}, static_cast<int64_t>(msg->data.result));
+      if (msg->msg == CURLMSG_DONE) {
+        on_curl_transfer_done(msg->easy_handle, msg->data.result);
+      }
 
       void *id_as_ptr = nullptr;
       dl::critical_section_call([&] { curl_easy_getinfo (msg->easy_handle, CURLINFO_PRIVATE, &id_as_ptr); });
@@ -968,6 +1038,14 @@ void register_curl_deallocation(size_t memory_used) noexcept {
   vk::singleton<CurlMemoryUsage>::get().currently_allocated -= memory_used;
 }
 
+void set_curl_share_max_connections(int64_t max_connections) noexcept {
+  vk::singleton<CurlShare>::get().set_max_connections(static_cast<long>(max_connections));
+}
+
+void set_curl_share_max_idle_time(int64_t max_idle_time_sec) noexcept {
+  vk::singleton<CurlShare>::get().set_max_idle_time(static_cast<long>(max_idle_time_sec));
+}
+
 void global_init_curl_lib() noexcept {
   if (curl_global_init_mem(
     CURL_GLOBAL_ALL,
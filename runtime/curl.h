@@ -57,6 +57,11 @@ Optional<string> f$curl_multi_strerror(int64_t error_num) noexcept;
 void global_init_curl_lib() noexcept;
 void free_curl_lib() noexcept;
 
+// connections are kept between requests in the per worker share while there are no more than max_connections of them, 0 disables the sharing
+void set_curl_share_max_connections(int64_t max_connections) noexcept;
+// connections which were idle for longer are closed instead of being reused
+void set_curl_share_max_idle_time(int64_t max_idle_time_sec) noexcept;
+
 struct CurlMemoryUsage : vk::not_copyable {
 public:
   size_t currently_allocated{0};
@@ -68,6 +73,28 @@ private:
   friend class vk::singleton<CurlMemoryUsage>;
 };
 
+struct CurlConnectionsStats : vk::not_copyable {
+public:
+  uint64_t transfers{0};
+  uint64_t new_connections{0};
+  uint64_t reused_connections{0};
+
+  // a failed transfer without the new connections might not get to the connection at all, so it isn't counted as reused
+  void on_transfer_done(long transfer_new_connections, bool succeeded) noexcept {
+    ++transfers;
+    if (transfer_new_connections > 0) {
+      new_connections += transfer_new_connections;
+    } else if (succeeded) {
+      ++reused_connections;
+    }
+  }
+
+private:
+  CurlConnectionsStats() = default;
+
+  friend class vk::singleton<CurlConnectionsStats>;
+};
+
 namespace curl_async {
 
 class CurlRequest {
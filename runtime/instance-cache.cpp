@@ -4,20 +4,37 @@
 
 #include "runtime/instance-cache.h"
 
+#include <array>
+#include <atomic>
+#include <cerrno>
 #include <chrono>
-#include <forward_list>
-#include <map>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
 #include <mutex>
+#include <string>
+#include <string_view>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <unordered_map>
 #include <unordered_set>
 
+#include "common/cacheline.h"
+#include "common/crc32.h"
+#include "common/huge-pages.h"
 #include "common/kprintf.h"
+#include "common/precise-time.h"
 #include "common/wrappers/memory-utils.h"
 
 #include "runtime/allocator.h"
 #include "runtime/critical_section.h"
 #include "runtime/inter-process-mutex.h"
 #include "runtime/inter-process-resource.h"
-#include "runtime/memory_resource/resource_allocator.h"
+#include "runtime/memory_resource/unsynchronized_pool_resource.h"
+#include "runtime/msgpack/unpack_exception.h"
+#include "runtime/msgpack/unpacker.h"
 #include "runtime/refcountable_php_classes.h"
 
 namespace impl_ {
@@ -35,6 +52,10 @@ inline void ic_debug(const char *, ...) {}
 static constexpr size_t DEFAULT_MEMORY_LIMIT{256u * 1024u * 1024u};
 // Buffer memory consumption threshold that states at which point we'll swap it
 static constexpr double REAL_MEMORY_USED_THRESHOLD{0.9};
+// Default buffer memory usage threshold that states at which point we'll start evicting cold elements
+static constexpr double DEFAULT_EVICTION_THRESHOLD{0.75};
+// The eviction frees memory until its usage is this much lower than the eviction threshold
+static constexpr double EVICTION_HYSTERESIS{0.05};
 // Elements that lived less than this ratio to the expected lifetime will not be overwritten
 static constexpr double FRESHNESS_ELEMENT_RATIO{0.2};
 // For the element that lived more than this ratio to the expected lifetime,
@@ -48,8 +69,67 @@ static constexpr std::chrono::minutes PHYSICAL_REMOVING_DELAY{1};
 static constexpr size_t DATA_SHARDS_COUNT{997u};
 // The buckets check step during the cache cleanup
 static constexpr size_t SHARDS_PURGE_PERIOD{5u};
+// Initial number of slots in the shard index
+static constexpr uint32_t SHARD_INDEX_MIN_CAPACITY{8u};
+// Default interval between the snapshots of the cache
+static constexpr double DEFAULT_SNAPSHOT_PERIOD_SEC{300.0};
+// The snapshot is written step by step in the master cron, a step doesn't take longer than this
+static constexpr double SNAPSHOT_STEP_DURATION_SEC{0.02};
+
+// Epoch based memory reclamation for the lock free readers of the shared memory.
+// A reader announces the current epoch in its own slot for the time of the lookup,
+// and the memory retired at the epoch E is freed only when there are no readers announced E or less.
+// It is allocated once in the master process and shared between all cache resources.
+class ReclamationEpochs : vk::not_copyable {
+public:
+  void enter() noexcept {
+    get_reader_epoch().store(current_epoch_.load(std::memory_order_relaxed), std::memory_order_seq_cst);
+    // the following acquire loads of the index may be reordered before the store above (even a seq_cst one),
+    // then the reclaimer could miss this reader and free the index or elements it has just loaded;
+    // the fence pairs with the one in min_active_epoch()
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+  }
+
+  void leave() noexcept {
+    get_reader_epoch().store(0, std::memory_order_release);
+  }
+
+  // returns the epoch which the memory retired before this call belongs to
+  uint64_t advance() noexcept {
+    return current_epoch_.fetch_add(1, std::memory_order_seq_cst);
+  }
+
+  uint64_t min_active_epoch() const noexcept {
+    // the garbage is unlinked before this point, so a reader either has already announced its epoch or can't see the garbage
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    uint64_t min_epoch = std::numeric_limits<uint64_t>::max();
+    const auto workers_count = vk::singleton<WorkersControl>::get().get_total_workers_count();
+    for (size_t i = 0; i != workers_count; ++i) {
+      if (const uint64_t epoch = readers_[i].epoch.load(std::memory_order_seq_cst)) {
+        min_epoch = std::min(min_epoch, epoch);
+      }
+    }
+    return min_epoch;
+  }
+
+private:
+  std::atomic<uint64_t> &get_reader_epoch() noexcept {
+    php_assert(logname_id >= 0 && logname_id < WorkersControl::max_workers_count);
+    return readers_[logname_id].epoch;
+  }
+
+  struct alignas(KDB_CACHELINE_SIZE) ReaderEpoch {
+    std::atomic<uint64_t> epoch{0};
+  };
+
+  std::atomic<uint64_t> current_epoch_{1};
+  std::array<ReaderEpoch, WorkersControl::max_workers_count> readers_;
+};
+
+static ReclamationEpochs *reclamation_epochs{nullptr};
 
 class ElementHolder;
+class ElementIndex;
 
 struct CacheContext : private vk::not_copyable {
   inter_process_mutex allocator_mutex;
@@ -58,11 +138,21 @@ struct CacheContext : private vk::not_copyable {
   std::atomic<bool> memory_swap_required{false};
 
   void move_to_garbage(ElementHolder *element) noexcept;
-  bool has_garbage() const noexcept { return cache_garbage_ != nullptr; }
+  // should be called under the allocator_mutex
+  void retire_index(ElementIndex *index) noexcept;
+  bool has_garbage() const noexcept {
+    return cache_garbage_.load(std::memory_order_relaxed) != nullptr ||
+           retired_elements_.load(std::memory_order_relaxed) != nullptr ||
+           retired_indices_.load(std::memory_order_relaxed) != nullptr;
+  }
+  // should be called under the allocator_mutex
   void clear_garbage() noexcept;
 
 private:
   std::atomic<ElementHolder *> cache_garbage_{nullptr};
+  // the garbage which may still be seen by the lock free readers, it is freed when they leave
+  std::atomic<ElementHolder *> retired_elements_{nullptr};
+  std::atomic<ElementIndex *> retired_indices_{nullptr};
 };
 
 class ElementHolder : private vk::thread_safe_refcnt<ElementHolder> {
@@ -70,6 +160,22 @@ public:
   using vk::thread_safe_refcnt<ElementHolder>::add_ref;
   using vk::thread_safe_refcnt<ElementHolder>::get_refcnt;
 
+  struct TimePoints {
+    std::chrono::nanoseconds stored_at{std::chrono::nanoseconds::min()};
+    std::chrono::nanoseconds expiring_at{std::chrono::nanoseconds::max()};
+  };
+
+  // a lock free reader may find an element which is being removed, so the reference is taken only if it is still alive
+  bool try_add_ref() noexcept {
+    size_t current = refcnt.load(std::memory_order_relaxed);
+    do {
+      if (current == 0) {
+        return false;
+      }
+    } while (!refcnt.compare_exchange_weak(current, current + 1));
+    return true;
+  }
+
   void release() noexcept {
     if (--refcnt == 0) {
       cache_context.move_to_garbage(this);
@@ -79,14 +185,16 @@ public:
   void destroy() noexcept {
     php_assert(refcnt == 0);
     cache_context.stats.elements_destroyed.fetch_add(1, std::memory_order_relaxed);
+    InstanceDeepDestroyVisitor{ExtraRefCnt::for_instance_cache}.process(key);
     auto &mem_resource = cache_context.memory_resource;
     this->~ElementHolder();
     mem_resource.deallocate(this, sizeof(ElementHolder));
   }
 
-  ElementHolder(std::chrono::nanoseconds now, int64_t ttl,
+  ElementHolder(string &&key_in_shared_memory, std::chrono::nanoseconds now, int64_t ttl,
                 std::unique_ptr<InstanceCopyistBase> &&instance,
                 CacheContext &context) noexcept:
+    key(std::move(key_in_shared_memory)),
     inserted_by_process(getpid()),
     instance_wrapper(std::move(instance)),
     cache_context(context) {
@@ -94,29 +202,62 @@ public:
     cache_context.stats.elements_created.fetch_add(1, std::memory_order_relaxed);
   }
 
+  // CLOCK reference bit, which is set by fetch and cleared by the eviction hand
+  void mark_recently_used() noexcept {
+    // don't dirty the cache line if the bit is already set
+    if (!recently_used_.load(std::memory_order_relaxed)) {
+      recently_used_.store(true, std::memory_order_relaxed);
+    }
+  }
+
+  bool test_and_clear_recently_used() noexcept {
+    return recently_used_.exchange(false, std::memory_order_relaxed);
+  }
+
   // returns how long the element is lived in relation to the expected lifetime
   double freshness_ratio(std::chrono::nanoseconds now, double immortal_ratio = 0.5) const noexcept {
+    const TimePoints time_points = load_time_points();
     // an immortal element
-    if (expiring_at == std::chrono::nanoseconds::max()) {
+    if (time_points.expiring_at == std::chrono::nanoseconds::max()) {
       return immortal_ratio;
     }
-    if (expiring_at <= stored_at) {
+    if (time_points.expiring_at <= time_points.stored_at) {
       return 1.0;
     }
-    const auto real_age = std::chrono::duration<double>{std::max(now, stored_at) - stored_at};
-    const auto max_age = std::chrono::duration<double>{expiring_at - stored_at};
+    const auto real_age = std::chrono::duration<double>{std::max(now, time_points.stored_at) - time_points.stored_at};
+    const auto max_age = std::chrono::duration<double>{time_points.expiring_at - time_points.stored_at};
     return real_age.count() / max_age.count();
   }
 
+  // time points are read without the storage_mutex, the seqlock guarantees a consistent snapshot
+  TimePoints load_time_points() const noexcept {
+    while (true) {
+      const uint32_t version = time_points_version_.load(std::memory_order_acquire);
+      if (version & 1) {
+        continue;
+      }
+      const TimePoints time_points{stored_at_.load(std::memory_order_relaxed), expiring_at_.load(std::memory_order_relaxed)};
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (time_points_version_.load(std::memory_order_relaxed) == version) {
+        return time_points;
+      }
+    }
+  }
+
+  // should be called under the storage_mutex
   void update_time_points(std::chrono::nanoseconds now, int64_t ttl) noexcept {
-    stored_at = std::max(now, stored_at);
-    expiring_at = ttl > 0 ? stored_at + std::chrono::seconds{ttl} : std::chrono::nanoseconds::max();
+    const auto stored_at = std::max(now, stored_at_.load(std::memory_order_relaxed));
+    store_time_points(TimePoints{stored_at, ttl > 0 ? stored_at + std::chrono::seconds{ttl} : std::chrono::nanoseconds::max()});
     early_fetch_performed = false;
   }
 
-  std::chrono::nanoseconds stored_at{std::chrono::nanoseconds::min()};
-  std::chrono::nanoseconds expiring_at{std::chrono::nanoseconds::max()};
-  bool early_fetch_performed{false};
+  // should be called under the storage_mutex
+  void update_expiring_at(std::chrono::nanoseconds expiring_at) noexcept {
+    store_time_points(TimePoints{stored_at_.load(std::memory_order_relaxed), expiring_at});
+  }
+
+  string key;
+  std::atomic<bool> early_fetch_performed{false};
   const pid_t inserted_by_process{0};
 
   std::unique_ptr<InstanceCopyistBase> instance_wrapper;
@@ -124,17 +265,199 @@ public:
 
   // Removed elements list
   std::atomic<ElementHolder *> next_in_garbage_list{nullptr};
+  uint64_t retired_at_epoch{0};
+
+private:
+  void store_time_points(const TimePoints &time_points) noexcept {
+    const uint32_t version = time_points_version_.load(std::memory_order_relaxed);
+    time_points_version_.store(version + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    stored_at_.store(time_points.stored_at, std::memory_order_relaxed);
+    expiring_at_.store(time_points.expiring_at, std::memory_order_relaxed);
+    time_points_version_.store(version + 2, std::memory_order_release);
+  }
+
+  std::atomic<bool> recently_used_{true};
+  std::atomic<uint32_t> time_points_version_{0};
+  std::atomic<std::chrono::nanoseconds> stored_at_{std::chrono::nanoseconds::min()};
+  std::atomic<std::chrono::nanoseconds> expiring_at_{std::chrono::nanoseconds::max()};
 };
 
-using ElementStorage_ = memory_resource::stl::map<string, vk::intrusive_ptr<ElementHolder>, memory_resource::unsynchronized_pool_resource, stl_string_less>;
+// Open addressing hash index of the shard elements, each slot keeps a reference to the element.
+// Lookups are lock free: a slot never becomes empty again, the removed elements are replaced with the tombstone,
+// and the index is rebuilt in a new memory when it runs out of empty slots.
+// All modifications are under the storage_mutex, the index rebuilding additionally requires the allocator_mutex.
+class ElementIndex : vk::not_copyable {
+public:
+  struct Slot {
+    std::atomic<uint64_t> hash{0};
+    std::atomic<ElementHolder *> element{nullptr};
+  };
 
-struct SharedDataStorages : private vk::not_copyable {
-  explicit SharedDataStorages(memory_resource::unsynchronized_pool_resource &resource) :
-    storage(ElementStorage_::allocator_type{resource}) {
+  static ElementIndex *create(void *mem, uint32_t capacity) noexcept {
+    php_assert(capacity && !(capacity & (capacity - 1)));
+    auto *index = new(mem) ElementIndex{capacity};
+    for (uint32_t i = 0; i != capacity; ++i) {
+      new(&index->slots()[i]) Slot{};
+    }
+    return index;
+  }
+
+  static size_t memory_size(uint32_t capacity) noexcept {
+    return sizeof(ElementIndex) + sizeof(Slot) * capacity;
+  }
+
+  static uint32_t capacity_for(uint32_t elements) noexcept {
+    uint32_t capacity = SHARD_INDEX_MIN_CAPACITY;
+    while (capacity < elements * 2) {
+      capacity *= 2;
+    }
+    return capacity;
+  }
+
+  // lock free, the caller should be inside of the reclamation epoch until it takes the reference to the element
+  ElementHolder *find(const string &key, uint64_t hash) const noexcept {
+    const uint32_t mask = capacity_ - 1;
+    for (uint32_t i = hash & mask, probes = 0; probes != capacity_; i = (i + 1) & mask, ++probes) {
+      const Slot &slot = slots()[i];
+      ElementHolder *element = slot.element.load(std::memory_order_acquire);
+      if (!element) {
+        return nullptr;
+      }
+      if (element != tombstone() && slot.hash.load(std::memory_order_relaxed) == hash && element->key == key) {
+        return element;
+      }
+    }
+    return nullptr;
+  }
+
+  // should be called under the storage_mutex
+  Slot *find_slot(const string &key, uint64_t hash) noexcept {
+    const uint32_t mask = capacity_ - 1;
+    for (uint32_t i = hash & mask, probes = 0; probes != capacity_; i = (i + 1) & mask, ++probes) {
+      Slot &slot = slots()[i];
+      ElementHolder *element = slot.element.load(std::memory_order_relaxed);
+      if (!element) {
+        return nullptr;
+      }
+      if (element != tombstone() && slot.hash.load(std::memory_order_relaxed) == hash && element->key == key) {
+        return &slot;
+      }
+    }
+    return nullptr;
+  }
+
+  bool can_insert() const noexcept {
+    return (used_ + 1) * 4 <= capacity_ * 3;
+  }
+
+  // should be called under the storage_mutex, the key must be absent; takes over the reference to the element
+  void insert(uint64_t hash, ElementHolder *element) noexcept {
+    php_assert(can_insert());
+    const uint32_t mask = capacity_ - 1;
+    for (uint32_t i = hash & mask;; i = (i + 1) & mask) {
+      Slot &slot = slots()[i];
+      ElementHolder *slot_element = slot.element.load(std::memory_order_relaxed);
+      if (!slot_element || slot_element == tombstone()) {
+        used_ += slot_element ? 0 : 1;
+        ++size_;
+        // the hash is published with the element
+        slot.hash.store(hash, std::memory_order_relaxed);
+        slot.element.store(element, std::memory_order_release);
+        return;
+      }
+    }
+  }
+
+  // should be called under the storage_mutex; the references to the removed elements are released
+  template<class F>
+  void remove_if(const F &should_be_removed) noexcept {
+    for_each_slot([this, &should_be_removed](Slot &slot, ElementHolder *element) {
+      if (should_be_removed(*element)) {
+        slot.element.store(tombstone(), std::memory_order_release);
+        --size_;
+        element->release();
+      }
+    });
+  }
+
+  // should be called under the storage_mutex
+  template<class F>
+  void for_each(const F &callback) noexcept {
+    for_each_slot([&callback](Slot &, ElementHolder *element) {
+      callback(*element);
+    });
+  }
+
+  // should be called under the storage_mutex
+  template<class F>
+  bool any_of(const F &predicate) noexcept {
+    bool found = false;
+    for_each_slot([&found, &predicate](Slot &, ElementHolder *element) {
+      found = found || predicate(*element);
+    });
+    return found;
+  }
+
+  // should be called under the storage_mutex, moves the elements with their references into the empty index
+  void move_to(ElementIndex &other) noexcept {
+    for_each_slot([&other](Slot &slot, ElementHolder *element) {
+      other.insert(slot.hash.load(std::memory_order_relaxed), element);
+    });
   }
 
+  uint32_t size() const noexcept {
+    return size_;
+  }
+
+  uint32_t capacity() const noexcept {
+    return capacity_;
+  }
+
+  // Retired indices list
+  ElementIndex *next_retired{nullptr};
+  uint64_t retired_at_epoch{0};
+
+private:
+  explicit ElementIndex(uint32_t capacity) noexcept:
+    capacity_(capacity) {
+  }
+
+  template<class F>
+  void for_each_slot(const F &callback) noexcept {
+    for (uint32_t i = 0; i != capacity_; ++i) {
+      Slot &slot = slots()[i];
+      ElementHolder *element = slot.element.load(std::memory_order_relaxed);
+      if (element && element != tombstone()) {
+        callback(slot, element);
+      }
+    }
+  }
+
+  static ElementHolder *tombstone() noexcept {
+    return reinterpret_cast<ElementHolder *>(alignof(ElementHolder));
+  }
+
+  Slot *slots() noexcept {
+    return reinterpret_cast<Slot *>(this + 1);
+  }
+
+  const Slot *slots() const noexcept {
+    return reinterpret_cast<const Slot *>(this + 1);
+  }
+
+  const uint32_t capacity_{0};
+  // number of the elements
+  uint32_t size_{0};
+  // number of the elements and tombstones
+  uint32_t used_{0};
+};
+
+static_assert(sizeof(ElementIndex) % alignof(ElementIndex::Slot) == 0, "slots are placed right after the index");
+
+struct SharedDataStorages : private vk::not_copyable {
   inter_process_mutex storage_mutex;
-  ElementStorage_ storage;
+  std::atomic<ElementIndex *> index{nullptr};
   std::atomic<bool> is_storage_empty{true};
 };
 
@@ -147,14 +470,57 @@ void CacheContext::move_to_garbage(ElementHolder *element) noexcept {
   } while (!cache_garbage_.compare_exchange_strong(next, element));
 }
 
+void CacheContext::retire_index(ElementIndex *index) noexcept {
+  index->retired_at_epoch = reclamation_epochs->advance();
+  index->next_retired = retired_indices_.load(std::memory_order_relaxed);
+  retired_indices_.store(index, std::memory_order_relaxed);
+}
+
 void CacheContext::clear_garbage() noexcept {
   auto *element = cache_garbage_.exchange(nullptr);
+  // the garbage elements are already removed from the indices,
+  // so only the readers that have entered before this point may still see them
+  if (element) {
+    const uint64_t epoch = reclamation_epochs->advance();
+    auto *retired = retired_elements_.load(std::memory_order_relaxed);
+    while (element) {
+      auto *next = element->next_in_garbage_list.load();
+      element->retired_at_epoch = epoch;
+      element->next_in_garbage_list.store(retired);
+      retired = element;
+      element = next;
+    }
+    retired_elements_.store(retired, std::memory_order_relaxed);
+  }
 
-  while (element) {
+  const uint64_t min_active_epoch = reclamation_epochs->min_active_epoch();
+  ElementHolder *still_retired_elements = nullptr;
+  for (element = retired_elements_.load(std::memory_order_relaxed); element;) {
     auto *next = element->next_in_garbage_list.load();
-    element->destroy();
+    if (element->retired_at_epoch < min_active_epoch) {
+      element->destroy();
+    } else {
+      element->next_in_garbage_list.store(still_retired_elements);
+      still_retired_elements = element;
+    }
     element = next;
   }
+  retired_elements_.store(still_retired_elements, std::memory_order_relaxed);
+
+  ElementIndex *still_retired_indices = nullptr;
+  for (auto *index = retired_indices_.load(std::memory_order_relaxed); index;) {
+    auto *next = index->next_retired;
+    if (index->retired_at_epoch < min_active_epoch) {
+      const size_t index_size = ElementIndex::memory_size(index->capacity());
+      index->~ElementIndex();
+      memory_resource.deallocate(index, index_size);
+    } else {
+      index->next_retired = still_retired_indices;
+      still_retired_indices = index;
+    }
+    index = next;
+  }
+  retired_indices_.store(still_retired_indices, std::memory_order_relaxed);
 }
 
 class SharedMemoryData : vk::not_copyable {
@@ -165,7 +531,7 @@ public:
     php_assert(!shared_memory_);
     shared_memory_pool_size_ = pool_size;
     share_memory_full_size_ = get_context_size() + get_data_size() + shared_memory_pool_size_;
-    shared_memory_ = mmap_shared(share_memory_full_size_);
+    shared_memory_ = mmap_shared_huge_pages(share_memory_full_size_);
     construct_data_inplace();
   }
 
@@ -216,7 +582,7 @@ private:
     cache_context_->memory_resource.init(data_storage_mem + get_data_size(), shared_memory_pool_size_);
     data_shards_ = reinterpret_cast<SharedDataStorages *>(data_storage_mem);
     for (size_t i = 0; i != DATA_SHARDS_COUNT; ++i) {
-      new(&data_shards_[i]) SharedDataStorages{cache_context_->memory_resource};
+      new(&data_shards_[i]) SharedDataStorages{};
     }
   }
 
@@ -235,10 +601,74 @@ private:
   SharedDataStorages *data_shards_{nullptr};
 };
 
+// the memory freed by purging and eviction is split into small pieces, which aren't taken into account until they are merged;
+// it is called under the allocator_mutex
+bool defragment_on_oom(memory_resource::unsynchronized_pool_resource &resource, size_t size) noexcept {
+  resource.perform_defragmentation();
+  return resource.is_enough_memory_for(size);
+}
+
 struct {
   size_t total_memory_limit{DEFAULT_MEMORY_LIMIT};
+  double eviction_threshold{DEFAULT_EVICTION_THRESHOLD};
+  std::string snapshot_path;
+  double snapshot_period_sec{DEFAULT_SNAPSHOT_PERIOD_SEC};
 } static instance_cache_settings;
 
+struct SnapshotClass {
+  uint64_t layout_hash{0};
+  InstanceCacheSnapshotPack pack{nullptr};
+  InstanceCacheSnapshotUnpack unpack{nullptr};
+};
+
+// the classes are registered during the static initialization, the key is typeid(InstanceCopyistImpl<T>).name()
+std::unordered_map<std::string_view, SnapshotClass> &get_snapshot_classes() noexcept {
+  static std::unordered_map<std::string_view, SnapshotClass> snapshot_classes;
+  return snapshot_classes;
+}
+
+// The snapshot file layout:
+//  header: SnapshotHeader
+//  records: uint32 size + msgpack array [key, type_name, layout_hash, stored_at_ns, expiring_at_ns, instance]
+//  trailer: uint32 zero + SnapshotTrailer, crc32 covers all the records
+struct SnapshotHeader {
+  char magic[8]{'K', 'P', 'H', 'P', 'I', 'C', 'S', '\0'};
+  uint32_t version{1};
+  uint32_t reserved{0};
+};
+
+struct SnapshotTrailer {
+  uint64_t records{0};
+  uint32_t crc32{0};
+  uint32_t reserved{0};
+};
+
+static constexpr size_t SNAPSHOT_RECORD_FIELDS{6};
+
+// the result of the written snapshot file sync and rename, which the helper process sends to the master through the pipe
+struct SnapshotFinishingResult {
+  enum class Action : int32_t { none, write, rename, finish };
+
+  int32_t error{0};
+  Action failed_action{Action::none};
+
+  static const char *action_name(Action action) noexcept {
+    switch (action) {
+      case Action::write:
+        return "write";
+      case Action::rename:
+        return "rename";
+      default:
+        return "finish";
+    }
+  }
+};
+
+bool is_valid_snapshot_header(const SnapshotHeader &header) noexcept {
+  const SnapshotHeader expected;
+  return std::memcmp(header.magic, expected.magic, sizeof(expected.magic)) == 0 && header.version == expected.version;
+}
+
 class InstanceCache {
 private:
   InstanceCache() :
@@ -253,6 +683,7 @@ public:
 
   void global_init() {
     php_assert(!current_ && !context_);
+    reclamation_epochs = new(mmap_shared(sizeof(ReclamationEpochs))) ReclamationEpochs{};
     data_manager_.init(instance_cache_settings.total_memory_limit);
   }
 
@@ -276,6 +707,8 @@ public:
     request_cache_.clear();
     // used_elements use a heap memory
     used_elements_.clear();
+    // the request could be interrupted inside of the lookup
+    reclamation_epochs->leave();
 
     if (context_->has_garbage()) {
       std::unique_lock<inter_process_mutex> allocator_lock{context_->allocator_mutex, std::try_to_lock};
@@ -304,7 +737,7 @@ public:
       return false;
     }
 
-    InstanceDeepCopyVisitor detach_processor{context_->memory_resource, ExtraRefCnt::for_instance_cache};
+    InstanceDeepCopyVisitor detach_processor{context_->memory_resource, ExtraRefCnt::for_instance_cache, defragment_on_oom};
     const ElementHolder *inserted_element = try_insert_element_into_cache(
       data, key, ttl, instance_wrapper, detach_processor);
 
@@ -343,45 +776,37 @@ public:
       return (*cached_element_ptr)->instance_wrapper.get();
     }
 
-    vk::intrusive_ptr<ElementHolder> element;
-    bool element_logically_expired = false;
-    {
-      auto &data = current_->get_data(key);
-      std::lock_guard<inter_process_mutex> shared_data_lock{data.storage_mutex};
-      auto it = data.storage.find(key);
-      if (it == data.storage.end()) {
-        ic_debug("can't fetch '%s' because it is absent\n", key.c_str());
-        context_->stats.elements_missed.fetch_add(1, std::memory_order_relaxed);
-        return nullptr;
-      }
+    vk::intrusive_ptr<ElementHolder> element = acquire_element(current_->get_data(key), key);
+    if (!element) {
+      ic_debug("can't fetch '%s' because it is absent\n", key.c_str());
+      context_->stats.elements_missed.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    element->mark_recently_used();
 
-      update_now();
-      // if more than EARLY_EXPIRATION_ELEMENT_RATIO time is passed out of the expected element lifetime,
-      // return null to the next worker process so it knows that the value needs to be updated in advance
-      if (!it->second->early_fetch_performed &&
-          it->second->freshness_ratio(now_) >= EARLY_EXPIRATION_ELEMENT_RATIO) {
-        it->second->early_fetch_performed = true;
-        context_->stats.elements_missed_earlier.fetch_add(1, std::memory_order_relaxed);
-        ic_debug("can't fetch '%s' because less than %f of total time is left\n",
-                 key.c_str(), EARLY_EXPIRATION_ELEMENT_RATIO);
-        return nullptr;
-      }
-      element_logically_expired = it->second->expiring_at <= now_;
-      if (element_logically_expired) {
-        if (even_if_expired) {
-          context_->stats.elements_logically_expired_but_fetched.fetch_add(1, std::memory_order_relaxed);
-          ic_debug("fetch logically expired element '%s'\n", key.c_str());
-        } else {
-          context_->stats.elements_logically_expired_and_ignored.fetch_add(1, std::memory_order_relaxed);
-          ic_debug("can't fetch '%s' because element was logically expired\n", key.c_str());
-          return nullptr;
-        }
+    update_now();
+    // if more than EARLY_EXPIRATION_ELEMENT_RATIO time is passed out of the expected element lifetime,
+    // return null to the next worker process so it knows that the value needs to be updated in advance
+    if (element->freshness_ratio(now_) >= EARLY_EXPIRATION_ELEMENT_RATIO &&
+        !element->early_fetch_performed.exchange(true)) {
+      context_->stats.elements_missed_earlier.fetch_add(1, std::memory_order_relaxed);
+      ic_debug("can't fetch '%s' because less than %f of total time is left\n",
+               key.c_str(), EARLY_EXPIRATION_ELEMENT_RATIO);
+      return nullptr;
+    }
+    const bool element_logically_expired = element->load_time_points().expiring_at <= now_;
+    if (element_logically_expired) {
+      if (even_if_expired) {
+        context_->stats.elements_logically_expired_but_fetched.fetch_add(1, std::memory_order_relaxed);
+        ic_debug("fetch logically expired element '%s'\n", key.c_str());
       } else {
-        context_->stats.elements_fetched.fetch_add(1, std::memory_order_relaxed);
-        ic_debug("fetch '%s' from inter process cache\n", key.c_str());
+        context_->stats.elements_logically_expired_and_ignored.fetch_add(1, std::memory_order_relaxed);
+        ic_debug("can't fetch '%s' because element was logically expired\n", key.c_str());
+        return nullptr;
       }
-
-      element = it->second;
+    } else {
+      context_->stats.elements_fetched.fetch_add(1, std::memory_order_relaxed);
+      ic_debug("fetch '%s' from inter process cache\n", key.c_str());
     }
 
     // don't cache logically expired elements
@@ -410,12 +835,12 @@ public:
     auto &data = current_->get_data(key);
     update_now();
     std::lock_guard<inter_process_mutex> shared_data_lock{data.storage_mutex};
-    auto it = data.storage.find(key);
-    if (it == data.storage.end()) {
+    ElementHolder *element = find_element_locked(data, key);
+    if (!element) {
       return false;
     }
 
-    it->second->update_time_points(now_, ttl);
+    element->update_time_points(now_, ttl);
     return true;
   }
 
@@ -429,22 +854,25 @@ public:
     auto &data = current_->get_data(key);
     update_now();
     std::lock_guard<inter_process_mutex> shared_data_lock{data.storage_mutex};
-    auto it = data.storage.find(key);
-    if (it == data.storage.end()) {
+    ElementHolder *element = find_element_locked(data, key);
+    if (!element) {
       return false;
     }
 
     // calculate expiring_at in a way that the next fetch returns false
     constexpr double SCALE = 1.0 / EARLY_EXPIRATION_ELEMENT_RATIO;
-    auto new_element_ttl = std::chrono::duration_cast<std::chrono::nanoseconds>((now_ - it->second->stored_at) * SCALE);
-    auto new_expiring_at = std::chrono::duration_cast<std::chrono::nanoseconds>(it->second->stored_at + new_element_ttl);
+    const auto stored_at = element->load_time_points().stored_at;
+    auto new_element_ttl = std::chrono::duration_cast<std::chrono::nanoseconds>((now_ - stored_at) * SCALE);
+    auto new_expiring_at = std::chrono::duration_cast<std::chrono::nanoseconds>(stored_at + new_element_ttl);
     new_expiring_at = std::min(new_expiring_at, now_ + DELETED_ELEMENT_LIFETIME_LIMIT);
-    it->second->expiring_at = std::max(new_expiring_at, it->second->stored_at);
+    element->update_expiring_at(std::max(new_expiring_at, stored_at));
     return true;
   }
 
   void force_release_all_resources() {
     data_manager_.force_release_all_resources();
+    // the previous process with the same id could die inside of the lookup
+    reclamation_epochs->leave();
   }
 
   // this function should be called only from master
@@ -466,12 +894,13 @@ public:
       if (data_shard.is_storage_empty.load(std::memory_order_relaxed)) {
         continue;
       }
+      const auto is_expired = [now_with_delay](const ElementHolder &element) {
+        return element.load_time_points().expiring_at <= now_with_delay;
+      };
       {
         std::lock_guard<inter_process_mutex> shared_data_lock{data_shard.storage_mutex};
-        if (std::none_of(data_shard.storage.begin(), data_shard.storage.end(),
-                         [now_with_delay](const auto &stored_element) {
-                           return stored_element.second->expiring_at <= now_with_delay;
-                         })) {
+        ElementIndex *index = data_shard.index.load(std::memory_order_relaxed);
+        if (!index || !index->any_of(is_expired)) {
           continue;
         }
       }
@@ -479,19 +908,22 @@ public:
       // lock in this very order and do not move allocator_lock anywhere below, otherwise it will result in a deadlock!
       std::lock_guard<inter_process_mutex> allocator_lock{context.allocator_mutex};
       std::lock_guard<inter_process_mutex> shared_data_lock{data_shard.storage_mutex};
-      for (auto it = data_shard.storage.begin(); it != data_shard.storage.end();) {
-        if (it->second->expiring_at <= now_with_delay) {
-          ic_debug("purge '%s'\n", it->first.c_str());
-          string removing_key = it->first;
-          it = data_shard.storage.erase(it);
-          InstanceDeepDestroyVisitor{ExtraRefCnt::for_instance_cache}.process(removing_key);
-          context.stats.elements_expired.fetch_add(1, std::memory_order_relaxed);
-          context.stats.elements_cached.fetch_sub(1, std::memory_order_relaxed);
-        } else {
-          ++it;
+      ElementIndex *index = data_shard.index.load(std::memory_order_relaxed);
+      index->remove_if([&context, &is_expired](const ElementHolder &element) {
+        if (!is_expired(element)) {
+          return false;
         }
+        ic_debug("purge '%s'\n", element.key.c_str());
+        context.stats.elements_expired.fetch_add(1, std::memory_order_relaxed);
+        context.stats.elements_cached.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+      });
+      const bool is_storage_empty = index->size() == 0;
+      if (is_storage_empty) {
+        data_shard.index.store(nullptr, std::memory_order_release);
+        context.retire_index(index);
       }
-      data_shard.is_storage_empty.store(data_shard.storage.empty(), std::memory_order_relaxed);
+      data_shard.is_storage_empty.store(is_storage_empty, std::memory_order_relaxed);
     }
 
     purge_shard_offset_ = (purge_shard_offset_ + 1) % SHARDS_PURGE_PERIOD;
@@ -501,11 +933,76 @@ public:
     last_memory_stats_ = context.memory_resource.get_memory_stats();
   }
 
+  // this function should be called only from master
+  // CLOCK approximation of LRU: the hand goes over the shards and evicts the elements
+  // that haven't been fetched since the previous pass, giving the fetched ones a second chance
+  void evict_cold_elements() {
+    const double memory_limit = static_cast<double>(last_memory_stats_.memory_limit);
+    const double memory_used = static_cast<double>(last_memory_stats_.memory_used);
+    if (!is_eviction_enabled() || memory_used < instance_cache_settings.eviction_threshold * memory_limit) {
+      return;
+    }
+
+    auto &current_data = data_manager_.get_current_resource();
+    auto &context = current_data.get_context();
+    const uint64_t elements_cached = context.stats.elements_cached.load(std::memory_order_relaxed);
+    if (!elements_cached) {
+      return;
+    }
+    // the memory of evicted elements is freed only when workers release them, so the amount is estimated by the average element size
+    const double memory_to_free = memory_used - (instance_cache_settings.eviction_threshold - EVICTION_HYSTERESIS) * memory_limit;
+    const double element_average_size = memory_used / static_cast<double>(elements_cached);
+    const auto elements_to_evict = static_cast<uint64_t>(std::ceil(memory_to_free / element_average_size));
+
+    dl::MemoryReplacementGuard shared_memory_guard{context.memory_resource, true};
+    auto *data_shards = current_data.get_data_shards();
+    const size_t shards_count = current_data.get_data_shards_count();
+    uint64_t elements_evicted = 0;
+    for (size_t visited_shards = 0; visited_shards != shards_count && elements_evicted < elements_to_evict; ++visited_shards) {
+      auto &data_shard = data_shards[eviction_hand_];
+      eviction_hand_ = (eviction_hand_ + 1) % shards_count;
+      if (data_shard.is_storage_empty.load(std::memory_order_relaxed)) {
+        continue;
+      }
+
+      // lock in this very order and do not move allocator_lock anywhere below, otherwise it will result in a deadlock!
+      std::lock_guard<inter_process_mutex> allocator_lock{context.allocator_mutex};
+      std::lock_guard<inter_process_mutex> shared_data_lock{data_shard.storage_mutex};
+      ElementIndex *index = data_shard.index.load(std::memory_order_relaxed);
+      if (!index) {
+        continue;
+      }
+      index->remove_if([&context, &elements_evicted, elements_to_evict](ElementHolder &element) {
+        if (elements_evicted == elements_to_evict || element.test_and_clear_recently_used()) {
+          return false;
+        }
+        ic_debug("evict '%s'\n", element.key.c_str());
+        ++elements_evicted;
+        context.stats.elements_evicted.fetch_add(1, std::memory_order_relaxed);
+        context.stats.elements_cached.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+      });
+      const bool is_storage_empty = index->size() == 0;
+      if (is_storage_empty) {
+        data_shard.index.store(nullptr, std::memory_order_release);
+        context.retire_index(index);
+      }
+      data_shard.is_storage_empty.store(is_storage_empty, std::memory_order_relaxed);
+    }
+    context.stats.eviction_passes.fetch_add(1, std::memory_order_relaxed);
+
+    std::lock_guard<inter_process_mutex> allocator_lock{context.allocator_mutex};
+    context.clear_garbage();
+    last_memory_stats_ = context.memory_resource.get_memory_stats();
+  }
+
   // this function should be called only from master
   InstanceCacheSwapStatus try_swap_memory_resource() {
     const auto &memory_stats = get_last_memory_stats();
     const auto threshold = REAL_MEMORY_USED_THRESHOLD * static_cast<double>(memory_stats.memory_limit);
-    if (static_cast<double>(memory_stats.real_memory_used) < threshold &&
+    // with the eviction the dirty memory is reused after defragmentation, so only the used memory matters
+    const size_t memory_used = is_eviction_enabled() ? memory_stats.memory_used : memory_stats.real_memory_used;
+    if (static_cast<double>(memory_used) < threshold &&
         !data_manager_.get_current_resource().get_context().memory_swap_required) {
       return InstanceCacheSwapStatus::no_need;
     }
@@ -524,14 +1021,425 @@ public:
     return last_memory_stats_;
   }
 
+  // this function should be called only from master
+  // the snapshot is written step by step, each step saves the next shards within SNAPSHOT_STEP_DURATION_SEC
+  void write_snapshot_step() {
+    if (instance_cache_settings.snapshot_path.empty()) {
+      return;
+    }
+    if (snapshot_finishing_.result_fd != -1) {
+      receive_snapshot_finishing_result();
+      return;
+    }
+    const double step_started_at = get_utime_monotonic();
+    auto &current_data = data_manager_.get_current_resource();
+    if (!snapshot_writer_.file) {
+      if (snapshot_writer_.next_snapshot_at == 0) {
+        // the first snapshot is written one period after the start
+        snapshot_writer_.next_snapshot_at = step_started_at + instance_cache_settings.snapshot_period_sec;
+      }
+      if (step_started_at < snapshot_writer_.next_snapshot_at) {
+        return;
+      }
+      snapshot_writer_.next_snapshot_at = step_started_at + instance_cache_settings.snapshot_period_sec;
+      if (!start_snapshot(current_data)) {
+        return;
+      }
+    } else if (snapshot_writer_.resource != &current_data) {
+      // the memory has been swapped, the saved part is stale, start again in the next step
+      abort_snapshot();
+      snapshot_writer_.next_snapshot_at = step_started_at;
+      return;
+    }
+
+    update_now();
+    string_buffer buffer;
+    std::vector<vk::intrusive_ptr<ElementHolder>> elements;
+    auto *data_shards = current_data.get_data_shards();
+    const size_t shards_count = current_data.get_data_shards_count();
+    while (snapshot_writer_.next_shard != shards_count && get_utime_monotonic() - step_started_at < SNAPSHOT_STEP_DURATION_SEC) {
+      auto &data_shard = data_shards[snapshot_writer_.next_shard++];
+      if (data_shard.is_storage_empty.load(std::memory_order_relaxed)) {
+        continue;
+      }
+      {
+        std::lock_guard<inter_process_mutex> shared_data_lock{data_shard.storage_mutex};
+        if (ElementIndex *index = data_shard.index.load(std::memory_order_relaxed)) {
+          index->for_each([&elements](ElementHolder &element) {
+            element.add_ref();
+            elements.emplace_back(&element, false);
+          });
+        }
+      }
+      // the elements are immutable, so they are packed without the storage_mutex
+      for (const auto &element : elements) {
+        if (!write_snapshot_record(*element, buffer)) {
+          abort_snapshot();
+          ++snapshot_stats_.snapshots_failed;
+          return;
+        }
+      }
+      // the released elements are put into the garbage, which is collected by purge_expired
+      elements.clear();
+    }
+
+    if (snapshot_writer_.next_shard == shards_count && !finish_snapshot()) {
+      ++snapshot_stats_.snapshots_failed;
+    }
+  }
+
+  // this function should be called only from master before the workers are started
+  void load_snapshot() {
+    const std::string &path = instance_cache_settings.snapshot_path;
+    if (path.empty()) {
+      return;
+    }
+    std::string content;
+    if (!read_snapshot_file(path, content)) {
+      return;
+    }
+
+    update_now();
+    auto &current_data = data_manager_.get_current_resource();
+    auto &context = current_data.get_context();
+    const double memory_limit = static_cast<double>(context.memory_resource.get_memory_stats().memory_limit);
+    const double fill_limit = std::min(instance_cache_settings.eviction_threshold, REAL_MEMORY_USED_THRESHOLD) * memory_limit;
+
+    // the unpacked instances are allocated in the cache memory and destroyed after copying
+    dl::MemoryReplacementGuard shared_memory_guard{context.memory_resource, true};
+    InstanceDeepCopyVisitor detach_processor{context.memory_resource, ExtraRefCnt::for_instance_cache, defragment_on_oom};
+    size_t pos = sizeof(SnapshotHeader);
+    while (true) {
+      uint32_t record_size = 0;
+      std::memcpy(&record_size, content.data() + pos, sizeof(record_size));
+      pos += sizeof(record_size);
+      if (!record_size) {
+        break;
+      }
+      if (static_cast<double>(context.memory_resource.get_memory_stats().memory_used) >= fill_limit) {
+        kprintf("Instance cache snapshot is loaded partially, the memory limit is reached\n");
+        break;
+      }
+      if (load_snapshot_record(current_data, string{content.data() + pos, record_size}, detach_processor)) {
+        ++snapshot_stats_.elements_loaded;
+      } else {
+        ++snapshot_stats_.elements_rejected;
+      }
+      pos += record_size;
+    }
+
+    std::lock_guard<inter_process_mutex> allocator_lock{context.allocator_mutex};
+    context.clear_garbage();
+    last_memory_stats_ = context.memory_resource.get_memory_stats();
+    kprintf("Instance cache snapshot '%s' is loaded: %" PRIu64 " elements restored, %" PRIu64 " rejected\n",
+            path.c_str(), snapshot_stats_.elements_loaded, snapshot_stats_.elements_rejected);
+  }
+
+  // this function should be called only from master
+  const InstanceCacheSnapshotStats &get_snapshot_stats() const noexcept {
+    return snapshot_stats_;
+  }
+
 private:
+  bool start_snapshot(const SharedMemoryData &resource) noexcept {
+    snapshot_writer_.tmp_path = instance_cache_settings.snapshot_path + ".tmp." + std::to_string(getpid());
+    snapshot_writer_.file = std::fopen(snapshot_writer_.tmp_path.c_str(), "wb");
+    if (!snapshot_writer_.file) {
+      kprintf("Can't create instance cache snapshot '%s': %m\n", snapshot_writer_.tmp_path.c_str());
+      ++snapshot_stats_.snapshots_failed;
+      return false;
+    }
+    snapshot_writer_.resource = &resource;
+    snapshot_writer_.next_shard = 0;
+    snapshot_writer_.records = 0;
+    snapshot_writer_.crc32 = ~0U;
+    const SnapshotHeader header;
+    if (std::fwrite(&header, sizeof(header), 1, snapshot_writer_.file) != 1) {
+      abort_snapshot();
+      ++snapshot_stats_.snapshots_failed;
+      return false;
+    }
+    return true;
+  }
+
+  bool write_snapshot_record(const ElementHolder &element, string_buffer &buffer) noexcept {
+    const auto time_points = element.load_time_points();
+    if (time_points.expiring_at <= now_) {
+      return true;
+    }
+    const char *type_name = typeid(*element.instance_wrapper).name();
+    const auto &snapshot_classes = get_snapshot_classes();
+    const auto snapshot_class = snapshot_classes.find(type_name);
+    if (snapshot_class == snapshot_classes.end()) {
+      ++snapshot_stats_.elements_skipped;
+      return true;
+    }
+
+    buffer.clean();
+    string_buffer::string_buffer_error_flag = STRING_BUFFER_ERROR_FLAG_ON;
+    auto reset_error_flag = vk::finally([] { string_buffer::string_buffer_error_flag = STRING_BUFFER_ERROR_FLAG_OFF; });
+    vk::msgpack::packer_float32_decorator::clear();
+    vk::msgpack::CheckInstanceDepth::depth = 0;
+    vk::msgpack::packer<string_buffer> packer{buffer};
+    packer.pack_array(SNAPSHOT_RECORD_FIELDS);
+    packer.pack(element.key);
+    const auto type_name_len = static_cast<uint32_t>(std::strlen(type_name));
+    packer.pack_str(type_name_len);
+    packer.pack_str_body(type_name, type_name_len);
+    packer.pack_uint64(snapshot_class->second.layout_hash);
+    packer.pack_int64(time_points.stored_at.count());
+    packer.pack_int64(time_points.expiring_at.count());
+    snapshot_class->second.pack(*element.instance_wrapper, packer);
+    if (string_buffer::string_buffer_error_flag == STRING_BUFFER_ERROR_FLAG_FAILED || vk::msgpack::CheckInstanceDepth::is_exceeded()) {
+      ++snapshot_stats_.elements_skipped;
+      return true;
+    }
+
+    const auto record_size = static_cast<uint32_t>(buffer.size());
+    if (std::fwrite(&record_size, sizeof(record_size), 1, snapshot_writer_.file) != 1 ||
+        std::fwrite(buffer.buffer(), record_size, 1, snapshot_writer_.file) != 1) {
+      kprintf("Can't write instance cache snapshot '%s': %m\n", snapshot_writer_.tmp_path.c_str());
+      return false;
+    }
+    snapshot_writer_.crc32 = crc32_partial(&record_size, sizeof(record_size), snapshot_writer_.crc32);
+    snapshot_writer_.crc32 = crc32_partial(buffer.buffer(), record_size, snapshot_writer_.crc32);
+    ++snapshot_writer_.records;
+    ++snapshot_stats_.elements_saved;
+    return true;
+  }
+
+  // the trailer is written in the master, while fsync and rename, which may take long, are done by the helper process;
+  // the master stays single threaded, because it keeps forking workers;
+  // the result is received through the pipe in the next write_snapshot_step
+  bool finish_snapshot() noexcept {
+    const uint32_t end_marker = 0;
+    const SnapshotTrailer trailer{snapshot_writer_.records, ~snapshot_writer_.crc32};
+    if (std::fwrite(&end_marker, sizeof(end_marker), 1, snapshot_writer_.file) != 1 ||
+        std::fwrite(&trailer, sizeof(trailer), 1, snapshot_writer_.file) != 1 ||
+        std::fflush(snapshot_writer_.file) != 0) {
+      kprintf("Can't write instance cache snapshot '%s': %m\n", snapshot_writer_.tmp_path.c_str());
+      abort_snapshot();
+      return false;
+    }
+
+    const int fd = fileno(snapshot_writer_.file);
+    int result_pipe[2] = {-1, -1};
+    pid_t intermediate_pid = -1;
+    if (pipe2(result_pipe, O_CLOEXEC | O_NONBLOCK) == 0) {
+      // the helper is forked twice and is reparented to init, so the master doesn't take it for a dead worker
+      intermediate_pid = fork();
+      if (intermediate_pid == 0) {
+        close(result_pipe[0]);
+        if (fork() == 0) {
+          const auto result = finish_snapshot_file(fd, snapshot_writer_.tmp_path.c_str(), instance_cache_settings.snapshot_path.c_str());
+          const ssize_t written = write(result_pipe[1], &result, sizeof(result));
+          _exit(written == sizeof(result) ? 0 : 1);
+        }
+        // if the helper isn't forked, the master gets no result and counts the snapshot as failed
+        _exit(0);
+      }
+      close(result_pipe[1]);
+      if (intermediate_pid == -1) {
+        close(result_pipe[0]);
+      } else {
+        waitpid(intermediate_pid, nullptr, 0);
+      }
+    }
+
+    if (intermediate_pid == -1) {
+      kprintf("Can't start instance cache snapshot helper: %m\n");
+      const auto result = finish_snapshot_file(fd, snapshot_writer_.tmp_path.c_str(), instance_cache_settings.snapshot_path.c_str());
+      snapshot_finishing_.tmp_path = snapshot_writer_.tmp_path;
+      complete_snapshot_finishing(result);
+    } else {
+      snapshot_finishing_.result_fd = result_pipe[0];
+      snapshot_finishing_.tmp_path = snapshot_writer_.tmp_path;
+    }
+    // the data is already flushed, the helper has its own copy of the descriptor
+    std::fclose(snapshot_writer_.file);
+    snapshot_writer_.file = nullptr;
+    snapshot_writer_.resource = nullptr;
+    return true;
+  }
+
+  // it is run in the forked helper process, so it makes only async-signal-safe calls
+  static SnapshotFinishingResult finish_snapshot_file(int fd, const char *tmp_path, const char *path) noexcept {
+    using Action = SnapshotFinishingResult::Action;
+    SnapshotFinishingResult result;
+    if (fsync(fd) != 0) {
+      result = SnapshotFinishingResult{errno, Action::write};
+    } else if (std::rename(tmp_path, path) != 0) {
+      result = SnapshotFinishingResult{errno, Action::rename};
+    }
+    if (result.error) {
+      unlink(tmp_path);
+    }
+    return result;
+  }
+
+  void receive_snapshot_finishing_result() noexcept {
+    SnapshotFinishingResult result;
+    const ssize_t received = read(snapshot_finishing_.result_fd, &result, sizeof(result));
+    if (received == -1 && (errno == EAGAIN || errno == EINTR)) {
+      return;
+    }
+    if (received != sizeof(result)) {
+      // the helper has died without the result
+      result = SnapshotFinishingResult{received == -1 ? errno : ECHILD, SnapshotFinishingResult::Action::finish};
+      unlink(snapshot_finishing_.tmp_path.c_str());
+    }
+    close(snapshot_finishing_.result_fd);
+    snapshot_finishing_.result_fd = -1;
+    complete_snapshot_finishing(result);
+  }
+
+  void complete_snapshot_finishing(const SnapshotFinishingResult &result) noexcept {
+    if (result.error) {
+      kprintf("Can't %s instance cache snapshot '%s': %s\n",
+              SnapshotFinishingResult::action_name(result.failed_action), snapshot_finishing_.tmp_path.c_str(), std::strerror(result.error));
+      ++snapshot_stats_.snapshots_failed;
+    } else {
+      ++snapshot_stats_.snapshots_written;
+    }
+  }
+
+  void abort_snapshot() noexcept {
+    if (snapshot_writer_.file) {
+      std::fclose(snapshot_writer_.file);
+      snapshot_writer_.file = nullptr;
+    }
+    snapshot_writer_.resource = nullptr;
+    unlink(snapshot_writer_.tmp_path.c_str());
+  }
+
+  // reads the whole file and checks its integrity, so the records can be parsed without bound checks
+  static bool read_snapshot_file(const std::string &path, std::string &content) noexcept {
+    FILE *file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+      if (errno != ENOENT) {
+        kprintf("Can't open instance cache snapshot '%s': %m\n", path.c_str());
+      }
+      return false;
+    }
+    char chunk[1 << 16];
+    size_t read_bytes = 0;
+    while ((read_bytes = std::fread(chunk, 1, sizeof(chunk), file)) > 0) {
+      content.append(chunk, read_bytes);
+    }
+    const bool read_failed = std::ferror(file);
+    std::fclose(file);
+
+    SnapshotHeader header;
+    if (read_failed || content.size() < sizeof(header) + sizeof(uint32_t) + sizeof(SnapshotTrailer)) {
+      kprintf("Instance cache snapshot '%s' is corrupted\n", path.c_str());
+      return false;
+    }
+    std::memcpy(&header, content.data(), sizeof(header));
+    if (!is_valid_snapshot_header(header)) {
+      kprintf("Instance cache snapshot '%s' has unknown format\n", path.c_str());
+      return false;
+    }
+
+    const size_t records_end_limit = content.size() - sizeof(SnapshotTrailer) - sizeof(uint32_t);
+    size_t pos = sizeof(header);
+    uint64_t records = 0;
+    while (pos <= records_end_limit) {
+      uint32_t record_size = 0;
+      std::memcpy(&record_size, content.data() + pos, sizeof(record_size));
+      if (!record_size) {
+        break;
+      }
+      pos += sizeof(record_size) + record_size;
+      ++records;
+    }
+    SnapshotTrailer trailer;
+    if (pos != records_end_limit) {
+      kprintf("Instance cache snapshot '%s' is corrupted\n", path.c_str());
+      return false;
+    }
+    std::memcpy(&trailer, content.data() + pos + sizeof(uint32_t), sizeof(trailer));
+    if (trailer.records != records || trailer.crc32 != compute_crc32(content.data() + sizeof(header), pos - sizeof(header))) {
+      kprintf("Instance cache snapshot '%s' is corrupted\n", path.c_str());
+      return false;
+    }
+    return true;
+  }
+
+  // should be called with the cache memory resource replacement
+  bool load_snapshot_record(SharedMemoryData &current_data, const string &record, InstanceDeepCopyVisitor &detach_processor) noexcept {
+    try {
+      vk::msgpack::unpacker unpacker{record};
+      const vk::msgpack::object obj = unpacker.unpack();
+      if (unpacker.has_error() || obj.type != vk::msgpack::stored_type::ARRAY || obj.via.array.size != SNAPSHOT_RECORD_FIELDS) {
+        return false;
+      }
+      const vk::msgpack::object *fields = obj.via.array.ptr;
+      const auto key = fields[0].as<string>();
+      const auto type_name = fields[1].as<string>();
+      const auto layout_hash = fields[2].as<uint64_t>();
+      const std::chrono::nanoseconds stored_at{fields[3].as<int64_t>()};
+      const std::chrono::nanoseconds expiring_at{fields[4].as<int64_t>()};
+
+      // the class may be removed or changed since the snapshot was written
+      const auto &snapshot_classes = get_snapshot_classes();
+      const auto snapshot_class = snapshot_classes.find(std::string_view{type_name.c_str(), type_name.size()});
+      if (snapshot_class == snapshot_classes.end() || snapshot_class->second.layout_hash != layout_hash || expiring_at <= now_) {
+        return false;
+      }
+      const std::unique_ptr<InstanceCopyistBase> instance_wrapper = snapshot_class->second.unpack(fields[5]);
+
+      auto &context = current_data.get_context();
+      auto &data = current_data.get_data(key);
+      std::lock_guard<inter_process_mutex> allocator_lock{context.allocator_mutex};
+      vk::intrusive_ptr<ElementHolder> element = create_element(context, key, stored_at, 0, *instance_wrapper, detach_processor);
+      if (!element) {
+        return false;
+      }
+      element->update_expiring_at(expiring_at);
+      std::lock_guard<inter_process_mutex> shared_data_lock{data.storage_mutex};
+      return !find_element_locked(data, key) && insert_new_element(context, data, static_cast<uint64_t>(key.hash()), element.get(), detach_processor);
+    } catch (vk::msgpack::type_error &) {
+      return false;
+    } catch (vk::msgpack::unpack_error &) {
+      return false;
+    }
+  }
+
+  // lock free lookup, the storage_mutex is taken only by the writers
+  static vk::intrusive_ptr<ElementHolder> acquire_element(SharedDataStorages &data, const string &key) noexcept {
+    const auto hash = static_cast<uint64_t>(key.hash());
+    reclamation_epochs->enter();
+    auto leave_epoch = vk::finally([] { reclamation_epochs->leave(); });
+    while (true) {
+      const ElementIndex *index = data.index.load(std::memory_order_acquire);
+      ElementHolder *element = index ? index->find(key, hash) : nullptr;
+      if (!element) {
+        return {};
+      }
+      if (element->try_add_ref()) {
+        return vk::intrusive_ptr<ElementHolder>{element, false};
+      }
+      // the element has just been replaced or removed, look it up again
+    }
+  }
+
+  static ElementHolder *find_element_locked(SharedDataStorages &data, const string &key) noexcept {
+    ElementIndex *index = data.index.load(std::memory_order_relaxed);
+    const ElementIndex::Slot *slot = index ? index->find_slot(key, static_cast<uint64_t>(key.hash())) : nullptr;
+    return slot ? slot->element.load(std::memory_order_relaxed) : nullptr;
+  }
+
+  static bool is_eviction_enabled() noexcept {
+    return instance_cache_settings.eviction_threshold < 1.0;
+  }
+
   bool is_element_insertion_can_be_skipped(SharedDataStorages &data, const string &key) const {
     std::lock_guard<inter_process_mutex> shared_data_lock{data.storage_mutex};
-    auto it = data.storage.find(key);
+    const ElementHolder *element = find_element_locked(data, key);
     // allow to skip the insertion of the element if it was inserted by another process recently enough
-    if (it != data.storage.end() &&
-        it->second->freshness_ratio(now_) < FRESHNESS_ELEMENT_RATIO &&
-        it->second->inserted_by_process != getpid()) {
+    if (element &&
+        element->freshness_ratio(now_) < FRESHNESS_ELEMENT_RATIO &&
+        element->inserted_by_process != getpid()) {
       ic_debug("skip '%s' because it was recently updated\n", key.c_str());
       context_->stats.elements_storing_skipped_due_recent_update.fetch_add(1, std::memory_order_relaxed);
       return true;
@@ -545,7 +1453,7 @@ private:
       return;
     }
 
-    InstanceDeepCopyVisitor detach_processor{context_->memory_resource, ExtraRefCnt::for_instance_cache};
+    InstanceDeepCopyVisitor detach_processor{context_->memory_resource, ExtraRefCnt::for_instance_cache, defragment_on_oom};
     for (auto it = storing_delayed_.cbegin(); it != storing_delayed_.cend(); it = storing_delayed_.cbegin()) {
       string key = it.get_key().to_string();
       const auto &delayed_instance = *it.get_value().get();
@@ -593,39 +1501,83 @@ private:
     // acquired an allocator lock, now we can safely collect the garbage
     auto clear_garbage = vk::finally([this] { context_->clear_garbage(); });
 
-    // moving an instance into a shared memory
-    if (auto cached_instance_wrapper = instance_wrapper.deep_copy_and_set_ref_cnt(detach_processor)) {
-      if (void *mem = detach_processor.prepare_raw_memory(sizeof(ElementHolder))) {
-        vk::intrusive_ptr<ElementHolder> element{new(mem) ElementHolder{now_, ttl, std::move(cached_instance_wrapper), *context_}};
-        std::lock_guard<inter_process_mutex> shared_data_lock{data.storage_mutex};
-        auto it = data.storage.find(key_in_script_memory);
-        if (it == data.storage.end()) {
-          string key_in_shared_memory = key_in_script_memory;
-          if (unlikely(!detach_processor.process(key_in_shared_memory))) {
-            return nullptr;
-          }
-          constexpr auto node_max_size = ElementStorage_::allocator_type::max_value_type_size();
-          if (unlikely(!detach_processor.is_enough_memory_for(node_max_size))) {
-            InstanceDeepDestroyVisitor{ExtraRefCnt::for_instance_cache}.process(key_in_shared_memory);
-            return nullptr;
-          }
-
-          it = data.storage.emplace(std::move(key_in_shared_memory), vk::intrusive_ptr<ElementHolder>{}).first;
-          data.is_storage_empty.store(false, std::memory_order_relaxed);
-          context_->stats.elements_cached.fetch_add(1, std::memory_order_relaxed);
-        }
-        // replace element and save previous element into used_elements_;
-        // it'll make it possible to free it without taking a storage_mutex lock
-        it->second.swap(element);
-        if (element) {
-          // used_elements_ uses heap memory for its internal allocations
-          used_elements_.emplace(std::move(element));
-        }
-        used_elements_.emplace(it->second);
-        return it->second.get();
+    vk::intrusive_ptr<ElementHolder> element = create_element(*context_, key_in_script_memory, now_, ttl, instance_wrapper, detach_processor);
+    if (!element) {
+      return nullptr;
+    }
+
+    const auto hash = static_cast<uint64_t>(key_in_script_memory.hash());
+    std::lock_guard<inter_process_mutex> shared_data_lock{data.storage_mutex};
+    ElementIndex *index = data.index.load(std::memory_order_relaxed);
+    if (ElementIndex::Slot *slot = index ? index->find_slot(key_in_script_memory, hash) : nullptr) {
+      // replace element and save previous element into used_elements_;
+      // it'll make it possible to free it without taking a storage_mutex lock
+      element->add_ref();
+      vk::intrusive_ptr<ElementHolder> previous_element{slot->element.exchange(element.get(), std::memory_order_acq_rel), false};
+      // used_elements_ uses heap memory for its internal allocations
+      used_elements_.emplace(std::move(previous_element));
+    } else if (!insert_new_element(*context_, data, hash, element.get(), detach_processor)) {
+      return nullptr;
+    }
+    used_elements_.emplace(element);
+    return element.get();
+  }
+
+  // should be called under the allocator_mutex, moves the instance and the key into the shared memory
+  static vk::intrusive_ptr<ElementHolder> create_element(CacheContext &context, const string &key, std::chrono::nanoseconds now, int64_t ttl,
+                                                         const InstanceCopyistBase &instance_wrapper,
+                                                         InstanceDeepCopyVisitor &detach_processor) noexcept {
+    auto cached_instance_wrapper = instance_wrapper.deep_copy_and_set_ref_cnt(detach_processor);
+    if (!cached_instance_wrapper) {
+      return {};
+    }
+    string key_in_shared_memory = key;
+    if (unlikely(!detach_processor.process(key_in_shared_memory))) {
+      return {};
+    }
+    void *mem = detach_processor.prepare_raw_memory(sizeof(ElementHolder));
+    if (unlikely(!mem)) {
+      InstanceDeepDestroyVisitor{ExtraRefCnt::for_instance_cache}.process(key_in_shared_memory);
+      return {};
+    }
+    return vk::intrusive_ptr<ElementHolder>{new(mem) ElementHolder{std::move(key_in_shared_memory), now, ttl, std::move(cached_instance_wrapper), context}};
+  }
+
+  // should be called under the allocator_mutex and the storage_mutex, the element must be absent in the index
+  static bool insert_new_element(CacheContext &context, SharedDataStorages &data, uint64_t hash, ElementHolder *element,
+                                 InstanceDeepCopyVisitor &detach_processor) noexcept {
+    ElementIndex *index = data.index.load(std::memory_order_relaxed);
+    if (!index || !index->can_insert()) {
+      index = rebuild_index(context, data, index, detach_processor);
+      if (unlikely(!index)) {
+        return false;
       }
     }
-    return nullptr;
+    element->add_ref();
+    index->insert(hash, element);
+    data.is_storage_empty.store(false, std::memory_order_relaxed);
+    context.stats.elements_cached.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // should be called under the allocator_mutex and the storage_mutex
+  static ElementIndex *rebuild_index(CacheContext &context, SharedDataStorages &data, ElementIndex *index,
+                                     InstanceDeepCopyVisitor &detach_processor) noexcept {
+    const uint32_t capacity = ElementIndex::capacity_for(index ? index->size() + 1 : 1);
+    void *mem = detach_processor.prepare_raw_memory(ElementIndex::memory_size(capacity));
+    if (unlikely(!mem)) {
+      return nullptr;
+    }
+    ElementIndex *new_index = ElementIndex::create(mem, capacity);
+    if (index) {
+      index->move_to(*new_index);
+    }
+    data.index.store(new_index, std::memory_order_release);
+    if (index) {
+      // the lock free readers may still use the previous index
+      context.retire_index(index);
+    }
+    return new_index;
   }
 
   void fire_warning(const InstanceDeepCopyVisitor &detach_processor, const char *class_name) noexcept {
@@ -667,8 +1619,30 @@ private:
   std::chrono::nanoseconds now_{std::chrono::nanoseconds::zero()};
   memory_resource::MemoryStats last_memory_stats_;
   size_t purge_shard_offset_{0};
+  size_t eviction_hand_{0};
+
+  struct {
+    FILE *file{nullptr};
+    std::string tmp_path;
+    const SharedMemoryData *resource{nullptr};
+    size_t next_shard{0};
+    uint64_t records{0};
+    uint32_t crc32{0};
+    double next_snapshot_at{0};
+  } snapshot_writer_;
+  struct {
+    int result_fd{-1};
+    std::string tmp_path;
+  } snapshot_finishing_;
+  InstanceCacheSnapshotStats snapshot_stats_;
 };
 
+bool register_instance_cache_snapshot_class(const char *type_name, uint64_t layout_hash,
+                                            InstanceCacheSnapshotPack pack, InstanceCacheSnapshotUnpack unpack) noexcept {
+  get_snapshot_classes().emplace(type_name, SnapshotClass{layout_hash, pack, unpack});
+  return true;
+}
+
 bool instance_cache_store(const string &key, const InstanceCopyistBase &instance_wrapper, int64_t ttl) {
   return InstanceCache::get().store(key, instance_wrapper, ttl);
 }
@@ -696,6 +1670,21 @@ void set_instance_cache_memory_limit(size_t limit) {
   impl_::instance_cache_settings.total_memory_limit = limit;
 }
 
+// should be called only from master
+void set_instance_cache_eviction_threshold(double threshold) {
+  impl_::instance_cache_settings.eviction_threshold = threshold;
+}
+
+// should be called only from master
+void set_instance_cache_snapshot_path(const char *path) {
+  impl_::instance_cache_settings.snapshot_path = path;
+}
+
+// should be called only from master
+void set_instance_cache_snapshot_period(double period_sec) {
+  impl_::instance_cache_settings.snapshot_period_sec = period_sec;
+}
+
 // should be called only from master
 InstanceCacheSwapStatus instance_cache_try_swap_memory() {
   return impl_::InstanceCache::get().try_swap_memory_resource();
@@ -716,6 +1705,26 @@ void instance_cache_purge_expired_elements() {
   impl_::InstanceCache::get().purge_expired();
 }
 
+// should be called only from master
+void instance_cache_evict_cold_elements() {
+  impl_::InstanceCache::get().evict_cold_elements();
+}
+
+// should be called only from master
+void instance_cache_load_snapshot() {
+  impl_::InstanceCache::get().load_snapshot();
+}
+
+// should be called only from master
+void instance_cache_write_snapshot_step() {
+  impl_::InstanceCache::get().write_snapshot_step();
+}
+
+// should be called only from master
+const InstanceCacheSnapshotStats &instance_cache_get_snapshot_stats() {
+  return impl_::InstanceCache::get().get_snapshot_stats();
+}
+
 void instance_cache_release_all_resources_acquired_by_this_proc() {
   impl_::InstanceCache::get().force_release_all_resources();
 }
@@ -14,12 +14,21 @@
 //  4) On store, all instances (and sub instances) are deeply cloned into instance cache;
 //  5) On fetch, all instances (and sub instances) are deeply cloned from instance cache;
 //  6) All instances (with all members) are destroyed strictly before or after request,
-//    and shouldn't be destroyed while request.
+//    and shouldn't be destroyed while request;
+//  7) Fetch is lock free, the memory of removed elements is reclaimed only when no fetch can see them;
+//  8) Instances of @kphp-serializable classes are periodically saved into the snapshot file by master,
+//    and the next master loads them on start if the class layout is the same.
+
+#include <memory>
+#include <type_traits>
+#include <typeinfo>
 
 #include "common/mixin/not_copyable.h"
 
 #include "runtime/instance-copy-processor.h"
 #include "runtime/kphp_core.h"
+#include "runtime/msgpack/adaptors.h"
+#include "runtime/msgpack/packer.h"
 #include "runtime/shape.h"
 
 namespace impl_ {
@@ -27,6 +36,37 @@ namespace impl_ {
 bool instance_cache_store(const string &key, const InstanceCopyistBase &instance_wrapper, int64_t ttl);
 const InstanceCopyistBase *instance_cache_fetch_wrapper(const string &key, bool even_if_expired);
 
+using InstanceCacheSnapshotPack = void (*)(const InstanceCopyistBase &instance_wrapper, vk::msgpack::packer<string_buffer> &packer);
+using InstanceCacheSnapshotUnpack = std::unique_ptr<InstanceCopyistBase> (*)(const vk::msgpack::object &msgpack_o);
+
+bool register_instance_cache_snapshot_class(const char *type_name, uint64_t layout_hash,
+                                            InstanceCacheSnapshotPack pack, InstanceCacheSnapshotUnpack unpack) noexcept;
+
+template<typename ClassInstanceType, typename = void>
+struct InstanceCacheSnapshotClass {
+  static constexpr bool registered = false;
+};
+
+// only @kphp-serializable classes can be saved into the snapshot
+template<typename ClassInstanceType>
+struct InstanceCacheSnapshotClass<ClassInstanceType, std::void_t<decltype(ClassInstanceType::ClassType::MSGPACK_LAYOUT_HASH)>> {
+  static void pack(const InstanceCopyistBase &instance_wrapper, vk::msgpack::packer<string_buffer> &packer) {
+    packer.pack(static_cast<const InstanceCopyistImpl<ClassInstanceType> &>(instance_wrapper).get_instance());
+  }
+
+  static std::unique_ptr<InstanceCopyistBase> unpack(const vk::msgpack::object &msgpack_o) {
+    return make_unique_on_script_memory<InstanceCopyistImpl<ClassInstanceType>>(msgpack_o.as<ClassInstanceType>());
+  }
+
+  // it is initialized before main(), so the master knows all cached classes before loading the snapshot
+  static const bool registered;
+};
+
+template<typename ClassInstanceType>
+const bool InstanceCacheSnapshotClass<ClassInstanceType, std::void_t<decltype(ClassInstanceType::ClassType::MSGPACK_LAYOUT_HASH)>>::registered =
+  register_instance_cache_snapshot_class(typeid(InstanceCopyistImpl<ClassInstanceType>).name(), ClassInstanceType::ClassType::MSGPACK_LAYOUT_HASH,
+                                         &InstanceCacheSnapshotClass::pack, &InstanceCacheSnapshotClass::unpack);
+
 } // namespace impl_
 
 void global_init_instance_cache_lib();
@@ -35,6 +75,9 @@ void free_instance_cache_lib();
 
 // these function should be called from master
 void set_instance_cache_memory_limit(size_t limit);
+void set_instance_cache_eviction_threshold(double threshold);
+void set_instance_cache_snapshot_path(const char *path);
+void set_instance_cache_snapshot_period(double period_sec);
 
 struct InstanceCacheStats : private vk::not_copyable {
   std::atomic<uint64_t> elements_stored{0};
@@ -52,6 +95,9 @@ struct InstanceCacheStats : private vk::not_copyable {
   std::atomic<uint64_t> elements_created{0};
   std::atomic<uint64_t> elements_destroyed{0};
   std::atomic<uint64_t> elements_cached{0};
+
+  std::atomic<uint64_t> elements_evicted{0};
+  std::atomic<uint64_t> eviction_passes{0};
 };
 
 enum class InstanceCacheSwapStatus {
@@ -67,6 +113,23 @@ const InstanceCacheStats &instance_cache_get_stats();
 const memory_resource::MemoryStats &instance_cache_get_memory_stats();
 // these function should be called from master
 void instance_cache_purge_expired_elements();
+// these function should be called from master
+void instance_cache_evict_cold_elements();
+
+struct InstanceCacheSnapshotStats {
+  uint64_t snapshots_written{0};
+  uint64_t snapshots_failed{0};
+  uint64_t elements_saved{0};
+  uint64_t elements_skipped{0};
+  uint64_t elements_loaded{0};
+  uint64_t elements_rejected{0};
+};
+// these function should be called from master
+void instance_cache_load_snapshot();
+// these function should be called from master
+void instance_cache_write_snapshot_step();
+// these function should be called from master
+const InstanceCacheSnapshotStats &instance_cache_get_snapshot_stats();
 
 void instance_cache_release_all_resources_acquired_by_this_proc();
 
@@ -76,6 +139,7 @@ bool f$instance_cache_store(const string &key, const ClassInstanceType &instance
   if (instance.is_null()) {
     return false;
   }
+  static_cast<void>(impl_::InstanceCacheSnapshotClass<ClassInstanceType>::registered);
   InstanceCopyistImpl<ClassInstanceType> instance_wrapper{instance};
   return impl_::instance_cache_store(key, instance_wrapper, ttl);
 }
@@ -54,6 +54,7 @@
 #include "runtime/udp.h"
 #include "runtime/url.h"
 #include "runtime/zlib.h"
+#include "runtime/zstd.h"
 #include "server/curl-adaptor.h"
 #include "server/database-drivers/adaptor.h"
 #include "server/database-drivers/mysql/mysql.h"
@@ -1515,6 +1516,7 @@ static void save_rpc_query_headers(const tl_query_header_t &header) {
   }
   if (header.flags & flag::supported_compression_version) {
     v$_SERVER.set_value(string("RPC_EXTRA_SUPPORTED_COMPRESSION_VERSION"), header.supported_compression_version);
+    rpc_set_supported_compression_version(header.supported_compression_version);
   }
   if (header.flags & flag::random_delay) {
     v$_SERVER.set_value(string("RPC_EXTRA_RANDOM_DELAY"), header.random_delay);
@@ -2374,10 +2376,12 @@ static void free_runtime_libs() {
   free_bcmath_lib();
   free_exception_lib();
   free_curl_lib();
+  free_zstd_lib();
   free_memcache_lib();
   free_mysql_lib();
   free_files_lib();
   free_openssl_lib();
+  free_regexp_lib();
   free_rpc_lib();
   free_typed_rpc_lib();
   free_streams_lib();
@@ -47,7 +47,13 @@ namespace {
 template<typename JobMessageT, typename T>
 JobMessageT *make_job_request_message(const class_instance<T> &instance) {
   auto &memory_manager = vk::singleton<job_workers::SharedMemoryManager>::get();
-  auto *memory_request = memory_manager.acquire_shared_message<JobMessageT>();
+  // the results of the finished jobs hold the messages, they're taken from the queue before the request fails;
+  // the jobs sent with the deferred wakeup are passed to the job workers, so they can release their messages sooner
+  auto *memory_request = memory_manager.acquire_shared_message<JobMessageT>([] {
+    auto &client = vk::singleton<job_workers::JobWorkerClient>::get();
+    client.wakeup_deferred_job_workers();
+    return client.take_job_results();
+  });
   if (memory_request == nullptr) {
     php_notice("Can't send job %s: not enough shared messages. "
                "Most probably job workers are slowed and overloaded due to external factors: net/cpu lags, network queries slowdown etc.", instance.get_class());
@@ -226,6 +232,9 @@ array<Optional<int64_t>> f$kphp_job_worker_start_multi(const array<class_instanc
     vk::singleton<ServerStats>::get().add_job_common_memory_stats(job_mem_stats.max_memory_used, job_mem_stats.max_real_memory_used);
   }
 
+  auto &client = vk::singleton<job_workers::JobWorkerClient>::get();
+  // the job workers are woken up once for all the jobs
+  client.defer_job_workers_wakeup();
   for (const auto &it : requests) {
     const auto &req = it.get_value();
 
@@ -261,6 +270,7 @@ array<Optional<int64_t>> f$kphp_job_worker_start_multi(const array<class_instanc
       res.set_value(it.get_key(), false);
     }
   }
+  client.flush_job_workers_wakeup();
 
   if (common_job_request) {
     vk::singleton<job_workers::SharedMemoryManager>::get().release_shared_message(common_job_request);
@@ -56,7 +56,7 @@ int64_t f$kphp_job_worker_store_response(const class_instance<C$KphpJobWorkerRes
     return job_workers::store_response_incorrect_call_error;
   }
   auto &memory_manager = vk::singleton<job_workers::SharedMemoryManager>::get();
-  auto *response_memory = memory_manager.acquire_shared_message<job_workers::JobSharedMessage>();
+  auto *response_memory = memory_manager.acquire_shared_message_for_reply();
   if (!response_memory) {
     php_warning("Can't store job response %s: not enough shared messages", response.get_class());
     return job_workers::store_response_not_enough_shared_messages_error;
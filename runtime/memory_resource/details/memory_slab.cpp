@@ -0,0 +1,58 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2023 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "runtime/memory_resource/details/memory_slab.h"
+
+#include <cstring>
+#include <new>
+
+namespace memory_resource {
+namespace details {
+
+constexpr size_t memory_slab::SIZE;
+constexpr size_t memory_slab::MAX_CHUNK_SIZE;
+constexpr size_t memory_slab::SIZE_CLASSES;
+
+memory_slab::memory_slab(uint32_t chunk_size, uint32_t capacity) noexcept:
+  chunk_size_(chunk_size),
+  chunk_size_reciprocal_(static_cast<uint32_t>(((uint64_t{1} << 32u) + chunk_size - 1) / chunk_size)),
+  capacity_(capacity),
+  bitmap_words_((capacity + 63u) / 64u),
+  free_chunks_(capacity) {
+  uint64_t *bitmap = get_bitmap();
+  std::fill(bitmap, bitmap + bitmap_words_, ~uint64_t{0});
+  if (const uint32_t tail = capacity_ % 64u) {
+    bitmap[bitmap_words_ - 1] = (uint64_t{1} << tail) - 1;
+  }
+}
+
+uint32_t memory_slab::get_capacity(size_t chunk_size) noexcept {
+  constexpr size_t payload_size = SIZE - sizeof(memory_slab);
+  // each chunk takes chunk_size bytes and 1 bit of the bitmap
+  auto capacity = static_cast<uint32_t>(payload_size * 8u / (chunk_size * 8u + 1u));
+  while (((capacity + 63u) / 64u) * sizeof(uint64_t) + capacity * chunk_size > payload_size) {
+    --capacity;
+  }
+  return capacity;
+}
+
+memory_slab *memory_slab::create(void *mem, size_t chunk_size) noexcept {
+  return new(mem) memory_slab{static_cast<uint32_t>(chunk_size), get_capacity(chunk_size)};
+}
+
+void memory_slab_pages::init(void *buffer, uint8_t *marks, size_t marks_size) noexcept {
+  const auto begin = reinterpret_cast<uintptr_t>(buffer) & ~(memory_slab::SIZE - 1);
+  if (marks_ == marks && marks_size_ == marks_size && begin_ == begin && ++epoch_ != 0) {
+    // the marks of the previous epochs are stale
+    return;
+  }
+  begin_ = begin;
+  marks_ = marks;
+  marks_size_ = marks_size;
+  std::memset(marks_, 0, marks_size_);
+  epoch_ = 1;
+}
+
+} // namespace details
+} // namespace memory_resource
@@ -0,0 +1,141 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2023 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+#include "common/mixin/not_copyable.h"
+
+#include "runtime/memory_resource/memory_resource.h"
+
+namespace memory_resource {
+namespace details {
+
+// The slab is an aligned page that is split into the chunks of one size class.
+// The chunks are tracked by the bitmap (1 is a free chunk) placed right after the slab header,
+// so the freed chunks aren't scattered over the memory as with the free lists.
+class memory_slab : vk::not_copyable {
+public:
+  static constexpr size_t SIZE{16u * 1024u};
+  static constexpr size_t MAX_CHUNK_SIZE{256u};
+  static constexpr size_t SIZE_CLASSES{MAX_CHUNK_SIZE / 8u};
+  static_assert(SIZE <= (1u << 14u) && MAX_CHUNK_SIZE <= (1u << 8u), "put_chunk relies on these limits");
+
+  static memory_slab *create(void *mem, size_t chunk_size) noexcept;
+  static uint32_t get_capacity(size_t chunk_size) noexcept;
+
+  static memory_slab *from_chunk(void *mem) noexcept {
+    return reinterpret_cast<memory_slab *>(reinterpret_cast<uintptr_t>(mem) & ~(SIZE - 1));
+  }
+
+  static constexpr size_t get_size_class(size_t aligned_size) noexcept {
+    return (aligned_size >> 3) - 1;
+  }
+
+  void *get_chunk() noexcept {
+    uint64_t *bitmap = get_bitmap();
+    for (; first_free_word_ != bitmap_words_; ++first_free_word_) {
+      if (uint64_t &word = bitmap[first_free_word_]) {
+        const auto bit = static_cast<uint32_t>(__builtin_ctzll(word));
+        word &= word - 1;
+        --free_chunks_;
+        return get_chunks_begin() + (first_free_word_ * 64u + bit) * chunk_size_;
+      }
+    }
+    return nullptr;
+  }
+
+  void put_chunk(void *mem) noexcept {
+    // the offset is less than 2^14 and the chunk size is at most 2^8, so the multiplication by the reciprocal is exact
+    const auto offset = static_cast<uint64_t>(static_cast<char *>(mem) - get_chunks_begin());
+    const auto chunk_id = static_cast<uint32_t>((offset * chunk_size_reciprocal_) >> 32u);
+    const uint32_t word = chunk_id / 64u;
+    get_bitmap()[word] |= uint64_t{1} << (chunk_id % 64u);
+    first_free_word_ = std::min(first_free_word_, word);
+    ++free_chunks_;
+  }
+
+  bool is_full() const noexcept {
+    return free_chunks_ == 0;
+  }
+
+  bool is_empty() const noexcept {
+    return free_chunks_ == capacity_;
+  }
+
+  size_t chunk_size() const noexcept {
+    return chunk_size_;
+  }
+
+  uint32_t free_chunks() const noexcept {
+    return free_chunks_;
+  }
+
+  memory_slab *prev{nullptr};
+  memory_slab *next{nullptr};
+
+private:
+  memory_slab(uint32_t chunk_size, uint32_t capacity) noexcept;
+
+  uint64_t *get_bitmap() noexcept {
+    return reinterpret_cast<uint64_t *>(this + 1);
+  }
+
+  char *get_chunks_begin() noexcept {
+    return reinterpret_cast<char *>(get_bitmap() + bitmap_words_);
+  }
+
+  const uint32_t chunk_size_{0};
+  const uint32_t chunk_size_reciprocal_{0};
+  const uint32_t capacity_{0};
+  const uint32_t bitmap_words_{0};
+  uint32_t free_chunks_{0};
+  uint32_t first_free_word_{0};
+};
+
+// The marks of the pages occupied by the slabs, they allow to check in O(1) whether a chunk belongs to a slab.
+// A page is marked with the current epoch, so all the marks are dropped by incrementing the epoch.
+class memory_slab_pages : vk::not_copyable {
+public:
+  static size_t get_marks_size(void *buffer, size_t buffer_size) noexcept {
+    const auto begin = reinterpret_cast<uintptr_t>(buffer) & ~(memory_slab::SIZE - 1);
+    return (reinterpret_cast<uintptr_t>(buffer) + buffer_size - begin + memory_slab::SIZE - 1) / memory_slab::SIZE;
+  }
+
+  // marks is the memory of get_marks_size() bytes, it's reused for the same buffer
+  void init(void *buffer, uint8_t *marks, size_t marks_size) noexcept;
+
+  void disable() noexcept {
+    marks_ = nullptr;
+    marks_size_ = 0;
+  }
+
+  bool enabled() const noexcept {
+    return marks_ != nullptr;
+  }
+
+  bool contains(const void *mem) const noexcept {
+    const size_t page = (reinterpret_cast<uintptr_t>(mem) - begin_) / memory_slab::SIZE;
+    return page < marks_size_ && marks_[page] == epoch_;
+  }
+
+  void mark(const memory_slab *slab) noexcept {
+    marks_[(reinterpret_cast<uintptr_t>(slab) - begin_) / memory_slab::SIZE] = epoch_;
+  }
+
+  void unmark(const memory_slab *slab) noexcept {
+    marks_[(reinterpret_cast<uintptr_t>(slab) - begin_) / memory_slab::SIZE] = 0;
+  }
+
+private:
+  uintptr_t begin_{0};
+  uint8_t *marks_{nullptr};
+  size_t marks_size_{0};
+  uint8_t epoch_{0};
+};
+
+} // namespace details
+} // namespace memory_resource
@@ -17,6 +17,20 @@ void MemoryStats::write_stats_to(stats_t *stats, const char *prefix) const noexc
   stats->add_gauge_stat(defragmentation_calls, prefix, ".memory.defragmentation_calls");
   stats->add_gauge_stat(huge_memory_pieces, prefix, ".memory.huge_memory_pieces");
   stats->add_gauge_stat(small_memory_pieces, prefix, ".memory.small_memory_pieces");
+
+  size_t slabs = empty_slabs;
+  for (size_t size_class = 0; size_class != slab_classes.size(); ++size_class) {
+    const SlabClassStats &class_stats = slab_classes[size_class];
+    if (class_stats.slabs) {
+      std::array<char, 64> class_key{};
+      std::snprintf(class_key.data(), class_key.size(), ".memory.slab_class_%zu", (size_class + 1) * 8);
+      stats->add_gauge_stat(class_stats.slabs, prefix, class_key.data(), ".slabs");
+      stats->add_gauge_stat(class_stats.chunks_used, prefix, class_key.data(), ".chunks_used");
+      slabs += class_stats.slabs;
+    }
+  }
+  stats->add_gauge_stat(slabs, prefix, ".memory.slabs");
+  stats->add_gauge_stat(empty_slabs, prefix, ".memory.empty_slabs");
 }
 
 } // namespace memory_resource
@@ -3,6 +3,7 @@
 // Distributed under the GPL v3 License, see LICENSE.notice.txt
 
 #pragma once
+#include <array>
 #include <cinttypes>
 #include <cstdarg>
 #include <cstdio>
@@ -49,6 +50,14 @@ public:
   size_t total_allocations{0}; // the total number of allocations
   size_t total_memory_allocated{0}; // the total amount of the memory allocated (doesn't take the freed memory into the account)
 
+  struct SlabClassStats {
+    uint32_t slabs{0}; // the number of slabs of the size class
+    uint32_t chunks_used{0}; // the number of allocated chunks in these slabs
+  };
+  static constexpr size_t SLAB_CLASSES_COUNT{32};
+  std::array<SlabClassStats, SLAB_CLASSES_COUNT> slab_classes{}; // the slabs of the size classes 8, 16, ..., 256 bytes
+  size_t empty_slabs{0}; // the number of empty slabs, which can be taken by any size class
+
   void write_stats_to(stats_t *stats, const char *prefix) const noexcept;
 };
 
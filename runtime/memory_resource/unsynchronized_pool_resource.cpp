@@ -12,7 +12,7 @@ namespace memory_resource {
 
 constexpr size_t unsynchronized_pool_resource::MAX_CHUNK_BLOCK_SIZE_;
 
-void unsynchronized_pool_resource::init(void *buffer, size_t buffer_size, size_t oom_handling_buffer_size) noexcept {
+void unsynchronized_pool_resource::init(void *buffer, size_t buffer_size, size_t oom_handling_buffer_size, bool use_slabs) noexcept {
   monotonic_buffer_resource::init(buffer, buffer_size);
 
   huge_pieces_.hard_reset();
@@ -22,10 +22,21 @@ void unsynchronized_pool_resource::init(void *buffer, size_t buffer_size, size_t
   extra_memory_head_ = &extra_memory_tail_;
 
   oom_handling_memory_size_ = oom_handling_buffer_size;
+
+  partial_slabs_.fill(nullptr);
+  empty_slabs_ = nullptr;
+  if (use_slabs) {
+    // the page marks are placed at the beginning of the buffer, and they are reused by the next init with the same buffer
+    const size_t marks_size = details::memory_slab_pages::get_marks_size(buffer, buffer_size + oom_handling_buffer_size);
+    auto *marks = static_cast<uint8_t *>(get_from_pool(details::align_for_chunk(marks_size)));
+    slab_pages_.init(buffer, marks, marks_size);
+  } else {
+    slab_pages_.disable();
+  }
 }
 
 void unsynchronized_pool_resource::hard_reset() noexcept {
-  init(memory_begin_, memory_end_ - memory_begin_);
+  init(memory_begin_, memory_end_ - memory_begin_, 0, slab_pages_.enabled());
   oom_handling_memory_size_ = 0;
 }
 
@@ -39,6 +50,7 @@ void unsynchronized_pool_resource::perform_defragmentation() noexcept {
   details::memory_ordered_chunk_list mem_list{memory_begin_};
 
   huge_pieces_.flush_to(mem_list);
+  flush_empty_slabs(mem_list);
   if (const size_t fallback_resource_left_size = fallback_resource_.size()) {
     mem_list.add_memory(fallback_resource_.memory_current(), fallback_resource_left_size);
     fallback_resource_.init(nullptr, 0);
@@ -105,6 +117,77 @@ void *unsynchronized_pool_resource::perform_defragmentation_and_allocate_huge_pi
   return allocate_huge_piece(aligned_size, false);
 }
 
+details::memory_slab *unsynchronized_pool_resource::acquire_slab(size_t aligned_size) noexcept {
+  if (!slab_pages_.enabled()) {
+    return nullptr;
+  }
+  void *slab_mem = empty_slabs_;
+  if (slab_mem) {
+    empty_slabs_ = empty_slabs_->next;
+    --stats_.empty_slabs;
+  } else {
+    const auto current = reinterpret_cast<uintptr_t>(memory_current_);
+    const size_t gap = ((current + details::memory_slab::SIZE - 1) & ~(details::memory_slab::SIZE - 1)) - current;
+    if (static_cast<size_t>(memory_end_ - memory_current_) < gap + details::memory_slab::SIZE) {
+      return nullptr;
+    }
+    if (gap) {
+      free_chunks_[details::get_chunk_id(gap)].put_mem(memory_current_);
+      ++stats_.small_memory_pieces;
+    }
+    slab_mem = memory_current_ + gap;
+    memory_current_ += gap + details::memory_slab::SIZE;
+  }
+
+  details::memory_slab *slab = details::memory_slab::create(slab_mem, aligned_size);
+  slab_pages_.mark(slab);
+  link_slab(slab);
+  ++stats_.slab_classes[details::memory_slab::get_size_class(aligned_size)].slabs;
+  memory_debug("allocate slab for %zu at %p\n", aligned_size, slab);
+  return slab;
+}
+
+void unsynchronized_pool_resource::release_slab(details::memory_slab *slab) noexcept {
+  memory_debug("release slab of %zu at %p\n", slab->chunk_size(), slab);
+  unlink_slab(slab);
+  --stats_.slab_classes[details::memory_slab::get_size_class(slab->chunk_size())].slabs;
+  slab->next = empty_slabs_;
+  empty_slabs_ = slab;
+  ++stats_.empty_slabs;
+}
+
+void unsynchronized_pool_resource::flush_empty_slabs(details::memory_ordered_chunk_list &mem_list) noexcept {
+  for (details::memory_slab *slab : partial_slabs_) {
+    for (; slab; slab = slab->next) {
+      if (slab->is_empty()) {
+        // the last slabs of the size classes aren't released on deallocation
+        release_slab(slab);
+        break;
+      }
+    }
+  }
+  for (details::memory_slab *slab = empty_slabs_; slab;) {
+    details::memory_slab *next = slab->next;
+    slab_pages_.unmark(slab);
+    mem_list.add_memory(slab, details::memory_slab::SIZE);
+    slab = next;
+  }
+  empty_slabs_ = nullptr;
+  stats_.empty_slabs = 0;
+}
+
+void unsynchronized_pool_resource::update_slab_classes_stats() noexcept {
+  for (size_t size_class = 0; size_class != partial_slabs_.size(); ++size_class) {
+    auto &class_stats = stats_.slab_classes[size_class];
+    // the full slabs aren't linked anywhere
+    uint32_t chunks_used = class_stats.slabs * details::memory_slab::get_capacity((size_class + 1) * 8);
+    for (const details::memory_slab *slab = partial_slabs_[size_class]; slab; slab = slab->next) {
+      chunks_used -= slab->free_chunks();
+    }
+    class_stats.chunks_used = chunks_used;
+  }
+}
+
 bool unsynchronized_pool_resource::is_memory_from_extra_pool(void *mem, size_t size) const noexcept {
   auto *extra_pool = extra_memory_head_;
   do {
@@ -8,6 +8,7 @@
 
 #include "runtime/memory_resource/details/memory_chunk_list.h"
 #include "runtime/memory_resource/details/memory_chunk_tree.h"
+#include "runtime/memory_resource/details/memory_slab.h"
 #include "runtime/memory_resource/details/universal_reallocate.h"
 #include "runtime/memory_resource/extra-memory-pool.h"
 #include "runtime/memory_resource/monotonic_buffer_resource.h"
@@ -16,20 +17,31 @@
 
 namespace memory_resource {
 
+// With use_slabs, the small pieces up to details::memory_slab::MAX_CHUNK_SIZE are allocated from the slabs,
+// the other pieces and the small ones, which don't fit into the slabs, use the free lists and the tree of the huge pieces.
+// A partially used slab holds its page, so the slabs suit the script memory, which is reset after each request,
+// rather than the long-living shared memory resources.
 class unsynchronized_pool_resource : private monotonic_buffer_resource {
 public:
-  using monotonic_buffer_resource::try_expand;
-  using monotonic_buffer_resource::get_memory_stats;
   using monotonic_buffer_resource::memory_begin;
 
-  void init(void *buffer, size_t buffer_size, size_t oom_handling_buffer_size = 0) noexcept;
+  void init(void *buffer, size_t buffer_size, size_t oom_handling_buffer_size = 0, bool use_slabs = false) noexcept;
   void hard_reset() noexcept;
   void unfreeze_oom_handling_memory() noexcept;
 
+  const MemoryStats &get_memory_stats() noexcept {
+    if (slab_pages_.enabled()) {
+      update_slab_classes_stats();
+    }
+    return stats_;
+  }
+
   void *allocate(size_t size) noexcept {
     void *mem = nullptr;
     const auto aligned_size = details::align_for_chunk(size);
-    if (aligned_size < MAX_CHUNK_BLOCK_SIZE_) {
+    if (aligned_size <= details::memory_slab::MAX_CHUNK_SIZE && (mem = try_allocate_from_slab(aligned_size))) {
+      memory_debug("allocate %zu, allocated address from slab %p\n", aligned_size, mem);
+    } else if (aligned_size < MAX_CHUNK_BLOCK_SIZE_) {
       mem = try_allocate_small_piece(aligned_size);
       if (!mem) {
         mem = allocate_small_piece_from_fallback_resource(aligned_size);
@@ -59,10 +71,19 @@ public:
     return details::universal_reallocate(*this, mem, aligned_new_size, aligned_old_size);
   }
 
+  void *try_expand(void *mem, size_t new_size, size_t old_size) noexcept {
+    // the slab chunks have a fixed size
+    return slab_pages_.contains(mem) ? nullptr : monotonic_buffer_resource::try_expand(mem, new_size, old_size);
+  }
+
   void deallocate(void *mem, size_t size) noexcept {
     memory_debug("deallocate %zu at %p\n", size, mem);
     const auto aligned_size = details::align_for_chunk(size);
-    put_memory_back(mem, aligned_size);
+    if (aligned_size <= details::memory_slab::MAX_CHUNK_SIZE && slab_pages_.contains(mem)) {
+      put_chunk_back_to_slab(mem);
+    } else {
+      put_memory_back(mem, aligned_size);
+    }
     register_deallocation(aligned_size);
   }
 
@@ -70,6 +91,10 @@ public:
 
   bool is_enough_memory_for(size_t size) const noexcept {
     const auto aligned_size = details::align_for_chunk(size);
+    if (aligned_size <= details::memory_slab::MAX_CHUNK_SIZE &&
+        (partial_slabs_[details::memory_slab::get_size_class(aligned_size)] || empty_slabs_)) {
+      return true;
+    }
     // not using free_chunks_ here as the real size can be smaller
     return static_cast<size_t>(memory_end_ - memory_current_) >= aligned_size || huge_pieces_.has_memory_for(aligned_size);
   }
@@ -85,6 +110,62 @@ public:
   }
 
 private:
+  void *try_allocate_from_slab(size_t aligned_size) noexcept {
+    const size_t size_class = details::memory_slab::get_size_class(aligned_size);
+    details::memory_slab *slab = partial_slabs_[size_class];
+    if (unlikely(!slab)) {
+      slab = acquire_slab(aligned_size);
+      if (!slab) {
+        return nullptr;
+      }
+    }
+    void *mem = slab->get_chunk();
+    if (slab->is_full()) {
+      unlink_slab(slab);
+    }
+    return mem;
+  }
+
+  void put_chunk_back_to_slab(void *mem) noexcept {
+    details::memory_slab *slab = details::memory_slab::from_chunk(mem);
+    const bool was_full = slab->is_full();
+    slab->put_chunk(mem);
+    if (was_full) {
+      link_slab(slab);
+    } else if (slab->is_empty() && (slab->prev || slab->next)) {
+      // keep the last slab of the size class, otherwise it may be released and acquired over and over again
+      release_slab(slab);
+    }
+  }
+
+  void link_slab(details::memory_slab *slab) noexcept {
+    auto &head = partial_slabs_[details::memory_slab::get_size_class(slab->chunk_size())];
+    slab->prev = nullptr;
+    slab->next = head;
+    if (head) {
+      head->prev = slab;
+    }
+    head = slab;
+  }
+
+  void unlink_slab(details::memory_slab *slab) noexcept {
+    if (slab->prev) {
+      slab->prev->next = slab->next;
+    } else {
+      partial_slabs_[details::memory_slab::get_size_class(slab->chunk_size())] = slab->next;
+    }
+    if (slab->next) {
+      slab->next->prev = slab->prev;
+    }
+    slab->prev = slab->next = nullptr;
+  }
+
+  details::memory_slab *acquire_slab(size_t aligned_size) noexcept;
+  void release_slab(details::memory_slab *slab) noexcept;
+  void flush_empty_slabs(details::memory_ordered_chunk_list &mem_list) noexcept;
+  // the chunks usage is calculated on demand, so the allocations don't touch the stats
+  void update_slab_classes_stats() noexcept;
+
   void *try_allocate_small_piece(size_t aligned_size) noexcept {
     const auto chunk_id = details::get_chunk_id(aligned_size);
     auto *mem = free_chunks_[chunk_id].get_mem();
@@ -142,6 +223,15 @@ private:
 
   static constexpr size_t MAX_CHUNK_BLOCK_SIZE_{16u * 1024u};
   std::array<details::memory_chunk_list, details::get_chunk_id(MAX_CHUNK_BLOCK_SIZE_)> free_chunks_;
+
+  static_assert(details::memory_slab::SIZE <= MAX_CHUNK_BLOCK_SIZE_, "the alignment gap before a slab should fit the free chunks");
+  static_assert(details::memory_slab::SIZE_CLASSES == MemoryStats::SLAB_CLASSES_COUNT, "check the slab classes stats");
+
+  details::memory_slab_pages slab_pages_;
+  // the slabs with free chunks
+  std::array<details::memory_slab *, details::memory_slab::SIZE_CLASSES> partial_slabs_{};
+  // the empty slabs, which can be taken by any size class, linked through the next pointer
+  details::memory_slab *empty_slabs_{nullptr};
 };
 
 } // namespace memory_resource
@@ -5,15 +5,40 @@
 #include <mysql/mysql.h>
 
 #include "runtime/pdo/mysql/mysql_pdo_emulated_statement.h"
+#include "runtime/pdo/pdo_placeholders.h"
 #include "runtime/pdo/pdo_statement.h"
 #include "runtime/resumable.h"
 #include "server/database-drivers/mysql/mysql.h"
+#include "server/database-drivers/mysql/mysql-connector.h"
 #include "server/database-drivers/mysql/mysql-request.h"
 #include "server/database-drivers/mysql/mysql-response.h"
 #include "server/database-drivers/adaptor.h"
 
 namespace pdo::mysql {
 
+namespace {
+
+string quote_param(MYSQL *ctx, const mixed &value) noexcept {
+  if (value.is_null()) {
+    return string{"NULL"};
+  }
+  if (value.is_bool()) {
+    return string{value.as_bool() ? "1" : "0"};
+  }
+  if (value.is_int() || value.is_float()) {
+    return value.to_string();
+  }
+  const string str = value.to_string();
+  string res{2 * str.size() + 2, false};
+  res[0] = '\'';
+  const unsigned long len = LIB_MYSQL_CALL(mysql_real_escape_string_quote(ctx, res.buffer() + 1, str.c_str(), str.size(), '\''));
+  res[len + 1] = '\'';
+  res.shrink(len + 2);
+  return res;
+}
+
+} // namespace
+
 class MysqlPdoEmulatedStatement::ExecuteResumable final : public Resumable {
 private:
   MysqlPdoEmulatedStatement *ctx{};
@@ -25,7 +50,7 @@ public:
   explicit ExecuteResumable(MysqlPdoEmulatedStatement *ctx, int64_t timeout_sec) noexcept : ctx(ctx), timeout_sec(timeout_sec) {}
   bool run() noexcept final {
     RESUMABLE_BEGIN
-      resumable_id = vk::singleton<database_drivers::Adaptor>::get().launch_request_resumable(std::make_unique<database_drivers::MysqlRequest>(ctx->connector_id, ctx->statement));
+      resumable_id = vk::singleton<database_drivers::Adaptor>::get().launch_request_resumable(std::make_unique<database_drivers::MysqlRequest>(ctx->connector_id, ctx->query));
       response = vk::singleton<database_drivers::Adaptor>::get().wait_request_resumable(resumable_id, timeout_sec);
       TRY_WAIT(MysqlPdoEmulatedStatement_ExecuteResumable_label, response, std::unique_ptr<database_drivers::Response>);
       if (auto *casted = dynamic_cast<database_drivers::MysqlResponse *>(response.get())) {
@@ -44,7 +69,26 @@ MysqlPdoEmulatedStatement::MysqlPdoEmulatedStatement(const string &statement, in
   , connector_id(connector_id) {}
 
 bool MysqlPdoEmulatedStatement::execute(const class_instance<C$PDOStatement> &v$this, const Optional<array<mixed>> &params) noexcept {
-  (void)v$this, (void)params; // TODO: use params
+  query = statement;
+  if (params.has_value() && !params.val().empty()) {
+    auto *connector = vk::singleton<database_drivers::Adaptor>::get().get_connector<database_drivers::MysqlConnector>(connector_id);
+    if (connector == nullptr) {
+      return false;
+    }
+    bool all_bound = true;
+    query = replace_placeholders(statement, true, [&](const string &name, int64_t position) {
+      const mixed *value = find_bound_param(params.val(), name, position);
+      if (value == nullptr) {
+        all_bound = false;
+        return string{};
+      }
+      return quote_param(connector->ctx, *value);
+    });
+    if (!all_bound) {
+      php_warning("Not all placeholders are bound in MySQL PDOStatement::execute");
+      return false;
+    }
+  }
   return start_resumable<bool>(new ExecuteResumable(this, v$this.get()->timeout_sec));
 }
 
@@ -23,6 +23,8 @@ public:
 
 private:
   string statement;
+  // statement with substituted parameters
+  string query;
   int connector_id{};
 
   std::unique_ptr<database_drivers::MysqlResponse> response;
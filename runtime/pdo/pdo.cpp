@@ -41,10 +41,16 @@ class_instance<C$PDO> f$PDO$$__construct(const class_instance<C$PDO> &v$this, co
 }
 
 class_instance<C$PDOStatement> f$PDO$$prepare(const class_instance<C$PDO> &v$this, const string &query, const array<mixed> &options) noexcept {
-  // TODO: prepared statements are not supported so far
   return v$this.get()->driver->prepare(v$this, query, options);
 }
 
+// like PHP, PDO::query() and PDO::exec() don't use server side prepared statements
+static array<mixed> emulated_prepare_options() noexcept {
+  array<mixed> options;
+  options.set_value(int64_t{C$PDO::ATTR_EMULATE_PREPARES}, true);
+  return options;
+}
+
 class PdoQueryResumable final : public Resumable {
 private:
   const class_instance<C$PDO> &v$this;
@@ -59,7 +65,7 @@ public:
 
   bool run() noexcept final {
     RESUMABLE_BEGIN
-      statement = f$PDO$$prepare(v$this, query);
+      statement = f$PDO$$prepare(v$this, query, emulated_prepare_options());
       ok = f$PDOStatement$$execute(statement);
       TRY_WAIT(PdoQueryResumable_label, ok, bool);
       if (!ok) {
@@ -0,0 +1,125 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2023 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include <cctype>
+
+#include "common/wrappers/string_view.h"
+
+#include "runtime/kphp_core.h"
+
+namespace pdo {
+
+/**
+ * @brief Replaces `?` and `:name` placeholders of @a query with the results of @a replacer.
+ * @param query
+ * @param backslash_escapes whether a backslash escapes the next character inside quoted literals (MySQL),
+ * otherwise pgSQL dollar quoted literals are recognized
+ * @param replacer callable (const string &name, int64_t position) -> string, name is empty for `?` placeholders
+ * @return Rewritten query.
+ *
+ * Placeholders inside quoted literals and identifiers, line and block comments, `::` casts and `??` (escaped `?` operator) are left as is.
+ */
+template<class F>
+string replace_placeholders(const string &query, bool backslash_escapes, const F &replacer) noexcept {
+  const auto is_name_char = [](char c) {
+    return c == '_' || ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') || ('0' <= c && c <= '9');
+  };
+  const vk::string_view text{query.c_str(), query.size()};
+  // returns the end of the region skipped as is, which starts at i, or npos if there is no such region
+  const auto find_skipped_region_end = [&](size_t i) {
+    const size_t n = text.size();
+    const char c = text[i];
+    const char next = i + 1 < n ? text[i + 1] : '\0';
+    if (c == '-' && next == '-') {
+      // MySQL requires a whitespace after `--`, otherwise it's a double minus
+      if (backslash_escapes && i + 2 < n && !isspace(static_cast<unsigned char>(text[i + 2]))) {
+        return vk::string_view::npos;
+      }
+      const size_t end = text.find('\n', i + 2);
+      return end == vk::string_view::npos ? n : end;
+    }
+    if (c == '/' && next == '*') {
+      const size_t end = text.find(vk::string_view{"*/"}, i + 2);
+      return end == vk::string_view::npos ? n : end + 2;
+    }
+    if (c == '$' && !backslash_escapes && (i == 0 || !is_name_char(text[i - 1])) && !('0' <= next && next <= '9')) {
+      // pgSQL dollar quoted literal: $tag$ ... $tag$, the tag may be empty
+      size_t tag_end = i + 1;
+      while (tag_end < n && is_name_char(text[tag_end])) {
+        ++tag_end;
+      }
+      if (tag_end == n || text[tag_end] != '$') {
+        return vk::string_view::npos;
+      }
+      const vk::string_view tag = text.substr(i, tag_end + 1 - i);
+      const size_t end = text.find(tag, tag_end + 1);
+      return end == vk::string_view::npos ? n : end + tag.size();
+    }
+    return vk::string_view::npos;
+  };
+
+  string result;
+  result.reserve_at_least(query.size());
+  const string::size_type n = query.size();
+  int64_t position = 0;
+  char quote = 0;
+  for (string::size_type i = 0; i < n; ++i) {
+    const char c = query[i];
+    if (quote) {
+      result.push_back(c);
+      if (backslash_escapes && c == '\\' && i + 1 < n) {
+        result.push_back(query[++i]);
+      } else if (c == quote) {
+        quote = 0;
+      }
+      continue;
+    }
+
+    if (c == '\'' || c == '"' || c == '`') {
+      quote = c;
+      result.push_back(c);
+    } else if (const size_t skipped_end = find_skipped_region_end(i); skipped_end != vk::string_view::npos) {
+      result.append(query.c_str() + i, static_cast<string::size_type>(skipped_end - i));
+      i = static_cast<string::size_type>(skipped_end - 1);
+    } else if (c == '?') {
+      if (i + 1 < n && query[i + 1] == '?') {
+        result.push_back('?');
+        ++i;
+      } else {
+        result.append(replacer(string{}, position++));
+      }
+    } else if (c == ':' && i + 1 < n && query[i + 1] == ':') {
+      result.append(2, ':');
+      ++i;
+    } else if (c == ':' && i + 1 < n && is_name_char(query[i + 1])) {
+      string::size_type end = i + 1;
+      while (end < n && is_name_char(query[end])) {
+        ++end;
+      }
+      result.append(replacer(string{query.c_str() + i + 1, end - i - 1}, position++));
+      i = end - 1;
+    } else {
+      result.push_back(c);
+    }
+  }
+  return result;
+}
+
+/**
+ * @brief Finds the value bound to a placeholder: by @a position for `?`, by @a name with or without leading ':' for `:name`.
+ * @return Pointer to the bound value or nullptr if it's not bound.
+ */
+inline const mixed *find_bound_param(const array<mixed> &params, const string &name, int64_t position) noexcept {
+  if (name.empty()) {
+    return params.find_value(position);
+  }
+  if (const mixed *value = params.find_value(name)) {
+    return value;
+  }
+  return params.find_value(string{":"}.append(name));
+}
+
+} // namespace pdo
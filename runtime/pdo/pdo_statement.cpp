@@ -5,7 +5,6 @@
 #include "runtime/pdo/pdo_statement.h"
 
 bool f$PDOStatement$$execute(const class_instance<C$PDOStatement> &v$this, const Optional<array<mixed>> &params) noexcept {
-  // TODO: prepared statements are not implemented so far. This is stub for future implementation
   return v$this.get()->statement->execute(v$this, params);
 }
 
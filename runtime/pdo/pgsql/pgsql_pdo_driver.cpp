@@ -6,6 +6,7 @@
 #include "runtime/pdo/pdo_statement.h"
 #include "runtime/pdo/pgsql/pgsql_pdo_driver.h"
 #include "runtime/pdo/pgsql/pgsql_pdo_emulated_statement.h"
+#include "runtime/pdo/pgsql/pgsql_pdo_prepared_statement.h"
 #include "server/database-drivers/adaptor.h"
 #include "server/database-drivers/pgsql/pgsql-connector.h"
 #include "server/database-drivers/pgsql/pgsql-response.h"
@@ -62,11 +63,15 @@ void PgsqlPdoDriver::connect(const class_instance<C$PDO> &v$this __attribute__((
 }
 
 class_instance<C$PDOStatement> PgsqlPdoDriver::prepare(const class_instance<C$PDO> &v$this, const string &query, const array<mixed> &options) noexcept {
-  (void)options;
   class_instance<C$PDOStatement> res;
   res.alloc();
 
-  res.get()->statement = std::make_unique<PgsqlPdoEmulatedStatement>(query, v$this.get()->driver->connector_id);
+  const mixed *emulate_prepares = options.find_value(int64_t{C$PDO::ATTR_EMULATE_PREPARES});
+  if (emulate_prepares != nullptr && emulate_prepares->to_bool()) {
+    res.get()->statement = std::make_unique<PgsqlPdoEmulatedStatement>(query, v$this.get()->driver->connector_id);
+  } else {
+    res.get()->statement = std::make_unique<PgsqlPdoPreparedStatement>(query, v$this.get()->driver->connector_id);
+  }
   res.get()->timeout_sec = v$this->timeout_sec;
 
   return res;
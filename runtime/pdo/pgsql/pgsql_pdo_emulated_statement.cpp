@@ -2,15 +2,42 @@
 
 #include "runtime/pdo/pgsql/pgsql_pdo_emulated_statement.h"
 #include "runtime/kphp_core.h"
+#include "runtime/pdo/pdo_placeholders.h"
 #include "runtime/pdo/pdo_statement.h"
 #include "runtime/resumable.h"
 #include "server/database-drivers/adaptor.h"
+#include "server/database-drivers/pgsql/pgsql-connector.h"
 #include "server/database-drivers/pgsql/pgsql-request.h"
 #include "server/database-drivers/pgsql/pgsql-response.h"
 #include "server/database-drivers/pgsql/pgsql.h"
 
 namespace pdo::pgsql {
 
+namespace {
+
+Optional<string> quote_param(PGconn *conn, const mixed &value) noexcept {
+  if (value.is_null()) {
+    return string{"NULL"};
+  }
+  if (value.is_bool()) {
+    return string{value.as_bool() ? "TRUE" : "FALSE"};
+  }
+  if (value.is_int() || value.is_float()) {
+    return value.to_string();
+  }
+  const string str = value.to_string();
+  dl::CriticalSectionGuard guard;
+  char *escaped = PQescapeLiteral(conn, str.c_str(), str.size());
+  if (escaped == nullptr) {
+    return false;
+  }
+  string res{escaped};
+  PQfreemem(escaped);
+  return res;
+}
+
+} // namespace
+
 class PgsqlPdoEmulatedStatement::ExecuteResumable final : public Resumable {
 private:
   PgsqlPdoEmulatedStatement *ctx{};
@@ -26,7 +53,7 @@ public:
   bool run() noexcept final {
     RESUMABLE_BEGIN
       resumable_id = vk::singleton<database_drivers::Adaptor>::get().launch_request_resumable(
-        std::make_unique<database_drivers::PgsqlRequest>(ctx->connector_id, ctx->statement));
+        std::make_unique<database_drivers::PgsqlRequest>(ctx->connector_id, ctx->query));
       response = vk::singleton<database_drivers::Adaptor>::get().wait_request_resumable(resumable_id, timeout_sec);
       TRY_WAIT(PgsqlPdoEmulatedStatement_ExecuteResumable_label, response, std::unique_ptr<database_drivers::Response>);
       if (auto *casted = dynamic_cast<database_drivers::PgsqlResponse *>(response.get())) {
@@ -42,10 +69,40 @@ public:
 
 PgsqlPdoEmulatedStatement::PgsqlPdoEmulatedStatement(const string &statement, int connector_id)
   : statement(statement)
+  , query(statement)
   , connector_id(connector_id) {}
 
 bool PgsqlPdoEmulatedStatement::execute(const class_instance<C$PDOStatement> &v$this, const Optional<array<mixed>> &params) noexcept {
-  (void)params;
+  query = statement;
+  if (params.has_value() && !params.val().empty()) {
+    auto *connector = vk::singleton<database_drivers::Adaptor>::get().get_connector<database_drivers::PgsqlConnector>(connector_id);
+    if (connector == nullptr) {
+      return false;
+    }
+    bool all_bound = true;
+    bool all_quoted = true;
+    query = replace_placeholders(statement, false, [&](const string &name, int64_t position) {
+      const mixed *value = find_bound_param(params.val(), name, position);
+      if (value == nullptr) {
+        all_bound = false;
+        return string{};
+      }
+      Optional<string> quoted = quote_param(connector->ctx.conn, *value);
+      all_quoted &= quoted.has_value();
+      return quoted.has_value() ? quoted.val() : string{};
+    });
+    if (!all_bound) {
+      php_warning("Not all placeholders are bound in pgSQL PDOStatement::execute");
+      return false;
+    }
+    if (!all_quoted) {
+      php_warning("Can't escape the bound params in pgSQL PDOStatement::execute");
+      return false;
+    }
+  }
+
+  processed_row = -1;
+  response = nullptr;
   return start_resumable<bool>(new ExecuteResumable(this, v$this.get()->timeout_sec));
 }
 
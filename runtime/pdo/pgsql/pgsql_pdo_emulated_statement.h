@@ -13,17 +13,20 @@ class PgsqlPdoEmulatedStatement : public pdo::AbstractPdoStatement {
 public:
   PgsqlPdoEmulatedStatement(const string &statement, int connector_id);
 
-  bool execute(const class_instance<C$PDOStatement> &v$this, const Optional<array<mixed>> &params) noexcept final;
+  bool execute(const class_instance<C$PDOStatement> &v$this, const Optional<array<mixed>> &params) noexcept override;
   mixed fetch(const class_instance<C$PDOStatement> &v$this) noexcept final;
   int64_t affected_rows() noexcept final;
 
-private:
+protected:
   string statement;
+  // the statement sent to the server: with the bound params interpolated or with `$n` placeholders
+  string query;
   int processed_row{-1};
   int connector_id{};
 
   std::unique_ptr<database_drivers::PgsqlResponse> response;
 
+private:
   class ExecuteResumable;
 };
 } // namespace pdo::pgsql
@@ -0,0 +1,85 @@
+#include "runtime/pdo/pgsql/pgsql_pdo_prepared_statement.h"
+
+#include "runtime/pdo/pdo_placeholders.h"
+#include "runtime/pdo/pdo_statement.h"
+#include "runtime/resumable.h"
+#include "server/database-drivers/adaptor.h"
+#include "server/database-drivers/pgsql/pgsql-request.h"
+#include "server/database-drivers/pgsql/pgsql-response.h"
+
+namespace pdo::pgsql {
+
+class PgsqlPdoPreparedStatement::ExecuteResumable final : public Resumable {
+private:
+  PgsqlPdoPreparedStatement *ctx{};
+  int64_t timeout_sec{-1};
+  std::unique_ptr<database_drivers::Response> response{};
+  int resumable_id{};
+
+public:
+  using ReturnT = bool;
+  explicit ExecuteResumable(PgsqlPdoPreparedStatement *ctx, int64_t timeout_sec) noexcept
+    : ctx(ctx)
+    , timeout_sec(timeout_sec) {}
+  bool run() noexcept final {
+    RESUMABLE_BEGIN
+      resumable_id = vk::singleton<database_drivers::Adaptor>::get().launch_request_resumable(
+        std::make_unique<database_drivers::PgsqlPreparedRequest>(ctx->connector_id, ctx->query, ctx->param_values));
+      response = vk::singleton<database_drivers::Adaptor>::get().wait_request_resumable(resumable_id, timeout_sec);
+      TRY_WAIT(PgsqlPdoPreparedStatement_ExecuteResumable_label, response, std::unique_ptr<database_drivers::Response>);
+      if (auto *casted = dynamic_cast<database_drivers::PgsqlResponse *>(response.get())) {
+        ctx->response = std::unique_ptr<database_drivers::PgsqlResponse>{casted};
+        response.release();
+      } else {
+        php_critical_error("Unexpected error at pgSQL PDOStatement::execute");
+      }
+      RETURN(!ctx->response->is_error);
+    RESUMABLE_END
+  }
+};
+
+PgsqlPdoPreparedStatement::PgsqlPdoPreparedStatement(const string &statement, int connector_id)
+  : PgsqlPdoEmulatedStatement(statement, connector_id) {
+  query = replace_placeholders(statement, false, [this](const string &name, int64_t position) {
+    int64_t index = param_names.count();
+    if (!name.empty()) {
+      // the same named placeholder used several times is the same parameter
+      for (auto it = param_names.cbegin(); it != param_names.cend(); ++it) {
+        if (it.get_value() == name) {
+          index = it.get_key().to_int();
+          break;
+        }
+      }
+    }
+    if (index == param_names.count()) {
+      param_names.push_back(name);
+      param_positions.push_back(position);
+    }
+    return string{"$"}.append(index + 1);
+  });
+}
+
+bool PgsqlPdoPreparedStatement::execute(const class_instance<C$PDOStatement> &v$this, const Optional<array<mixed>> &params) noexcept {
+  const array<mixed> &bound_params = params.has_value() ? params.val() : array<mixed>{};
+  param_values = array<Optional<string>>{array_size{param_names.count(), 0, true}};
+  for (int64_t i = 0; i < param_names.count(); ++i) {
+    const mixed *value = find_bound_param(bound_params, param_names.get_value(i), param_positions.get_value(i));
+    if (value == nullptr) {
+      php_warning("Not all placeholders are bound in pgSQL PDOStatement::execute");
+      return false;
+    }
+    if (value->is_null()) {
+      param_values.push_back(Optional<string>{});
+    } else if (value->is_bool()) {
+      param_values.push_back(string{value->as_bool() ? "t" : "f"});
+    } else {
+      param_values.push_back(value->to_string());
+    }
+  }
+
+  processed_row = -1;
+  response = nullptr;
+  return start_resumable<bool>(new ExecuteResumable(this, v$this.get()->timeout_sec));
+}
+
+} // namespace pdo::pgsql
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "runtime/kphp_core.h"
+#include "runtime/pdo/pgsql/pgsql_pdo_emulated_statement.h"
+
+namespace pdo::pgsql {
+
+/**
+ * Statement executed with server side prepared statement, @see database_drivers::PgsqlPreparedRequest.
+ * Placeholders `?` and `:name` are rewritten to pgSQL `$n` ones, the parameters are sent separately from the query.
+ */
+class PgsqlPdoPreparedStatement final : public PgsqlPdoEmulatedStatement {
+public:
+  PgsqlPdoPreparedStatement(const string &statement, int connector_id);
+
+  bool execute(const class_instance<C$PDOStatement> &v$this, const Optional<array<mixed>> &params) noexcept final;
+
+private:
+  // name (empty for `?`) and position of the placeholder for each `$n`
+  array<string> param_names;
+  array<int64_t> param_positions;
+  array<Optional<string>> param_values;
+
+  class ExecuteResumable;
+};
+
+} // namespace pdo::pgsql
@@ -4,12 +4,17 @@
 
 #include "runtime/regexp.h"
 
+#include <algorithm>
+#include <array>
 #include <cstddef>
 #include <re2/re2.h>
+#include <unordered_map>
+#include <vector>
 #if ASAN_ENABLED
 #include <sanitizer/lsan_interface.h>
 #endif
 #include "common/unicode/utf8-utils.h"
+#include "common/wrappers/string_view.h"
 
 #include "runtime/critical_section.h"
 
@@ -30,6 +35,145 @@ static re2::StringPiece RE2_submatch[MAX_SUBPATTERNS];
 // submatch[2 * i + 1] - end position of match
 int32_t regexp::submatch[3 * MAX_SUBPATTERNS];
 pcre_extra regexp::extra;
+pcre_jit_stack *regexp::jit_stack = nullptr;
+
+namespace {
+
+constexpr int32_t PCRE_JIT_STACK_MIN_SIZE = 32 * 1024;
+constexpr int32_t PCRE_JIT_STACK_MAX_SIZE = 1024 * 1024;
+
+size_t regexp_worker_cache_memory_limit = 16 * 1024 * 1024;
+
+// Non-constant regexps compiled on the heap of the worker process, they are shared between requests.
+// A pattern is admitted on its second miss, so the patterns used once don't push the reused ones out.
+// When the cache is over the memory limit, the CLOCK hand evicts the entries which weren't hit since the hand's previous pass.
+// The script may still use the evicted regexp, so it's destroyed when the request is finished.
+class RegexpWorkerCache : vk::not_copyable {
+public:
+  const regexp *find(vk::string_view key) noexcept {
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+      ++stats_.misses;
+      return nullptr;
+    }
+    ++stats_.hits;
+    Entry &entry = entries_[it->second];
+    entry.referenced = true;
+    return entry.re;
+  }
+
+  // remembers the hash of the missed pattern and returns true if it was missed before
+  bool admit(vk::string_view key) noexcept {
+    const size_t hash = std::hash<vk::string_view>{}(key) | 1;
+    size_t &missed_hash = missed_hashes_[hash % missed_hashes_.size()];
+    if (missed_hash == hash) {
+      missed_hash = 0;
+      return true;
+    }
+    missed_hash = hash;
+    return false;
+  }
+
+  // takes the ownership of the key allocated with malloc() and of the regexp
+  void insert(vk::string_view key, const regexp *re) noexcept {
+    const Entry new_entry{key, re, key.size() + re->get_memory_usage(), false};
+    if (new_entry.memory_usage > regexp_worker_cache_memory_limit) {
+      evict(new_entry);
+      return;
+    }
+
+    while (memory_usage_ + new_entry.memory_usage > regexp_worker_cache_memory_limit) {
+      evict_by_clock_hand();
+    }
+    memory_usage_ += new_entry.memory_usage;
+    index_.emplace(new_entry.key, entries_.size());
+    entries_.push_back(new_entry);
+  }
+
+  void evict_over_memory_limit() noexcept {
+    while (memory_usage_ > regexp_worker_cache_memory_limit) {
+      evict_by_clock_hand();
+    }
+  }
+
+  void destroy_evicted() noexcept {
+    for (const Entry &entry : evicted_) {
+      free(const_cast<char *>(entry.key.data()));
+      delete entry.re;
+    }
+    evicted_.clear();
+  }
+
+  RegexpWorkerCacheStats get_stats() const noexcept {
+    RegexpWorkerCacheStats stats = stats_;
+    stats.size = entries_.size();
+    stats.memory_usage = memory_usage_;
+    return stats;
+  }
+
+private:
+  struct Entry {
+    vk::string_view key;
+    const regexp *re{nullptr};
+    size_t memory_usage{0};
+    bool referenced{false};
+  };
+
+  void evict(const Entry &entry) noexcept {
+    evicted_.push_back(entry);
+    ++stats_.evictions;
+  }
+
+  void evict_by_clock_hand() noexcept {
+    while (entries_[hand_].referenced) {
+      entries_[hand_].referenced = false;
+      hand_ = (hand_ + 1) % entries_.size();
+    }
+    Entry &victim = entries_[hand_];
+    index_.erase(victim.key);
+    memory_usage_ -= victim.memory_usage;
+    evict(victim);
+
+    // the last entry takes the place of the victim
+    if (hand_ + 1 != entries_.size()) {
+      victim = entries_.back();
+      index_[victim.key] = hand_;
+    }
+    entries_.pop_back();
+    if (hand_ == entries_.size()) {
+      hand_ = 0;
+    }
+  }
+
+  std::vector<Entry> entries_;
+  std::unordered_map<vk::string_view, size_t> index_;
+  size_t hand_{0};
+  size_t memory_usage_{0};
+  std::array<size_t, 4096> missed_hashes_{};
+  std::vector<Entry> evicted_;
+  RegexpWorkerCacheStats stats_;
+};
+
+RegexpWorkerCache &get_regexp_worker_cache() noexcept {
+  static RegexpWorkerCache worker_cache;
+  return worker_cache;
+}
+
+} // namespace
+
+void set_regexp_worker_cache_memory_limit(size_t memory_limit) noexcept {
+  regexp_worker_cache_memory_limit = memory_limit;
+  get_regexp_worker_cache().evict_over_memory_limit();
+}
+
+RegexpWorkerCacheStats get_regexp_worker_cache_stats() noexcept {
+  return get_regexp_worker_cache().get_stats();
+}
+
+void free_regexp_lib() noexcept {
+  dl::CriticalSectionGuard critical_section;
+  get_regexp_worker_cache().destroy_evicted();
+}
 
 
 regexp::regexp(const string &regexp_string) {
@@ -317,6 +461,22 @@ void regexp::init(const string &regexp_string, const char *function, const char
   use_heap_memory = (dl::get_script_memory_stats().memory_limit == 0);
 
   if (!use_heap_memory) {
+    auto &worker_cache = get_regexp_worker_cache();
+    const vk::string_view key{regexp_string.c_str(), regexp_string.size()};
+    if (const regexp *re = worker_cache.find(key)) {
+      // the failed compilations are cached too, they have no compiled data but the warning
+      re->check_pattern_compilation_warning();
+      borrow_compiled_data(*re);
+      return;
+    }
+
+    if (regexp_worker_cache_memory_limit > 0 && worker_cache.admit(key)) {
+      if (const regexp *re = compile_into_worker_cache(regexp_string, function, file)) {
+        borrow_compiled_data(*re);
+        return;
+      }
+    }
+
     if (dl::query_num != regexp_last_query_num) {
       new(regexp_cache_storage) array<regexp *>();
       regexp_last_query_num = dl::query_num;
@@ -360,7 +520,86 @@ void regexp::init(const string &regexp_string, const char *function, const char
   }
 }
 
+const regexp *regexp::compile_into_worker_cache(const string &regexp_string, const char *function, const char *file) {
+  dl::CriticalSectionGuard critical_section;
+
+  // the key is copied before the compilation, so the warnings aren't reported twice on the fallback
+  auto *key = static_cast<char *>(malloc(regexp_string.size()));
+  if (unlikely(key == nullptr)) {
+    return nullptr;
+  }
+  memcpy(key, regexp_string.c_str(), regexp_string.size());
+
+  auto *re = new regexp();
+  re->use_heap_memory = true;
+  re->compile(regexp_string.c_str(), regexp_string.size(), function, file);
+  // clean() drops the flag on failure, but the failed regexp is cached too, so it isn't recompiled on every call
+  re->use_heap_memory = true;
+
+  get_regexp_worker_cache().insert(vk::string_view{key, regexp_string.size()}, re);
+  return re;
+}
+
+size_t regexp::get_memory_usage() const noexcept {
+  size_t memory_usage = sizeof(regexp);
+  if (regex_compilation_warning) {
+    memory_usage += strlen(regex_compilation_warning) + 1;
+  }
+  if (subpattern_names) {
+    memory_usage += sizeof(string) * subpatterns_count;
+    for (int32_t i = 0; i < subpatterns_count; ++i) {
+      if (!subpattern_names[i].empty()) {
+        memory_usage += string::inner_sizeof() + subpattern_names[i].size() + 1;
+      }
+    }
+  }
+  if (pcre_regexp) {
+    size_t pcre_size = 0;
+    if (pcre_fullinfo(pcre_regexp, nullptr, PCRE_INFO_SIZE, &pcre_size) == 0) {
+      memory_usage += pcre_size;
+    }
+    if (pcre_study_extra) {
+      size_t study_size = 0;
+      if (pcre_fullinfo(pcre_regexp, pcre_study_extra, PCRE_INFO_STUDYSIZE, &study_size) == 0) {
+        memory_usage += sizeof(pcre_extra) + study_size;
+      }
+      size_t jit_size = 0;
+      if (pcre_fullinfo(pcre_regexp, pcre_study_extra, PCRE_INFO_JITSIZE, &jit_size) == 0) {
+        memory_usage += jit_size;
+      }
+    }
+  }
+  if (RE2_regexp) {
+    // RE2 doesn't report its memory, so it's estimated by the number of the instructions in its program;
+    // the reverse program and the DFA states are built lazily and aren't counted, they are limited by RE2::Options::max_mem
+    constexpr size_t RE2_INSTRUCTION_SIZE = 16;
+    memory_usage += sizeof(RE2) + RE2_regexp->pattern().size() + RE2_INSTRUCTION_SIZE * std::max(RE2_regexp->ProgramSize(), 0);
+  }
+  return memory_usage;
+}
+
+void regexp::borrow_compiled_data(const regexp &other) noexcept {
+  php_assert(other.use_heap_memory);
+
+  subpatterns_count = other.subpatterns_count;
+  named_subpatterns_count = other.named_subpatterns_count;
+  is_utf8 = other.is_utf8;
+  use_heap_memory = true;
+  from_worker_cache = true;
+
+  subpattern_names = other.subpattern_names;
+
+  pcre_regexp = other.pcre_regexp;
+  pcre_study_extra = other.pcre_study_extra;
+  RE2_regexp = other.RE2_regexp;
+}
+
 void regexp::init(const char *regexp_string, int64_t regexp_len, const char *function, const char *file) {
+  use_heap_memory = (dl::get_script_memory_stats().memory_limit == 0);
+  compile(regexp_string, regexp_len, function, file);
+}
+
+void regexp::compile(const char *regexp_string, int64_t regexp_len, const char *function, const char *file) {
   if (regexp_len == 0) {
     pattern_compilation_warning(function, file, "Empty regular expression");
     return;
@@ -411,8 +650,6 @@ void regexp::init(const char *regexp_string, int64_t regexp_len, const char *fun
 
   static_SB.clean().append(regexp_string + 1, static_cast<size_t>(regexp_end - 1));
 
-  use_heap_memory = (dl::get_script_memory_stats().memory_limit == 0);
-
   auto malloc_replacement_guard = make_malloc_replacement_with_script_allocator(!use_heap_memory);
 
   is_utf8 = false;
@@ -520,6 +757,10 @@ void regexp::init(const char *regexp_string, int64_t regexp_len, const char *fun
       clean();
       return;
     }
+    // JIT code isn't allocated on the script memory, so only the regexps living on the heap are studied
+    if (use_heap_memory) {
+      study_pcre_regexp();
+    }
   }
 
   //compile has finished
@@ -547,11 +788,7 @@ void regexp::init(const char *regexp_string, int64_t regexp_len, const char *fun
 
         for (int64_t i = 0; i < named_subpatterns_count; i++) {
           int64_t name_id = (((unsigned char)name_table[0]) << 8) + (unsigned char)name_table[1];
-          string name(name_table + 2);
-
-          if (use_heap_memory) {
-            name.set_reference_counter_to(ExtraRefCnt::for_global_const);
-          }
+          string name = make_subpattern_name(name_table + 2);
 
           if (name.is_int()) {
             pattern_compilation_warning(function, file, "Numeric named subpatterns are not allowed");
@@ -579,19 +816,74 @@ void regexp::init(const char *regexp_string, int64_t regexp_len, const char *fun
   }
 }
 
-void regexp::clean() {
+void regexp::study_pcre_regexp() noexcept {
+#ifdef PCRE_STUDY_JIT_COMPILE
+  const char *error = nullptr;
+  pcre_study_extra = pcre_study(pcre_regexp, PCRE_STUDY_JIT_COMPILE, &error);
+#if ASAN_ENABLED
+  __lsan_ignore_object(pcre_study_extra);
+#endif
+  if (pcre_study_extra == nullptr) {
+    // there is nothing to study, pcre_exec() will use the default extra
+    return;
+  }
+
+  pcre_study_extra->flags |= PCRE_EXTRA_MATCH_LIMIT | PCRE_EXTRA_MATCH_LIMIT_RECURSION;
+  pcre_study_extra->match_limit = PCRE_BACKTRACK_LIMIT;
+  pcre_study_extra->match_limit_recursion = PCRE_RECURSION_LIMIT;
+
+  if (jit_stack == nullptr) {
+    jit_stack = pcre_jit_stack_alloc(PCRE_JIT_STACK_MIN_SIZE, PCRE_JIT_STACK_MAX_SIZE);
+  }
+  if (jit_stack != nullptr) {
+    pcre_assign_jit_stack(pcre_study_extra, nullptr, jit_stack);
+  }
+#endif
+}
+
+string regexp::make_subpattern_name(const char *name) const noexcept {
   if (!use_heap_memory) {
-    // Regexp is stored inside a static cache, see regexp_cache_storage
+    return string(name);
+  }
+  // heap regexps outlive the script memory, so the names are placed on the heap too
+  const auto name_len = static_cast<string::size_type>(strlen(name));
+  const size_t memory_size = string::inner_sizeof() + name_len + 1;
+  void *memory = malloc(memory_size);
+#if ASAN_ENABLED
+  __lsan_ignore_object(memory);
+#endif
+  return string::make_const_string_on_memory(name, name_len, memory, memory_size);
+}
+
+void regexp::clean() {
+  if (!use_heap_memory || from_worker_cache) {
+    // Regexp is stored inside a static cache, see regexp_cache_storage and get_regexp_worker_cache()
     return;
   }
 
   php_assert(!dl::is_malloc_replaced());
 
+  if (subpattern_names != nullptr) {
+    // the names are placed on the heap by make_subpattern_name()
+    for (int32_t i = 0; i < subpatterns_count; ++i) {
+      if (!subpattern_names[i].empty()) {
+        free(const_cast<char *>(subpattern_names[i].c_str()) - string::inner_sizeof());
+      }
+    }
+    delete[] subpattern_names;
+    subpattern_names = nullptr;
+  }
+
   subpatterns_count = 0;
   named_subpatterns_count = 0;
   is_utf8 = false;
   use_heap_memory = false;
 
+  if (pcre_study_extra != nullptr) {
+    pcre_free_study(pcre_study_extra);
+    pcre_study_extra = nullptr;
+  }
+
   if (pcre_regexp != nullptr) {
     pcre_free(pcre_regexp);
     pcre_regexp = nullptr;
@@ -599,9 +891,6 @@ void regexp::clean() {
 
   delete RE2_regexp;
   RE2_regexp = nullptr;
-
-  delete[] subpattern_names;
-  subpattern_names = nullptr;
 }
 
 regexp::~regexp() {
@@ -645,7 +934,7 @@ int64_t regexp::exec(const string &subject, int64_t offset, bool second_try) con
 
   int32_t options = second_try ? PCRE_NO_UTF8_CHECK | PCRE_NOTEMPTY_ATSTART : PCRE_NO_UTF8_CHECK;
   dl::enter_critical_section();//OK
-  int64_t count = pcre_exec(pcre_regexp, &extra, subject.c_str(), subject.size(),
+  int64_t count = pcre_exec(pcre_regexp, pcre_study_extra ? pcre_study_extra : &extra, subject.c_str(), subject.size(),
                             static_cast<int32_t>(offset), options, submatch, 3 * subpatterns_count);
   dl::leave_critical_section();
 
@@ -1063,6 +1352,10 @@ int64_t regexp::last_error() {
       return PREG_BAD_UTF8_OFFSET_ERROR;
     case PCRE2_ERROR_BADOFFSET:
       return PHP_PCRE_INTERNAL_ERROR;
+#ifdef PCRE_ERROR_JIT_STACKLIMIT
+    case PCRE_ERROR_JIT_STACKLIMIT:
+      return PHP_PCRE_JIT_STACKLIMIT_ERROR;
+#endif
     default:
       php_assert (0);
       exit(1);
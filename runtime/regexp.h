@@ -37,7 +37,8 @@ enum {
   PHP_PCRE_BACKTRACK_LIMIT_ERROR,
   PHP_PCRE_RECURSION_LIMIT_ERROR,
   PHP_PCRE_BAD_UTF8_ERROR,
-  PREG_BAD_UTF8_OFFSET_ERROR
+  PREG_BAD_UTF8_OFFSET_ERROR,
+  PHP_PCRE_JIT_STACKLIMIT_ERROR
 };
 
 class regexp : vk::not_copyable {
@@ -46,22 +47,37 @@ private:
   int32_t named_subpatterns_count{0};
   bool is_utf8{false};
   bool use_heap_memory{false};
+  // compiled data is borrowed from the worker regexp cache and mustn't be freed
+  bool from_worker_cache{false};
 
   string *subpattern_names{nullptr};
 
   pcre *pcre_regexp{nullptr};
+  pcre_extra *pcre_study_extra{nullptr};
   re2::RE2 *RE2_regexp{nullptr};
 
   char *regex_compilation_warning{nullptr};
 
   void clean();
 
+  void compile(const char *regexp_string, int64_t regexp_len, const char *function, const char *file);
+
+  void study_pcre_regexp() noexcept;
+
+  string make_subpattern_name(const char *name) const noexcept;
+
+  void borrow_compiled_data(const regexp &other) noexcept;
+
+  static const regexp *compile_into_worker_cache(const string &regexp_string, const char *function, const char *file);
+
   int64_t exec(const string &subject, int64_t offset, bool second_try) const;
 
   bool is_valid_RE2_regexp(const char *regexp_string, int64_t regexp_len, bool is_utf8, const char *function, const char *file) noexcept;
 
   static pcre_extra extra;
 
+  static pcre_jit_stack *jit_stack;
+
   static int64_t pcre_last_error;
 
   static int32_t submatch[3 * MAX_SUBPATTERNS];
@@ -90,6 +106,9 @@ public:
     return !use_heap_memory;
   }
 
+  // the heap memory taken by the compiled regexp, approximately
+  size_t get_memory_usage() const noexcept;
+
   Optional<int64_t> match(const string &subject, bool all_matches) const;
   Optional<int64_t> match(const string &subject, mixed &matches, bool all_matches, int64_t offset = 0) const;
 
@@ -109,6 +128,21 @@ public:
 
 void global_init_regexp_lib();
 
+void set_regexp_worker_cache_memory_limit(size_t memory_limit) noexcept;
+
+struct RegexpWorkerCacheStats {
+  size_t size{0};
+  size_t memory_usage{0};
+  uint64_t hits{0};
+  uint64_t misses{0};
+  uint64_t evictions{0};
+};
+
+RegexpWorkerCacheStats get_regexp_worker_cache_stats() noexcept;
+
+// destroys the regexps evicted from the worker cache during the request
+void free_regexp_lib() noexcept;
+
 inline void preg_add_match(array<mixed> &v, const mixed &match, const string &name);
 inline void preg_add_match(array<string> &v, const string &match, const string &name);
 
@@ -7,9 +7,11 @@
 #include <cstdarg>
 #include <chrono>
 
+#include "common/algorithms/arithmetic.h"
 #include "common/rpc-error-codes.h"
 #include "common/rpc-headers.h"
 #include "common/tl/constants/common.h"
+#include "common/tl/methods/compression.h"
 
 #include "runtime/critical_section.h"
 #include "runtime/exception.h"
@@ -25,9 +27,12 @@
 #include "runtime/tl/rpc_tl_query.h"
 #include "runtime/tl/tl_builtins.h"
 #include "runtime/zlib.h"
+#include "runtime/zstd.h"
 #include "server/php-queries.h"
 
 static const int GZIP_PACKED = 0x3072cfa1;
+// the same level is used by the engines for the answers packing
+static constexpr int RPC_ZSTD_PACK_LEVEL = 1;
 
 const string tl_str_("");
 const string tl_str_underscore("_");
@@ -51,11 +56,20 @@ static const int32_t *rpc_data;
 static int32_t rpc_data_len;
 static string rpc_data_copy;
 static string rpc_filename;
+// the end of the last string fetched in place, if the data is pinned, see rpc_fetch_string_in_place()
+static const char *rpc_data_pinned_end;
+static size_t rpc_pinned_data_size;
 
 static const int *rpc_data_begin_backup;
 static const int *rpc_data_backup;
 static int rpc_data_len_backup;
 static string rpc_data_copy_backup;
+static const char *rpc_data_pinned_end_backup;
+
+// the large strings are fetched in place, if they take at least a half of the rpc answer
+static constexpr int RPC_IN_PLACE_STRING_MIN_SIZE = 4096;
+// the pinned answers are freed only at the end of the request, so they can't take more than this part of the script memory
+static constexpr size_t RPC_PINNED_DATA_MAX_PART = 8;
 
 tl_fetch_wrapper_ptr tl_fetch_wrapper;
 array<tl_storer_ptr> tl_storers_ht;
@@ -96,6 +110,7 @@ static void rpc_parse_save_backup() {
   rpc_data_begin_backup = rpc_data_begin;
   rpc_data_backup = rpc_data;
   rpc_data_len_backup = rpc_data_len;
+  rpc_data_pinned_end_backup = rpc_data_pinned_end;
 }
 
 void rpc_parse_restore_previous() {
@@ -109,6 +124,7 @@ void rpc_parse_restore_previous() {
   rpc_data_begin = rpc_data_begin_backup;
   rpc_data = rpc_data_backup;
   rpc_data_len = rpc_data_len_backup;
+  rpc_data_pinned_end = rpc_data_pinned_end_backup;
 }
 
 const char *last_rpc_error_message_get() {
@@ -130,6 +146,7 @@ void rpc_parse(const int32_t *new_rpc_data, int32_t new_rpc_data_len) {
   rpc_data_begin = new_rpc_data;
   rpc_data = new_rpc_data;
   rpc_data_len = new_rpc_data_len;
+  rpc_data_pinned_end = nullptr;
 }
 
 bool f$rpc_parse(const string &new_rpc_data) {
@@ -148,6 +165,7 @@ bool f$rpc_parse(const string &new_rpc_data) {
 
   rpc_data_begin = rpc_data = reinterpret_cast <const int *> (rpc_data_copy.c_str());
   rpc_data_len = static_cast<int>(rpc_data_copy.size() / sizeof(int));
+  rpc_data_pinned_end = nullptr;
   return true;
 }
 
@@ -177,6 +195,10 @@ bool rpc_set_pos(int32_t pos) {
   if (pos < 0 || rpc_data_begin + pos > rpc_data) {
     return false;
   }
+  // the data before the strings fetched in place is overwritten
+  if (rpc_data_pinned_end && reinterpret_cast<const char *>(rpc_data_begin + pos) < rpc_data_pinned_end) {
+    return false;
+  }
 
   rpc_data_len += static_cast<int32_t>(rpc_data - rpc_data_begin - pos);
   rpc_data = rpc_data_begin + pos;
@@ -270,9 +292,53 @@ static inline const char *f$fetch_string_raw(int *string_len) {
   return str;
 }
 
+static bool rpc_data_pin() {
+  // the parsed string is going to be changed in place, so nobody else may refer to it
+  if (rpc_data_copy.empty() || rpc_data_copy.c_str() != reinterpret_cast<const char *>(rpc_data_begin) || rpc_data_copy.get_reference_counter() != 1) {
+    return false;
+  }
+  const size_t data_size = rpc_data_copy.estimate_memory_usage();
+  if (rpc_pinned_data_size + data_size > dl::get_script_memory_stats().memory_limit / RPC_PINNED_DATA_MAX_PART) {
+    return false;
+  }
+  rpc_pinned_data_size += data_size;
+  rpc_data_pinned_end = rpc_data_copy.c_str() - STRING_RAW_HEADER_SIZE;
+
+  dl::enter_critical_section();//OK
+  rpc_data_copy.set_reference_counter_to(ExtraRefCnt::for_rpc_answer);
+  rpc_data_copy = string{};
+  dl::leave_critical_section();
+  return true;
+}
+
+// A large string is fetched without a copy: its header is written over the already fetched data right before the string,
+// and the terminating zero is written to the TL padding after it. The data is pinned then, it's freed at the end of the request,
+// and the fetched strings are read only, they are copied on the first change.
+static const char *rpc_fetch_string_in_place(const char *str, int len) {
+  if (len < RPC_IN_PLACE_STRING_MIN_SIZE || (len & 3) == 0) {
+    return nullptr;
+  }
+  if (!rpc_data_pinned_end && (static_cast<size_t>(len) * 2 < rpc_data_copy.size() || !rpc_data_pin())) {
+    return nullptr;
+  }
+  char *raw_str = const_cast<char *>(str) - STRING_RAW_HEADER_SIZE;
+  if (raw_str < rpc_data_pinned_end) {
+    return nullptr;
+  }
+  char *data = string_raw_init_header(raw_str, len, ExtraRefCnt::for_rpc_answer, 0);
+  data[len] = '\0';
+  rpc_data_pinned_end = data + len + 1;
+  return raw_str;
+}
+
 string f$fetch_string() {
   int result_len = 0;
   const char *str = TRY_CALL(const char*, string, f$fetch_string_raw(&result_len));
+  if (const char *raw_str = rpc_fetch_string_in_place(str, result_len)) {
+    string result;
+    result.assign_raw(raw_str);
+    return result;
+  }
   return {str, static_cast<string::size_type>(result_len)};
 }
 
@@ -328,16 +394,17 @@ bool f$fetch_end() {
   return true;
 }
 
-C$RpcConnection::C$RpcConnection(int32_t host_num, int32_t port, int32_t timeout_ms, int32_t actor_id, int32_t connect_timeout, int32_t reconnect_timeout) :
+C$RpcConnection::C$RpcConnection(int32_t host_num, int32_t port, int32_t timeout_ms, int32_t actor_id, int32_t connect_timeout, int32_t reconnect_timeout, bool hedging) :
   host_num(host_num),
   port(port),
   timeout_ms(timeout_ms),
   actor_id(actor_id),
   connect_timeout(connect_timeout),
-  reconnect_timeout(reconnect_timeout) {
+  reconnect_timeout(reconnect_timeout),
+  hedging(hedging) {
 }
 
-class_instance<C$RpcConnection> f$new_rpc_connection(const string &host_name, int64_t port, const mixed &actor_id, double timeout, double connect_timeout, double reconnect_timeout) {
+class_instance<C$RpcConnection> f$new_rpc_connection(const string &host_name, int64_t port, const mixed &actor_id, double timeout, double connect_timeout, double reconnect_timeout, bool hedging) {
   int32_t host_num = rpc_connect_to(host_name.c_str(), static_cast<int32_t>(port));
   if (host_num < 0) {
     return {};
@@ -345,7 +412,7 @@ class_instance<C$RpcConnection> f$new_rpc_connection(const string &host_name, in
 
   return make_instance<C$RpcConnection>(host_num, static_cast<int32_t>(port), timeout_convert_to_ms(timeout),
                                         store_parse_number<int32_t>(actor_id),
-                                        timeout_convert_to_ms(connect_timeout), timeout_convert_to_ms(reconnect_timeout));
+                                        timeout_convert_to_ms(connect_timeout), timeout_convert_to_ms(reconnect_timeout), hedging);
 }
 
 static string_buffer data_buf;
@@ -353,6 +420,8 @@ static string_buffer data_buf;
 bool rpc_stored;
 static int64_t rpc_pack_threshold;
 static int64_t rpc_pack_from;
+static int64_t rpc_zstd_pack_threshold;
+static int rpc_supported_compression_version;
 
 void estimate_and_flush_overflow(size_t &bytes_sent) {
   // estimate
@@ -389,6 +458,47 @@ void f$store_finish_gzip_pack(int64_t threshold) {
   rpc_pack_from = -1;
 }
 
+void set_rpc_zstd_pack_threshold(int64_t pack_threshold_bytes) {
+  rpc_zstd_pack_threshold = pack_threshold_bytes;
+}
+
+void rpc_set_supported_compression_version(int version) {
+  rpc_supported_compression_version = version;
+}
+
+// The answer is replaced by reqResultHeader with the compression_version flag followed by the packed answer,
+// as the engines do it, the client unpacks the answer before it's fetched.
+bool rpc_zstd_pack_answer(string_buffer &buffer, int64_t pack_from) {
+  const int64_t answer_size = buffer.size() - pack_from;
+  php_assert (pack_from % sizeof(int) == 0 && 0 <= pack_from && 0 <= answer_size);
+
+  const string_buffer *compressed = zstd_encode(buffer.c_str() + pack_from, static_cast<size_t>(answer_size), RPC_ZSTD_PACK_LEVEL);
+  const int compressed_size = static_cast<int>(compressed->size());
+  if (compressed_size == 0 || static_cast<int64_t>(4 * sizeof(int) + align4(compressed_size)) >= answer_size) {
+    return false;
+  }
+  const int32_t header[] = {
+    static_cast<int32_t>(TL_REQ_RESULT_HEADER),
+    static_cast<int32_t>(vk::tl::common::rpc_req_result_extra_flags::compression_version),
+    COMPRESSION_VERSION_ZSTD,
+    compressed_size
+  };
+  buffer.set_pos(pack_from);
+  buffer.append(reinterpret_cast<const char *>(header), sizeof(header));
+  buffer.append(compressed->buffer(), compressed_size);
+  buffer.append("\0\0\0", align4(compressed_size) - compressed_size);
+  return true;
+}
+
+static bool store_finish_zstd_pack() {
+  if (rpc_zstd_pack_threshold <= 0 || rpc_supported_compression_version < COMPRESSION_VERSION_ZSTD) {
+    return false;
+  }
+  if (data_buf.size() - rpc_pack_from < rpc_zstd_pack_threshold) {
+    return false;
+  }
+  return rpc_zstd_pack_answer(data_buf, rpc_pack_from);
+}
 
 template<class T>
 inline bool store_raw(T v) {
@@ -562,7 +672,11 @@ bool rpc_store(bool is_error) {
 
   if (!is_error) {
     rpc_pack_from = sizeof(RpcHeaders);
-    f$store_finish_gzip_pack(rpc_pack_threshold);
+    if (store_finish_zstd_pack()) {
+      rpc_pack_from = -1;
+    } else {
+      f$store_finish_gzip_pack(rpc_pack_threshold);
+    }
   }
 
   store_int(-1); // reserve for crc32
@@ -612,9 +726,9 @@ protected:
 
     /*
         if (request->resumable_id == -1) {
-          int len = *reinterpret_cast <int *>(request->answer - 12);
+          int len = *reinterpret_cast <int *>(request->answer - STRING_RAW_HEADER_SIZE + sizeof(int64_t));
           fprintf (stderr, "Receive  string of len %d at %p\n", len, request->answer);
-          for (int i = -12; i <= len; i++) {
+          for (int i = -STRING_RAW_HEADER_SIZE; i <= len; i++) {
             fprintf (stderr, "%d: %x(%d)\t%c\n", i, request->answer[i], request->answer[i], request->answer[i] >= 32 ? request->answer[i] : '.');
           }
         }
@@ -678,7 +792,9 @@ int64_t rpc_send(const class_instance<C$RpcConnection> &conn, double timeout, bo
   size_t rpc_payload_size = data_buf.size() - sizeof(RpcHeaders);
   uint32_t function_magic = CurrentProcessingQuery::get().get_last_stored_tl_function_magic();
   RpcExtraHeaders extra_headers{};
-  size_t extra_headers_size = fill_extra_headers_if_needed(extra_headers, function_magic, conn.get()->actor_id, ignore_answer);
+  const int supported_compression_version = rpc_zstd_pack_threshold > 0 ? COMPRESSION_VERSION_ZSTD : COMPRESSION_VERSION_NONE;
+  size_t extra_headers_size = fill_extra_headers_if_needed(extra_headers, function_magic, conn.get()->actor_id, ignore_answer,
+                                                           supported_compression_version);
 
   const auto request_size = static_cast<size_t>(data_buf.size() + extra_headers_size);
   char *p = static_cast<char *>(dl::allocate(request_size));
@@ -689,7 +805,8 @@ int64_t rpc_send(const class_instance<C$RpcConnection> &conn, double timeout, bo
   memcpy(p + sizeof(RpcHeaders), &extra_headers, extra_headers_size);
   memcpy(p + sizeof(RpcHeaders) + extra_headers_size, rpc_payload_start, rpc_payload_size);
 
-  slot_id_t q_id = rpc_send_query(conn.get()->host_num, p, static_cast<int>(request_size), timeout_convert_to_ms(timeout));
+  slot_id_t q_id = rpc_send_query(conn.get()->host_num, p, static_cast<int>(request_size), timeout_convert_to_ms(timeout),
+                                   conn.get()->hedging && !ignore_answer);
   if (q_id <= 0) {
     return -1;
   }
@@ -785,7 +902,7 @@ void process_rpc_answer(int32_t request_id, char *result, int32_t result_len) {
 
   if (request->resumable_id < 0) {
     php_assert (result != nullptr);
-    dl::deallocate(result - 12, result_len + 13);
+    dl::deallocate(result - STRING_RAW_HEADER_SIZE, result_len + STRING_RAW_HEADER_SIZE + 1);
     php_assert (request->resumable_id != -1);
     return;
   }
@@ -875,7 +992,7 @@ protected:
       php_assert (res.resumable_id == -1);
 
       string result;
-      result.assign_raw(res.answer - 12);
+      result.assign_raw(res.answer - STRING_RAW_HEADER_SIZE);
       RETURN(result);
     RESUMABLE_END
   }
@@ -952,7 +1069,7 @@ protected:
       php_assert (res.resumable_id == -1);
 
       string result;
-      result.assign_raw(res.answer - 12);
+      result.assign_raw(res.answer - STRING_RAW_HEADER_SIZE);
       bool parse_result = f$rpc_parse(result);
       php_assert(parse_result);
 
@@ -1401,6 +1518,8 @@ void global_init_rpc_lib() {
 }
 
 static void reset_rpc_global_vars() {
+  rpc_pinned_data_size = 0;
+  rpc_supported_compression_version = COMPRESSION_VERSION_NONE;
   hard_reset_var(rpc_filename);
   hard_reset_var(rpc_data_copy);
   hard_reset_var(rpc_data_copy_backup);
@@ -122,8 +122,10 @@ struct C$RpcConnection final : public refcountable_php_classes<C$RpcConnection>,
   int32_t actor_id{-1};
   int32_t connect_timeout{-1};
   int32_t reconnect_timeout{-1};
+  // the slow queries of this connection may be sent twice, see --rpc-hedging-percentile, so it's only for the idempotent ones
+  bool hedging{false};
 
-  C$RpcConnection(int32_t host_num, int32_t port, int32_t tmeout_ms, int32_t actor_id, int32_t connect_timeout, int32_t reconnect_timeout);
+  C$RpcConnection(int32_t host_num, int32_t port, int32_t tmeout_ms, int32_t actor_id, int32_t connect_timeout, int32_t reconnect_timeout, bool hedging);
 
   const char *get_class() const  noexcept {
     return R"(RpcConnection)";
@@ -142,10 +144,11 @@ struct C$RpcConnection final : public refcountable_php_classes<C$RpcConnection>,
     visitor("actor_id", actor_id);
     visitor("connect_timeout", connect_timeout);
     visitor("reconnect_timeout", reconnect_timeout);
+    visitor("hedging", hedging);
   }
 };
 
-class_instance<C$RpcConnection> f$new_rpc_connection(const string &host_name, int64_t port, const mixed &actor_id = 0, double timeout = 0.3, double connect_timeout = 0.3, double reconnect_timeout = 17);
+class_instance<C$RpcConnection> f$new_rpc_connection(const string &host_name, int64_t port, const mixed &actor_id = 0, double timeout = 0.3, double connect_timeout = 0.3, double reconnect_timeout = 17, bool hedging = false);
 
 void f$store_gzip_pack_threshold(int64_t pack_threshold_bytes);
 
@@ -153,6 +156,14 @@ void f$store_start_gzip_pack();
 
 void f$store_finish_gzip_pack(int64_t threshold);
 
+// the answers of at least this size are packed with zstd instead of gzip if the client supports it,
+// the support is announced in the outgoing queries as well, 0 turns both off
+void set_rpc_zstd_pack_threshold(int64_t pack_threshold_bytes);
+// the compression version supported by the client of the current rpc query
+void rpc_set_supported_compression_version(int version);
+// packs the answer stored in the buffer from the given position, returns false if it isn't worth packing
+bool rpc_zstd_pack_answer(string_buffer &buffer, int64_t pack_from);
+
 bool f$store_header(const mixed &cluster_id, int64_t flags = 0);
 
 bool f$store_error(int64_t error_code, const string &error_text);
@@ -10,6 +10,7 @@ prepend(KPHP_RUNTIME_MEMORY_RESOURCE_SOURCES memory_resource/
         dealer.cpp
         details/memory_chunk_tree.cpp
         details/memory_ordered_chunk_list.cpp
+        details/memory_slab.cpp
         heap_resource.cpp
         memory_resource.cpp
         monotonic_buffer_resource.cpp
@@ -46,7 +47,8 @@ endif()
 if (PDO_DRIVER_PGSQL)
 prepend(KPHP_RUNTIME_PDO_PGSQL_SOURCES pdo/pgsql/
         pgsql_pdo_driver.cpp
-        pgsql_pdo_emulated_statement.cpp)
+        pgsql_pdo_emulated_statement.cpp
+        pgsql_pdo_prepared_statement.cpp)
 endif()
 
 prepend(KPHP_RUNTIME_SOURCES ${BASE_DIR}/runtime/
@@ -59,6 +59,7 @@ string::string_inner *string::string_inner::create(size_type requested_capacity,
   size_type new_size = (size_type)(sizeof(string_inner) + (capacity + 1));
   string_inner *p = (string_inner *)dl::allocate(new_size);
   p->capacity = capacity;
+  p->hash = 0;
   return p;
 }
 
@@ -78,6 +79,9 @@ void string::string_inner::dispose() {
     ref_count--;
     if (ref_count <= -1) {
       destroy();
+    } else if (ref_count == 0) {
+      // the only owner may change the data in place, the cached hash can't be trusted anymore
+      hash = 0;
     }
   }
 }
@@ -641,7 +645,7 @@ string &string::assign(size_type n, bool b __attribute__((unused))) {
 
 
 void string::assign_raw(const char *s) {
-  static_assert (sizeof(string_inner) == 12u, "need 12 bytes");
+  static_assert (sizeof(string_inner) == STRING_RAW_HEADER_SIZE, "need to be compatible with string_raw()");
   p = const_cast <char *> (s + sizeof(string_inner));
 }
 
@@ -912,7 +916,22 @@ bool string::is_numeric() const {
 }
 
 int64_t string::hash() const {
-  return string_hash(p, size());
+  string_inner *s = inner();
+  // shared strings can't be modified in place, so their hash may be cached until the string becomes unshared again
+  if (s->ref_count <= 0) {
+    return string_hash(p, size());
+  }
+  if (s->hash == 0) {
+    const int64_t h = string_hash(p, size());
+    // the constant strings may be placed in read only memory, the ones made by the compiler have the hash precomputed;
+    // the strings with other extra reference counters may be read concurrently from shared memory,
+    // but the aligned 8 bytes are written at once, and every process writes the same value
+    if (s->ref_count != ExtraRefCnt::for_global_const) {
+      s->hash = h;
+    }
+    return h;
+  }
+  return s->hash;
 }
 
 
@@ -1041,6 +1060,7 @@ bool string::is_reference_counter(ExtraRefCnt ref_cnt_value) const noexcept {
 void string::set_reference_counter_to(ExtraRefCnt ref_cnt_value) noexcept {
   // some const arrays are placed in read only memory and can't be modified
   if (inner()->ref_count != ref_cnt_value) {
+    // the cached hash, if any, is kept: the data doesn't change, the hash is computed on the first hash() otherwise
     inner()->ref_count = ref_cnt_value;
   }
 }
@@ -1065,7 +1085,7 @@ inline string::size_type string::estimate_memory_usage(size_t len) noexcept {
 
 inline string string::make_const_string_on_memory(const char *str, size_type len, void *memory, size_t memory_size) {
   php_assert(len + inner_sizeof() + 1 <= memory_size);
-  auto *inner = new (memory) string_inner {len, len, ExtraRefCnt::for_global_const};
+  auto *inner = new (memory) string_inner {string_hash(str, len), len, len, ExtraRefCnt::for_global_const};
   memcpy(inner->ref_data(), str, len);
   inner->ref_data()[len] = '\0';
   string result;
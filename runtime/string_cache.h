@@ -13,23 +13,24 @@
 
 class string_cache {
 private:
-  struct string_8bytes {
-    static constexpr size_t TAIL_SIZE = 8u;
+  // the tail keeps the size a multiple of 8, so the cached hash of every string is aligned
+  struct alignas(8) string_8bytes {
+    static constexpr size_t TAIL_SIZE = 12u;
 
     constexpr explicit string_8bytes(char c) :
-      inner{1, 1, ExtraRefCnt::for_global_const},
+      inner{0, 1, 1, ExtraRefCnt::for_global_const},
       data{c, '\0'} {
     }
 
     template<size_t... Digits>
     constexpr explicit string_8bytes(std::index_sequence<Digits...>) :
-      inner{sizeof...(Digits), sizeof...(Digits), ExtraRefCnt::for_global_const},
+      inner{0, sizeof...(Digits), sizeof...(Digits), ExtraRefCnt::for_global_const},
       data{static_cast<char>('0' + Digits)..., '\0'} {
     }
 
     constexpr string_8bytes() = default;
 
-    string::string_inner inner{0, 0, ExtraRefCnt::for_global_const};
+    string::string_inner inner{0, 0, 0, ExtraRefCnt::for_global_const};
     char data[TAIL_SIZE]{'\0'};
   };
 
@@ -40,7 +40,13 @@ private:
   char *p;
 
 private:
+#pragma pack(push, 4)
   struct string_inner {
+    // string_hash() of the data cached while the string is shared (and therefore immutable), 0 if not computed;
+    // the constant strings made by the compiler have it precomputed, see string_raw(), the ones of string_cache don't,
+    // as they're in read only memory, their hash is computed on each call.
+    // It goes first to be 8-byte aligned, as the headers are allocated
+    int64_t hash;
     size_type size;
     size_type capacity;
     int ref_count;
@@ -65,6 +71,7 @@ private:
 
     inline char *clone(size_type requested_cap);
   };
+#pragma pack(pop)
 
   inline string_inner *inner() const;
 
@@ -4,10 +4,18 @@
 
 #define ZSTD_STATIC_LINKING_ONLY
 
+#include <cstring>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
 #include <zstd.h>
 
-#include "common/smart_ptrs/unique_ptr_with_delete_function.h"
+#include "common/containers/final_action.h"
+#include "common/mixin/not_copyable.h"
+#include "common/smart_ptrs/singleton.h"
 
+#include "runtime/critical_section.h"
 #include "runtime/string_functions.h"
 
 #include "runtime/zstd.h"
@@ -16,7 +24,7 @@ namespace {
 
 static_assert(2 * ZSTD_BLOCKSIZE_MAX < PHP_BUF_LEN, "double block size is expected to be less then buffer size");
 
-ZSTD_customMem make_custom_alloc() noexcept {
+ZSTD_customMem make_script_custom_alloc() noexcept {
   return ZSTD_customMem{
     [](void *, size_t size) { return dl::script_allocator_malloc(size); },
     [](void *, void *address) { dl::script_allocator_free(address); },
@@ -24,29 +32,186 @@ ZSTD_customMem make_custom_alloc() noexcept {
   };
 }
 
-template<class T, size_t (*Deleter)(T *)>
-void free_ctx_wrapper(T *ptr) { Deleter(ptr); }
+// contexts are kept in the heap between requests,
+// so every allocation made by zstd must be protected from signals
+ZSTD_customMem make_heap_custom_alloc() noexcept {
+  return ZSTD_customMem{
+    [](void *, size_t size) {
+      dl::CriticalSectionGuard critical_section;
+      return malloc(size);
+    },
+    [](void *, void *address) {
+      dl::CriticalSectionGuard critical_section;
+      free(address);
+    },
+    nullptr
+  };
+}
+
+// contexts grown by high compression levels or huge windows are freed after use instead of being kept
+constexpr size_t MAX_CACHED_CONTEXT_SIZE = 16 * 1024 * 1024;
+constexpr size_t MAX_CACHED_DICTS = 16;
+
+/**
+ * Dictionary content digested for compression (per level) and decompression.
+ * Digested dictionaries refer to the content copy owned by this object, which must be destroyed in the critical section.
+ */
+class ZstdDict : vk::not_copyable {
+public:
+  ZstdDict(int64_t hash, const string &content) noexcept:
+    hash(hash),
+    content(content.c_str(), content.size()) {
+  }
+
+  ~ZstdDict() {
+    for (auto &level_and_cdict : cdicts_) {
+      ZSTD_freeCDict(level_and_cdict.second);
+    }
+    ZSTD_freeDDict(ddict_);
+  }
+
+  bool is_same(int64_t other_hash, const string &other_content) const noexcept {
+    // the hash and the size are only the cheap checks, a dictionary found by a hash collision would corrupt the data
+    return hash == other_hash && content.size() == other_content.size()
+           && std::memcmp(content.data(), other_content.c_str(), content.size()) == 0;
+  }
+
+  ZSTD_CDict *get_cdict(int level) noexcept {
+    for (const auto &level_and_cdict : cdicts_) {
+      if (level_and_cdict.first == level) {
+        return level_and_cdict.second;
+      }
+    }
+    dl::CriticalSectionGuard critical_section;
+    ZSTD_CDict *cdict = ZSTD_createCDict_byReference(content.data(), content.size(), level);
+    if (cdict) {
+      cdicts_.emplace_back(level, cdict);
+    }
+    return cdict;
+  }
+
+  ZSTD_DDict *get_ddict() noexcept {
+    if (!ddict_) {
+      dl::CriticalSectionGuard critical_section;
+      ddict_ = ZSTD_createDDict_byReference(content.data(), content.size());
+    }
+    return ddict_;
+  }
 
-using ZSTD_CCtxPtr = vk::unique_ptr_with_delete_function<ZSTD_CStream, free_ctx_wrapper<ZSTD_CCtx, ZSTD_freeCCtx>>;
-using ZSTD_DCtxPtr = vk::unique_ptr_with_delete_function<ZSTD_DCtx, free_ctx_wrapper<ZSTD_DCtx, ZSTD_freeDCtx>>;
+  const int64_t hash{0};
+  const std::string content;
 
-Optional<string> zstd_compress_impl(const string &data, int64_t level = DEFAULT_COMPRESS_LEVEL, const string &dict = string{}) noexcept {
-  ZSTD_CCtxPtr ctx{ZSTD_createCCtx_advanced(make_custom_alloc())};
+private:
+  std::vector<std::pair<int, ZSTD_CDict *>> cdicts_;
+  ZSTD_DDict *ddict_{nullptr};
+};
+
+/**
+ * Per worker zstd state: contexts reused by all calls and the LRU cache of digested dictionaries.
+ * Dictionaries are looked up by the content hash and size.
+ */
+class ZstdWorkerCache : vk::not_copyable {
+public:
+  ZSTD_CCtx *get_cctx() noexcept {
+    if (!cctx_) {
+      cctx_ = ZSTD_createCCtx_advanced(make_heap_custom_alloc());
+    } else {
+      ZSTD_CCtx_reset(cctx_, ZSTD_reset_session_and_parameters);
+    }
+    return cctx_;
+  }
+
+  ZSTD_DCtx *get_dctx() noexcept {
+    if (!dctx_) {
+      dctx_ = ZSTD_createDCtx_advanced(make_heap_custom_alloc());
+    } else {
+      ZSTD_DCtx_reset(dctx_, ZSTD_reset_session_and_parameters);
+    }
+    return dctx_;
+  }
+
+  void shrink_contexts() noexcept {
+    if (cctx_ && ZSTD_sizeof_CCtx(cctx_) > MAX_CACHED_CONTEXT_SIZE) {
+      ZSTD_freeCCtx(std::exchange(cctx_, nullptr));
+    }
+    if (dctx_ && ZSTD_sizeof_DCtx(dctx_) > MAX_CACHED_CONTEXT_SIZE) {
+      ZSTD_freeDCtx(std::exchange(dctx_, nullptr));
+    }
+  }
+
+  std::shared_ptr<ZstdDict> get_dict(const string &content) noexcept {
+    const int64_t hash = content.hash();
+    dl::CriticalSectionGuard critical_section;
+    for (auto it = dicts_.begin(); it != dicts_.end(); ++it) {
+      if ((*it)->is_same(hash, content)) {
+        dicts_.splice(dicts_.begin(), dicts_, it);
+        return dicts_.front();
+      }
+    }
+    dicts_.emplace_front(std::make_shared<ZstdDict>(hash, content));
+    if (dicts_.size() > MAX_CACHED_DICTS) {
+      dicts_.pop_back();
+    }
+    return dicts_.front();
+  }
+
+  int64_t add_dict_handle(std::shared_ptr<ZstdDict> &&dict) noexcept {
+    dl::CriticalSectionGuard critical_section;
+    dict_handles_.emplace_back(std::move(dict));
+    return static_cast<int64_t>(dict_handles_.size());
+  }
+
+  ZstdDict *get_dict_by_handle(int64_t dict_id) const noexcept {
+    if (dict_id <= 0 || dict_id > static_cast<int64_t>(dict_handles_.size())) {
+      return nullptr;
+    }
+    return dict_handles_[dict_id - 1].get();
+  }
+
+  void free_dict_handles() noexcept {
+    dl::CriticalSectionGuard critical_section;
+    dict_handles_.clear();
+  }
+
+private:
+  ZstdWorkerCache() = default;
+
+  ZSTD_CCtx *cctx_{nullptr};
+  ZSTD_DCtx *dctx_{nullptr};
+  // the most recently used dictionaries are at the front
+  std::list<std::shared_ptr<ZstdDict>> dicts_;
+  // dictionaries pinned by zstd_dict_load() until the end of the request
+  std::vector<std::shared_ptr<ZstdDict>> dict_handles_;
+
+  friend class vk::singleton<ZstdWorkerCache>;
+};
+
+Optional<string> zstd_compress_impl(const string &data, int64_t level = DEFAULT_COMPRESS_LEVEL, ZstdDict *dict = nullptr) noexcept {
+  auto &cache = vk::singleton<ZstdWorkerCache>::get();
+  ZSTD_CCtx *ctx = cache.get_cctx();
   if (!ctx) {
     php_warning("zstd_compress: can not create context");
     return false;
   }
+  auto contexts_shrinker = vk::finally([&cache] { cache.shrink_contexts(); });
 
-  size_t result = ZSTD_CCtx_setParameter(ctx.get(), ZSTD_c_compressionLevel, static_cast<int>(level));
+  size_t result = ZSTD_CCtx_setParameter(ctx, ZSTD_c_compressionLevel, static_cast<int>(level));
   if (ZSTD_isError(result)) {
     php_warning("zstd_compress: can not init context: %s", ZSTD_getErrorName(result));
     return false;
   }
 
-  result = ZSTD_CCtx_loadDictionary_byReference(ctx.get(), dict.c_str(), dict.size());
-  if (ZSTD_isError(result)) {
-    php_warning("zstd_compress: can not load dict: %s", ZSTD_getErrorName(result));
-    return false;
+  if (dict) {
+    ZSTD_CDict *cdict = dict->get_cdict(static_cast<int>(level));
+    if (!cdict) {
+      php_warning("zstd_compress: can not load dict");
+      return false;
+    }
+    result = ZSTD_CCtx_refCDict(ctx, cdict);
+    if (ZSTD_isError(result)) {
+      php_warning("zstd_compress: can not load dict: %s", ZSTD_getErrorName(result));
+      return false;
+    }
   }
 
   php_assert(ZSTD_CStreamOutSize() <= PHP_BUF_LEN);
@@ -55,7 +220,7 @@ Optional<string> zstd_compress_impl(const string &data, int64_t level = DEFAULT_
 
   string encoded_string;
   do {
-    result = ZSTD_compressStream2(ctx.get(), &out, &in, ZSTD_e_end);
+    result = ZSTD_compressStream2(ctx, &out, &in, ZSTD_e_end);
     if (ZSTD_isError(result)) {
       php_warning("zstd_compress: got zstd stream compression error: %s", ZSTD_getErrorName(result));
       return false;
@@ -66,23 +231,33 @@ Optional<string> zstd_compress_impl(const string &data, int64_t level = DEFAULT_
   return encoded_string;
 }
 
-Optional<string> zstd_uncompress_impl(const string &data, const string &dict = string{}) noexcept {
+Optional<string> zstd_uncompress_impl(const string &data, ZstdDict *dict = nullptr) noexcept {
   auto size = ZSTD_getFrameContentSize(data.c_str(), data.size());
   if (size == ZSTD_CONTENTSIZE_ERROR) {
     php_warning("zstd_uncompress: it was not compressed by zstd");
     return false;
   }
 
-  ZSTD_DCtxPtr ctx{ZSTD_createDCtx_advanced(make_custom_alloc())};
+  auto &cache = vk::singleton<ZstdWorkerCache>::get();
+  ZSTD_DCtx *ctx = cache.get_dctx();
   if (!ctx) {
     php_warning("zstd_uncompress: can not create context");
     return false;
   }
+  auto contexts_shrinker = vk::finally([&cache] { cache.shrink_contexts(); });
 
-  size_t result = ZSTD_DCtx_loadDictionary_byReference(ctx.get(), dict.c_str(), dict.size());
-  if (ZSTD_isError(result)) {
-    php_warning("zstd_uncompress: can not load dict: %s", ZSTD_getErrorName(result));
-    return false;
+  size_t result = 0;
+  if (dict) {
+    ZSTD_DDict *ddict = dict->get_ddict();
+    if (!ddict) {
+      php_warning("zstd_uncompress: can not load dict");
+      return false;
+    }
+    result = ZSTD_DCtx_refDDict(ctx, ddict);
+    if (ZSTD_isError(result)) {
+      php_warning("zstd_uncompress: can not load dict: %s", ZSTD_getErrorName(result));
+      return false;
+    }
   }
 
   if (size != ZSTD_CONTENTSIZE_UNKNOWN) {
@@ -91,7 +266,7 @@ Optional<string> zstd_uncompress_impl(const string &data, const string &dict = s
       return false;
     }
     string decompressed{static_cast<string::size_type>(size), false};
-    result = ZSTD_decompressDCtx(ctx.get(), decompressed.buffer(), size, data.c_str(), data.size());
+    result = ZSTD_decompressDCtx(ctx, decompressed.buffer(), size, data.c_str(), data.size());
     if (ZSTD_isError(result)) {
       php_warning("zstd_uncompress: got zstd error: %s", ZSTD_getErrorName(result));
       return false;
@@ -99,11 +274,6 @@ Optional<string> zstd_uncompress_impl(const string &data, const string &dict = s
     return decompressed;
   }
 
-  if (ZSTD_isError(result)) {
-    php_warning("zstd_uncompress: can not init stream: %s", ZSTD_getErrorName(result));
-    return false;
-  }
-
   php_assert(ZSTD_DStreamOutSize() <= PHP_BUF_LEN);
   ZSTD_inBuffer in{data.c_str(), data.size(), 0};
   ZSTD_outBuffer out{php_buf, PHP_BUF_LEN, 0};
@@ -115,7 +285,7 @@ Optional<string> zstd_uncompress_impl(const string &data, const string &dict = s
       out.pos = 0;
     }
 
-    result = ZSTD_decompressStream(ctx.get(), &out, &in);
+    result = ZSTD_decompressStream(ctx, &out, &in);
     if (ZSTD_isError(result)) {
       php_warning("zstd_uncompress: can not decompress stream: %s", ZSTD_getErrorName(result));
       return false;
@@ -128,16 +298,84 @@ Optional<string> zstd_uncompress_impl(const string &data, const string &dict = s
   return decoded_string;
 }
 
-} // namespace
+std::shared_ptr<ZstdDict> get_cached_dict(const string &dict) noexcept {
+  return dict.empty() ? nullptr : vk::singleton<ZstdWorkerCache>::get().get_dict(dict);
+}
 
-Optional<string> f$zstd_compress(const string &data, int64_t level) noexcept {
+bool check_compress_level(int64_t level) noexcept {
   const int min_level = ZSTD_minCLevel();
   const int max_level = ZSTD_maxCLevel();
   if (min_level > level || level > max_level) {
     php_warning("zstd_compress: compression level (%" PRIi64 ") must be within %d..%d or equal to 0", level, min_level, max_level);
     return false;
   }
+  return true;
+}
+
+ZstdDict *get_dict_by_handle(int64_t dict_id) noexcept {
+  ZstdDict *dict = vk::singleton<ZstdWorkerCache>::get().get_dict_by_handle(dict_id);
+  if (unlikely(!dict)) {
+    php_warning("Wrong zstd dict id %" PRIi64 " specified", dict_id);
+  }
+  return dict;
+}
+
+Optional<string> zstd_stream_compress(ZSTD_CCtx *ctx, const string &data, ZSTD_EndDirective directive, const char *function) noexcept {
+  php_assert(ZSTD_CStreamOutSize() <= PHP_BUF_LEN);
+  ZSTD_outBuffer out{php_buf, PHP_BUF_LEN, 0};
+  ZSTD_inBuffer in{data.c_str(), data.size(), 0};
+
+  string encoded_string;
+  size_t result = 0;
+  do {
+    result = ZSTD_compressStream2(ctx, &out, &in, directive);
+    if (ZSTD_isError(result)) {
+      php_warning("%s: got zstd stream compression error: %s", function, ZSTD_getErrorName(result));
+      ZSTD_CCtx_reset(ctx, ZSTD_reset_session_only);
+      return false;
+    }
+    encoded_string.append(static_cast<char *>(out.dst), static_cast<string::size_type>(out.pos));
+    out.pos = 0;
+  } while (directive == ZSTD_e_end ? result != 0 : in.pos < in.size);
+  return encoded_string;
+}
+
+Optional<string> zstd_stream_decompress(C$ZstdContext &context, const string &data, const char *function) noexcept {
+  php_assert(ZSTD_DStreamOutSize() <= PHP_BUF_LEN);
+  ZSTD_inBuffer in{data.c_str(), data.size(), 0};
+  ZSTD_outBuffer out{php_buf, PHP_BUF_LEN, 0};
+
+  string decoded_string;
+  // a full output buffer means that zstd may still have buffered data to flush
+  bool out_is_full = false;
+  while (in.pos < in.size || out_is_full) {
+    const size_t result = ZSTD_decompressStream(context.dctx, &out, &in);
+    if (ZSTD_isError(result)) {
+      php_warning("%s: can not decompress stream: %s", function, ZSTD_getErrorName(result));
+      ZSTD_DCtx_reset(context.dctx, ZSTD_reset_session_only);
+      context.frame_finished = true;
+      return false;
+    }
+    decoded_string.append(static_cast<char *>(out.dst), static_cast<string::size_type>(out.pos));
+    out_is_full = out.pos == out.size;
+    out.pos = 0;
+    context.frame_finished = result == 0;
+  }
+  return decoded_string;
+}
+
+} // namespace
+
+C$ZstdContext::~C$ZstdContext() {
+  dl::CriticalSectionGuard guard;
+  ZSTD_freeCCtx(cctx);
+  ZSTD_freeDCtx(dctx);
+}
 
+Optional<string> f$zstd_compress(const string &data, int64_t level) noexcept {
+  if (!check_compress_level(level)) {
+    return false;
+  }
   return zstd_compress_impl(data, level);
 }
 
@@ -145,10 +383,178 @@ Optional<string> f$zstd_uncompress(const string &data) noexcept {
   return zstd_uncompress_impl(data);
 }
 
-Optional<string> f$zstd_compress_dict(const string &data, const string &dict) noexcept {
-  return zstd_compress_impl(data, DEFAULT_COMPRESS_LEVEL, dict);
+Optional<string> f$zstd_compress_dict(const string &data, const string &dict, int64_t level) noexcept {
+  if (!check_compress_level(level)) {
+    return false;
+  }
+  return zstd_compress_impl(data, level, get_cached_dict(dict).get());
 }
 
 Optional<string> f$zstd_uncompress_dict(const string &data, const string &dict) noexcept {
+  return zstd_uncompress_impl(data, get_cached_dict(dict).get());
+}
+
+int64_t f$zstd_dict_load(const string &dict) noexcept {
+  if (dict.empty()) {
+    php_warning("zstd_dict_load: dict is empty");
+    return 0;
+  }
+  return vk::singleton<ZstdWorkerCache>::get().add_dict_handle(get_cached_dict(dict));
+}
+
+Optional<string> f$zstd_compress_with_dict(const string &data, int64_t dict_id, int64_t level) noexcept {
+  ZstdDict *dict = get_dict_by_handle(dict_id);
+  if (!dict || !check_compress_level(level)) {
+    return false;
+  }
+  return zstd_compress_impl(data, level, dict);
+}
+
+Optional<string> f$zstd_uncompress_with_dict(const string &data, int64_t dict_id) noexcept {
+  ZstdDict *dict = get_dict_by_handle(dict_id);
+  if (!dict) {
+    return false;
+  }
   return zstd_uncompress_impl(data, dict);
 }
+
+class_instance<C$ZstdContext> f$zstd_stream_init(int64_t mode, const array<mixed> &options) noexcept {
+  if (mode != ZSTD_STREAM_COMPRESS && mode != ZSTD_STREAM_DECOMPRESS) {
+    php_warning("zstd_stream_init: mode should be one of ZSTD_STREAM_COMPRESS, ZSTD_STREAM_DECOMPRESS");
+    return {};
+  }
+  const bool compress = mode == ZSTD_STREAM_COMPRESS;
+
+  int64_t level = DEFAULT_COMPRESS_LEVEL;
+  int64_t window_log = 0;
+  bool long_distance_matching = false;
+  string dict;
+  for (const auto &option : options) {
+    if (!option.is_string_key()) {
+      php_warning("zstd_stream_init: unsupported option");
+      return {};
+    }
+    const string &name = option.get_string_key();
+    const mixed &value = option.get_value();
+    if (compress && name == string{"level"}) {
+      if (!value.is_int()) {
+        php_warning("zstd_stream_init: option level should be int");
+        return {};
+      }
+      if (!check_compress_level(value.as_int())) {
+        return {};
+      }
+      level = value.as_int();
+    } else if (name == string{"window_log"}) {
+      if (!value.is_int() || value.as_int() < ZSTD_WINDOWLOG_MIN || value.as_int() > ZSTD_WINDOWLOG_MAX) {
+        php_warning("zstd_stream_init: option window_log should be number between %d..%d", ZSTD_WINDOWLOG_MIN, ZSTD_WINDOWLOG_MAX);
+        return {};
+      }
+      window_log = value.as_int();
+    } else if (compress && name == string{"long_distance_matching"}) {
+      if (!value.is_bool()) {
+        php_warning("zstd_stream_init: option long_distance_matching should be bool");
+        return {};
+      }
+      long_distance_matching = value.as_bool();
+    } else if (name == string{"dict"}) {
+      if (!value.is_string()) {
+        php_warning("zstd_stream_init: option dict should be string");
+        return {};
+      }
+      dict = value.as_string();
+    } else {
+      php_warning("zstd_stream_init: unknown option name \"%s\"", name.c_str());
+      return {};
+    }
+  }
+
+  class_instance<C$ZstdContext> context;
+  context.alloc();
+
+  dl::CriticalSectionGuard guard;
+  size_t result = 0;
+  const auto set_param = [&result](auto setter) {
+    if (!ZSTD_isError(result)) {
+      result = setter();
+    }
+  };
+  if (compress) {
+    ZSTD_CCtx *ctx = context->cctx = ZSTD_createCCtx_advanced(make_script_custom_alloc());
+    if (!ctx) {
+      php_warning("zstd_stream_init: can not create context");
+      return {};
+    }
+    set_param([&] { return ZSTD_CCtx_setParameter(ctx, ZSTD_c_compressionLevel, static_cast<int>(level)); });
+    // the output is produced synchronously by the calls, so the compression is never offloaded to threads
+    set_param([&] { return ZSTD_CCtx_setParameter(ctx, ZSTD_c_nbWorkers, 0); });
+    set_param([&] { return ZSTD_CCtx_setParameter(ctx, ZSTD_c_windowLog, static_cast<int>(window_log)); });
+    set_param([&] { return ZSTD_CCtx_setParameter(ctx, ZSTD_c_enableLongDistanceMatching, long_distance_matching ? 1 : 0); });
+    if (!dict.empty()) {
+      set_param([&] { return ZSTD_CCtx_loadDictionary(ctx, dict.c_str(), dict.size()); });
+    }
+  } else {
+    ZSTD_DCtx *ctx = context->dctx = ZSTD_createDCtx_advanced(make_script_custom_alloc());
+    if (!ctx) {
+      php_warning("zstd_stream_init: can not create context");
+      return {};
+    }
+    set_param([&] { return ZSTD_DCtx_setParameter(ctx, ZSTD_d_windowLogMax, static_cast<int>(window_log)); });
+    if (!dict.empty()) {
+      set_param([&] { return ZSTD_DCtx_loadDictionary(ctx, dict.c_str(), dict.size()); });
+    }
+  }
+  if (ZSTD_isError(result)) {
+    php_warning("zstd_stream_init: can not init context: %s", ZSTD_getErrorName(result));
+    return {};
+  }
+  return context;
+}
+
+Optional<string> f$zstd_stream_add(const class_instance<C$ZstdContext> &context, const string &data) noexcept {
+  dl::CriticalSectionGuard guard;
+  if (context->cctx) {
+    return zstd_stream_compress(context->cctx, data, ZSTD_e_continue, "zstd_stream_add");
+  }
+  return zstd_stream_decompress(*context.get(), data, "zstd_stream_add");
+}
+
+Optional<string> f$zstd_stream_finish(const class_instance<C$ZstdContext> &context, const string &data) noexcept {
+  dl::CriticalSectionGuard guard;
+  if (context->cctx) {
+    return zstd_stream_compress(context->cctx, data, ZSTD_e_end, "zstd_stream_finish");
+  }
+  Optional<string> result = zstd_stream_decompress(*context.get(), data, "zstd_stream_finish");
+  if (result.has_value() && !context->frame_finished) {
+    php_warning("zstd_stream_finish: the data ends in the middle of a frame");
+    ZSTD_DCtx_reset(context->dctx, ZSTD_reset_session_only);
+    context->frame_finished = true;
+    return false;
+  }
+  return result;
+}
+
+const string_buffer *zstd_encode(const char *s, size_t s_len, int level) noexcept {
+  static_SB.clean();
+  auto &cache = vk::singleton<ZstdWorkerCache>::get();
+  ZSTD_CCtx *ctx = cache.get_cctx();
+  if (!ctx) {
+    php_warning("zstd_encode: can not create context");
+    return &static_SB;
+  }
+  auto contexts_shrinker = vk::finally([&cache] { cache.shrink_contexts(); });
+
+  const size_t bound = ZSTD_compressBound(s_len);
+  static_SB.reserve(static_cast<int>(bound));
+  const size_t result = ZSTD_compressCCtx(ctx, static_SB.buffer(), bound, s, s_len, level);
+  if (ZSTD_isError(result)) {
+    php_warning("zstd_encode: got zstd compression error: %s", ZSTD_getErrorName(result));
+    return &static_SB;
+  }
+  static_SB.set_pos(static_cast<int64_t>(result));
+  return &static_SB;
+}
+
+void free_zstd_lib() noexcept {
+  vk::singleton<ZstdWorkerCache>::get().free_dict_handles();
+}
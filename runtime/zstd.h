@@ -4,15 +4,53 @@
 
 #pragma once
 
+#include "runtime/dummy-visitor-methods.h"
 #include "runtime/kphp_core.h"
 #include "runtime/optional.h"
+#include "runtime/refcountable_php_classes.h"
+
+struct ZSTD_CCtx_s;
+struct ZSTD_DCtx_s;
 
 constexpr int DEFAULT_COMPRESS_LEVEL = 3;
 
+constexpr int64_t ZSTD_STREAM_COMPRESS = 0;
+constexpr int64_t ZSTD_STREAM_DECOMPRESS = 1;
+
+struct C$ZstdContext : public refcountable_php_classes<C$ZstdContext>, private DummyVisitorMethods {
+  C$ZstdContext() = default;
+  using DummyVisitorMethods::accept;
+
+  ~C$ZstdContext();
+
+  // exactly one of them is set, both are allocated in the script memory
+  ZSTD_CCtx_s *cctx{nullptr};
+  ZSTD_DCtx_s *dctx{nullptr};
+  // decompression only: whether the last consumed input has ended a frame
+  bool frame_finished{true};
+};
+
 Optional<string> f$zstd_compress(const string &data, int64_t level = DEFAULT_COMPRESS_LEVEL) noexcept;
 
 Optional<string> f$zstd_uncompress(const string &data) noexcept;
 
-Optional<string> f$zstd_compress_dict(const string &data, const string &dict) noexcept;
+Optional<string> f$zstd_compress_dict(const string &data, const string &dict, int64_t level = DEFAULT_COMPRESS_LEVEL) noexcept;
 
 Optional<string> f$zstd_uncompress_dict(const string &data, const string &dict) noexcept;
+
+int64_t f$zstd_dict_load(const string &dict) noexcept;
+
+Optional<string> f$zstd_compress_with_dict(const string &data, int64_t dict_id, int64_t level = DEFAULT_COMPRESS_LEVEL) noexcept;
+
+Optional<string> f$zstd_uncompress_with_dict(const string &data, int64_t dict_id) noexcept;
+
+class_instance<C$ZstdContext> f$zstd_stream_init(int64_t mode, const array<mixed> &options = {}) noexcept;
+
+Optional<string> f$zstd_stream_add(const class_instance<C$ZstdContext> &context, const string &data) noexcept;
+
+Optional<string> f$zstd_stream_finish(const class_instance<C$ZstdContext> &context, const string &data = string{}) noexcept;
+
+// compresses the data into a single zstd frame, returns pointer to static_SB, which is empty on error
+const string_buffer *zstd_encode(const char *s, size_t s_len, int level) noexcept;
+
+void free_zstd_lib() noexcept;
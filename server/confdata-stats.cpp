@@ -80,6 +80,11 @@ void ConfdataStats::write_stats_to(stats_t *stats, const memory_resource::Memory
   stats->add_gauge_stat("confdata.total_updating_time", to_seconds(total_updating_time));
   stats->add_gauge_stat("confdata.seconds_since_last_update", to_seconds(std::chrono::steady_clock::now() - last_update_time_point));
 
+  const auto &hash_index_stats = ConfdataGlobalManager::get().get_hash_index_stats();
+  stats->add_gauge_stat("confdata.hash_index.built", hash_index_stats.built);
+  stats->add_gauge_stat("confdata.hash_index.failed", hash_index_stats.failed);
+  stats->add_gauge_stat("confdata.hash_index.bytes", hash_index_stats.bytes);
+
   stats->add_gauge_stat("confdata.updates.ignored", ignored_updates);
   stats->add_gauge_stat("confdata.updates.total", total_updates);
 
@@ -7,6 +7,7 @@
 #include "runtime/critical_section.h"
 #include "runtime/net_events.h"
 #include "runtime/resumable.h"
+#include "server/database-drivers/connection-pool.h"
 #include "server/database-drivers/connector.h"
 #include "server/database-drivers/request.h"
 #include "server/database-drivers/response.h"
@@ -76,8 +77,10 @@ int Adaptor::initiate_connect(std::unique_ptr<Connector> &&connector) noexcept {
 }
 
 void Adaptor::reset() noexcept {
+  // idle connectors return their connections to the pool on destruction
   connectors.clear();
   processing_requests.clear();
+  vk::singleton<ConnectionPool>::get().close_expired();
 }
 
 int Adaptor::epoll_gateway(int fd, void *data, event_t *ev) noexcept {
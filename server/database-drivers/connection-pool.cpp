@@ -0,0 +1,85 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2023 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "server/database-drivers/connection-pool.h"
+
+#include <cerrno>
+#include <sys/socket.h>
+
+#include "common/precise-time.h"
+#include "runtime/critical_section.h"
+
+namespace database_drivers {
+
+namespace {
+
+// An idle connection must have nothing to read: EOF means that the server has closed it,
+// and any unsolicited data (e.g. an error packet before disconnect) makes the protocol state unknown
+bool is_idle_connection_alive(int fd) noexcept {
+  if (fd < 0) {
+    return false;
+  }
+  char c = 0;
+  const ssize_t res = recv(fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+  return res < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+}
+
+} // namespace
+
+std::unique_ptr<PooledConnection> ConnectionPool::acquire(const std::string &key) noexcept {
+  dl::CriticalSectionGuard guard;
+  close_expired();
+
+  for (auto it = idle_connections_.begin(); it != idle_connections_.end();) {
+    if (it->key != key) {
+      ++it;
+      continue;
+    }
+    std::unique_ptr<PooledConnection> connection = std::move(it->connection);
+    it = idle_connections_.erase(it);
+    if (!is_idle_connection_alive(connection->get_fd())) {
+      ++stats_.health_check_failures;
+      continue;
+    }
+    ++stats_.hits;
+    stats_.idle_connections = idle_connections_.size();
+    return connection;
+  }
+
+  ++stats_.misses;
+  stats_.idle_connections = idle_connections_.size();
+  return nullptr;
+}
+
+void ConnectionPool::release(std::string key, std::unique_ptr<PooledConnection> &&connection) noexcept {
+  dl::CriticalSectionGuard guard;
+  if (!enabled()) {
+    return;
+  }
+
+  idle_connections_.push_front(IdleConnection{std::move(key), std::move(connection), get_utime_monotonic()});
+  while (idle_connections_.size() > max_idle_connections_) {
+    idle_connections_.pop_back();
+    ++stats_.evictions;
+  }
+  stats_.idle_connections = idle_connections_.size();
+}
+
+void ConnectionPool::close_expired() noexcept {
+  dl::CriticalSectionGuard guard;
+  const double now = get_utime_monotonic();
+  while (!idle_connections_.empty() && now - idle_connections_.back().released_at > idle_timeout_sec_) {
+    idle_connections_.pop_back();
+    ++stats_.evictions;
+  }
+  stats_.idle_connections = idle_connections_.size();
+}
+
+void ConnectionPool::clear() noexcept {
+  dl::CriticalSectionGuard guard;
+  idle_connections_.clear();
+  stats_.idle_connections = 0;
+}
+
+} // namespace database_drivers
@@ -0,0 +1,113 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2023 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+
+#include "common/mixin/not_copyable.h"
+#include "common/smart_ptrs/singleton.h"
+
+namespace database_drivers {
+
+/**
+ * Established DB connection detached from its Connector.
+ * It lives in the heap memory, so it survives the script memory reset, and closes the connection on destruction.
+ */
+class PooledConnection : vk::not_copyable {
+public:
+  virtual ~PooledConnection() noexcept = default;
+
+  /**
+   * @brief Gets file descriptor number of underlying connection.
+   */
+  virtual int get_fd() const noexcept = 0;
+};
+
+/**
+ * Per worker pool of idle DB connections, which survives Adaptor::reset() between requests.
+ * Connections are looked up by the key built from DSN and credentials, so a connection is never shared between different users or databases.
+ * The session state left by the previous request (session variables, roles, temporary tables, locks etc.) is reset by the Connector
+ * which takes the connection, asynchronously, before its first request, @see Connector::send_session_reset_async().
+ * All operations are in the critical section.
+ */
+class ConnectionPool : vk::not_copyable {
+public:
+  struct Stats {
+    uint64_t idle_connections{0};
+    uint64_t hits{0};
+    uint64_t misses{0};
+    uint64_t health_check_failures{0};
+    uint64_t session_reset_failures{0};
+    uint64_t evictions{0};
+  };
+
+  /**
+   * @brief Takes an idle connection established with the same @a key.
+   * @param key
+   * @return Live connection or nullptr if there is no suitable one.
+   *
+   * Connections closed by the server side are detected without a round-trip and dropped.
+   */
+  std::unique_ptr<PooledConnection> acquire(const std::string &key) noexcept;
+
+  /**
+   * @brief Returns @a connection to the pool, the caller must guarantee that the connection is idle and has no open transaction.
+   * @param key
+   * @param connection
+   *
+   * If the pool is full, the least recently used connection is closed.
+   */
+  void release(std::string key, std::unique_ptr<PooledConnection> &&connection) noexcept;
+
+  /**
+   * @brief Closes the connections which were idle for too long.
+   */
+  void close_expired() noexcept;
+
+  void clear() noexcept;
+
+  void on_session_reset_failure() noexcept {
+    ++stats_.session_reset_failures;
+  }
+
+  bool enabled() const noexcept {
+    return max_idle_connections_ > 0;
+  }
+
+  void set_max_idle_connections(size_t max_idle_connections) noexcept {
+    max_idle_connections_ = max_idle_connections;
+  }
+
+  void set_idle_timeout(double idle_timeout_sec) noexcept {
+    idle_timeout_sec_ = idle_timeout_sec;
+  }
+
+  const Stats &get_stats() const noexcept {
+    return stats_;
+  }
+
+private:
+  struct IdleConnection {
+    std::string key;
+    std::unique_ptr<PooledConnection> connection;
+    double released_at{0};
+  };
+
+  ConnectionPool() = default;
+
+  // the most recently released connections are at the front
+  std::list<IdleConnection> idle_connections_;
+  size_t max_idle_connections_{8};
+  double idle_timeout_sec_{60};
+  Stats stats_;
+
+  friend class vk::singleton<ConnectionPool>;
+};
+
+} // namespace database_drivers
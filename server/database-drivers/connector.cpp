@@ -7,19 +7,32 @@
 #include "net/net-events.h"
 #include "runtime/critical_section.h"
 #include "server/database-drivers/adaptor.h"
+#include "server/database-drivers/connection-pool.h"
+#include "server/database-drivers/request.h"
 #include "server/php-queries.h"
 
 namespace database_drivers {
 
 void Connector::push_async_request(std::unique_ptr<Request> &&request) noexcept {
   dl::CriticalSectionGuard guard;
-  assert(pending_request == nullptr && pending_response == nullptr && "Pipelining is not allowed");
+  if (session_reset_failed) {
+    fail_request(std::move(request));
+    return;
+  }
+  if (session_reset_pending || pending_request != nullptr || pending_response != nullptr) {
+    queued_requests.emplace_back(std::move(request));
+    return;
+  }
   pending_request = std::move(request);
   update_state_ready_to_write();
 }
 
 void Connector::handle_write() noexcept {
   assert(connected());
+  if (session_reset_pending) {
+    on_session_reset_status(send_session_reset_async(), false);
+    return;
+  }
   assert(pending_request);
 
   AsyncOperationStatus status = pending_request->send_async();
@@ -36,12 +49,16 @@ void Connector::handle_write() noexcept {
       response->is_error = true;
       pending_request = nullptr;
       vk::singleton<Adaptor>::get().finish_request_resumable(std::move(response));
-      update_state_idle();
+      send_next_queued_request();
       break;
   }
 }
 
 void Connector::handle_read() noexcept {
+  if (session_reset_pending) {
+    on_session_reset_status(fetch_session_reset_async(), true);
+    return;
+  }
   assert(pending_response);
 
   auto &adaptor = vk::singleton<database_drivers::Adaptor>::get();
@@ -53,17 +70,64 @@ void Connector::handle_read() noexcept {
     case AsyncOperationStatus::ERROR:
       adaptor.finish_request_resumable(std::move(pending_response));
       pending_response = nullptr;
-      update_state_idle();
+      send_next_queued_request();
       break;
   }
 }
 
 void Connector::handle_special() noexcept {}
 
+AsyncOperationStatus Connector::send_session_reset_async() noexcept {
+  return AsyncOperationStatus::COMPLETED;
+}
+
+AsyncOperationStatus Connector::fetch_session_reset_async() noexcept {
+  return AsyncOperationStatus::COMPLETED;
+}
+
 bool Connector::connected() const noexcept {
   return is_connected;
 }
 
+bool Connector::idle() const noexcept {
+  return pending_request == nullptr && pending_response == nullptr && queued_requests.empty() && !session_reset_pending && !session_reset_failed;
+}
+
+void Connector::on_session_reset_status(AsyncOperationStatus status, bool answer_fetched) noexcept {
+  switch (status) {
+    case AsyncOperationStatus::IN_PROGRESS:
+      break;
+    case AsyncOperationStatus::COMPLETED:
+      if (!answer_fetched) {
+        update_state_ready_to_read();
+        break;
+      }
+      session_reset_pending = false;
+      send_next_queued_request();
+      break;
+    case AsyncOperationStatus::ERROR:
+      // the state of the previous request session may leak, so the connection isn't used anymore
+      vk::singleton<ConnectionPool>::get().on_session_reset_failure();
+      session_reset_pending = false;
+      session_reset_failed = true;
+      update_state_idle();
+      while (!queued_requests.empty()) {
+        auto request = std::move(queued_requests.front());
+        queued_requests.pop_front();
+        fail_request(std::move(request));
+      }
+      break;
+  }
+}
+
+void Connector::fail_request(std::unique_ptr<Request> &&request) noexcept {
+  pending_request = std::move(request);
+  auto response = make_response();
+  response->is_error = true;
+  pending_request = nullptr;
+  vk::singleton<Adaptor>::get().finish_request_resumable(std::move(response));
+}
+
 AsyncOperationStatus Connector::connect_async_and_epoll_insert() noexcept {
   dl::CriticalSectionGuard guard;
   if (connected()) {
@@ -76,6 +140,9 @@ AsyncOperationStatus Connector::connect_async_and_epoll_insert() noexcept {
       int fd = get_fd();
       epoll_insert(fd, EVT_SPEC | EVT_LEVEL);
       epoll_sethandler(fd, 0, Adaptor::epoll_gateway, reinterpret_cast<void *>(static_cast<int64_t>(connector_id)));
+      if (session_reset_pending) {
+        update_state_ready_to_write();
+      }
       return AsyncOperationStatus::COMPLETED;
     }
     case AsyncOperationStatus::IN_PROGRESS:
@@ -103,6 +170,17 @@ void Connector::update_state_idle() {
   update_state_in_reactor();
 }
 
+void Connector::send_next_queued_request() {
+  dl::CriticalSectionGuard guard;
+  if (queued_requests.empty()) {
+    update_state_idle();
+    return;
+  }
+  pending_request = std::move(queued_requests.front());
+  queued_requests.pop_front();
+  update_state_ready_to_write();
+}
+
 void Connector::update_state_in_reactor() const noexcept {
   int action_flags = 0;
   if (ready_to_read) {
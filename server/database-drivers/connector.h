@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <deque>
 #include <memory>
 
 #include "common/mixin/not_copyable.h"
@@ -71,14 +72,39 @@ public:
    */
   virtual std::unique_ptr<Response> make_response() const noexcept = 0;
 
+  /**
+   * @brief Sends the reset of the session state left by the previous request of a pooled connection.
+   * @return Status of operation: in progress, completed or error.
+   *
+   * The reset goes through the same write and read readiness as requests do, the requests wait in the queue until it's finished.
+   */
+  virtual AsyncOperationStatus send_session_reset_async() noexcept;
+
+  /**
+   * @brief Reads the result of the session reset, @see send_session_reset_async().
+   * @return Status of operation: in progress, completed or error.
+   */
+  virtual AsyncOperationStatus fetch_session_reset_async() noexcept;
+
   bool connected() const noexcept;
 
+  /**
+   * @brief Checks that there are no requests in flight or waiting in the queue and the session state is known.
+   */
+  bool idle() const noexcept;
+
 protected:
   std::unique_ptr<Request> pending_request;
   std::unique_ptr<Response> pending_response;
+  // requests pushed by other forks while the connection is busy, they are sent one by one
+  std::deque<std::unique_ptr<Request>> queued_requests;
   bool is_connected{};
   bool ready_to_read{};
   bool ready_to_write{};
+  // the connection is taken from the pool, its session is reset before the first request
+  bool session_reset_pending{};
+  // the requests fail then, the connection isn't returned to the pool
+  bool session_reset_failed{};
 
   void update_state_ready_to_write();
 
@@ -86,7 +112,12 @@ protected:
 
   void update_state_idle();
 
+  void send_next_queued_request();
+
 private:
+  void on_session_reset_status(AsyncOperationStatus status, bool answer_fetched) noexcept;
+  void fail_request(std::unique_ptr<Request> &&request) noexcept;
+
   AsyncOperationStatus connect_async_and_epoll_insert() noexcept;
   void update_state_in_reactor() const noexcept;
 
@@ -5,15 +5,44 @@
 #include "server/database-drivers/mysql/mysql-connector.h"
 
 #include <mysql/mysql.h>
+#include <utility>
 
 #include "server/database-drivers/mysql/mysql.h"
 #include "server/database-drivers/mysql/mysql-request.h"
 #include "server/database-drivers/mysql/mysql-response.h"
 #include "server/database-drivers/adaptor.h"
+#include "server/database-drivers/connection-pool.h"
 #include "server/php-engine.h"
 
 namespace database_drivers {
 
+namespace {
+
+class MysqlPooledConnection final : public PooledConnection {
+public:
+  explicit MysqlPooledConnection(MYSQL *ctx) noexcept
+    : ctx(ctx) {}
+
+  ~MysqlPooledConnection() noexcept final {
+    if (ctx != nullptr) {
+      LIB_MYSQL_CALL(mysql_close(ctx));
+    }
+  }
+
+  int get_fd() const noexcept final {
+    return ctx->net.fd;
+  }
+
+  MYSQL *detach() noexcept {
+    return std::exchange(ctx, nullptr);
+  }
+
+private:
+  MYSQL *ctx{};
+};
+
+} // namespace
+
 MysqlConnector::MysqlConnector(MYSQL *ctx, string host, string user, string password, string db_name, int port)
   : ctx(ctx)
   , host(std::move(host))
@@ -25,6 +54,11 @@ MysqlConnector::MysqlConnector(MYSQL *ctx, string host, string user, string pass
 MysqlConnector::~MysqlConnector() noexcept {
   if (is_connected) {
     epoll_remove(get_fd());
+    if (can_be_pooled()) {
+      vk::singleton<ConnectionPool>::get().release(pool_key(), std::make_unique<MysqlPooledConnection>(ctx));
+      tvkprintf(mysql, 1, "MySQL connection to [%s:%d] returned to pool: connector_id = %d\n", host.c_str(), port, connector_id);
+      return;
+    }
     LIB_MYSQL_CALL(mysql_close(ctx));
     tvkprintf(mysql, 1, "MySQL disconnected from [%s:%d]: connector_id = %d\n", host.c_str(), port, connector_id);
   }
@@ -41,6 +75,16 @@ AsyncOperationStatus MysqlConnector::connect_async() noexcept {
   if (is_connected) {
     return AsyncOperationStatus::COMPLETED;
   }
+  if (!connect_started) {
+    connect_started = true;
+    if (auto pooled = vk::singleton<ConnectionPool>::get().acquire(pool_key())) {
+      LIB_MYSQL_CALL(mysql_close(ctx));
+      ctx = static_cast<MysqlPooledConnection &>(*pooled).detach();
+      session_reset_pending = true;
+      tvkprintf(mysql, 1, "MySQL reuse pooled connection to [%s:%d]: connector_id = %d\n", host.c_str(), port, connector_id);
+      return AsyncOperationStatus::COMPLETED;
+    }
+  }
   net_async_status status =
     LIB_MYSQL_CALL(mysql_real_connect_nonblocking(ctx, host.c_str(), user.c_str(), password.c_str(), db_name.c_str(), port, nullptr, 0));
 
@@ -56,6 +100,56 @@ AsyncOperationStatus MysqlConnector::connect_async() noexcept {
   }
 }
 
+AsyncOperationStatus MysqlConnector::send_session_reset_async() noexcept {
+  // rolls back the transaction, drops the temporary tables, releases the locks, resets the session and user variables;
+  // the first call sends COM_RESET_CONNECTION, the following ones read the answer
+  net_async_status status = LIB_MYSQL_CALL(mysql_reset_connection_nonblocking(ctx));
+  tvkprintf(mysql, 1, "MySQL send session reset: connector_id = %d, status = %d\n", connector_id, status);
+  switch (status) {
+    case NET_ASYNC_NOT_READY:
+      return AsyncOperationStatus::COMPLETED;
+    case NET_ASYNC_COMPLETE:
+      session_reset_answered = true;
+      return AsyncOperationStatus::COMPLETED;
+    case NET_ASYNC_ERROR:
+    default:
+      return AsyncOperationStatus::ERROR;
+  }
+}
+
+AsyncOperationStatus MysqlConnector::fetch_session_reset_async() noexcept {
+  if (session_reset_answered) {
+    return AsyncOperationStatus::COMPLETED;
+  }
+  net_async_status status = LIB_MYSQL_CALL(mysql_reset_connection_nonblocking(ctx));
+  tvkprintf(mysql, 1, "MySQL fetch session reset: connector_id = %d, status = %d\n", connector_id, status);
+  switch (status) {
+    case NET_ASYNC_NOT_READY:
+      return AsyncOperationStatus::IN_PROGRESS;
+    case NET_ASYNC_COMPLETE:
+      session_reset_answered = true;
+      return AsyncOperationStatus::COMPLETED;
+    case NET_ASYNC_ERROR:
+    default:
+      return AsyncOperationStatus::ERROR;
+  }
+}
+
+std::string MysqlConnector::pool_key() const noexcept {
+  dl::CriticalSectionGuard guard;
+  std::string key{"mysql:"};
+  for (const string *part : {&host, &user, &password, &db_name}) {
+    key.append(std::to_string(part->size())).append(":").append(part->c_str(), part->size());
+  }
+  return key.append(std::to_string(port));
+}
+
+bool MysqlConnector::can_be_pooled() const noexcept {
+  // a connection in the middle of a query or with an open transaction can't be handed over to another request
+  return vk::singleton<ConnectionPool>::get().enabled() && idle()
+         && ctx->status == MYSQL_STATUS_READY && !(ctx->server_status & SERVER_STATUS_IN_TRANS) && !LIB_MYSQL_CALL(mysql_more_results(ctx));
+}
+
 std::unique_ptr<Response> MysqlConnector::make_response() const noexcept {
   return std::make_unique<MysqlResponse>(connector_id, pending_request->request_id);
 }
@@ -6,6 +6,7 @@
 
 #include <memory>
 #include <mysql/mysql.h>
+#include <string>
 
 #include "runtime/kphp_core.h"
 #include "server/database-drivers/connector.h"
@@ -27,14 +28,23 @@ public:
 
   int get_fd() const noexcept final;
 
+  AsyncOperationStatus send_session_reset_async() noexcept final;
+
+  AsyncOperationStatus fetch_session_reset_async() noexcept final;
+
 private:
   string host{};
   string user{};
   string password{};
   string db_name{};
   int port{};
+  bool connect_started{};
+  bool session_reset_answered{};
 
   std::unique_ptr<Response> make_response() const noexcept override;
+
+  std::string pool_key() const noexcept;
+  bool can_be_pooled() const noexcept;
 };
 
 } // namespace database_drivers
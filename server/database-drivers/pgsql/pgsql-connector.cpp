@@ -1,25 +1,75 @@
 #include "server/database-drivers/pgsql/pgsql-connector.h"
 
 #include <postgresql/libpq-fe.h>
+#include <utility>
 
 #include "server/database-drivers/adaptor.h"
+#include "server/database-drivers/connection-pool.h"
+#include "server/database-drivers/pgsql/pgsql-request.h"
 #include "server/database-drivers/pgsql/pgsql-response.h"
 #include "server/database-drivers/pgsql/pgsql.h"
 #include "server/php-engine.h"
 
 namespace database_drivers {
 
+namespace {
+
+// it's DISCARD ALL without DEALLOCATE ALL, the prepared statements are kept as they are pooled along with the connection,
+// @see PgsqlPreparedStatements; the statements are run as one implicit transaction, where DISCARD ALL isn't allowed
+constexpr const char *RESET_SESSION_QUERY = "CLOSE ALL; SET SESSION AUTHORIZATION DEFAULT; RESET ALL; UNLISTEN *; "
+                                            "SELECT pg_advisory_unlock_all(); DISCARD PLANS; DISCARD TEMP; DISCARD SEQUENCES";
+
+class PgsqlPooledConnection final : public PooledConnection {
+public:
+  PgsqlPooledConnection(PGconn *conn, std::unique_ptr<PgsqlPreparedStatements> &&prepared_statements) noexcept
+    : conn(conn)
+    , prepared_statements(std::move(prepared_statements)) {}
+
+  ~PgsqlPooledConnection() noexcept final {
+    dl::CriticalSectionGuard guard;
+    if (conn != nullptr) {
+      LIB_PGSQL_CALL(PQfinish(conn));
+    }
+    prepared_statements.reset();
+  }
+
+  int get_fd() const noexcept final {
+    return LIB_PGSQL_CALL(PQsocket(conn));
+  }
+
+  PGconn *detach() noexcept {
+    return std::exchange(conn, nullptr);
+  }
+
+  std::unique_ptr<PgsqlPreparedStatements> detach_prepared_statements() noexcept {
+    return std::move(prepared_statements);
+  }
+
+private:
+  PGconn *conn{};
+  std::unique_ptr<PgsqlPreparedStatements> prepared_statements;
+};
+
+} // namespace
+
 PgsqlConnector::PgsqlConnector(string conninfo)
   : ctx()
   , conninfo(std::move(conninfo)) {}
 
 PgsqlConnector::~PgsqlConnector() noexcept {
+  dl::CriticalSectionGuard guard;
   if (is_connected) {
     epoll_remove(get_fd());
+    if (can_be_pooled()) {
+      vk::singleton<ConnectionPool>::get().release(pool_key(), std::make_unique<PgsqlPooledConnection>(ctx.conn, std::move(prepared_statements)));
+      tvkprintf(pgsql, 1, "pgSQL connection returned to pool: connector_id = %d\n", connector_id);
+      return;
+    }
     tvkprintf(pgsql, 1, "pgSQL disconnected from [%s:%d]: connector_id = %d\n", LIB_PGSQL_CALL(PQhost(ctx.conn)),
               (int)string{LIB_PGSQL_CALL(PQport(ctx.conn))}.to_int(), connector_id);
     LIB_PGSQL_CALL(PQfinish(ctx.conn));
   }
+  prepared_statements.reset();
 }
 
 int PgsqlConnector::get_fd() const noexcept {
@@ -35,6 +85,14 @@ AsyncOperationStatus PgsqlConnector::connect_async() noexcept {
   }
 
   if (ctx.conn == nullptr) {
+    if (auto pooled = vk::singleton<ConnectionPool>::get().acquire(pool_key())) {
+      auto &pooled_connection = static_cast<PgsqlPooledConnection &>(*pooled);
+      ctx.conn = pooled_connection.detach();
+      prepared_statements = pooled_connection.detach_prepared_statements();
+      session_reset_pending = true;
+      tvkprintf(pgsql, 1, "pgSQL reuse pooled connection: connector_id = %d\n", connector_id);
+      return AsyncOperationStatus::COMPLETED;
+    }
     if ((ctx.conn = LIB_PGSQL_CALL(PQconnectStart(conninfo.c_str()))) == nullptr) {
       return AsyncOperationStatus::ERROR;
     }
@@ -56,7 +114,61 @@ AsyncOperationStatus PgsqlConnector::connect_async() noexcept {
   }
 }
 
+AsyncOperationStatus PgsqlConnector::send_session_reset_async() noexcept {
+  dl::CriticalSectionGuard guard;
+  tvkprintf(pgsql, 1, "pgSQL send session reset: connector_id = %d\n", connector_id);
+  session_reset_statement_failed = false;
+  if (LIB_PGSQL_CALL(PQsendQuery(ctx.conn, RESET_SESSION_QUERY)) != 1) {
+    return AsyncOperationStatus::ERROR;
+  }
+  return AsyncOperationStatus::COMPLETED;
+}
+
+AsyncOperationStatus PgsqlConnector::fetch_session_reset_async() noexcept {
+  dl::CriticalSectionGuard guard;
+  if (LIB_PGSQL_CALL(PQconsumeInput(ctx.conn)) != 1) {
+    return AsyncOperationStatus::ERROR;
+  }
+  // every statement of the query has its own result, the results are taken while they don't block
+  while (!LIB_PGSQL_CALL(PQisBusy(ctx.conn))) {
+    PGresult *res = LIB_PGSQL_CALL(PQgetResult(ctx.conn));
+    if (res == nullptr) {
+      tvkprintf(pgsql, 1, "pgSQL fetch session reset: connector_id = %d, failed = %d\n", connector_id, session_reset_statement_failed);
+      return session_reset_statement_failed ? AsyncOperationStatus::ERROR : AsyncOperationStatus::COMPLETED;
+    }
+    const ExecStatusType status = LIB_PGSQL_CALL(PQresultStatus(res));
+    session_reset_statement_failed |= status != PGRES_COMMAND_OK && status != PGRES_TUPLES_OK;
+    LIB_PGSQL_CALL(PQclear(res));
+  }
+  return AsyncOperationStatus::IN_PROGRESS;
+}
+
+std::string PgsqlConnector::pool_key() const noexcept {
+  dl::CriticalSectionGuard guard;
+  return std::string{"pgsql:"}.append(conninfo.c_str(), conninfo.size());
+}
+
+bool PgsqlConnector::can_be_pooled() const noexcept {
+  // a connection in the middle of a query or with an open transaction can't be handed over to another request
+  return vk::singleton<ConnectionPool>::get().enabled() && idle()
+         && LIB_PGSQL_CALL(PQstatus(ctx.conn)) == CONNECTION_OK && LIB_PGSQL_CALL(PQtransactionStatus(ctx.conn)) == PQTRANS_IDLE;
+}
+
+PgsqlPreparedStatements &PgsqlConnector::get_prepared_statements() noexcept {
+  dl::CriticalSectionGuard guard;
+  if (!prepared_statements) {
+    prepared_statements = std::make_unique<PgsqlPreparedStatements>();
+  }
+  return *prepared_statements;
+}
+
 std::unique_ptr<Response> PgsqlConnector::make_response() const noexcept {
-  return std::make_unique<PgsqlResponse>(connector_id, pending_request->request_id);
+  auto response = std::make_unique<PgsqlResponse>(connector_id, pending_request->request_id);
+  if (const auto *prepared_request = dynamic_cast<const PgsqlPreparedRequest *>(pending_request.get())) {
+    if (!prepared_request->statement_to_execute.empty()) {
+      response->execute_after_prepare.emplace(PgsqlResponse::DeferredExecute{prepared_request->query, prepared_request->statement_to_execute, prepared_request->params});
+    }
+  }
+  return response;
 }
 } // namespace database_drivers
@@ -2,6 +2,8 @@
 
 #include <memory>
 #include <postgresql/libpq-fe.h>
+#include <string>
+#include <unordered_map>
 
 #include "runtime/kphp_core.h"
 #include "server/database-drivers/connector.h"
@@ -14,6 +16,17 @@ namespace database_drivers {
 class Request;
 class Response;
 
+/**
+ * Server side prepared statements live as long as the connection, so they are pooled along with it.
+ * Allocated in the heap memory.
+ */
+struct PgsqlPreparedStatements {
+  static constexpr size_t MAX_SIZE = 256;
+
+  std::unordered_map<std::string, std::string> names; // query -> statement name
+  uint64_t last_id{0};
+};
+
 class PgsqlConnector final : public Connector {
 public:
   PGSQL ctx{};
@@ -26,10 +39,21 @@ public:
 
   int get_fd() const noexcept final;
 
+  AsyncOperationStatus send_session_reset_async() noexcept final;
+
+  AsyncOperationStatus fetch_session_reset_async() noexcept final;
+
+  PgsqlPreparedStatements &get_prepared_statements() noexcept;
+
 private:
   string conninfo{};
+  std::unique_ptr<PgsqlPreparedStatements> prepared_statements;
+  bool session_reset_statement_failed{};
 
   std::unique_ptr<Response> make_response() const noexcept override;
+
+  std::string pool_key() const noexcept;
+  bool can_be_pooled() const noexcept;
 };
 
 } // namespace database_drivers
@@ -1,6 +1,8 @@
 #include "server/database-drivers/pgsql/pgsql-request.h"
 
 #include <postgresql/libpq-fe.h>
+#include <string>
+#include <vector>
 
 #include "server/database-drivers/adaptor.h"
 #include "server/database-drivers/pgsql/pgsql-connector.h"
@@ -28,4 +30,53 @@ AsyncOperationStatus PgsqlRequest::send_async() noexcept {
   }
 }
 
+PgsqlPreparedRequest::PgsqlPreparedRequest(int connector_id, const string &query, const array<Optional<string>> &params)
+  : Request(connector_id)
+  , query(query)
+  , params(params) {}
+
+AsyncOperationStatus PgsqlPreparedRequest::send_async() noexcept {
+  dl::CriticalSectionGuard guard;
+
+  auto *connector = vk::singleton<database_drivers::Adaptor>::get().get_connector<PgsqlConnector>(connector_id);
+  if (connector == nullptr) {
+    return AsyncOperationStatus::ERROR;
+  }
+  assert(connector->connected());
+
+  auto &prepared_statements = connector->get_prepared_statements();
+  const std::string key{query.c_str(), query.size()};
+  int status = 0;
+  if (auto it = prepared_statements.names.find(key); it != prepared_statements.names.end()) {
+    tvkprintf(pgsql, 1, "pgSQL send prepared request: request_id = %d, statement = %s\n", request_id, it->second.c_str());
+    status = send_query_prepared(connector->ctx.conn, it->second.c_str(), params);
+  } else if (prepared_statements.names.size() < PgsqlPreparedStatements::MAX_SIZE) {
+    statement_to_execute = string{"kphp_pdo_"}.append(static_cast<int64_t>(++prepared_statements.last_id));
+    tvkprintf(pgsql, 1, "pgSQL prepare request: request_id = %d, statement = %s\n", request_id, statement_to_execute.c_str());
+    status = LIB_PGSQL_CALL(PQsendPrepare(connector->ctx.conn, statement_to_execute.c_str(), query.c_str(), 0, nullptr));
+  } else {
+    // too many different queries on this connection, use the unnamed statement
+    tvkprintf(pgsql, 1, "pgSQL send request with params: request_id = %d\n", request_id);
+    std::vector<const char *> values = get_param_values(params);
+    status = LIB_PGSQL_CALL(PQsendQueryParams(connector->ctx.conn, query.c_str(), static_cast<int>(values.size()), nullptr, values.data(), nullptr, nullptr, 0));
+  }
+  return status == 1 ? AsyncOperationStatus::COMPLETED : AsyncOperationStatus::ERROR;
+}
+
+std::vector<const char *> get_param_values(const array<Optional<string>> &params) noexcept {
+  dl::CriticalSectionGuard guard;
+  std::vector<const char *> values;
+  values.reserve(params.count());
+  for (const auto &it : params) {
+    values.push_back(it.get_value().has_value() ? it.get_value().val().c_str() : nullptr);
+  }
+  return values;
+}
+
+int send_query_prepared(PGconn *conn, const char *statement_name, const array<Optional<string>> &params) noexcept {
+  dl::CriticalSectionGuard guard;
+  std::vector<const char *> values = get_param_values(params);
+  return LIB_PGSQL_CALL(PQsendQueryPrepared(conn, statement_name, static_cast<int>(values.size()), values.data(), nullptr, nullptr, 0));
+}
+
 } // namespace database_drivers
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <postgresql/libpq-fe.h>
+#include <vector>
+
 #include "runtime/kphp_core.h"
 #include "server/database-drivers/request.h"
 
@@ -16,4 +19,24 @@ public:
 private:
   string request;
 };
+
+/**
+ * Executes a server side prepared statement.
+ * The first execution of a query on a connection prepares it with PQsendPrepare(), the statement is executed by PgsqlResponse after that.
+ * The following executions on the same connection (even pooled and reused by another request) send PQsendQueryPrepared() only.
+ */
+class PgsqlPreparedRequest final : public Request {
+public:
+  PgsqlPreparedRequest(int connector_id, const string &query, const array<Optional<string>> &params);
+
+  AsyncOperationStatus send_async() noexcept final;
+
+  const string query;
+  const array<Optional<string>> params;
+  // not empty if the statement has been sent for preparing and must be executed after that
+  string statement_to_execute;
+};
+
+std::vector<const char *> get_param_values(const array<Optional<string>> &params) noexcept;
+int send_query_prepared(PGconn *conn, const char *statement_name, const array<Optional<string>> &params) noexcept;
 } // namespace database_drivers
@@ -2,6 +2,7 @@
 
 #include "server/database-drivers/adaptor.h"
 #include "server/database-drivers/pgsql/pgsql-connector.h"
+#include "server/database-drivers/pgsql/pgsql-request.h"
 #include "server/database-drivers/pgsql/pgsql-resources.h"
 #include "server/database-drivers/pgsql/pgsql.h"
 
@@ -19,6 +20,16 @@ AsyncOperationStatus PgsqlResponse::fetch_async() noexcept {
   tvkprintf(pgsql, 1, "pgSQL fetch response: request_id = %d, get result set, status = %d\n", bound_request_id, status);
   switch (status) {
     case CONNECTION_OK:
+      if (LIB_PGSQL_CALL(PQconsumeInput(connector->ctx.conn)) != 1) {
+        is_error = true;
+        return AsyncOperationStatus::ERROR;
+      }
+      if (LIB_PGSQL_CALL(PQisBusy(connector->ctx.conn))) {
+        return AsyncOperationStatus::IN_PROGRESS;
+      }
+      if (execute_after_prepare.has_value()) {
+        return execute_prepared(connector);
+      }
       res = LIB_PGSQL_CALL(PQgetResult(connector->ctx.conn));
       assert(res != nullptr);
       connector->ctx.remember_result_status(res);
@@ -42,6 +53,36 @@ AsyncOperationStatus PgsqlResponse::fetch_async() noexcept {
   }
 }
 
+AsyncOperationStatus PgsqlResponse::execute_prepared(PgsqlConnector *connector) noexcept {
+  dl::CriticalSectionGuard guard;
+  PGconn *conn = connector->ctx.conn;
+  PGresult *prepare_res = LIB_PGSQL_CALL(PQgetResult(conn));
+  assert(prepare_res != nullptr);
+  connector->ctx.remember_result_status(prepare_res);
+  const bool prepared = LIB_PGSQL_CALL(PQresultStatus(prepare_res)) == PGRES_COMMAND_OK;
+  LIB_PGSQL_CALL(PQclear(prepare_res));
+  while (PGresult *extra_res = LIB_PGSQL_CALL(PQgetResult(conn))) {
+    LIB_PGSQL_CALL(PQclear(extra_res));
+  }
+
+  const DeferredExecute execute = std::move(*execute_after_prepare);
+  execute_after_prepare.reset();
+  if (!prepared) {
+    tvkprintf(pgsql, 1, "pgSQL fetch response: request_id = %d, can't prepare statement %s\n", bound_request_id, execute.statement_name.c_str());
+    is_error = true;
+    return AsyncOperationStatus::ERROR;
+  }
+
+  connector->get_prepared_statements().names.emplace(std::string{execute.query.c_str(), execute.query.size()},
+                                                     std::string{execute.statement_name.c_str(), execute.statement_name.size()});
+  tvkprintf(pgsql, 1, "pgSQL fetch response: request_id = %d, statement %s prepared, send it\n", bound_request_id, execute.statement_name.c_str());
+  if (send_query_prepared(conn, execute.statement_name.c_str(), execute.params) != 1) {
+    is_error = true;
+    return AsyncOperationStatus::ERROR;
+  }
+  return AsyncOperationStatus::IN_PROGRESS;
+}
+
 PgsqlResponse::~PgsqlResponse() {
   if (res) {
     remove_pgsql_response(res);
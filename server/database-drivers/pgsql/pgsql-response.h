@@ -1,7 +1,9 @@
 #pragma once
 
+#include <optional>
 #include <postgresql/libpq-fe.h>
 
+#include "runtime/kphp_core.h"
 #include "server/database-drivers/response.h"
 
 namespace database_drivers {
@@ -10,14 +12,25 @@ class PgsqlConnector;
 
 class PgsqlResponse final : public Response {
 public:
+  struct DeferredExecute {
+    string query;
+    string statement_name;
+    array<Optional<string>> params;
+  };
+
   PGresult *res{nullptr};
   uint64_t affected_rows{0};
+  // set if the first result is the result of statement preparing, @see PgsqlPreparedRequest
+  std::optional<DeferredExecute> execute_after_prepare;
 
   using Response::Response;
 
   AsyncOperationStatus fetch_async() noexcept final;
 
   ~PgsqlResponse() final;
+
+private:
+  AsyncOperationStatus execute_prepared(PgsqlConnector *connector) noexcept;
 };
 
 } // namespace database_drivers
@@ -0,0 +1,108 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2023 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "server/job-workers/job-messages-queue.h"
+
+#include <cassert>
+#include <new>
+
+#include "server/job-workers/job-message.h"
+
+namespace job_workers {
+
+namespace {
+
+uint64_t make_cell(uint32_t lap, uint32_t message_id) noexcept {
+  return (static_cast<uint64_t>(lap) << 32u) | message_id;
+}
+
+uint32_t get_cell_lap(uint64_t cell) noexcept {
+  return static_cast<uint32_t>(cell >> 32u);
+}
+
+uint32_t get_cell_message_id(uint64_t cell) noexcept {
+  return static_cast<uint32_t>(cell);
+}
+
+} // namespace
+
+JobMessagesQueue::JobMessagesQueue(uint32_t capacity_log2, JobSharedMessage *messages_begin) noexcept:
+  messages_begin_(messages_begin),
+  capacity_log2_(capacity_log2),
+  mask_((1u << capacity_log2) - 1) {
+  for (uint64_t position = 0; position <= mask_; ++position) {
+    new(&get_cell(position)) std::atomic<uint64_t>{make_cell(0, 0)};
+  }
+}
+
+uint32_t JobMessagesQueue::get_capacity_log2(uint32_t capacity) noexcept {
+  assert(capacity && capacity <= (1u << 31u));
+  uint32_t capacity_log2 = 0;
+  while ((1u << capacity_log2) < capacity) {
+    ++capacity_log2;
+  }
+  return capacity_log2;
+}
+
+size_t JobMessagesQueue::get_memory_size(uint32_t capacity) noexcept {
+  return sizeof(JobMessagesQueue) + (size_t{1} << get_capacity_log2(capacity)) * sizeof(std::atomic<uint64_t>);
+}
+
+JobMessagesQueue *JobMessagesQueue::create(void *mem, uint32_t capacity, JobSharedMessage *messages_begin) noexcept {
+  static_assert(alignof(JobMessagesQueue) == 64, "the cells are placed right after the queue");
+  return new(mem) JobMessagesQueue{get_capacity_log2(capacity), messages_begin};
+}
+
+bool JobMessagesQueue::push(JobSharedMessage *message) noexcept {
+  const auto message_id = static_cast<uint32_t>(message - messages_begin_) + 1;
+  while (true) {
+    uint64_t position = push_position_.load(std::memory_order_acquire);
+    const uint32_t lap = get_lap(position);
+    uint64_t cell = get_cell(position).load(std::memory_order_acquire);
+    const auto lap_diff = static_cast<int32_t>(get_cell_lap(cell) - lap);
+    if (lap_diff == 0 && !get_cell_message_id(cell)) {
+      if (get_cell(position).compare_exchange_strong(cell, make_cell(lap, message_id), std::memory_order_seq_cst)) {
+        push_position_.compare_exchange_strong(position, position + 1, std::memory_order_release);
+        return true;
+      }
+    } else if (lap_diff < 0) {
+      // the message of the previous lap is still there
+      return false;
+    } else {
+      // the cell is already filled (or even taken), but the position wasn't moved forward
+      push_position_.compare_exchange_strong(position, position + 1, std::memory_order_release);
+    }
+  }
+}
+
+JobSharedMessage *JobMessagesQueue::pop() noexcept {
+  while (true) {
+    uint64_t position = pop_position_.load(std::memory_order_acquire);
+    const uint32_t lap = get_lap(position);
+    uint64_t cell = get_cell(position).load(std::memory_order_seq_cst);
+    const auto lap_diff = static_cast<int32_t>(get_cell_lap(cell) - lap);
+    if (lap_diff == 0) {
+      const uint32_t message_id = get_cell_message_id(cell);
+      if (!message_id) {
+        return nullptr;
+      }
+      // the cell is released for the next lap
+      if (get_cell(position).compare_exchange_strong(cell, make_cell(lap + 1, 0), std::memory_order_acq_rel)) {
+        pop_position_.compare_exchange_strong(position, position + 1, std::memory_order_release);
+        return messages_begin_ + (message_id - 1);
+      }
+    } else if (lap_diff > 0) {
+      // the cell is already taken, but the position wasn't moved forward
+      pop_position_.compare_exchange_strong(position, position + 1, std::memory_order_release);
+    }
+  }
+}
+
+bool JobMessagesQueue::empty() const noexcept {
+  const uint64_t position = pop_position_.load(std::memory_order_seq_cst);
+  const uint64_t cell = get_cell(position).load(std::memory_order_seq_cst);
+  return get_cell_lap(cell) != get_lap(position) || !get_cell_message_id(cell);
+}
+
+} // namespace job_workers
@@ -0,0 +1,63 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2023 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "common/mixin/not_copyable.h"
+
+namespace job_workers {
+
+struct JobSharedMessage;
+
+// The bounded lock-free multi-producer multi-consumer queue of the job messages, it's placed in the shared memory.
+// Each cell is a single 64-bit word: the lap of the queue position it's used for and the message index + 1 (0 is for an empty cell),
+// so a message is put or taken with one CAS. The queue positions are moved forward by any process that sees them behind,
+// therefore a process killed in the middle of push() or pop() doesn't block the queue.
+class JobMessagesQueue : vk::not_copyable {
+public:
+  // the capacity is rounded up to a power of 2
+  static size_t get_memory_size(uint32_t capacity) noexcept;
+  static JobMessagesQueue *create(void *mem, uint32_t capacity, JobSharedMessage *messages_begin) noexcept;
+
+  bool push(JobSharedMessage *message) noexcept;
+  JobSharedMessage *pop() noexcept;
+
+  // it's a hint: the result may be stale as soon as it's returned
+  bool empty() const noexcept;
+
+  uint32_t capacity() const noexcept {
+    return mask_ + 1;
+  }
+
+private:
+  JobMessagesQueue(uint32_t capacity_log2, JobSharedMessage *messages_begin) noexcept;
+
+  static uint32_t get_capacity_log2(uint32_t capacity) noexcept;
+
+  uint32_t get_lap(uint64_t position) const noexcept {
+    return static_cast<uint32_t>(position >> capacity_log2_);
+  }
+
+  std::atomic<uint64_t> &get_cell(uint64_t position) noexcept {
+    return reinterpret_cast<std::atomic<uint64_t> *>(this + 1)[position & mask_];
+  }
+
+  const std::atomic<uint64_t> &get_cell(uint64_t position) const noexcept {
+    return reinterpret_cast<const std::atomic<uint64_t> *>(this + 1)[position & mask_];
+  }
+
+  JobSharedMessage *const messages_begin_{nullptr};
+  const uint32_t capacity_log2_{0};
+  const uint32_t mask_{0};
+
+  // the producers and the consumers don't share a cache line
+  alignas(64) std::atomic<uint64_t> push_position_{0};
+  alignas(64) std::atomic<uint64_t> pop_position_{0};
+};
+
+} // namespace job_workers
@@ -27,12 +27,22 @@ size_t JobStats::MemoryBufferStats::write_stats_to(stats_t *stats, const char *p
   return memory_used;
 }
 
+void JobStats::add_message_size(size_t size) noexcept {
+  size_t bucket = 0;
+  while (bucket + 1 != message_sizes.size() && size > (size_t{16 * 1024} << bucket)) {
+    ++bucket;
+  }
+  ++message_sizes[bucket];
+}
+
 void JobStats::write_stats_to(stats_t *stats) const noexcept {
   const char *prefix = "workers.job.";
   stats->add_gauge_stat(errors_pipe_server_write, prefix, "pipe_errors.server_write");
   stats->add_gauge_stat(errors_pipe_server_read, prefix, "pipe_errors.server_read");
   stats->add_gauge_stat(errors_pipe_client_write, prefix, "pipe_errors.client_write");
   stats->add_gauge_stat(errors_pipe_client_read, prefix, "pipe_errors.client_read");
+  stats->add_gauge_stat(errors_jobs_queue_full, prefix, "queue_full.jobs");
+  stats->add_gauge_stat(errors_job_results_queue_full, prefix, "queue_full.job_results");
 
   stats->add_gauge_stat(job_worker_skip_job_due_another_is_running, prefix, "jobs.skip.another_is_running");
   stats->add_gauge_stat(job_worker_skip_job_due_steal, prefix, "jobs.skip.steal");
@@ -40,6 +50,8 @@ void JobStats::write_stats_to(stats_t *stats) const noexcept {
   stats->add_gauge_stat(job_queue_size, prefix, "jobs.queue_size");
   stats->add_gauge_stat(jobs_sent, prefix, "jobs.sent");
   stats->add_gauge_stat(jobs_replied, prefix, "jobs.replied");
+  stats->add_gauge_stat(job_workers_wakeups, prefix, "jobs.wakeups");
+  stats->add_gauge_stat(messages_retries, prefix, "jobs.shared_messages_retries");
 
   size_t currently_used = messages.write_stats_to(stats, "workers.job.memory.messages.shared_messages.", JOB_SHARED_MESSAGE_BYTES);
   constexpr std::array<const char *, JOB_EXTRA_MEMORY_BUFFER_BUCKETS> extra_memory_prefixes{
@@ -56,6 +68,26 @@ void JobStats::write_stats_to(stats_t *stats) const noexcept {
     currently_used += extra_memory[i].write_stats_to(stats, extra_memory_prefixes[i], buffer_size);
   }
 
+  constexpr std::array<const char *, JOB_MESSAGE_SIZES_HISTOGRAM_BUCKETS> message_sizes_names{
+    "memory.messages.sizes.16kb",
+    "memory.messages.sizes.32kb",
+    "memory.messages.sizes.64kb",
+    "memory.messages.sizes.128kb",
+    "memory.messages.sizes.256kb",
+    "memory.messages.sizes.512kb",
+    "memory.messages.sizes.1mb",
+    "memory.messages.sizes.2mb",
+    "memory.messages.sizes.4mb",
+    "memory.messages.sizes.8mb",
+    "memory.messages.sizes.16mb",
+    "memory.messages.sizes.32mb",
+    "memory.messages.sizes.64mb",
+    "memory.messages.sizes.larger",
+  };
+  for (size_t i = 0; i != JOB_MESSAGE_SIZES_HISTOGRAM_BUCKETS; ++i) {
+    stats->add_gauge_stat(message_sizes[i], prefix, message_sizes_names[i]);
+  }
+
   stats->add_gauge_stat(memory_limit, prefix, "memory.messages.reserved_bytes");
   stats->add_gauge_stat(currently_used, prefix, "memory.messages.currently_used_bytes");
   stats->add_gauge_stat(unused_memory, prefix, "memory.messages.unused_bytes");
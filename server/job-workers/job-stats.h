@@ -14,12 +14,17 @@
 
 namespace job_workers {
 
+// the message sizes histogram buckets: up to 16KB, 32KB, ..., 64MB and the larger ones
+constexpr size_t JOB_MESSAGE_SIZES_HISTOGRAM_BUCKETS = 14;
+
 class JobStats : vk::not_copyable {
 public:
   std::atomic<uint32_t> errors_pipe_server_write{0};
   std::atomic<uint32_t> errors_pipe_server_read{0};
   std::atomic<uint32_t> errors_pipe_client_write{0};
   std::atomic<uint32_t> errors_pipe_client_read{0};
+  std::atomic<uint32_t> errors_jobs_queue_full{0};
+  std::atomic<uint32_t> errors_job_results_queue_full{0};
 
   std::atomic<uint32_t> job_worker_skip_job_due_another_is_running{0};
   std::atomic<size_t> job_worker_skip_job_due_steal{0};
@@ -27,12 +32,14 @@ public:
   std::atomic<size_t> jobs_sent{0};
   std::atomic<size_t> jobs_replied{0};
   std::atomic<int32_t> job_queue_size{0};
+  std::atomic<size_t> job_workers_wakeups{0};
+  std::atomic<size_t> messages_retries{0};
 
   uint32_t unused_memory{0};
   size_t memory_limit{0};
 
   struct MemoryBufferStats : private vk::not_copyable {
-    uint32_t count{0};
+    std::atomic<uint32_t> count{0};
     std::atomic<uint32_t> acquire_fails{0};
     std::atomic<size_t> acquired{0};
     std::atomic<size_t> released{0};
@@ -43,6 +50,10 @@ public:
   MemoryBufferStats messages;
   std::array<MemoryBufferStats, JOB_EXTRA_MEMORY_BUFFER_BUCKETS> extra_memory{};
 
+  // the memory used by the released messages, including the extra memory
+  std::array<std::atomic<size_t>, JOB_MESSAGE_SIZES_HISTOGRAM_BUCKETS> message_sizes{};
+
+  void add_message_size(size_t size) noexcept;
   void write_stats_to(stats_t *stats) const noexcept;
 };
 
@@ -14,6 +14,7 @@
 #include "server/job-workers/job-worker-client.h"
 #include "server/job-workers/job-workers-context.h"
 #include "server/job-workers/job-stats.h"
+#include "server/job-workers/pipe-io.h"
 #include "server/job-workers/shared-memory-manager.h"
 #include "server/php-engine.h"
 #include "server/php-queries.h"
@@ -36,23 +37,18 @@ int JobWorkerClient::read_job_results(int fd, void *data __attribute__((unused))
     return 0;
   }
 
-  PipeJobReader::ReadStatus status{};
+  if (!drain_pipe_wakeups(fd, "read job results wakeup")) {
+    ++vk::singleton<SharedMemoryManager>::get().get_stats().errors_pipe_client_read;
+    return -1;
+  }
 
+  auto &memory_manager = vk::singleton<SharedMemoryManager>::get();
+  auto &job_results_queue = memory_manager.get_job_results_queue(job_worker_client.job_result_fd_idx);
   do {
-    JobSharedMessage *job_result = nullptr;
-    status = job_worker_client.job_reader.read_job_result(job_result);
-    if (status == PipeJobReader::READ_FAIL) {
-      ++vk::singleton<SharedMemoryManager>::get().get_stats().errors_pipe_client_read;
-      return -1;
-    }
-    if (status == PipeJobReader::READ_OK) {
-      tvkprintf(job_workers, 2, "got job result: ready_job_id = %d, job_result_memory_ptr = %p\n", job_result->job_id, job_result);
-      vk::singleton<SharedMemoryManager>::get().attach_shared_message_to_this_proc(job_result);
-      const int event_status = create_job_worker_answer_event(job_result);
-      vk::singleton<SharedMemoryManager>::get().release_shared_message(job_result);
-      on_net_event(event_status);
-    }
-  } while (status != PipeJobReader::READ_BLOCK);
+    job_worker_client.take_job_results();
+    memory_manager.arm_job_results_wakeup();
+    // a result pushed before the wakeup is armed is taken here, otherwise the job worker that disarms the wakeup writes to the pipe
+  } while (!job_results_queue.empty() && memory_manager.disarm_job_results_wakeup(job_worker_client.job_result_fd_idx));
 
   return 0;
 }
@@ -78,7 +74,7 @@ void JobWorkerClient::init(int job_result_slot) {
   if (read_job_result_fd >= 0) {
     epoll_sethandler(read_job_result_fd, 0, JobWorkerClient::read_job_results, nullptr);
     epoll_insert(read_job_result_fd, EVT_READ | EVT_SPEC);
-    job_reader = PipeJobReader{read_job_result_fd};
+    vk::singleton<SharedMemoryManager>::get().arm_job_results_wakeup();
   }
 }
 
@@ -87,15 +83,62 @@ bool JobWorkerClient::send_job(JobSharedMessage *job_request) {
             job_result_fd_idx, job_request->job_id, job_request, write_job_fd);
 
   job_request->job_result_fd_idx = job_result_fd_idx;
-  bool success = job_writer.write_job(job_request, write_job_fd);
-  if (!success) {
-    ++vk::singleton<SharedMemoryManager>::get().get_stats().errors_pipe_client_write;
+  auto &memory_manager = vk::singleton<SharedMemoryManager>::get();
+  if (!memory_manager.get_jobs_queue().push(job_request)) {
+    ++memory_manager.get_stats().errors_jobs_queue_full;
     return false;
   }
 
-  ++vk::singleton<SharedMemoryManager>::get().get_stats().job_queue_size;
-  ++vk::singleton<SharedMemoryManager>::get().get_stats().jobs_sent;
+  ++memory_manager.get_stats().job_queue_size;
+  ++memory_manager.get_stats().jobs_sent;
+  if (job_workers_wakeup_deferred) {
+    job_workers_wakeup_pending = true;
+  } else {
+    wakeup_job_workers();
+  }
   return true;
 }
 
+void JobWorkerClient::defer_job_workers_wakeup() {
+  job_workers_wakeup_deferred = true;
+}
+
+void JobWorkerClient::flush_job_workers_wakeup() {
+  wakeup_deferred_job_workers();
+  job_workers_wakeup_deferred = false;
+}
+
+void JobWorkerClient::wakeup_deferred_job_workers() {
+  if (job_workers_wakeup_pending) {
+    wakeup_job_workers();
+  }
+  job_workers_wakeup_pending = false;
+}
+
+bool JobWorkerClient::take_job_results() {
+  auto &memory_manager = vk::singleton<SharedMemoryManager>::get();
+  auto &job_results_queue = memory_manager.get_job_results_queue(job_result_fd_idx);
+  bool taken = false;
+  while (JobSharedMessage *job_result = job_results_queue.pop()) {
+    tvkprintf(job_workers, 2, "got job result: ready_job_id = %d, job_result_memory_ptr = %p\n", job_result->job_id, job_result);
+    memory_manager.attach_shared_message_to_this_proc(job_result);
+    const int event_status = create_job_worker_answer_event(job_result);
+    memory_manager.release_shared_message(job_result);
+    on_net_event(event_status);
+    taken = true;
+  }
+  return taken;
+}
+
+void JobWorkerClient::wakeup_job_workers() {
+  // the busy job workers take the jobs from the queue themselves after the running ones
+  auto &memory_manager = vk::singleton<SharedMemoryManager>::get();
+  if (memory_manager.has_workers_waiting_for_jobs()) {
+    ++memory_manager.get_stats().job_workers_wakeups;
+    if (!write_pipe_wakeup(write_job_fd, "waking up job workers")) {
+      ++memory_manager.get_stats().errors_pipe_client_write;
+    }
+  }
+}
+
 } // namespace job_workers
@@ -9,7 +9,6 @@
 #include "common/algorithms/find.h"
 #include "common/mixin/not_copyable.h"
 #include "common/smart_ptrs/singleton.h"
-#include "server/job-workers/pipe-io.h"
 
 typedef struct event_descr event_t;
 
@@ -27,8 +26,6 @@ public:
   int job_result_fd_idx{-1};
   int read_job_result_fd{-1};
   int write_job_fd{-1};
-  PipeJobWriter job_writer;
-  PipeJobReader job_reader;
 
   void init(int job_result_slot);
 
@@ -38,9 +35,23 @@ public:
 
   bool send_job(JobSharedMessage *job_request);
 
+  // the job workers are woken up once for all the jobs sent between these calls
+  void defer_job_workers_wakeup();
+  void flush_job_workers_wakeup();
+  // wakes up the job workers for the jobs sent so far, the next ones are still deferred
+  void wakeup_deferred_job_workers();
+
+  // moves the finished job results to the script memory and releases their shared messages, returns whether there were any
+  bool take_job_results();
+
 private:
+  bool job_workers_wakeup_deferred{false};
+  bool job_workers_wakeup_pending{false};
+
   JobWorkerClient() = default;
 
+  void wakeup_job_workers();
+
   static int read_job_results(int fd, void *data __attribute__((unused)), event_t *ev);
 };
 
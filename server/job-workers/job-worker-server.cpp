@@ -15,6 +15,7 @@
 #include "server/job-workers/job-message.h"
 #include "server/job-workers/job-worker-server.h"
 #include "server/job-workers/job-workers-context.h"
+#include "server/job-workers/pipe-io.h"
 #include "server/job-workers/shared-memory-manager.h"
 #include "server/php-worker.h"
 #include "server/server-log.h"
@@ -128,28 +129,44 @@ int JobWorkerServer::job_parse_execute(connection *c) noexcept {
     return 0;
   }
 
-  JobSharedMessage *job = nullptr;
-  PipeJobReader::ReadStatus status = job_reader.read_job(job);
-
   auto job_fd_rearmer = vk::finally([this]() {
     rearm_read_job_fd(); // because > 1 workers can wake up on single job
   });
 
-  if (status == PipeJobReader::READ_BLOCK) {
-    assert(errno == EWOULDBLOCK);
-    // another job worker has already taken the job (all job workers are readers for this fd)
-    // or there are no more jobs in pipe
-    tvkprintf(job_workers, 3, "No jobs in pipe after wakeup\n");
-    ++vk::singleton<SharedMemoryManager>::get().get_stats().job_worker_skip_job_due_steal;
-    return 0;
-  } else if (status == PipeJobReader::READ_FAIL) {
-    ++vk::singleton<SharedMemoryManager>::get().get_stats().errors_pipe_server_read;
+  auto &memory_manager = vk::singleton<job_workers::SharedMemoryManager>::get();
+  const bool was_waiting = memory_manager.is_waiting_for_jobs();
+  if (was_waiting && !drain_pipe_wakeups(read_job_fd, "read job wakeup")) {
+    ++memory_manager.get_stats().errors_pipe_server_read;
     return -1;
   }
 
+  auto &jobs_queue = memory_manager.get_jobs_queue();
+  JobSharedMessage *job = jobs_queue.pop();
+  if (!job) {
+    // the job could be pushed right before the clients see this worker waiting
+    memory_manager.start_waiting_for_jobs();
+    job = jobs_queue.pop();
+  }
+
+  if (!job) {
+    // another job worker has already taken the job (all job workers are woken up by the same pipe)
+    // or there are no more jobs in the queue
+    if (was_waiting) {
+      tvkprintf(job_workers, 3, "No jobs in queue after wakeup\n");
+      ++memory_manager.get_stats().job_worker_skip_job_due_steal;
+    }
+    return 0;
+  }
+
   job_fd_rearmer.disable();
 
-  auto &memory_manager = vk::singleton<job_workers::SharedMemoryManager>::get();
+  memory_manager.stop_waiting_for_jobs();
+  if (!jobs_queue.empty() && memory_manager.has_workers_waiting_for_jobs()) {
+    // the wakeup could be read by this worker only, so it's passed on to the others for the rest of the jobs
+    ++memory_manager.get_stats().job_workers_wakeups;
+    write_pipe_wakeup(vk::singleton<JobWorkersContext>::get().job_pipe[1], "waking up job workers");
+  }
+
   --memory_manager.get_stats().job_queue_size;
   memory_manager.attach_shared_message_to_this_proc(job);
   if (job->common_job) {
@@ -198,7 +215,12 @@ void JobWorkerServer::init() noexcept {
 
   tvkprintf(job_workers, 1, "insert read job connection [fd = %d] to epoll\n", read_job_connection->fd);
 
-  job_reader = PipeJobReader{read_job_fd};
+  auto &memory_manager = vk::singleton<job_workers::SharedMemoryManager>::get();
+  memory_manager.start_waiting_for_jobs();
+  if (!memory_manager.get_jobs_queue().empty()) {
+    // the jobs pushed before this worker became waiting
+    write_pipe_wakeup(job_workers_ctx.job_pipe[1], "waking up job workers");
+  }
 }
 
 void JobWorkerServer::rearm_read_job_fd() noexcept {
@@ -219,7 +241,7 @@ const char *JobWorkerServer::send_job_reply(JobSharedMessage *job_response) noex
     return reply_was_sent ? "The reply has been already sent" : "Job has no-reply flag";
   }
 
-  int write_job_result_fd = vk::singleton<JobWorkersContext>::get().result_pipes.at(running_job->job_result_fd_idx)[1];
+  const int client_id = running_job->job_result_fd_idx;
   job_response->job_id = running_job->job_id;
 
   const auto &job_memory_stats = job_response->resource.get_memory_stats();
@@ -227,9 +249,16 @@ const char *JobWorkerServer::send_job_reply(JobSharedMessage *job_response) noex
   job_stat.job_response_max_memory_used = job_memory_stats.max_memory_used;
 
   int32_t job_response_id = job_response->job_id;
-  if (!job_writer.write_job_result(job_response, write_job_result_fd)) {
-    ++vk::singleton<SharedMemoryManager>::get().get_stats().errors_pipe_server_write;
-    return "Can't write job reply to the pipe";
+  auto &memory_manager = vk::singleton<SharedMemoryManager>::get();
+  if (!memory_manager.get_job_results_queue(client_id).push(job_response)) {
+    ++memory_manager.get_stats().errors_job_results_queue_full;
+    return "Can't push job reply to the queue";
+  }
+  if (memory_manager.disarm_job_results_wakeup(client_id)) {
+    int write_job_result_fd = vk::singleton<JobWorkersContext>::get().result_pipes.at(client_id)[1];
+    if (!write_pipe_wakeup(write_job_result_fd, "writing job result wakeup")) {
+      ++memory_manager.get_stats().errors_pipe_server_write;
+    }
   }
   ++vk::singleton<SharedMemoryManager>::get().get_stats().jobs_replied;
   reply_was_sent = true;
@@ -242,7 +271,7 @@ void JobWorkerServer::store_job_response_error(const char *error_msg, int error_
   php_assert(running_job);
 
   auto &memory_manager = vk::singleton<job_workers::SharedMemoryManager>::get();
-  auto *response_memory = memory_manager.acquire_shared_message<job_workers::JobSharedMessage>();
+  auto *response_memory = memory_manager.acquire_shared_message_for_reply();
   if (!response_memory) {
     log_server_error("Can't store job response error: not enough shared messages.\nUnstored error details: error_code = %d, error_msg = %s", error_code, error_msg);
     return;
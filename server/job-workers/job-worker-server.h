@@ -9,7 +9,6 @@
 #include "common/mixin/not_copyable.h"
 #include "common/smart_ptrs/singleton.h"
 #include "common/timer.h"
-#include "server/job-workers/pipe-io.h"
 
 struct connection;
 
@@ -52,8 +51,6 @@ private:
   const char *send_job_reply(JobSharedMessage *response) noexcept;
 
   JobSharedMessage *running_job{nullptr};
-  PipeJobWriter job_writer;
-  PipeJobReader job_reader;
   int read_job_fd{-1};
   connection *read_job_connection{nullptr};
   bool reply_was_sent{false};
@@ -2,6 +2,10 @@
 // Copyright (c) 2021 LLC «V Kontakte»
 // Distributed under the GPL v3 License, see LICENSE.notice.txt
 
+#include <algorithm>
+#include <array>
+
+#include "common/huge-pages.h"
 #include "common/wrappers/memory-utils.h"
 
 #include "server/php-engine-vars.h"
@@ -27,15 +31,18 @@ void SharedMemoryManager::init() noexcept {
     auto mul = per_process_memory_limit_ ? per_process_memory_limit_ : JOB_DEFAULT_MEMORY_LIMIT_PROCESS_MULTIPLIER;
     memory_limit_ = processes * mul + sizeof(ControlBlock);
   }
-  auto *raw_mem = static_cast<uint8_t *>(mmap_shared(memory_limit_));
+  auto *raw_mem = static_cast<uint8_t *>(mmap_shared_huge_pages(memory_limit_));
   const size_t left_memory = memory_limit_ - sizeof(ControlBlock);
   const uint32_t messages_count = std::min(shared_messages_count_, left_memory / sizeof(JobSharedMessage));
   control_block_ = new(raw_mem) ControlBlock{};
   raw_mem += sizeof(ControlBlock);
+  auto *messages_begin = reinterpret_cast<JobSharedMessage *>(raw_mem);
   for (uint32_t i = 0; i != messages_count; ++i) {
-    freelist_put(&control_block_->free_messages, raw_mem);
+    put_free_message(raw_mem);
     raw_mem += sizeof(JobSharedMessage);
   }
+  // each job worker replies to one job at once
+  reserved_messages_for_replies_ = std::min<uint32_t>(vk::singleton<WorkersControl>::get().get_count(WorkerType::job_worker), messages_count / 2);
 
   std::array<memory_resource::extra_memory_raw_bucket, JOB_EXTRA_MEMORY_BUFFER_BUCKETS> extra_memory;
   control_block_->stats.unused_memory = memory_resource::distribute_memory(extra_memory, shared_messages_count_ / 2, raw_mem,
@@ -51,6 +58,15 @@ void SharedMemoryManager::init() noexcept {
 
   control_block_->stats.memory_limit = memory_limit_;
   control_block_->stats.messages.count = messages_count;
+
+  // each queued job or job result holds a message, so the queues can't overflow
+  constexpr size_t queue_alignment = alignof(JobMessagesQueue);
+  queue_memory_size_ = (JobMessagesQueue::get_memory_size(messages_count) + queue_alignment - 1) & ~(queue_alignment - 1);
+  // the jobs queue and the job results queue for each process
+  queues_memory_ = static_cast<uint8_t *>(mmap_shared(queue_memory_size_ * (processes + 1)));
+  for (size_t queue_id = 0; queue_id != processes + 1; ++queue_id) {
+    JobMessagesQueue::create(queues_memory_ + queue_id * queue_memory_size_, messages_count, messages_begin);
+  }
 }
 
 bool SharedMemoryManager::set_memory_limit(size_t memory_limit) noexcept {
@@ -102,7 +118,8 @@ void SharedMemoryManager::release_shared_message(JobMetadata *message) noexcept
       freelist_put(&control_block_->free_extra_memory[i], releasing_extra_memory);
       ++control_block_->stats.extra_memory[i].released;
     }
-    freelist_put(&control_block_->free_messages, message);
+    control_block_->stats.add_message_size(message->resource.get_memory_stats().max_memory_used);
+    put_free_message(message);
     ++control_block_->stats.messages.released;
   }
 }
@@ -152,6 +169,151 @@ bool SharedMemoryManager::request_extra_memory_for_resource(memory_resource::uns
   return false;
 }
 
+void SharedMemoryManager::rebalance_extra_memory() noexcept {
+  assert(control_block_);
+  std::array<bool, JOB_EXTRA_MEMORY_BUFFER_BUCKETS> lacked{};
+  for (size_t i = 0; i != lacked.size(); ++i) {
+    const uint32_t acquire_fails = control_block_->stats.extra_memory[i].acquire_fails.load(std::memory_order_relaxed);
+    lacked[i] = acquire_fails != extra_memory_acquire_fails_[i];
+    extra_memory_acquire_fails_[i] = acquire_fails;
+  }
+
+  for (size_t i = 0; i != lacked.size(); ++i) {
+    if (!lacked[i]) {
+      continue;
+    }
+    // a larger buffer is split first, as the requests that fail for the smaller buckets are served by the larger ones anyway
+    bool rebalanced = false;
+    for (size_t larger = i + 1; larger != lacked.size() && !rebalanced; ++larger) {
+      if (!lacked[larger] && get_free_extra_memory_buffers(larger)) {
+        rebalanced = split_extra_memory_buffer(larger);
+        for (size_t bucket = larger - 1; rebalanced && bucket != i; --bucket) {
+          rebalanced = split_extra_memory_buffer(bucket);
+        }
+      }
+    }
+    if (!rebalanced && i && !lacked[i - 1] && get_free_extra_memory_buffers(i - 1) >= 2) {
+      merge_extra_memory_buffers(i - 1);
+    }
+  }
+}
+
+bool SharedMemoryManager::split_extra_memory_buffer(size_t bucket) noexcept {
+  assert(bucket && bucket < control_block_->free_extra_memory.size());
+  auto *buffer = static_cast<uint8_t *>(freelist_get(&control_block_->free_extra_memory[bucket]));
+  if (!buffer) {
+    return false;
+  }
+  const size_t half_size = memory_resource::extra_memory_raw_bucket::get_size_by_bucket(bucket - 1);
+  freelist_put(&control_block_->free_extra_memory[bucket - 1], buffer);
+  freelist_put(&control_block_->free_extra_memory[bucket - 1], buffer + half_size);
+  --control_block_->stats.extra_memory[bucket].count;
+  control_block_->stats.extra_memory[bucket - 1].count += 2;
+  return true;
+}
+
+bool SharedMemoryManager::merge_extra_memory_buffers(size_t bucket) noexcept {
+  assert(bucket + 1 < control_block_->free_extra_memory.size());
+  // the free buffers are popped one by one until an adjacent pair is found, but not more than candidates can hold,
+  // the workers that need them meanwhile fall back to the larger buckets
+  auto &free_buffers = control_block_->free_extra_memory[bucket];
+  const size_t buffer_size = memory_resource::extra_memory_raw_bucket::get_size_by_bucket(bucket);
+  std::array<uint8_t *, 16> candidates{};
+  size_t candidates_count = 0;
+  bool merged = false;
+  while (!merged && candidates_count != candidates.size()) {
+    auto *buffer = static_cast<uint8_t *>(freelist_get(&free_buffers));
+    if (!buffer) {
+      break;
+    }
+    for (size_t i = 0; i != candidates_count && !merged; ++i) {
+      if (candidates[i] + buffer_size == buffer || buffer + buffer_size == candidates[i]) {
+        freelist_put(&control_block_->free_extra_memory[bucket + 1], std::min(candidates[i], buffer));
+        candidates[i] = candidates[--candidates_count];
+        merged = true;
+      }
+    }
+    if (!merged) {
+      candidates[candidates_count++] = buffer;
+    }
+  }
+  for (size_t i = 0; i != candidates_count; ++i) {
+    freelist_put(&free_buffers, candidates[i]);
+  }
+  if (merged) {
+    control_block_->stats.extra_memory[bucket].count -= 2;
+    ++control_block_->stats.extra_memory[bucket + 1].count;
+  }
+  return merged;
+}
+
+uint32_t SharedMemoryManager::get_free_extra_memory_buffers(size_t bucket) const noexcept {
+  const auto &stats = control_block_->stats.extra_memory[bucket];
+  const size_t used = stats.acquired.load(std::memory_order_relaxed) - stats.released.load(std::memory_order_relaxed);
+  const uint32_t count = stats.count.load(std::memory_order_relaxed);
+  return used < count ? count - used : 0;
+}
+
+void *SharedMemoryManager::get_free_message(uint32_t reserved_messages) noexcept {
+  uint32_t free_messages_count = control_block_->free_messages_count.load(std::memory_order_relaxed);
+  do {
+    if (free_messages_count <= reserved_messages) {
+      return nullptr;
+    }
+  } while (!control_block_->free_messages_count.compare_exchange_weak(free_messages_count, free_messages_count - 1, std::memory_order_acq_rel));
+
+  void *message = freelist_get(&control_block_->free_messages);
+  if (!message) {
+    // it shouldn't happen, as the counter is never ahead of the freelist, but the counter is kept consistent anyway
+    ++control_block_->free_messages_count;
+  }
+  return message;
+}
+
+void SharedMemoryManager::put_free_message(void *message) noexcept {
+  freelist_put(&control_block_->free_messages, message);
+  ++control_block_->free_messages_count;
+}
+
+void SharedMemoryManager::start_waiting_for_jobs() noexcept {
+  bool &waits_for_jobs = control_block_->workers_table[logname_id].waits_for_jobs;
+  if (!waits_for_jobs) {
+    waits_for_jobs = true;
+    control_block_->workers_waiting_for_jobs.fetch_add(1, std::memory_order_seq_cst);
+  }
+}
+
+void SharedMemoryManager::stop_waiting_for_jobs() noexcept {
+  bool &waits_for_jobs = control_block_->workers_table[logname_id].waits_for_jobs;
+  if (waits_for_jobs) {
+    waits_for_jobs = false;
+    control_block_->workers_waiting_for_jobs.fetch_sub(1, std::memory_order_seq_cst);
+  }
+}
+
+bool SharedMemoryManager::is_waiting_for_jobs() const noexcept {
+  return control_block_->workers_table[logname_id].waits_for_jobs;
+}
+
+bool SharedMemoryManager::has_workers_waiting_for_jobs() const noexcept {
+  return control_block_->workers_waiting_for_jobs.load(std::memory_order_seq_cst) != 0;
+}
+
+void SharedMemoryManager::forcibly_stop_waiting_for_jobs() noexcept {
+  if (control_block_) {
+    // the previous process with the same id could be killed while it was waiting
+    stop_waiting_for_jobs();
+  }
+}
+
+void SharedMemoryManager::arm_job_results_wakeup() noexcept {
+  control_block_->workers_table[logname_id].job_results_wakeup_armed.store(true, std::memory_order_seq_cst);
+}
+
+bool SharedMemoryManager::disarm_job_results_wakeup(int client_id) noexcept {
+  return control_block_->workers_table[client_id].job_results_wakeup_armed.exchange(false, std::memory_order_seq_cst);
+}
+
 JobStats &SharedMemoryManager::get_stats() noexcept {
   assert(control_block_);
   return control_block_->stats;
@@ -10,6 +10,7 @@
 
 #include "runtime/critical_section.h"
 #include "runtime/memory_resource/extra-memory-pool.h"
+#include "server/job-workers/job-messages-queue.h"
 #include "server/job-workers/job-stats.h"
 #include "server/job-workers/job-workers-context.h"
 #include "server/php-engine-vars.h"
@@ -34,6 +35,10 @@ struct WorkerProcessMeta {
   // + 2 messages: mutable request & immutable request, if job is invoked from running job
   // so let's use 8 just in case
   std::array<JobMetadata *, 8> attached_messages{};
+  // the job worker is counted in ControlBlock::workers_waiting_for_jobs
+  bool waits_for_jobs{false};
+  // the job results producer should wake up the client, it's reset by the producer who does it
+  std::atomic<bool> job_results_wakeup_armed{false};
 
   void attach(JobMetadata *message) noexcept {
     replace(nullptr, message);
@@ -59,18 +64,22 @@ class SharedMemoryManager : vk::not_copyable {
 public:
   void init() noexcept;
 
+  // the last messages are reserved for the job replies, so the running jobs can always reply, and the requests can't take them
   template <typename JobMessageT>
   JobMessageT *acquire_shared_message() noexcept {
-    assert(control_block_);
-    dl::CriticalSectionGuard critical_section;
-    if (void *free_mem = freelist_get(&control_block_->free_messages)) {
-      auto *message = new(free_mem) JobMessageT{};
-      control_block_->workers_table[logname_id].attach(message);
-      ++control_block_->stats.messages.acquired;
-      return message;
-    }
-    ++control_block_->stats.messages.acquire_fails;
-    return nullptr;
+    return acquire_shared_message_impl<JobMessageT>(reserved_messages_for_replies_, [] { return false; });
+  }
+
+  // if there are no free messages, release_own_messages is called to release the messages held by the caller itself
+  // (e.g. its finished job results, which the job workers can't release), the acquire is retried while it releases any,
+  // otherwise it fails at once, as the job workers can't release the messages while the caller doesn't return to the reactor
+  template <typename JobMessageT, typename F>
+  JobMessageT *acquire_shared_message(const F &release_own_messages) noexcept {
+    return acquire_shared_message_impl<JobMessageT>(reserved_messages_for_replies_, release_own_messages);
+  }
+
+  JobSharedMessage *acquire_shared_message_for_reply() noexcept {
+    return acquire_shared_message_impl<JobSharedMessage>(0, [] { return false; });
   }
 
   void release_shared_message(JobMetadata *message) noexcept;
@@ -87,6 +96,34 @@ public:
 
   bool request_extra_memory_for_resource(memory_resource::unsynchronized_pool_resource &resource, size_t required_size) noexcept;
 
+  // called from master cron: the extra memory buffers of the buckets, which weren't enough since the previous call,
+  // are made of the free buffers of the other buckets, either by splitting a larger buffer or by merging two adjacent smaller ones
+  void rebalance_extra_memory() noexcept;
+
+  // the jobs are pushed by the clients and popped by the job workers
+  JobMessagesQueue &get_jobs_queue() noexcept {
+    return get_queue(0);
+  }
+
+  // the job results are pushed by the job workers and popped by the client
+  JobMessagesQueue &get_job_results_queue(int client_id) noexcept {
+    assert(client_id >= 0 && client_id < vk::singleton<WorkersControl>::get().get_total_workers_count());
+    return get_queue(client_id + 1);
+  }
+
+  // the job worker that found the jobs queue empty becomes waiting, so the clients wake it up after pushing jobs;
+  // it should check the queue once more after that, as the clients could push a job before they see it waiting
+  void start_waiting_for_jobs() noexcept;
+  void stop_waiting_for_jobs() noexcept;
+  bool is_waiting_for_jobs() const noexcept;
+  bool has_workers_waiting_for_jobs() const noexcept;
+  void forcibly_stop_waiting_for_jobs() noexcept;
+
+  // the client arms the wakeup after it has popped all the job results,
+  // the job worker that disarms it after pushing a result should wake up the client
+  void arm_job_results_wakeup() noexcept;
+  bool disarm_job_results_wakeup(int client_id) noexcept;
+
   JobStats &get_stats() noexcept;
 
   bool is_initialized() const noexcept {
@@ -103,6 +140,44 @@ private:
   size_t per_process_memory_limit_{0};
   size_t shared_messages_count_process_multiplier_{0};
 
+  uint32_t reserved_messages_for_replies_{0};
+  // the master's view of the extra memory acquire fails at the previous rebalance
+  std::array<uint32_t, JOB_EXTRA_MEMORY_BUFFER_BUCKETS> extra_memory_acquire_fails_{};
+
+  uint8_t *queues_memory_{nullptr};
+  size_t queue_memory_size_{0};
+
+  JobMessagesQueue &get_queue(size_t queue_id) noexcept {
+    assert(queues_memory_);
+    return *reinterpret_cast<JobMessagesQueue *>(queues_memory_ + queue_id * queue_memory_size_);
+  }
+
+  template <typename JobMessageT, typename F>
+  JobMessageT *acquire_shared_message_impl(uint32_t reserved_messages, const F &release_own_messages) noexcept {
+    assert(control_block_);
+    bool retried = false;
+    do {
+      dl::CriticalSectionGuard critical_section;
+      if (void *free_mem = get_free_message(reserved_messages)) {
+        auto *message = new(free_mem) JobMessageT{};
+        control_block_->workers_table[logname_id].attach(message);
+        ++control_block_->stats.messages.acquired;
+        control_block_->stats.messages_retries += retried;
+        return message;
+      }
+      retried = true;
+    } while (release_own_messages());
+    ++control_block_->stats.messages.acquire_fails;
+    return nullptr;
+  }
+
+  void *get_free_message(uint32_t reserved_messages) noexcept;
+  void put_free_message(void *message) noexcept;
+
+  bool split_extra_memory_buffer(size_t bucket) noexcept;
+  bool merge_extra_memory_buffers(size_t bucket) noexcept;
+  uint32_t get_free_extra_memory_buffers(size_t bucket) const noexcept;
+
   struct alignas(8) ControlBlock {
     ControlBlock() noexcept {
       freelist_init(&free_messages);
@@ -114,6 +189,9 @@ private:
     JobStats stats;
     std::array<WorkerProcessMeta, WorkersControl::max_workers_count> workers_table{};
     freelist_t free_messages{};
+    // it's decremented before taking a message from the freelist and incremented after putting one there
+    std::atomic<uint32_t> free_messages_count{0};
+    std::atomic<uint32_t> workers_waiting_for_jobs{0};
 
     //  index => (1 << index) MB:
     //    0 => 1MB, 1 => 2MB, 2 => 4MB, 3 => 8MB, 4 => 16MB, 5 => 32MB, 6 => 64MB
@@ -23,6 +23,7 @@
 #include "common/crc32c.h"
 #include "common/cycleclock.h"
 #include "common/dl-utils-lite.h"
+#include "common/huge-pages.h"
 #include "common/kprintf.h"
 #include "common/macos-ports.h"
 #include "common/options.h"
@@ -36,6 +37,7 @@
 #include "common/server/signals.h"
 #include "common/tl/constants/common.h"
 #include "common/tl/constants/kphp.h"
+#include "common/tl/methods/compression.h"
 #include "common/tl/methods/rwm.h"
 #include "common/tl/parse.h"
 #include "common/tl/query-header.h"
@@ -55,13 +57,16 @@
 #include "net/net-tcp-rpc-client.h"
 #include "net/net-tcp-rpc-server.h"
 
+#include "runtime/curl.h"
 #include "runtime/interface.h"
 #include "runtime/json-functions.h"
 #include "runtime/profiler.h"
+#include "runtime/regexp.h"
 #include "runtime/rpc.h"
 #include "server/server-config.h"
 #include "server/confdata-binlog-replay.h"
 #include "server/database-drivers/adaptor.h"
+#include "server/database-drivers/connection-pool.h"
 #include "server/database-drivers/connector.h"
 #include "server/job-workers/job-worker-client.h"
 #include "server/job-workers/job-worker-server.h"
@@ -76,9 +81,11 @@
 #include "server/php-init-scripts.h"
 #include "server/php-lease.h"
 #include "server/php-master-warmup.h"
+#include "server/php-master-zygote.h"
 #include "server/php-master.h"
 #include "server/php-mc-connections.h"
 #include "server/php-queries.h"
+#include "server/php-rpc-connections.h"
 #include "server/php-runner.h"
 #include "server/php-sql-connections.h"
 #include "server/php-worker.h"
@@ -270,8 +277,9 @@ void command_net_write_run_rpc(command_t *base_command, void *data) {
   } else {
     auto *d = (connection *)data;
     //assert (d->status == conn_ready);
-    send_rpc_query(d, TL_RPC_INVOKE_REQ, slot_id, (int *)command->data, command->len);
+    send_rpc_query_later(d, TL_RPC_INVOKE_REQ, slot_id, (int *)command->data, command->len);
     d->last_query_sent_time = precise_now;
+    vk::singleton<RpcConnectionsLoad>::get().on_query_sent(d, slot_id);
   }
 }
 
@@ -314,6 +322,12 @@ int queries_to_recreate_script = 100;
 
 PhpScript *php_script;
 
+void create_php_script_if_needed() noexcept {
+  if (php_script == nullptr) {
+    php_script = new PhpScript(max_memory, oom_handling_memory_ratio, 8 << 20);
+  }
+}
+
 int has_pending_scripts() {
   return php_worker_run_flag || pending_http_queue.first_query != (conn_query *)&pending_http_queue;
 }
@@ -336,7 +350,9 @@ void prepare_rpc_query_raw(int packet_id, int *q, int qsize, unsigned (*crc32_pa
   q[qlen - 1] = (int)~crc32_partial_custom(q, q[0] - 4, 0xffffffff);
 }
 
-void send_rpc_query(connection *c, int op, long long id, int *q, int qsize) {
+static void push_rpc_query(connection *c, int op, long long id, int *q, int qsize) ubsan_supp("alignment");
+
+static void push_rpc_query(connection *c, int op, long long id, int *q, int qsize) {
   q[2] = op;
   if (id != -1) {
     *(long long *)(q + 3) = id;
@@ -344,10 +360,19 @@ void send_rpc_query(connection *c, int op, long long id, int *q, int qsize) {
 
   vkprintf (4, "send_rpc_query: [len = %d] [op = %08x] [rpc_id = <%lld>]\n", q[0], op, id);
   tcp_rpc_conn_send_data(c, static_cast<int>(qsize - 3 * sizeof(int)), q + 2);
+}
 
+void send_rpc_query(connection *c, int op, long long id, int *q, int qsize) {
+  push_rpc_query(c, op, id, q, qsize);
   TCP_RPCS_FUNC(c)->flush_packet(c);
 }
 
+void send_rpc_query_later(connection *c, int op, long long id, int *q, int qsize) {
+  push_rpc_query(c, op, id, q, qsize);
+  // the crypto padding is added by the flush, right before the output is written
+  flush_later(c);
+}
+
 void on_net_event(int event_status) {
   if (event_status == 0) {
     return;
@@ -692,6 +717,7 @@ conn_type_t ct_php_rpc_client = [] {
   res.run = server_read_write;
   res.reader = tcp_server_reader;
   res.writer = tcp_server_writer;
+  res.flush = tcp_rpcc_flush;
   res.parse_execute = tcp_rpcc_parse_execute;
   res.close = tcp_rpcc_close_connection;
   res.free_buffers = tcp_free_connection_buffers;
@@ -895,6 +921,34 @@ static void send_rpc_error(connection *c, long long req_id, int error_code, cons
   }
 }
 
+// The answer to the query announcing supported_compression_version may be packed as the engines do it:
+// reqResultHeader with the compression_version flag is followed by the packed rest of the answer.
+// The scripts can't fetch such answers, so they are unpacked here, see tl_fetch_packed_query_answer_header().
+static int create_unpacked_rpc_answer_event(slot_id_t slot_id) {
+  static std::string unpacked_header;
+  // the answer is copied to the script memory, so it can't be larger than that
+  if (!tl_fetch_packed_query_answer_header(unpacked_header, static_cast<int>(max_memory))) {
+    return create_rpc_error_event(slot_id, TL_ERROR_HEADER, "Can't unpack the rpc answer", nullptr);
+  }
+  const int unpacked_header_len = static_cast<int>(unpacked_header.size());
+  const int unpacked_len = static_cast<int>(tl_fetch_unread());
+
+  net_event_t *event = nullptr;
+  int event_status = create_rpc_answer_event(slot_id, unpacked_header_len + unpacked_len, &event);
+  if (event_status > 0) {
+    char *result_buf = nullptr;
+    if (auto *ptr = std::get_if<net_events_data::rpc_answer>(&event->data)) {
+      result_buf = ptr->result;
+    } else {
+      assert(false);
+    }
+    memcpy(result_buf, unpacked_header.data(), unpacked_header_len);
+    auto fetched_bytes = tl_fetch_data(result_buf + unpacked_header_len, unpacked_len);
+    assert (fetched_bytes == unpacked_len);
+  }
+  return event_status;
+}
+
 int rpcx_execute(connection *c, int op, raw_message *raw) {
   vkprintf(1, "rpcx_execute: fd=%d, op=%d, len=%d\n", c->fd, op, raw->total_bytes);
 
@@ -1049,6 +1103,11 @@ int rpcx_execute(connection *c, int op, raw_message *raw) {
       assert(op_from_tl == op);
 
       auto id = tl_fetch_long();
+      const double response_time = vk::singleton<RpcConnectionsLoad>::get().on_answer_received(c, id);
+      if (!vk::singleton<RpcQueriesHedging>::get().on_answer_received(c, id, response_time)) {
+        // the other copy of the hedged query has been already answered
+        return 0;
+      }
       if (op == TL_RPC_REQ_ERROR) {
         //FIXME: error code, error string
         //almost never happens
@@ -1056,6 +1115,15 @@ int rpcx_execute(connection *c, int op, raw_message *raw) {
         break;
       }
 
+      int answer_header[2] = {0, 0};
+      if (tl_fetch_unread() >= static_cast<int64_t>(sizeof(answer_header))) {
+        tl_fetch_lookup_data(reinterpret_cast<char *>(answer_header), sizeof(answer_header));
+      }
+      if (answer_header[0] == static_cast<int>(TL_REQ_RESULT_HEADER) && (answer_header[1] & vk::tl::common::rpc_req_result_extra_flags::compression_version)) {
+        event_status = create_unpacked_rpc_answer_event(static_cast<slot_id_t>(id));
+        break;
+      }
+
       net_event_t *event = nullptr;
       event_status = create_rpc_answer_event(static_cast<slot_id_t>(id), result_len, &event);
       if (event_status > 0) {
@@ -1641,10 +1709,18 @@ void start_server() {
   }
 
   worker_global_init(worker_type);
+  if (prefault_memory_enabled()) {
+    // the script memory is created and pre-faulted before the first request
+    create_php_script_if_needed();
+  }
   generic_event_loop(worker_type, !master_flag);
 }
 
 void set_instance_cache_memory_limit(size_t limit);
+void set_instance_cache_eviction_threshold(double threshold);
+void set_instance_cache_snapshot_path(const char *path);
+void set_instance_cache_snapshot_period(double period_sec);
+void instance_cache_load_snapshot();
 const char *get_php_scripts_version() noexcept;
 char **get_runtime_options(int *count) noexcept;
 
@@ -1685,6 +1761,10 @@ void init_all() {
   worker_id = (int)lrand48();
 
   init_confdata_binlog_reader();
+
+  if (!run_once) {
+    instance_cache_load_snapshot();
+  }
 }
 
 void init_logname(const char *src) {
@@ -2190,6 +2270,68 @@ int main_args_handler(int i, const char *long_option) {
     case 2034: {
       return read_option_to(long_option, 0.0, 5.0, hard_timeout);
     }
+    case 2035: {
+      const int64_t regexp_worker_cache_memory_limit = parse_memory_limit(optarg);
+      if (regexp_worker_cache_memory_limit < 0) {
+        kprintf("--%s option: couldn't parse argument\n", long_option);
+        return -1;
+      }
+      set_regexp_worker_cache_memory_limit(static_cast<size_t>(regexp_worker_cache_memory_limit));
+      return 0;
+    }
+    case 2036: {
+      return parse_numeric_option(long_option, 0, std::numeric_limits<int>::max(), [](int max_idle) {
+        vk::singleton<database_drivers::ConnectionPool>::get().set_max_idle_connections(static_cast<size_t>(max_idle));
+      });
+    }
+    case 2037: {
+      return parse_numeric_option(long_option, 0.0, 86400.0, [](double idle_timeout) {
+        vk::singleton<database_drivers::ConnectionPool>::get().set_idle_timeout(idle_timeout);
+      });
+    }
+    case 2038: {
+      return parse_numeric_option(long_option, 0, std::numeric_limits<int>::max(), [](int max_connections) {
+        set_curl_share_max_connections(max_connections);
+      });
+    }
+    case 2039: {
+      return parse_numeric_option(long_option, 0, 86400, [](int max_idle_time) {
+        set_curl_share_max_idle_time(max_idle_time);
+      });
+    }
+    case 2040: {
+      return parse_numeric_option(long_option, 0.1, 1.0, [](double threshold) {
+        set_instance_cache_eviction_threshold(threshold);
+      });
+    }
+    case 2041: {
+      set_instance_cache_snapshot_path(optarg);
+      return 0;
+    }
+    case 2042: {
+      return parse_numeric_option(long_option, 1.0, 86400.0, [](double period_sec) {
+        set_instance_cache_snapshot_period(period_sec);
+      });
+    }
+    case 2043: {
+      vk::singleton<WorkerZygote>::get().enable();
+      return 0;
+    }
+    case 2044: {
+      return parse_numeric_option(long_option, 50.0, 99.9, [](double percentile) {
+        vk::singleton<RpcQueriesHedging>::get().set_percentile(percentile);
+      });
+    }
+    case 2045: {
+      return parse_numeric_option(long_option, 0.0, 1.0, [](double budget) {
+        vk::singleton<RpcQueriesHedging>::get().set_budget(budget);
+      });
+    }
+    case 2046: {
+      return parse_numeric_option(long_option, 0, std::numeric_limits<int>::max(), [](int pack_threshold) {
+        set_rpc_zstd_pack_threshold(pack_threshold);
+      });
+    }
     default:
       return -1;
   }
@@ -2297,6 +2439,21 @@ void parse_main_args(int argc, char *argv[]) {
   parse_option("runtime-config", required_argument, 2032, "JSON file path that will be available at runtime as 'mixed' via 'kphp_runtime_config()");
   parse_option("oom-handling-memory-ratio", required_argument, 2033, "memory ratio of overall script memory to handle OOM errors (default: 0.00)");
   parse_option("hard-time-limit", required_argument, 2034, "time limit for script termination after the main timeout has expired (default: 1 sec). Use 0 to disable");
+  parse_option("regexp-worker-cache-memory-limit", required_argument, 2035, "memory limit for the non-constant regexps compiled on their second use and reused between requests by each worker (default: 16m). Use 0 to disable");
+  parse_option("db-connection-pool-max-idle", required_argument, 2036, "maximal number of idle PDO connections kept by each worker between requests (default: 8). Use 0 to disable");
+  parse_option("db-connection-pool-idle-timeout", required_argument, 2037, "idle PDO connections kept longer than this are closed, in seconds (default: 60)");
+  parse_option("curl-max-cached-connections", required_argument, 2038, "maximal number of curl connections kept alive by each worker between requests (default: 16). Use 0 to disable the reuse");
+  parse_option("curl-cached-connection-max-idle", required_argument, 2039, "curl connections idle for longer than this are not reused, in seconds (default: 60)");
+  parse_option("instance-cache-eviction-threshold", required_argument, 2040, "the ratio of the instance cache memory limit at which the least recently fetched elements start being evicted (default: 0.75). Use 1 to disable the eviction");
+  parse_option("instance-cache-snapshot", required_argument, 2041, "path to the file, where the master periodically saves instances of @kphp-serializable classes from the instance cache, they are loaded back on start");
+  parse_option("instance-cache-snapshot-period", required_argument, 2042, "interval in seconds between the instance cache snapshots (default: 300)");
+  parse_option("zygote", no_argument, 2043, "fork workers from a template process initialized once by the master, so the respawned workers share its memory and start faster");
+  parse_option("rpc-hedging-percentile", required_argument, 2044, "send a copy of the rpc query to another connection of the target, "
+                                                                 "if it isn't answered in this percentile of the target response times (50..99.9, disabled by default); "
+                                                                 "only the queries of the connections created by new_rpc_connection() with $hedging = true are hedged");
+  parse_option("rpc-hedging-budget", required_argument, 2045, "maximum ratio of the hedged rpc queries to all the sent rpc queries (default: 0.05)");
+  parse_option("rpc-zstd-pack-threshold", required_argument, 2046, "pack the rpc answers of at least this size with zstd instead of gzip if the client supports it, "
+                                                                  "and announce the zstd support in the outgoing rpc queries (0 is for disabled, default)");
   parse_engine_options_long(argc, argv, main_args_handler);
   parse_main_args_till_option(argc, argv);
   // TODO: remove it after successful migration from kphb.readyV2 to kphb.readyV3
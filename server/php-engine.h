@@ -43,6 +43,9 @@ extern command_t command_net_write_rpc_base;
 extern conn_target_t rpc_ct;
 
 void send_rpc_query(connection *c, int op, long long id, int *q, int qsize) ubsan_supp("alignment");
+// both are written by the deferred flush, but unlike send_rpc_query(), the crypto padding isn't added after each query,
+// it's added once by the flush of the connection, right before the output is written
+void send_rpc_query_later(connection *c, int op, long long id, int *q, int qsize) ubsan_supp("alignment");
 void on_net_event(int event_status);
 void create_delayed_send_query(conn_target_t *t, command_t *command, double finish_time);
 
@@ -57,6 +60,8 @@ extern int queries_to_recreate_script;
 
 class PhpScript;
 extern PhpScript *php_script;
+// the script memory is kept between the requests until the script is recreated
+void create_php_script_if_needed() noexcept;
 
 void turn_sigterm_on();
 
@@ -0,0 +1,213 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2023 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "server/php-master-zygote.h"
+
+#include <csignal>
+#include <cstring>
+#include <type_traits>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "common/kprintf.h"
+#include "common/macos-ports.h"
+#include "net/net-connections.h"
+#include "net/net-events.h"
+
+namespace {
+
+template<class T>
+bool send_message(int socket_fd, const T &message) noexcept {
+  return send(socket_fd, &message, sizeof(message), MSG_NOSIGNAL) == sizeof(message);
+}
+
+template<class T>
+bool receive_message(int socket_fd, T &message) noexcept {
+  return recv(socket_fd, &message, sizeof(message), MSG_WAITALL) == sizeof(message);
+}
+
+// the worker pid is sent together with the socket the worker waits for the master acknowledgement on
+bool send_worker_pid(int socket_fd, pid_t worker_pid, int ack_fd) noexcept {
+  iovec iov{&worker_pid, sizeof(worker_pid)};
+  std::aligned_storage_t<CMSG_SPACE(sizeof(int)), alignof(cmsghdr)> buf;
+  msghdr msg{};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = &buf;
+  msg.msg_controllen = sizeof(buf);
+
+  cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+  memcpy(CMSG_DATA(cmsg), &ack_fd, sizeof(int));
+  msg.msg_controllen = cmsg->cmsg_len;
+  return sendmsg(socket_fd, &msg, MSG_NOSIGNAL) == sizeof(worker_pid);
+}
+
+bool receive_worker_pid(int socket_fd, pid_t &worker_pid, int &ack_fd) noexcept {
+  iovec iov{&worker_pid, sizeof(worker_pid)};
+  std::aligned_storage_t<CMSG_SPACE(sizeof(int)), alignof(cmsghdr)> buf;
+  msghdr msg{};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = &buf;
+  msg.msg_controllen = sizeof(buf);
+
+  ack_fd = -1;
+  if (recvmsg(socket_fd, &msg, MSG_WAITALL | MSG_CMSG_CLOEXEC) != sizeof(worker_pid)) {
+    return false;
+  }
+  const cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+  if (cmsg != nullptr && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+    memcpy(&ack_fd, CMSG_DATA(cmsg), sizeof(int));
+  }
+  return ack_fd != -1;
+}
+
+} // namespace
+
+pid_t WorkerZygote::fork_worker(WorkerType &worker_type, uint16_t &worker_unique_id) noexcept {
+  if (!enabled_ || (zygote_pid_ != -1 && zygote_socket_ == -1)) {
+    // the zygote is disabled or it's being stopped
+    return fork();
+  }
+
+  if (zygote_pid_ == -1) {
+    int sockets[2];
+    if (prctl(PR_SET_CHILD_SUBREAPER, 1) != 0 || socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0) {
+      kprintf("Can't start the zygote, the workers are forked from the master: %m\n");
+      enabled_ = false;
+      return fork();
+    }
+
+    const pid_t master_pid = getpid();
+    const pid_t zygote_pid = fork();
+    if (zygote_pid == 0) {
+      close(sockets[0]);
+      zygote_socket_ = sockets[1];
+      prctl(PR_SET_PDEATHSIG, SIGKILL);
+      if (getppid() != master_pid) {
+        _exit(0);
+      }
+      // the zygote mustn't keep the master connections and epoll open, as the master closes them;
+      // the workers forked from it create their own epoll anyway
+      net_reset_after_fork();
+      close_epoll();
+      SpawnRequest request{};
+      serve_spawn_requests(request);
+      worker_type = request.worker_type;
+      worker_unique_id = request.worker_unique_id;
+      return 0;
+    }
+
+    close(sockets[1]);
+    if (zygote_pid == -1) {
+      kprintf("Can't fork the zygote, the worker is forked from the master: %m\n");
+      close(sockets[0]);
+      return fork();
+    }
+
+    // the zygote answers right after the fork, if it doesn't, it's considered broken;
+    // the master waits for it synchronously, so the timeout is short not to stall the master cron
+    const timeval timeout{0, 200 * 1000};
+    setsockopt(sockets[0], SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    zygote_pid_ = zygote_pid;
+    zygote_socket_ = sockets[0];
+    vkprintf(1, "zygote launched [pid = %d]\n", static_cast<int>(zygote_pid_));
+  }
+
+  pid_t worker_pid = -1;
+  int ack_fd = -1;
+  if (send_message(zygote_socket_, SpawnRequest{worker_type, worker_unique_id}) && receive_worker_pid(zygote_socket_, worker_pid, ack_fd)) {
+    // the worker is known to the master from now on, even if it has already died, it's waited for as a usual worker
+    send_message(ack_fd, char{1});
+    close(ack_fd);
+    return worker_pid;
+  }
+
+  kprintf("Can't fork the worker from the zygote [pid = %d], the worker is forked from the master\n", static_cast<int>(zygote_pid_));
+  stop();
+  return fork();
+}
+
+void WorkerZygote::serve_spawn_requests(SpawnRequest &request) noexcept {
+  // the loop exits only in the forked workers, the zygote itself exits when the master closes the socket
+  while (receive_message(zygote_socket_, request)) {
+    // the spawn is transactional: the worker starts only after the master has acknowledged its pid,
+    // if the master gave up waiting for the answer, the acknowledgement socket is closed and the worker exits,
+    // so the same worker_unique_id is never used by two workers
+    int ack_sockets[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, ack_sockets) != 0) {
+      send_message(zygote_socket_, pid_t{-1});
+      continue;
+    }
+
+    const pid_t intermediate_pid = fork();
+    if (intermediate_pid == 0) {
+      const pid_t self_pid = getpid();
+      const pid_t worker_pid = fork();
+      if (worker_pid == 0) {
+        close(zygote_socket_);
+        close(ack_sockets[0]);
+        char ack = 0;
+        const bool acknowledged = receive_message(ack_sockets[1], ack);
+        close(ack_sockets[1]);
+        if (!acknowledged) {
+          _exit(SPAWN_ABORTED_EXIT_CODE);
+        }
+        zygote_socket_ = -1;
+        zygote_pid_ = -1;
+        // the worker is reparented to the master as soon as the intermediate process exits
+        while (getppid() == self_pid) {
+          usleep(100);
+        }
+        return;
+      }
+      if (worker_pid == -1) {
+        send_message(zygote_socket_, pid_t{-1});
+      } else {
+        send_worker_pid(zygote_socket_, worker_pid, ack_sockets[0]);
+      }
+      // the exit code matters only if the zygote is killed and the master waits for this process instead
+      _exit(SPAWN_ABORTED_EXIT_CODE);
+    }
+
+    close(ack_sockets[0]);
+    close(ack_sockets[1]);
+    if (intermediate_pid == -1) {
+      send_message(zygote_socket_, pid_t{-1});
+    } else {
+      waitpid(intermediate_pid, nullptr, 0);
+    }
+  }
+  _exit(0);
+}
+
+void WorkerZygote::stop() noexcept {
+  // the zygote pid is kept until the master waits for it
+  kill(zygote_pid_, SIGKILL);
+  close(zygote_socket_);
+  zygote_socket_ = -1;
+}
+
+bool WorkerZygote::on_child_exited(pid_t child_pid, int status) noexcept {
+  if (enabled_ && WIFEXITED(status) && WEXITSTATUS(status) == SPAWN_ABORTED_EXIT_CODE) {
+    // the intermediate process or the not acknowledged worker of a killed zygote, it's reparented to the master
+    vkprintf(1, "aborted zygote spawn exited [pid = %d]\n", static_cast<int>(child_pid));
+    return true;
+  }
+  if (zygote_pid_ == -1 || child_pid != zygote_pid_) {
+    return false;
+  }
+  vkprintf(1, "zygote exited [pid = %d], it will be restarted with the next worker\n", static_cast<int>(zygote_pid_));
+  if (zygote_socket_ != -1) {
+    close(zygote_socket_);
+    zygote_socket_ = -1;
+  }
+  zygote_pid_ = -1;
+  return true;
+}
@@ -0,0 +1,58 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2023 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include <cstdint>
+#include <sys/types.h>
+
+#include "common/smart_ptrs/singleton.h"
+#include "server/workers-control.h"
+
+// The zygote is a template process the workers are forked from, it's turned on by the --zygote option.
+// It's forked from the master right before the first worker, when everything request-independent is already initialized:
+// the runtime libs, the constant arrays and strings, the regexp and TL storers tables, the http sockets and the job workers pipes.
+// The workers share these pages copy-on-write with the zygote, which image never changes, unlike the master heap,
+// so the respawns don't depend on the master memory growth and the master doesn't copy its page tables on each fork.
+// Each worker is forked twice: the intermediate process exits at once, and the worker is reparented to the master,
+// which is a child subreaper, so the master waits and controls it as a usual child.
+// The worker starts only after the master has acknowledged its pid, otherwise it exits with SPAWN_ABORTED_EXIT_CODE.
+class WorkerZygote : public vk::singleton<WorkerZygote> {
+public:
+  void enable() noexcept {
+    enabled_ = true;
+  }
+
+  bool is_enabled() const noexcept {
+    return enabled_;
+  }
+
+  // called from master, works as fork(): returns the worker pid in the master and 0 in the worker,
+  // if the worker is forked from the zygote, worker_type and worker_unique_id are set to the requested ones in the worker;
+  // if the zygote isn't available, the worker is forked from the master
+  pid_t fork_worker(WorkerType &worker_type, uint16_t &worker_unique_id) noexcept;
+
+  // called from master for each waited child, returns true if it was the zygote or its aborted spawn,
+  // the zygote is restarted on the next fork_worker
+  bool on_child_exited(pid_t child_pid, int status) noexcept;
+
+private:
+  static constexpr int SPAWN_ABORTED_EXIT_CODE = 125;
+
+  struct SpawnRequest {
+    WorkerType worker_type;
+    uint16_t worker_unique_id;
+  };
+
+  void serve_spawn_requests(SpawnRequest &request) noexcept;
+  void stop() noexcept;
+
+  bool enabled_{false};
+  pid_t zygote_pid_{-1};
+  int zygote_socket_{-1};
+
+  WorkerZygote() = default;
+
+  friend vk::singleton<WorkerZygote>;
+};
@@ -69,6 +69,7 @@
 
 #include "server/php-master-restart.h"
 #include "server/php-master-warmup.h"
+#include "server/php-master-zygote.h"
 #include "server/server-log.h"
 
 #include "server/job-workers/job-stats.h"
@@ -567,8 +568,8 @@ int run_worker(WorkerType worker_type) {
   assert (vk::singleton<WorkersControl>::get().get_all_alive() < WorkersControl::max_workers_count);
 
   tot_workers_started++;
-  const uint16_t worker_unique_id = vk::singleton<WorkersControl>::get().on_worker_creating(worker_type);
-  pid_t new_pid = fork();
+  uint16_t worker_unique_id = vk::singleton<WorkersControl>::get().on_worker_creating(worker_type);
+  pid_t new_pid = vk::singleton<WorkerZygote>::get().fork_worker(worker_type, worker_unique_id);
   if (new_pid == -1) {
     log_server_critical("fork error on launching %s worker: %s", (worker_type == WorkerType::general_worker ? "general" : "job"), strerror(errno));
     assert(false);
@@ -641,11 +642,16 @@ int run_worker(WorkerType worker_type) {
       char buf[100];
       snprintf(buf, 100, logname_pattern, worker_unique_id);
       logname = strdup(buf);
+    } else if (logname && vk::singleton<WorkerZygote>::get().is_enabled()) {
+      // the logs could be rotated after the zygote start
+      reopen_logs();
+      reopen_json_log();
     }
 
     instance_cache_release_all_resources_acquired_by_this_proc();
     ConfdataGlobalManager::get().force_release_all_resources_acquired_by_this_proc_if_init();
     vk::singleton<job_workers::SharedMemoryManager>::get().forcibly_release_all_attached_messages();
+    vk::singleton<job_workers::SharedMemoryManager>::get().forcibly_stop_waiting_for_jobs();
     vk::singleton<ServerStats>::get().after_fork(pid, active_special_connections, max_special_connections, worker_unique_id, worker_type);
     return 1;
   }
@@ -699,6 +705,10 @@ void update_workers() {
     int status;
     pid_t pid = waitpid(-1, &status, WNOHANG);
     if (pid > 0) {
+      if (vk::singleton<WorkerZygote>::get().on_child_exited(pid, status)) {
+        changed = 1;
+        continue;
+      }
       if (!WIFEXITED (status)) {
         tot_workers_strange_dead++;
       }
@@ -1127,6 +1137,16 @@ STATS_PROVIDER_TAGGED(kphp_stats, 100, stats_tag_kphp_server) {
   stats->add_gauge_stat(instance_cache_element_stats.elements_cached, "instance_cache.elements.cached");
   stats->add_gauge_stat(instance_cache_element_stats.elements_logically_expired_and_ignored, "instance_cache.elements.logically_expired_and_ignored");
   stats->add_gauge_stat(instance_cache_element_stats.elements_logically_expired_but_fetched, "instance_cache.elements.logically_expired_but_fetched");
+  stats->add_gauge_stat(instance_cache_element_stats.elements_evicted, "instance_cache.elements.evicted");
+  stats->add_gauge_stat(instance_cache_element_stats.eviction_passes, "instance_cache.eviction_passes");
+
+  const auto &instance_cache_snapshot_stats = instance_cache_get_snapshot_stats();
+  stats->add_gauge_stat(instance_cache_snapshot_stats.snapshots_written, "instance_cache.snapshot.written");
+  stats->add_gauge_stat(instance_cache_snapshot_stats.snapshots_failed, "instance_cache.snapshot.failed");
+  stats->add_gauge_stat(instance_cache_snapshot_stats.elements_saved, "instance_cache.snapshot.elements_saved");
+  stats->add_gauge_stat(instance_cache_snapshot_stats.elements_skipped, "instance_cache.snapshot.elements_skipped");
+  stats->add_gauge_stat(instance_cache_snapshot_stats.elements_loaded, "instance_cache.snapshot.elements_loaded");
+  stats->add_gauge_stat(instance_cache_snapshot_stats.elements_rejected, "instance_cache.snapshot.elements_rejected");
 
   write_confdata_stats_to(stats);
   vk::singleton<ServerStats>::get().write_stats_to(stats);
@@ -1411,8 +1431,13 @@ static void cron() {
   vk::singleton<SharedData>::get().store_worker_stats({general_workers_stat.running_workers, general_workers_stat.waiting_workers,
                                                         general_workers_stat.ready_for_accept_workers, general_workers_stat.total_workers});
   instance_cache_purge_expired_elements();
+  instance_cache_evict_cold_elements();
+  instance_cache_write_snapshot_step();
   check_and_instance_cache_try_swap_memory();
   confdata_binlog_update_cron();
+  if (vk::singleton<job_workers::SharedMemoryManager>::get().is_initialized()) {
+    vk::singleton<job_workers::SharedMemoryManager>::get().rebalance_extra_memory();
+  }
 }
 
 auto get_steady_tp_ms_now() noexcept {
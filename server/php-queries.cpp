@@ -792,24 +792,16 @@ void *dl_allocate_safe(size_t size) {
     return nullptr;
   }
 
-  assert (size <= (1u << 30) - 13);
-  void *dest = dl::allocate(size + 13);
+  assert (size <= (1u << 30) - STRING_RAW_HEADER_SIZE - 1);
+  void *dest = dl::allocate(size + STRING_RAW_HEADER_SIZE + 1);
   if (dest == nullptr) {
     return nullptr;
   }
 
-  int *dest_int = static_cast <int *> (dest);
-  dest_int[0] = static_cast<int>(size);
-  dest_int[1] = static_cast<int>(size);
-  dest_int[2] = 0;
-  (static_cast <char *> (dest))[size + 12] = '\0';
+  char *data = string_raw_init_header(static_cast <char *> (dest), static_cast<int>(size), 0, 0);
+  data[size] = '\0';
 
-//  fprintf (stderr, "Allocate string of len %d at %p\n", (int)size, (void *)(dest_int + 3));
-//  for (int i = 0; i < (int)size + 13; i++) {
-//    fprintf (stderr, "%d: %x(%d)\n", i - 12, static_cast <char *> (dest)[i], static_cast <char *> (dest)[i]);
-//  }
-
-  return (void *)(dest_int + 3);
+  return data;
 }
 
 int alloc_net_event(slot_id_t slot_id, net_event_t **res) {
@@ -954,7 +946,7 @@ void http_send_immediate_response(const char *headers, int headers_len, const ch
   }
 }
 
-slot_id_t rpc_send_query(int host_num, char *request, int request_size, int timeout_ms) {
+slot_id_t rpc_send_query(int host_num, char *request, int request_size, int timeout_ms, bool hedging) {
   net_query_t *query = create_net_query();
   if (query == nullptr) {
     return -1; // memory limit
@@ -966,7 +958,7 @@ slot_id_t rpc_send_query(int host_num, char *request, int request_size, int time
   }
 
   PhpQueriesStats::get_rpc_queries_stat().register_query(request_size);
-  query->data = net_queries_data::rpc_send{ host_num, request, request_size, timeout_ms };
+  query->data = net_queries_data::rpc_send{ host_num, request, request_size, timeout_ms, hedging };
   return query->slot_id;
 }
 
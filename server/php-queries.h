@@ -65,6 +65,8 @@ struct rpc_send {
   char *request{};
   int request_size{};
   int timeout_ms{};
+  // the query is sent by the connection with the hedging turned on, and its answer isn't ignored
+  bool hedging{};
 };
 
 } // namespace net_queries_data
@@ -327,7 +329,7 @@ void script_error();
 void finish_script(int exit_code);
 void http_send_immediate_response(const char *headers, int headers_len, const char *body, int body_len);
 int rpc_connect_to(const char *host_name, int port);
-slot_id_t rpc_send_query(int host_num, char *request, int request_len, int timeout_ms);
+slot_id_t rpc_send_query(int host_num, char *request, int request_len, int timeout_ms, bool hedging);
 void wait_net_events(int timeout_ms);
 net_event_t *pop_net_event();
 const net_event_t *get_last_net_event();
@@ -0,0 +1,195 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2023 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "server/php-rpc-connections.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "common/container_of.h"
+#include "common/precise-time.h"
+#include "common/tl/constants/common.h"
+#include "net/net-events.h"
+#include "server/php-engine.h"
+
+namespace {
+
+// the weight of the last response time in the smoothed one
+constexpr double RESPONSE_TIME_SMOOTHING = 0.2;
+
+bool is_less_loaded(const connection *lhs, const connection *rhs) noexcept {
+  if (lhs->rpc_queries_in_flight != rhs->rpc_queries_in_flight) {
+    return lhs->rpc_queries_in_flight < rhs->rpc_queries_in_flight;
+  }
+  return lhs->rpc_avg_response_time < rhs->rpc_avg_response_time;
+}
+
+} // namespace
+
+connection *RpcConnectionsLoad::choose_connection(conn_target_t *target) noexcept {
+  return choose_connection(target, nullptr);
+}
+
+connection *RpcConnectionsLoad::choose_connection(conn_target_t *target, const connection *skipped_conn) noexcept {
+  if (!target) {
+    return nullptr;
+  }
+  connection *ready_conn = nullptr;
+  connection *stopped_conn = nullptr;
+  int unreliability = 10000;
+  for (connection *c = target->first_conn; c != reinterpret_cast<connection *>(target); c = c->next) {
+    if (c == skipped_conn) {
+      continue;
+    }
+    const int ready = target->type->check_ready(c);
+    if (ready == cr_ok) {
+      if (!ready_conn || is_less_loaded(c, ready_conn)) {
+        ready_conn = c;
+      }
+    } else if (ready == cr_stopped && c->unreliability < unreliability) {
+      unreliability = c->unreliability;
+      stopped_conn = c;
+    }
+  }
+  return ready_conn ? ready_conn : stopped_conn;
+}
+
+void RpcConnectionsLoad::on_query_sent(connection *c, int64_t query_id) noexcept {
+  ++queries_sent;
+  if (c->rpc_queries_in_flight > 0) {
+    ++queries_sent_to_busy_connections;
+  }
+  queries_in_flight_.emplace(query_id, QueryInFlight{c, c->generation, precise_now});
+  ++c->rpc_queries_in_flight;
+  max_queries_in_flight = std::max(max_queries_in_flight, static_cast<uint64_t>(c->rpc_queries_in_flight));
+}
+
+double RpcConnectionsLoad::on_answer_received(connection *c, int64_t query_id) noexcept {
+  const auto queries = queries_in_flight_.equal_range(query_id);
+  const auto it = std::find_if(queries.first, queries.second, [c](const auto &query) { return query.second.conn == c; });
+  if (it == queries.second) {
+    return -1;
+  }
+  const QueryInFlight query = it->second;
+  queries_in_flight_.erase(it);
+  // the connection could be closed and reused by another one meanwhile
+  if (c->generation != query.conn_generation || c->rpc_queries_in_flight <= 0) {
+    return -1;
+  }
+  --c->rpc_queries_in_flight;
+  const double response_time = precise_now - query.sent_time;
+  double &avg_response_time = c->rpc_avg_response_time;
+  avg_response_time = avg_response_time > 0
+                      ? avg_response_time + RESPONSE_TIME_SMOOTHING * (response_time - avg_response_time)
+                      : response_time;
+  return response_time;
+}
+
+void RpcConnectionsLoad::on_script_finished() noexcept {
+  for (const auto &query : queries_in_flight_) {
+    connection *c = query.second.conn;
+    if (c->generation == query.second.conn_generation && c->rpc_queries_in_flight > 0) {
+      --c->rpc_queries_in_flight;
+    }
+  }
+  queries_in_flight_.clear();
+}
+
+void RpcQueriesHedging::on_query_sent(conn_target_t *target, connection *c, slot_id_t slot_id, const net_queries_data::rpc_send &query) noexcept {
+  tokens_ = std::min(tokens_ + budget_, MAX_TOKENS);
+  const auto latency = targets_latency_.find(target);
+  if (latency == targets_latency_.end() || latency->second.samples_count < MIN_LATENCY_SAMPLES
+      || latency->second.hedging_delay * 1000 >= query.timeout_ms) {
+    free_rpc_send_query(query);
+    return;
+  }
+
+  HedgedQuery &hedged_query = hedged_queries_[slot_id];
+  hedged_query.slot_id = slot_id;
+  hedged_query.target = target;
+  hedged_query.conn = c;
+  hedged_query.query = query;
+  set_timer_params(&hedged_query.timer, hedging_timer_wakeup, precise_now + latency->second.hedging_delay, "rpc_hedging");
+  insert_event_timer(&hedged_query.timer);
+}
+
+int RpcQueriesHedging::hedging_timer_wakeup(event_timer_t *timer) noexcept {
+  auto *hedged_query = container_of(timer, HedgedQuery, timer);
+  vk::singleton<RpcQueriesHedging>::get().send_hedged_copy(*hedged_query);
+  return 0;
+}
+
+void RpcQueriesHedging::send_hedged_copy(HedgedQuery &hedged_query) noexcept {
+  auto &rpc_connections_load = vk::singleton<RpcConnectionsLoad>::get();
+  connection *c = rpc_connections_load.choose_connection(hedged_query.target, hedged_query.conn);
+  if (tokens_ >= 1 && c != nullptr && hedged_query.target->type->check_ready(c) == cr_ok
+      && rpc_ids_factory.is_from_current_script_execution(hedged_query.slot_id)) {
+    tokens_ -= 1;
+    ++hedged_queries;
+    send_rpc_query_later(c, TL_RPC_INVOKE_REQ, hedged_query.slot_id, reinterpret_cast<int *>(hedged_query.query.request), hedged_query.query.request_size);
+    c->last_query_sent_time = precise_now;
+    rpc_connections_load.on_query_sent(c, hedged_query.slot_id);
+    hedged_query.hedged_conn = c;
+  }
+  release_request(hedged_query);
+  if (!hedged_query.hedged_conn) {
+    hedged_queries_.erase(hedged_query.slot_id);
+  }
+}
+
+bool RpcQueriesHedging::on_answer_received(connection *c, int64_t query_id, double response_time) noexcept {
+  if (response_time >= 0 && is_enabled()) {
+    add_latency_sample(c->target, response_time);
+  }
+  const auto it = hedged_queries_.find(static_cast<slot_id_t>(query_id));
+  if (it == hedged_queries_.end()) {
+    return true;
+  }
+  HedgedQuery &hedged_query = it->second;
+  if (hedged_query.answered) {
+    hedged_queries_.erase(it);
+    return false;
+  }
+  if (!hedged_query.hedged_conn) {
+    remove_event_timer(&hedged_query.timer);
+    release_request(hedged_query);
+    hedged_queries_.erase(it);
+    return true;
+  }
+  // the answer to the other copy is waited to be dropped
+  hedged_query.answered = true;
+  if (c == hedged_query.hedged_conn) {
+    ++hedged_queries_won;
+  }
+  return true;
+}
+
+void RpcQueriesHedging::on_script_finished() noexcept {
+  for (auto &hedged_query : hedged_queries_) {
+    remove_event_timer(&hedged_query.second.timer);
+    release_request(hedged_query.second);
+  }
+  hedged_queries_.clear();
+}
+
+void RpcQueriesHedging::add_latency_sample(conn_target_t *target, double response_time) noexcept {
+  TargetLatency &latency = targets_latency_[target];
+  latency.samples[latency.samples_count++ % LATENCY_SAMPLES] = static_cast<float>(response_time);
+  if (++latency.new_samples < LATENCY_RECALC_PERIOD || latency.samples_count < MIN_LATENCY_SAMPLES) {
+    return;
+  }
+  latency.new_samples = 0;
+  std::array<float, LATENCY_SAMPLES> samples = latency.samples;
+  const size_t size = std::min(latency.samples_count, LATENCY_SAMPLES);
+  const auto nth = std::min(static_cast<size_t>(std::floor(size * percentile_ / 100.0)), size - 1);
+  std::nth_element(samples.begin(), samples.begin() + nth, samples.begin() + size);
+  latency.hedging_delay = samples[nth];
+}
+
+void RpcQueriesHedging::release_request(HedgedQuery &hedged_query) noexcept {
+  if (hedged_query.query.request) {
+    free_rpc_send_query(hedged_query.query);
+    hedged_query.query.request = nullptr;
+  }
+}
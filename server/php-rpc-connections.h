@@ -0,0 +1,118 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2023 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+
+#include "common/mixin/not_copyable.h"
+#include "common/smart_ptrs/singleton.h"
+
+#include "net/net-connections.h"
+#include "server/php-queries.h"
+
+// The rpc queries of the running script are tracked per outbound connection, so the queries to a target with several connections
+// are spread over them: the ready connection with the fewest queries in flight is chosen, and the faster one among the equally loaded.
+class RpcConnectionsLoad : vk::not_copyable {
+public:
+  // if there are no ready connections, the most reliable stopped one is chosen as get_target_connection() does
+  connection *choose_connection(conn_target_t *target) noexcept;
+
+  // connection c is skipped, if it isn't null
+  connection *choose_connection(conn_target_t *target, const connection *skipped_conn) noexcept;
+
+  void on_query_sent(connection *c, int64_t query_id) noexcept;
+  // returns the response time of the query sent to this connection, or a negative value if it isn't tracked
+  double on_answer_received(connection *c, int64_t query_id) noexcept;
+  // the answers to the queries of the finished script aren't tracked anymore
+  void on_script_finished() noexcept;
+
+  uint64_t queries_sent{0};
+  // the queries sent to the connections, which already had some queries in flight
+  uint64_t queries_sent_to_busy_connections{0};
+  uint64_t max_queries_in_flight{0};
+
+private:
+  RpcConnectionsLoad() = default;
+
+  struct QueryInFlight {
+    connection *conn{nullptr};
+    int conn_generation{0};
+    double sent_time{0};
+  };
+  // a hedged query is in flight on two connections
+  std::unordered_multimap<int64_t, QueryInFlight> queries_in_flight_;
+
+  friend class vk::singleton<RpcConnectionsLoad>;
+};
+
+// The hedging is turned on by the --rpc-hedging-percentile option for the rpc connections created with $hedging = true only,
+// as the query may be executed twice: if an rpc query isn't answered in the given percentile of the target response times,
+// its copy is sent to another ready connection of the target, the first answer wins and the other one is dropped.
+// The hedged copies are limited by the budget: each sent query gives the budget ratio of a token, each hedged copy takes the whole token.
+class RpcQueriesHedging : vk::not_copyable {
+public:
+  void set_percentile(double percentile) noexcept {
+    percentile_ = percentile;
+  }
+
+  void set_budget(double budget) noexcept {
+    budget_ = budget;
+  }
+
+  bool is_enabled() const noexcept {
+    return percentile_ > 0;
+  }
+
+  // takes the ownership of the query request, it's freed when the query is answered, hedged or isn't hedged at all
+  void on_query_sent(conn_target_t *target, connection *c, slot_id_t slot_id, const net_queries_data::rpc_send &query) noexcept;
+  // returns false if the other copy of the hedged query has been already answered, so this answer should be dropped
+  bool on_answer_received(connection *c, int64_t query_id, double response_time) noexcept;
+  void on_script_finished() noexcept;
+
+  uint64_t hedged_queries{0};
+  // the queries, which hedged copies were answered first
+  uint64_t hedged_queries_won{0};
+
+private:
+  RpcQueriesHedging() = default;
+
+  static constexpr size_t LATENCY_SAMPLES = 256;
+  static constexpr size_t MIN_LATENCY_SAMPLES = 64;
+  static constexpr size_t LATENCY_RECALC_PERIOD = 32;
+  static constexpr double MAX_TOKENS = 10;
+
+  // the recent response times of the target, the hedging delay is their percentile
+  struct TargetLatency {
+    std::array<float, LATENCY_SAMPLES> samples{};
+    size_t samples_count{0};
+    size_t new_samples{0};
+    double hedging_delay{0};
+  };
+
+  struct HedgedQuery {
+    event_timer_t timer{};
+    slot_id_t slot_id{0};
+    conn_target_t *target{nullptr};
+    connection *conn{nullptr};
+    connection *hedged_conn{nullptr};
+    net_queries_data::rpc_send query{};
+    bool answered{false};
+  };
+
+  static int hedging_timer_wakeup(event_timer_t *timer) noexcept;
+  void send_hedged_copy(HedgedQuery &hedged_query) noexcept;
+  void add_latency_sample(conn_target_t *target, double response_time) noexcept;
+  void release_request(HedgedQuery &hedged_query) noexcept;
+
+  double percentile_{0};
+  double budget_{0.05};
+  double tokens_{0};
+  std::unordered_map<const conn_target_t *, TargetLatency> targets_latency_;
+  std::unordered_map<slot_id_t, HedgedQuery> hedged_queries_;
+
+  friend class vk::singleton<RpcQueriesHedging>;
+};
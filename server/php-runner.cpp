@@ -15,6 +15,7 @@
 #include <unistd.h>
 
 #include "common/fast-backtrace.h"
+#include "common/huge-pages.h"
 #include "common/kernel-version.h"
 #include "common/kprintf.h"
 #include "common/wrappers/memory-utils.h"
@@ -141,14 +142,15 @@ void PhpScriptStack::asan_stack_clear() const noexcept {
 PhpScript::PhpScript(size_t mem_size, double oom_handling_memory_ratio, size_t stack_size) noexcept
   : mem_size(mem_size)
   , oom_handling_memory_ratio(oom_handling_memory_ratio)
-  , run_mem(static_cast<char *>(mmap(nullptr, mem_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0)))
+  , run_mem(static_cast<char *>(mmap_private_huge_pages(mem_size, &run_mem_is_hugetlb)))
   , script_stack(stack_size) {
+  prefault_private_memory(run_mem, mem_size);
   // fprintf (stderr, "PHPScriptBase: constructor\n");
   // fprintf (stderr, "[%p -> %p] [%p -> %p]\n", run_stack, run_stack_end, run_mem, run_mem + mem_size);
 }
 
 PhpScript::~PhpScript() noexcept {
-  munmap(run_mem, mem_size);
+  munmap_huge_pages(run_mem, mem_size);
 }
 
 void PhpScript::init(script_t *script, php_query_data *data_to_set) noexcept {
@@ -350,10 +352,14 @@ void PhpScript::clear() noexcept {
   run_main->clear();
   free_runtime_environment();
   state = run_state_t::empty;
-  if (use_madvise_dontneed) {
-    if (dl::get_script_memory_stats().real_memory_used > memory_used_to_recreate_script) {
+  // the hugetlb pages are reserved for the process anyway and can't be released with MADV_FREE
+  if (use_madvise_dontneed && !run_mem_is_hugetlb) {
+    // the huge pages mustn't be split, so the kept part is rounded up to them
+    const size_t granularity = huge_pages_granularity();
+    const size_t memory_to_keep = (static_cast<size_t>(memory_used_to_recreate_script) + granularity - 1) / granularity * granularity;
+    if (dl::get_script_memory_stats().real_memory_used > memory_to_keep && memory_to_keep < mem_size) {
       const int advice = madvise_madv_free_supported() ? MADV_FREE : MADV_DONTNEED;
-      our_madvise(&run_mem[memory_used_to_recreate_script], mem_size - memory_used_to_recreate_script, advice);
+      our_madvise(&run_mem[memory_to_keep], mem_size - memory_to_keep, advice);
     }
   }
   script_stack.asan_stack_clear();
@@ -104,6 +104,7 @@ public:
   php_query_base_t *query{nullptr};
   const size_t mem_size{0};
   double oom_handling_memory_ratio{0};
+  bool run_mem_is_hugetlb{false};
   char *run_mem{nullptr};
   PhpScriptStack script_stack;
 
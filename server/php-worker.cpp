@@ -20,6 +20,7 @@
 #include "server/php-engine.h"
 #include "server/php-lease.h"
 #include "server/php-mc-connections.h"
+#include "server/php-rpc-connections.h"
 #include "server/php-sql-connections.h"
 #include "server/php-worker.h"
 #include "server/server-stats.h"
@@ -145,9 +146,7 @@ void PhpWorker::state_init_script() noexcept {
 
   script_t *script = get_script();
   dl_assert(script != nullptr, "failed to get script");
-  if (php_script == nullptr) {
-    php_script = new PhpScript(max_memory, oom_handling_memory_ratio, 8 << 20);
-  }
+  create_php_script_if_needed();
   dl::init_critical_section();
   php_script->init(script, data);
   php_script->set_timeout(timeout);
@@ -159,18 +158,27 @@ void php_worker_run_rpc_send_query(int32_t request_id, const net_queries_data::r
   slot_id_t slot_id = request_id;
   if (connection_id < 0 || connection_id >= MAX_TARGETS) {
     on_net_event(create_rpc_error_event(slot_id, TL_ERROR_INVALID_CONNECTION_ID, "Invalid connection_id (1)", nullptr));
+    free_rpc_send_query(query);
     return;
   }
   conn_target_t *target = &Targets[connection_id];
-  connection *conn = get_target_connection(target, 0);
+  auto &rpc_connections_load = vk::singleton<RpcConnectionsLoad>::get();
+  connection *conn = rpc_connections_load.choose_connection(target);
 
   if (conn != nullptr) {
-    send_rpc_query(conn, TL_RPC_INVOKE_REQ, slot_id, reinterpret_cast<int *>(query.request), query.request_size);
+    send_rpc_query_later(conn, TL_RPC_INVOKE_REQ, slot_id, reinterpret_cast<int *>(query.request), query.request_size);
     conn->last_query_sent_time = precise_now;
+    rpc_connections_load.on_query_sent(conn, slot_id);
+    auto &rpc_queries_hedging = vk::singleton<RpcQueriesHedging>::get();
+    if (query.hedging && rpc_queries_hedging.is_enabled()) {
+      rpc_queries_hedging.on_query_sent(target, conn, slot_id, query);
+      return;
+    }
   } else {
     int new_conn_cnt = create_new_connections(target);
     if (new_conn_cnt <= 0 && get_target_connection(target, 1) == nullptr) {
       on_net_event(create_rpc_error_event(slot_id, TL_ERROR_NO_CONNECTIONS_IN_RPC_CLIENT, "Failed to establish connection [probably reconnect timeout is not expired]", nullptr));
+      free_rpc_send_query(query);
       return;
     }
 
@@ -178,6 +186,7 @@ void php_worker_run_rpc_send_query(int32_t request_id, const net_queries_data::r
     double timeout = fix_timeout(query.timeout_ms * 0.001) + precise_now;
     create_delayed_send_query(target, command, timeout);
   }
+  free_rpc_send_query(query);
 }
 
 void php_worker_run_net_queue(PhpWorker *worker __attribute__((unused))) {
@@ -187,7 +196,6 @@ void php_worker_run_net_queue(PhpWorker *worker __attribute__((unused))) {
     std::visit(overloaded{
                  [&](const net_queries_data::rpc_send &data) {
                    php_worker_run_rpc_send_query(query->slot_id, data);
-                   free_rpc_send_query(data);
                  },
                  [&](database_drivers::Request *data) {
                    php_assert(query->slot_id == data->request_id);
@@ -408,6 +416,8 @@ void PhpWorker::state_free_script() noexcept {
   }
 
   php_queries_finish();
+  vk::singleton<RpcConnectionsLoad>::get().on_script_finished();
+  vk::singleton<RpcQueriesHedging>::get().on_script_finished();
   php_script->disable_timeout();
   php_script->clear();
 
@@ -14,10 +14,13 @@
 #include "net/net-events.h"
 
 #include "runtime/curl.h"
+#include "runtime/regexp.h"
 
 #include "server/workers-control.h"
 
+#include "server/database-drivers/connection-pool.h"
 #include "server/json-logger.h"
+#include "server/php-rpc-connections.h"
 #include "server/server-stats.h"
 #include "server/statshouse/statshouse-client.h"
 #include "server/statshouse/worker-stats-buffer.h"
@@ -90,6 +93,49 @@ struct HeapStat : WithStatType<uint64_t> {
   };
 };
 
+struct DbConnectionPoolStat : WithStatType<uint64_t> {
+  enum class Key {
+    idle_connections = 0,
+    hits,
+    misses,
+    health_check_failures,
+    session_reset_failures,
+    evictions,
+    types_count
+  };
+};
+
+struct CurlConnectionsStat : WithStatType<uint64_t> {
+  enum class Key {
+    transfers = 0,
+    new_connections,
+    reused_connections,
+    types_count
+  };
+};
+
+struct RegexpWorkerCacheStat : WithStatType<uint64_t> {
+  enum class Key {
+    size = 0,
+    memory_usage,
+    hits,
+    misses,
+    evictions,
+    types_count
+  };
+};
+
+struct RpcConnectionsStat : WithStatType<uint64_t> {
+  enum class Key {
+    queries_sent = 0,
+    queries_sent_to_busy_connections,
+    max_queries_in_flight,
+    hedged_queries,
+    hedged_queries_won,
+    types_count
+  };
+};
+
 struct VMStat : WithStatType<uint32_t> {
   enum class Key {
     vm_peak_kb,
@@ -97,6 +143,8 @@ struct VMStat : WithStatType<uint32_t> {
     rss_peak_kb,
     rss_kb,
     shm_kb,
+    page_tables_kb,
+    hugetlb_kb,
     types_count
   };
 };
@@ -186,6 +234,8 @@ EnumTable<VMStat> get_virtual_memory_stat() noexcept {
   result[VMStat::Key::rss_peak_kb] = mem_stats.rss_peak;
   result[VMStat::Key::rss_kb] = mem_stats.rss;
   result[VMStat::Key::shm_kb] = mem_stats.rss_shmem + mem_stats.rss_file;
+  result[VMStat::Key::page_tables_kb] = mem_stats.page_tables;
+  result[VMStat::Key::hugetlb_kb] = mem_stats.hugetlb;
   return result;
 }
 
@@ -205,6 +255,50 @@ EnumTable<HeapStat> get_heap_stat() noexcept {
   return result;
 }
 
+EnumTable<DbConnectionPoolStat> get_db_connection_pool_stat() noexcept {
+  EnumTable<DbConnectionPoolStat> result;
+  const auto &pool_stats = vk::singleton<database_drivers::ConnectionPool>::get().get_stats();
+  result[DbConnectionPoolStat::Key::idle_connections] = pool_stats.idle_connections;
+  result[DbConnectionPoolStat::Key::hits] = pool_stats.hits;
+  result[DbConnectionPoolStat::Key::misses] = pool_stats.misses;
+  result[DbConnectionPoolStat::Key::health_check_failures] = pool_stats.health_check_failures;
+  result[DbConnectionPoolStat::Key::session_reset_failures] = pool_stats.session_reset_failures;
+  result[DbConnectionPoolStat::Key::evictions] = pool_stats.evictions;
+  return result;
+}
+
+EnumTable<CurlConnectionsStat> get_curl_connections_stat() noexcept {
+  EnumTable<CurlConnectionsStat> result;
+  const auto &curl_stats = vk::singleton<CurlConnectionsStats>::get();
+  result[CurlConnectionsStat::Key::transfers] = curl_stats.transfers;
+  result[CurlConnectionsStat::Key::new_connections] = curl_stats.new_connections;
+  result[CurlConnectionsStat::Key::reused_connections] = curl_stats.reused_connections;
+  return result;
+}
+
+EnumTable<RegexpWorkerCacheStat> get_regexp_worker_cache_stat() noexcept {
+  EnumTable<RegexpWorkerCacheStat> result;
+  const auto regexp_stats = get_regexp_worker_cache_stats();
+  result[RegexpWorkerCacheStat::Key::size] = regexp_stats.size;
+  result[RegexpWorkerCacheStat::Key::memory_usage] = regexp_stats.memory_usage;
+  result[RegexpWorkerCacheStat::Key::hits] = regexp_stats.hits;
+  result[RegexpWorkerCacheStat::Key::misses] = regexp_stats.misses;
+  result[RegexpWorkerCacheStat::Key::evictions] = regexp_stats.evictions;
+  return result;
+}
+
+EnumTable<RpcConnectionsStat> get_rpc_connections_stat() noexcept {
+  EnumTable<RpcConnectionsStat> result;
+  const auto &rpc_connections_load = vk::singleton<RpcConnectionsLoad>::get();
+  result[RpcConnectionsStat::Key::queries_sent] = rpc_connections_load.queries_sent;
+  result[RpcConnectionsStat::Key::queries_sent_to_busy_connections] = rpc_connections_load.queries_sent_to_busy_connections;
+  result[RpcConnectionsStat::Key::max_queries_in_flight] = rpc_connections_load.max_queries_in_flight;
+  const auto &rpc_queries_hedging = vk::singleton<RpcQueriesHedging>::get();
+  result[RpcConnectionsStat::Key::hedged_queries] = rpc_queries_hedging.hedged_queries;
+  result[RpcConnectionsStat::Key::hedged_queries_won] = rpc_queries_hedging.hedged_queries_won;
+  return result;
+}
+
 EnumTable<IdleStat> get_idle_stat() noexcept {
   EnumTable<IdleStat> result;
   result[IdleStat::Key::tot_idle_time] = epoll_total_idle_time();
@@ -462,6 +556,10 @@ public:
 struct WorkerProcessStats : private vk::not_copyable {
   WorkerStatsBundle<MallocStat> malloc_stats{};
   WorkerStatsBundle<HeapStat> heap_stats{};
+  WorkerStatsBundle<DbConnectionPoolStat> db_connection_pool_stats{};
+  WorkerStatsBundle<CurlConnectionsStat> curl_connections_stats{};
+  WorkerStatsBundle<RegexpWorkerCacheStat> regexp_worker_cache_stats{};
+  WorkerStatsBundle<RpcConnectionsStat> rpc_connections_stats{};
   WorkerStatsBundle<VMStat> vm_stats{};
   WorkerStatsBundle<MiscStat> misc_stats{};
   WorkerStatsBundle<QueriesStat> query_stats{};
@@ -470,6 +568,10 @@ struct WorkerProcessStats : private vk::not_copyable {
   void update_worker_stats(uint16_t worker_index) noexcept {
     malloc_stats.set_worker_stats(get_malloc_stat(), worker_index);
     heap_stats.set_worker_stats(get_heap_stat(), worker_index);
+    db_connection_pool_stats.set_worker_stats(get_db_connection_pool_stat(), worker_index);
+    curl_connections_stats.set_worker_stats(get_curl_connections_stat(), worker_index);
+    regexp_worker_cache_stats.set_worker_stats(get_regexp_worker_cache_stat(), worker_index);
+    rpc_connections_stats.set_worker_stats(get_rpc_connections_stat(), worker_index);
     vm_stats.set_worker_stats(get_virtual_memory_stat(), worker_index);
     idle_stats.set_worker_stats(get_idle_stat(), worker_index);
     misc_stats.inc_stat(MiscStat::Key::worker_activity_counter, worker_index);
@@ -532,6 +634,10 @@ struct WorkerAggregatedStats {
               const WorkerProcessStats &stats, uint16_t first_id, uint16_t last_id) noexcept {
     script_samples.recalc(script_shared_samples, now_tp);
     heap_samples.recalc(stats.heap_stats, first_id, last_id);
+    db_connection_pool_samples.recalc(stats.db_connection_pool_stats, first_id, last_id);
+    curl_connections_samples.recalc(stats.curl_connections_stats, first_id, last_id);
+    regexp_worker_cache_samples.recalc(stats.regexp_worker_cache_stats, first_id, last_id);
+    rpc_connections_samples.recalc(stats.rpc_connections_stats, first_id, last_id);
     malloc_samples.recalc(stats.malloc_stats, first_id, last_id);
     vm_samples.recalc(stats.vm_stats, first_id, last_id);
     idle_samples.recalc(stats.idle_stats, first_id, last_id);
@@ -540,6 +646,10 @@ struct WorkerAggregatedStats {
   AggregatedSamplesBundle<ScriptSamples> script_samples;
   WorkerSamplesBundle<MallocStat> malloc_samples;
   WorkerSamplesBundle<HeapStat> heap_samples;
+  WorkerSamplesBundle<DbConnectionPoolStat> db_connection_pool_samples;
+  WorkerSamplesBundle<CurlConnectionsStat> curl_connections_samples;
+  WorkerSamplesBundle<RegexpWorkerCacheStat> regexp_worker_cache_samples;
+  WorkerSamplesBundle<RpcConnectionsStat> rpc_connections_samples;
   WorkerSamplesBundle<VMStat> vm_samples;
   WorkerSamplesBundle<IdleStat> idle_samples;
 };
@@ -769,8 +879,38 @@ void write_to(stats_t *stats, const char *prefix, const WorkerAggregatedStats &a
   write_to(stats, prefix, ".memory.rss_bytes", agg.vm_samples[VMStat::Key::rss_kb], kb2bytes);
   write_to(stats, prefix, ".memory.vms_bytes", agg.vm_samples[VMStat::Key::vm_kb], kb2bytes);
   write_to(stats, prefix, ".memory.shm_bytes", agg.vm_samples[VMStat::Key::shm_kb], kb2bytes);
+  write_to(stats, prefix, ".memory.page_tables_bytes", agg.vm_samples[VMStat::Key::page_tables_kb], kb2bytes);
+  write_to(stats, prefix, ".memory.hugetlb_bytes", agg.vm_samples[VMStat::Key::hugetlb_kb], kb2bytes);
 
   write_to(stats, prefix, ".cpu.recent_idle", agg.idle_samples[IdleStat::Key::recent_idle_percent]);
+
+  const auto &db_pool = agg.db_connection_pool_samples;
+  stats->add_gauge_stat(db_pool[DbConnectionPoolStat::Key::idle_connections].percentiles.sum, prefix, ".db_connection_pool.idle_connections");
+  stats->add_gauge_stat(db_pool[DbConnectionPoolStat::Key::hits].percentiles.sum, prefix, ".db_connection_pool.hits");
+  stats->add_gauge_stat(db_pool[DbConnectionPoolStat::Key::misses].percentiles.sum, prefix, ".db_connection_pool.misses");
+  stats->add_gauge_stat(db_pool[DbConnectionPoolStat::Key::health_check_failures].percentiles.sum, prefix, ".db_connection_pool.health_check_failures");
+  stats->add_gauge_stat(db_pool[DbConnectionPoolStat::Key::session_reset_failures].percentiles.sum, prefix, ".db_connection_pool.session_reset_failures");
+  stats->add_gauge_stat(db_pool[DbConnectionPoolStat::Key::evictions].percentiles.sum, prefix, ".db_connection_pool.evictions");
+
+  const auto &curl_connections = agg.curl_connections_samples;
+  stats->add_gauge_stat(curl_connections[CurlConnectionsStat::Key::transfers].percentiles.sum, prefix, ".curl.transfers");
+  stats->add_gauge_stat(curl_connections[CurlConnectionsStat::Key::new_connections].percentiles.sum, prefix, ".curl.new_connections");
+  stats->add_gauge_stat(curl_connections[CurlConnectionsStat::Key::reused_connections].percentiles.sum, prefix, ".curl.reused_connections");
+
+  const auto &regexp_worker_cache = agg.regexp_worker_cache_samples;
+  stats->add_gauge_stat(regexp_worker_cache[RegexpWorkerCacheStat::Key::size].percentiles.sum, prefix, ".regexp_worker_cache.size");
+  stats->add_gauge_stat(regexp_worker_cache[RegexpWorkerCacheStat::Key::memory_usage].percentiles.sum, prefix, ".regexp_worker_cache.memory_usage");
+  stats->add_gauge_stat(regexp_worker_cache[RegexpWorkerCacheStat::Key::hits].percentiles.sum, prefix, ".regexp_worker_cache.hits");
+  stats->add_gauge_stat(regexp_worker_cache[RegexpWorkerCacheStat::Key::misses].percentiles.sum, prefix, ".regexp_worker_cache.misses");
+  stats->add_gauge_stat(regexp_worker_cache[RegexpWorkerCacheStat::Key::evictions].percentiles.sum, prefix, ".regexp_worker_cache.evictions");
+
+  const auto &rpc_connections = agg.rpc_connections_samples;
+  stats->add_gauge_stat(rpc_connections[RpcConnectionsStat::Key::queries_sent].percentiles.sum, prefix, ".rpc.queries_sent");
+  stats->add_gauge_stat(rpc_connections[RpcConnectionsStat::Key::queries_sent_to_busy_connections].percentiles.sum, prefix,
+                        ".rpc.queries_sent_to_busy_connections");
+  stats->add_gauge_stat(rpc_connections[RpcConnectionsStat::Key::max_queries_in_flight].percentiles.max, prefix, ".rpc.max_queries_in_flight");
+  stats->add_gauge_stat(rpc_connections[RpcConnectionsStat::Key::hedged_queries].percentiles.sum, prefix, ".rpc.hedged_queries");
+  stats->add_gauge_stat(rpc_connections[RpcConnectionsStat::Key::hedged_queries_won].percentiles.sum, prefix, ".rpc.hedged_queries_won");
 }
 
 void write_to(stats_t *stats, const char *prefix, const JobWorkerAggregatedStats &job_agg) noexcept {
@@ -791,6 +931,8 @@ void write_to(stats_t *stats, const char *prefix, const MasterProcessStats &mast
   stats->add_gauge_stat(kb2bytes(master_process.vm_stats[VMStat::Key::rss_kb]), prefix, ".memory.rss_bytes");
   stats->add_gauge_stat(kb2bytes(master_process.vm_stats[VMStat::Key::vm_kb]), prefix, ".memory.vms_bytes");
   stats->add_gauge_stat(kb2bytes(master_process.vm_stats[VMStat::Key::shm_kb]), prefix, ".memory.shm_bytes");
+  stats->add_gauge_stat(kb2bytes(master_process.vm_stats[VMStat::Key::page_tables_kb]), prefix, ".memory.page_tables_bytes");
+  stats->add_gauge_stat(kb2bytes(master_process.vm_stats[VMStat::Key::hugetlb_kb]), prefix, ".memory.hugetlb_bytes");
 }
 
 template<class S>
@@ -813,6 +955,8 @@ void write_server_vm_to(stats_t *stats, const char *prefix, const EnumTable<VMSt
 
   const uint64_t rss_no_shm = get_sum(general_vm, job_vm, master_vm, VMStat::Key::rss_kb) - get_sum(general_vm, job_vm, master_vm, VMStat::Key::shm_kb);
   stats->add_gauge_stat(kb2bytes(rss_no_shm), prefix, ".memory.rss_no_shm_total_bytes");
+  // the shared regions are mapped by every process, so their page tables are multiplied by the processes count
+  stats->add_gauge_stat(kb2bytes(get_sum(general_vm, job_vm, master_vm, VMStat::Key::page_tables_kb)), prefix, ".memory.page_tables_total_bytes");
 }
 
 } // namespace
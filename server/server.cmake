@@ -14,6 +14,7 @@ prepend(KPHP_SERVER_SOURCES ${BASE_DIR}/server/
         php-lease.cpp
         php-master.cpp
         php-master-restart.cpp
+        php-master-zygote.cpp
         php-master-tl-handlers.cpp
         php-mc-connections.cpp
         php-queries.cpp
@@ -21,6 +22,7 @@ prepend(KPHP_SERVER_SOURCES ${BASE_DIR}/server/
         php-query-data.cpp
         php-runner.cpp
         php-init-scripts.cpp
+        php-rpc-connections.cpp
         php-sql-connections.cpp
         php-worker.cpp
         server-config.cpp
@@ -35,6 +37,7 @@ prepend(KPHP_SERVER_SOURCES ${BASE_DIR}/server/
         statshouse/worker-stats-buffer.cpp)
 
 prepend(KPHP_JOB_WORKERS_SOURCES ${BASE_DIR}/server/job-workers/
+        job-messages-queue.cpp
         job-stats.cpp
         job-worker-server.cpp
         job-worker-client.cpp
@@ -44,6 +47,7 @@ prepend(KPHP_JOB_WORKERS_SOURCES ${BASE_DIR}/server/job-workers/
 
 prepend(KPHP_DATABASE_DRIVERS_SOURCES ${BASE_DIR}/server/database-drivers/
         adaptor.cpp
+        connection-pool.cpp
         connector.cpp)
 
 if (PDO_DRIVER_MYSQL)
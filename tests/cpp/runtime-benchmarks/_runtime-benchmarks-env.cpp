@@ -0,0 +1,38 @@
+#include <benchmark/benchmark.h>
+#include <sys/mman.h>
+
+#include "runtime/interface.h"
+#include "server/php-engine-vars.h"
+#include "server/workers-control.h"
+
+namespace {
+
+// benchmarks run in a single "request", so the script memory must fit all of them
+constexpr size_t SCRIPT_MEMORY_SIZE = 512 * 1024 * 1024;
+
+} // namespace
+
+int main(int argc, char **argv) {
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+
+  pid = 0;
+  logname_id = 0;
+  vk::singleton<WorkersControl>::get().set_total_workers_count(1);
+
+  auto *script_memory = static_cast<char *>(mmap(nullptr, SCRIPT_MEMORY_SIZE, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0));
+  global_init_runtime_libs();
+  global_init_script_allocator();
+  init_runtime_environment(nullptr, script_memory, SCRIPT_MEMORY_SIZE);
+  php_disable_warnings = true;
+  php_warning_level = 0;
+
+  benchmark::RunSpecifiedBenchmarks();
+
+  free_runtime_environment();
+  benchmark::Shutdown();
+  munmap(script_memory, SCRIPT_MEMORY_SIZE);
+  return 0;
+}
@@ -0,0 +1,142 @@
+#include <benchmark/benchmark.h>
+
+#include "runtime/array_functions.h"
+#include "runtime/kphp_core.h"
+
+static void BM_array_int_keys_insert(benchmark::State &state) {
+  const int64_t size = state.range(0);
+  for (auto _ : state) {
+    array<int64_t> arr;
+    for (int64_t i = 0; i < size; ++i) {
+      arr.set_value(i * 7, i);
+    }
+    benchmark::DoNotOptimize(arr);
+  }
+  state.SetItemsProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_array_int_keys_insert)->Arg(16)->Arg(1024)->Arg(65536);
+
+static void BM_array_vector_push_back(benchmark::State &state) {
+  const int64_t size = state.range(0);
+  for (auto _ : state) {
+    array<int64_t> arr;
+    for (int64_t i = 0; i < size; ++i) {
+      arr.push_back(i);
+    }
+    benchmark::DoNotOptimize(arr);
+  }
+  state.SetItemsProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_array_vector_push_back)->Arg(16)->Arg(1024)->Arg(65536);
+
+static void BM_array_string_keys_insert(benchmark::State &state) {
+  const int64_t size = state.range(0);
+  array<string> keys;
+  for (int64_t i = 0; i < size; ++i) {
+    keys.push_back(string{"key_"}.append(i));
+  }
+  for (auto _ : state) {
+    array<int64_t> arr;
+    for (const auto &key : keys) {
+      arr.set_value(key.get_value(), key.get_key().to_int());
+    }
+    benchmark::DoNotOptimize(arr);
+  }
+  state.SetItemsProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_array_string_keys_insert)->Arg(16)->Arg(1024)->Arg(65536);
+
+static void BM_array_string_keys_lookup(benchmark::State &state) {
+  const int64_t size = state.range(0);
+  array<string> keys;
+  array<int64_t> arr;
+  for (int64_t i = 0; i < size; ++i) {
+    keys.push_back(string{"key_"}.append(i));
+    arr.set_value(keys.get_value(i), i);
+  }
+  for (auto _ : state) {
+    int64_t sum = 0;
+    for (const auto &key : keys) {
+      sum += *arr.find_value(key.get_value());
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_array_string_keys_lookup)->Arg(16)->Arg(1024)->Arg(65536);
+
+// the keys are shared with the array, like the confdata or instance cache keys, and long, like the config ones
+static void BM_array_long_string_keys_lookup(benchmark::State &state) {
+  const int64_t size = state.range(0);
+  const string prefix{"some.rather.long.config.key.prefix.of.the.service.settings."};
+  array<string> keys;
+  array<int64_t> arr;
+  for (int64_t i = 0; i < size; ++i) {
+    keys.push_back(string{prefix}.append(i));
+    arr.set_value(keys.get_value(i), i);
+  }
+  for (auto _ : state) {
+    int64_t sum = 0;
+    for (const auto &key : keys) {
+      sum += *arr.find_value(key.get_value());
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_array_long_string_keys_lookup)->Arg(16)->Arg(1024)->Arg(65536);
+
+static void BM_array_int_keys_lookup(benchmark::State &state) {
+  const int64_t size = state.range(0);
+  array<int64_t> arr;
+  for (int64_t i = 0; i < size; ++i) {
+    arr.set_value(i * 7, i);
+  }
+  for (auto _ : state) {
+    int64_t sum = 0;
+    for (int64_t i = 0; i < size; ++i) {
+      sum += *arr.find_value(i * 7);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_array_int_keys_lookup)->Arg(16)->Arg(1024)->Arg(65536);
+
+static void BM_array_map_iterate(benchmark::State &state) {
+  const int64_t size = state.range(0);
+  array<mixed> arr;
+  for (int64_t i = 0; i < size; ++i) {
+    arr.set_value(string{"key_"}.append(i), i);
+  }
+  for (auto _ : state) {
+    int64_t sum = 0;
+    for (const auto &it : arr) {
+      sum += it.get_value().as_int();
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_array_map_iterate)->Arg(16)->Arg(1024)->Arg(65536);
+
+static void BM_array_sort_int64(benchmark::State &state) {
+  const int64_t size = state.range(0);
+  array<int64_t> source;
+  uint64_t x = 88172645463325252ULL;
+  for (int64_t i = 0; i < size; ++i) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    source.push_back(static_cast<int64_t>(x));
+  }
+  for (auto _ : state) {
+    state.PauseTiming();
+    array<int64_t> arr = source;
+    state.ResumeTiming();
+    f$sort(arr);
+    benchmark::DoNotOptimize(arr);
+  }
+  state.SetItemsProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_array_sort_int64)->Arg(1024)->Arg(65536);
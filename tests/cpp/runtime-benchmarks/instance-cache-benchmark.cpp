@@ -0,0 +1,96 @@
+#include <benchmark/benchmark.h>
+
+#include "runtime/instance-cache.h"
+#include "runtime/kphp_core.h"
+#include "runtime/refcountable_php_classes.h"
+
+namespace {
+
+// mirrors the code generated for a plain php class
+struct C$BenchmarkCachedItem : public refcountable_php_classes<C$BenchmarkCachedItem> {
+  int64_t $id{0};
+  string $name;
+  array<mixed> $payload;
+
+  const char *get_class() const noexcept {
+    return "BenchmarkCachedItem";
+  }
+
+  int get_hash() const noexcept {
+    return 0;
+  }
+
+  template<class Visitor>
+  void generic_accept(Visitor &&visitor) noexcept {
+    visitor("id", $id);
+    visitor("name", $name);
+    visitor("payload", $payload);
+  }
+
+  void accept(InstanceReferencesCountingVisitor &visitor) noexcept {
+    generic_accept(visitor);
+  }
+
+  void accept(InstanceDeepCopyVisitor &visitor) noexcept {
+    generic_accept(visitor);
+  }
+
+  void accept(InstanceDeepDestroyVisitor &visitor) noexcept {
+    generic_accept(visitor);
+  }
+};
+
+class_instance<C$BenchmarkCachedItem> make_item(int64_t id, int64_t payload_size) {
+  class_instance<C$BenchmarkCachedItem> item;
+  item.alloc();
+  item->$id = id;
+  item->$name = string{"cached item "}.append(id);
+  for (int64_t i = 0; i < payload_size; ++i) {
+    item->$payload.set_value(string{"field_"}.append(i), string{"value "}.append(i * id));
+  }
+  return item;
+}
+
+array<string> make_keys(int64_t count) {
+  array<string> keys;
+  for (int64_t i = 0; i < count; ++i) {
+    keys.push_back(string{"benchmark_key_"}.append(i));
+  }
+  return keys;
+}
+
+} // namespace
+
+static void BM_instance_cache_store(benchmark::State &state) {
+  const array<string> keys = make_keys(1024);
+  const auto item = make_item(1, state.range(0));
+  int64_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(f$instance_cache_store(keys.get_value(i++ % keys.count()), item));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_instance_cache_store)->Arg(1)->Arg(100);
+
+static void BM_instance_cache_fetch(benchmark::State &state) {
+  const array<string> keys = make_keys(1024);
+  for (const auto &key : keys) {
+    f$instance_cache_store(key.get_value(), make_item(key.get_key().to_int(), state.range(0)));
+  }
+  const string class_name{"BenchmarkCachedItem"};
+  int64_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(f$instance_cache_fetch<class_instance<C$BenchmarkCachedItem>>(class_name, keys.get_value(i++ % keys.count())));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_instance_cache_fetch)->Arg(1)->Arg(100);
+
+static void BM_instance_cache_fetch_miss(benchmark::State &state) {
+  const string class_name{"BenchmarkCachedItem"};
+  const string key{"benchmark_missing_key"};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(f$instance_cache_fetch<class_instance<C$BenchmarkCachedItem>>(class_name, key));
+  }
+}
+BENCHMARK(BM_instance_cache_fetch_miss);
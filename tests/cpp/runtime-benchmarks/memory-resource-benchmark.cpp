@@ -0,0 +1,90 @@
+#include <array>
+#include <benchmark/benchmark.h>
+#include <vector>
+
+#include "runtime/memory_resource/unsynchronized_pool_resource.h"
+
+namespace {
+
+constexpr size_t MEMORY_SIZE = 64 * 1024 * 1024;
+
+// the second argument of the benchmarks enables the slabs
+class PoolResourceFixture : public benchmark::Fixture {
+public:
+  void SetUp(const benchmark::State &state) final {
+    memory_.resize(MEMORY_SIZE);
+    resource_.init(memory_.data(), memory_.size(), 0, state.range(1) != 0);
+  }
+
+  void TearDown(const benchmark::State &) final {
+    resource_.hard_reset();
+  }
+
+protected:
+  memory_resource::unsynchronized_pool_resource resource_;
+
+private:
+  std::vector<char> memory_;
+};
+
+} // namespace
+
+// allocate and immediately free the same size, the best case of the free lists
+BENCHMARK_DEFINE_F(PoolResourceFixture, BM_alloc_free_same_size)(benchmark::State &state) {
+  const auto size = static_cast<size_t>(state.range(0));
+  for (auto _ : state) {
+    void *mem = resource_.allocate(size);
+    benchmark::DoNotOptimize(mem);
+    resource_.deallocate(mem, size);
+  }
+}
+BENCHMARK_REGISTER_F(PoolResourceFixture, BM_alloc_free_same_size)
+  ->ArgsProduct({{16, 128, 4096, 64 * 1024}, {0, 1}});
+
+// allocate a batch of different sizes and free it in the reverse order
+BENCHMARK_DEFINE_F(PoolResourceFixture, BM_alloc_free_batch_lifo)(benchmark::State &state) {
+  constexpr std::array<size_t, 8> sizes{8, 24, 40, 64, 100, 256, 1000, 4096};
+  std::vector<void *> pieces(static_cast<size_t>(state.range(0)));
+  for (auto _ : state) {
+    for (size_t i = 0; i < pieces.size(); ++i) {
+      pieces[i] = resource_.allocate(sizes[i % sizes.size()]);
+    }
+    for (size_t i = pieces.size(); i-- > 0;) {
+      resource_.deallocate(pieces[i], sizes[i % sizes.size()]);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_REGISTER_F(PoolResourceFixture, BM_alloc_free_batch_lifo)->ArgsProduct({{1024, 16 * 1024}, {0, 1}});
+
+// free every other piece first, so the memory gets fragmented
+BENCHMARK_DEFINE_F(PoolResourceFixture, BM_alloc_free_interleaved)(benchmark::State &state) {
+  constexpr std::array<size_t, 4> sizes{32, 96, 512, 2048};
+  std::vector<void *> pieces(static_cast<size_t>(state.range(0)));
+  for (auto _ : state) {
+    for (size_t i = 0; i < pieces.size(); ++i) {
+      pieces[i] = resource_.allocate(sizes[i % sizes.size()]);
+    }
+    for (size_t i = 0; i < pieces.size(); i += 2) {
+      resource_.deallocate(pieces[i], sizes[i % sizes.size()]);
+    }
+    for (size_t i = 1; i < pieces.size(); i += 2) {
+      resource_.deallocate(pieces[i], sizes[i % sizes.size()]);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_REGISTER_F(PoolResourceFixture, BM_alloc_free_interleaved)->ArgsProduct({{1024, 16 * 1024}, {0, 1}});
+
+BENCHMARK_DEFINE_F(PoolResourceFixture, BM_reallocate_growing)(benchmark::State &state) {
+  for (auto _ : state) {
+    size_t size = 16;
+    void *mem = resource_.allocate(size);
+    while (size < static_cast<size_t>(state.range(0))) {
+      mem = resource_.reallocate(mem, size * 2, size);
+      size *= 2;
+    }
+    resource_.deallocate(mem, size);
+  }
+}
+BENCHMARK_REGISTER_F(PoolResourceFixture, BM_reallocate_growing)->ArgsProduct({{64 * 1024, 4 * 1024 * 1024}, {0, 1}});
@@ -0,0 +1,50 @@
+#include <benchmark/benchmark.h>
+
+#include "runtime/kphp_core.h"
+#include "runtime/regexp.h"
+
+namespace {
+
+const string &get_subject() {
+  static const string subject{"GET /api/v1/users/1234567/friends?offset=100&count=50 HTTP/1.1 user-agent: benchmark/1.0"};
+  return subject;
+}
+
+} // namespace
+
+// the regexp object is created once, as the compiler does for constant patterns
+static void BM_preg_match_compiled(benchmark::State &state) {
+  const regexp re{string{"~/users/(\\d+)/(\\w+)\\?~"}};
+  mixed matches;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(f$preg_match(re, get_subject(), matches));
+  }
+}
+BENCHMARK(BM_preg_match_compiled);
+
+// the pattern is a runtime string, so it goes through the regexp cache on every call
+static void BM_preg_match_dynamic_pattern(benchmark::State &state) {
+  const string pattern{"~offset=(\\d+)&count=(\\d+)~"};
+  mixed matches;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(f$preg_match(pattern, get_subject(), matches));
+  }
+}
+BENCHMARK(BM_preg_match_dynamic_pattern);
+
+static void BM_preg_replace(benchmark::State &state) {
+  const regexp re{string{"~\\d+~"}};
+  const string replacement{"N"};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(f$preg_replace(re, replacement, get_subject()));
+  }
+}
+BENCHMARK(BM_preg_replace);
+
+static void BM_preg_split(benchmark::State &state) {
+  const regexp re{string{"~[/?&= ]~"}};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(f$preg_split(re, get_subject()));
+  }
+}
+BENCHMARK(BM_preg_split);
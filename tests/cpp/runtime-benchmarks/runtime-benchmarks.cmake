@@ -0,0 +1,11 @@
+prepend(RUNTIME_BENCHMARKS_SOURCES ${BASE_DIR}/tests/cpp/runtime-benchmarks/
+        _runtime-benchmarks-env.cpp
+        array-benchmark.cpp
+        instance-cache-benchmark.cpp
+        memory-resource-benchmark.cpp
+        regexp-benchmark.cpp
+        serialization-benchmark.cpp
+        string-benchmark.cpp)
+
+vk_add_benchmark(runtime "${RUNTIME_LIBS};${RUNTIME_LINK_TEST_LIBS}" ${RUNTIME_BENCHMARKS_SOURCES}
+                 ${BASE_DIR}/tests/cpp/runtime/_runtime-tests-linkage.cpp)
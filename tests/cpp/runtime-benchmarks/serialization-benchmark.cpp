@@ -0,0 +1,63 @@
+#include <benchmark/benchmark.h>
+
+#include "runtime/json-functions.h"
+#include "runtime/kphp_core.h"
+#include "runtime/msgpack-serialization.h"
+
+namespace {
+
+// a typical API response: a list of flat objects with ints, floats, strings and nested lists
+mixed make_document(int64_t items) {
+  array<mixed> list;
+  for (int64_t i = 0; i < items; ++i) {
+    array<mixed> item;
+    item.set_value(string{"id"}, i);
+    item.set_value(string{"name"}, string{"user name "}.append(i));
+    item.set_value(string{"rating"}, static_cast<double>(i) * 0.75);
+    item.set_value(string{"is_active"}, i % 3 == 0);
+    item.set_value(string{"tags"}, array<mixed>::create(string{"first"}, string{"second"}, i));
+    list.push_back(item);
+  }
+  array<mixed> document;
+  document.set_value(string{"count"}, items);
+  document.set_value(string{"items"}, list);
+  return document;
+}
+
+} // namespace
+
+static void BM_json_encode(benchmark::State &state) {
+  const mixed document = make_document(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(f$json_encode(document));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_json_encode)->Arg(10)->Arg(1000);
+
+static void BM_json_decode(benchmark::State &state) {
+  const string json = f$json_encode(make_document(state.range(0))).val();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(f$json_decode(json, true));
+  }
+  state.SetBytesProcessed(state.iterations() * json.size());
+}
+BENCHMARK(BM_json_decode)->Arg(10)->Arg(1000);
+
+static void BM_msgpack_serialize(benchmark::State &state) {
+  const mixed document = make_document(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(f$msgpack_serialize(document));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_msgpack_serialize)->Arg(10)->Arg(1000);
+
+static void BM_msgpack_deserialize(benchmark::State &state) {
+  const string packed = f$msgpack_serialize(make_document(state.range(0))).val();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(f$msgpack_deserialize(packed));
+  }
+  state.SetBytesProcessed(state.iterations() * packed.size());
+}
+BENCHMARK(BM_msgpack_deserialize)->Arg(10)->Arg(1000);
@@ -0,0 +1,95 @@
+#include <benchmark/benchmark.h>
+
+#include "runtime/kphp_core.h"
+
+static void BM_string_concat(benchmark::State &state) {
+  const int64_t parts = state.range(0);
+  const string part{"some string part "};
+  for (auto _ : state) {
+    string result;
+    for (int64_t i = 0; i < parts; ++i) {
+      result.append(part).append(i);
+    }
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetItemsProcessed(state.iterations() * parts);
+}
+BENCHMARK(BM_string_concat)->Arg(16)->Arg(1024)->Arg(65536);
+
+static void BM_string_buffer_append(benchmark::State &state) {
+  const int64_t parts = state.range(0);
+  const string part{"some string part "};
+  string_buffer sb;
+  for (auto _ : state) {
+    sb.clean();
+    for (int64_t i = 0; i < parts; ++i) {
+      sb << part << i << ' ' << 3.25;
+    }
+    benchmark::DoNotOptimize(sb.str());
+  }
+  state.SetItemsProcessed(state.iterations() * parts);
+}
+BENCHMARK(BM_string_buffer_append)->Arg(16)->Arg(1024)->Arg(65536);
+
+static void BM_string_hash(benchmark::State &state) {
+  const string str{static_cast<string::size_type>(state.range(0)), 'x'};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(string_hash(str.c_str(), str.size()));
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_string_hash)->Arg(8)->Arg(64)->Arg(1024);
+
+static void BM_string_compare(benchmark::State &state) {
+  const string lhs{"some_rather_long_key_prefix_12345"};
+  const string rhs{"some_rather_long_key_prefix_12346"};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(lhs.compare(rhs));
+  }
+}
+BENCHMARK(BM_string_compare);
+
+static void BM_mixed_int_to_string(benchmark::State &state) {
+  int64_t i = 0;
+  for (auto _ : state) {
+    mixed value{i++ * 7919};
+    benchmark::DoNotOptimize(value.to_string());
+  }
+}
+BENCHMARK(BM_mixed_int_to_string);
+
+static void BM_mixed_double_to_string(benchmark::State &state) {
+  double d = 0.5;
+  for (auto _ : state) {
+    mixed value{d};
+    d += 1.25;
+    benchmark::DoNotOptimize(value.to_string());
+  }
+}
+BENCHMARK(BM_mixed_double_to_string);
+
+static void BM_mixed_numeric_string_to_int(benchmark::State &state) {
+  const mixed value{string{"1234567890"}};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(value.to_int());
+  }
+}
+BENCHMARK(BM_mixed_numeric_string_to_int);
+
+static void BM_mixed_numeric_string_to_float(benchmark::State &state) {
+  const mixed value{string{"12345.678"}};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(value.to_float());
+  }
+}
+BENCHMARK(BM_mixed_numeric_string_to_float);
+
+static void BM_mixed_compare(benchmark::State &state) {
+  const mixed lhs{string{"100"}};
+  const mixed rhs{100.0};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(equals(lhs, rhs));
+    benchmark::DoNotOptimize(eq2(lhs, rhs));
+  }
+}
+BENCHMARK(BM_mixed_compare);
@@ -1,6 +1,13 @@
+#include <algorithm>
+#include <cmath>
 #include <gtest/gtest.h>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <vector>
 
 #include "runtime/kphp_core.h"
+#include "runtime/array_functions.h"
 
 TEST(array_test, find_no_mutate_in_empy_array) {
   array<int> arr;
@@ -132,3 +139,133 @@ TEST(array_test, test_mutate_shared_map) {
   ASSERT_EQ(arr_copy.get_reference_counter(), 1);
   ASSERT_FALSE(arr_copy.is_equal_inner_pointer(arr));
 }
+
+TEST(array_test, test_sort_matches_std_sort) {
+  std::mt19937_64 gen{42};
+  for (int64_t n : {0, 1, 2, 15, 17, 100, 255, 256, 1000, 4095, 4096, 10000}) {
+    for (int64_t range : {int64_t{3}, int64_t{1000}, std::numeric_limits<int64_t>::max()}) {
+      std::vector<int64_t> expected;
+      array<int64_t> arr;
+      for (int64_t i = 0; i < n; ++i) {
+        const int64_t value = static_cast<int64_t>(gen() % range) - range / 2;
+        expected.push_back(value);
+        arr.push_back(value);
+      }
+
+      std::sort(expected.begin(), expected.end());
+      auto sorted = arr;
+      sorted.sort(sort_compare<int64_t>(), true);
+      ASSERT_EQ(sorted.count(), n);
+      for (int64_t i = 0; i < n; ++i) {
+        ASSERT_EQ(sorted.get_value(i), expected[i]);
+      }
+
+      std::reverse(expected.begin(), expected.end());
+      auto rsorted = arr;
+      rsorted.sort(rsort_compare_numeric<int64_t>(), true);
+      for (int64_t i = 0; i < n; ++i) {
+        ASSERT_EQ(rsorted.get_value(i), expected[i]);
+      }
+
+      // goes through the comparison sort, not the radix one
+      auto usorted = arr;
+      usorted.sort([](int64_t lhs, int64_t rhs) { return lhs < rhs ? -1 : lhs > rhs; }, true);
+      std::reverse(expected.begin(), expected.end());
+      for (int64_t i = 0; i < n; ++i) {
+        ASSERT_EQ(usorted.get_value(i), expected[i]);
+      }
+    }
+  }
+}
+
+TEST(array_test, test_sort_adversarial_inputs) {
+  const int64_t n = 10000;
+  std::vector<int64_t> ascending(n), descending(n), organ_pipe(n), all_equal(n, 7);
+  for (int64_t i = 0; i < n; ++i) {
+    ascending[i] = i;
+    descending[i] = n - i;
+    organ_pipe[i] = i < n / 2 ? i : n - i;
+  }
+  for (const auto &input : {ascending, descending, organ_pipe, all_equal}) {
+    array<mixed> arr;
+    for (int64_t value : input) {
+      arr.push_back(value);
+    }
+    arr.sort(sort_compare<mixed>(), true);
+    for (int64_t i = 1; i < n; ++i) {
+      ASSERT_TRUE(leq(arr.get_value(i - 1), arr.get_value(i)));
+    }
+  }
+}
+
+TEST(array_test, test_sort_inconsistent_comparator) {
+  std::mt19937_64 gen{7};
+  array<int64_t> arr;
+  for (int64_t i = 0; i < 1000; ++i) {
+    arr.push_back(static_cast<int64_t>(gen() % 100));
+  }
+  arr.sort([&gen](int64_t, int64_t) { return static_cast<int64_t>(gen() % 3) - 1; }, true);
+  ASSERT_EQ(arr.count(), 1000);
+}
+
+TEST(array_test, test_sort_doubles_matches_std_sort) {
+  std::mt19937_64 gen{42};
+  std::uniform_real_distribution<double> distribution{-1e6, 1e6};
+  const double special_values[] = {0.0, -0.0, std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity(),
+                                   std::numeric_limits<double>::min(), -std::numeric_limits<double>::max()};
+  for (int64_t n : {0, 1, 17, 1000, 4095, 4096, 10000}) {
+    std::vector<double> expected;
+    array<double> arr;
+    for (int64_t i = 0; i < n; ++i) {
+      const double value = i % 10 ? distribution(gen) : special_values[(i / 10) % std::size(special_values)];
+      expected.push_back(value);
+      arr.push_back(value);
+    }
+
+    std::sort(expected.begin(), expected.end());
+    auto sorted = arr;
+    sorted.sort(sort_compare<double>(), true);
+    ASSERT_EQ(sorted.count(), n);
+    for (int64_t i = 0; i < n; ++i) {
+      ASSERT_EQ(sorted.get_value(i), expected[i]);
+    }
+
+    std::reverse(expected.begin(), expected.end());
+    auto rsorted = arr;
+    rsorted.sort(rsort_compare<double>(), true);
+    for (int64_t i = 0; i < n; ++i) {
+      ASSERT_EQ(rsorted.get_value(i), expected[i]);
+    }
+  }
+}
+
+TEST(array_test, test_sort_doubles_with_nan) {
+  array<double> arr;
+  for (int64_t i = 0; i < 10000; ++i) {
+    arr.push_back(i % 100 ? static_cast<double>(10000 - i) : std::numeric_limits<double>::quiet_NaN());
+  }
+  // NaN isn't ordered with anything, it's the same as the comparison sort does
+  auto expected = arr;
+  expected.sort([](double lhs, double rhs) { return lhs < rhs ? -1 : lhs > rhs; }, true);
+  arr.sort(sort_compare<double>(), true);
+  for (int64_t i = 0; i < arr.count(); ++i) {
+    ASSERT_EQ(std::isnan(arr.get_value(i)), std::isnan(expected.get_value(i)));
+    if (!std::isnan(arr.get_value(i))) {
+      ASSERT_EQ(arr.get_value(i), expected.get_value(i));
+    }
+  }
+}
+
+TEST(array_test, test_sort_without_memory_for_radix_buffer) {
+  // the array takes more than a third of the script memory, so there is no room for the radix sort buffer
+  const int64_t n = static_cast<int64_t>(dl::get_script_memory_stats().memory_limit / sizeof(int64_t) * 4 / 10);
+  array<int64_t> arr{array_size{n, 0, true}};
+  for (int64_t i = 0; i < n; ++i) {
+    arr.push_back(n - i);
+  }
+  arr.sort(sort_compare<int64_t>(), true);
+  ASSERT_EQ(arr.count(), n);
+  for (int64_t i = 0; i < n; ++i) {
+    ASSERT_EQ(arr.get_value(i), i + 1);
+  }
+}
@@ -1,4 +1,6 @@
 #include <gtest/gtest.h>
+#include <string>
+#include <unordered_set>
 
 #include "common/php-functions.h"
 
@@ -147,3 +149,22 @@ TEST(test_php_try_to_integer, long_strings) {
   ASSERT_FALSE(php_try_to_int_wrapper("-784894841981984984891498", x));
   ASSERT_FALSE(php_try_to_int_wrapper("-9223372036854775809", x));
 }
+
+TEST(test_string_hash, structured_keys_dont_collide) {
+  std::unordered_set<int64_t> hashes;
+  for (int i = 0; i < 100000; ++i) {
+    const std::string key = "prefix." + std::to_string(i) + ".suffix";
+    ASSERT_TRUE(hashes.insert(string_hash(key.c_str(), key.size())).second) << key;
+  }
+}
+
+TEST(test_string_hash, all_lengths) {
+  std::string buf(256, 'x');
+  std::unordered_set<int64_t> hashes;
+  for (size_t len = 0; len <= buf.size(); ++len) {
+    ASSERT_TRUE(hashes.insert(string_hash(buf.c_str(), len)).second) << len;
+    // hash doesn't depend on the data alignment
+    const std::string copy = "a" + buf.substr(0, len);
+    ASSERT_EQ(string_hash(buf.c_str(), len), string_hash(copy.c_str() + 1, len));
+  }
+}
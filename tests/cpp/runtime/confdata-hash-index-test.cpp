@@ -0,0 +1,175 @@
+#include <csignal>
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "runtime/confdata-global-manager.h"
+
+namespace {
+
+class ConfdataHashIndexTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    memory_.resize(1024 * 1024);
+    resource_.init(memory_.data(), memory_.size());
+  }
+
+  confdata_sample_storage make_storage() noexcept {
+    return confdata_sample_storage{confdata_sample_storage::allocator_type{resource_}};
+  }
+
+  static const mixed *find_in_map(const confdata_sample_storage &confdata, const string &key) noexcept {
+    const auto it = confdata.find(key);
+    return it != confdata.end() ? &it->second : nullptr;
+  }
+
+  // the keys with the same lower bits of the hash get into the same probe sequence
+  static std::vector<string> make_colliding_keys(size_t count) noexcept {
+    std::vector<string> keys;
+    size_t low_bits = 0;
+    for (int64_t i = 0; keys.size() < count; ++i) {
+      string key = string{"collision_"}.append(i);
+      const size_t key_low_bits = static_cast<size_t>(key.hash()) & 0xff;
+      if (keys.empty()) {
+        low_bits = key_low_bits;
+      }
+      if (key_low_bits == low_bits) {
+        keys.emplace_back(std::move(key));
+      }
+    }
+    return keys;
+  }
+
+  std::vector<char> memory_;
+  memory_resource::unsynchronized_pool_resource resource_;
+};
+
+// the failed allocations of the memory resource raise SIGUSR2, which is handled by the server only
+class ScopedSigusr2Ignore {
+public:
+  ScopedSigusr2Ignore() noexcept {
+    struct sigaction ignore_action {};
+    ignore_action.sa_handler = SIG_IGN;
+    sigaction(SIGUSR2, &ignore_action, &previous_action_);
+  }
+
+  ~ScopedSigusr2Ignore() {
+    sigaction(SIGUSR2, &previous_action_, nullptr);
+  }
+
+private:
+  struct sigaction previous_action_ {};
+};
+
+} // namespace
+
+TEST_F(ConfdataHashIndexTest, agrees_with_map) {
+  auto confdata = make_storage();
+  for (int64_t i = 0; i < 1000; ++i) {
+    confdata.emplace(string{"key_"}.append(i), mixed{i});
+  }
+
+  ConfdataHashIndex index;
+  ASSERT_TRUE(index.build(confdata, resource_));
+  ASSERT_TRUE(index.is_built());
+  ASSERT_GE(index.get_memory_usage(), confdata.size() * 2 * (sizeof(int64_t) + sizeof(void *)));
+
+  for (const auto &element : confdata) {
+    ASSERT_EQ(index.find_value(element.first), &element.second);
+  }
+  for (int64_t i = 0; i < 1000; ++i) {
+    const string key = string{"missing_"}.append(i);
+    ASSERT_EQ(find_in_map(confdata, key), nullptr);
+    ASSERT_EQ(index.find_value(key), nullptr);
+  }
+  ASSERT_EQ(index.find_value(string{}), nullptr);
+
+  index.clear(resource_);
+  ASSERT_FALSE(index.is_built());
+  ASSERT_EQ(index.get_memory_usage(), 0);
+}
+
+TEST_F(ConfdataHashIndexTest, empty_confdata_isnt_indexed) {
+  auto confdata = make_storage();
+  ConfdataHashIndex index;
+  ASSERT_TRUE(index.build(confdata, resource_));
+  ASSERT_FALSE(index.is_built());
+}
+
+TEST_F(ConfdataHashIndexTest, colliding_hashes) {
+  const std::vector<string> keys = make_colliding_keys(32);
+  auto confdata = make_storage();
+  for (size_t i = 0; i < keys.size(); i += 2) {
+    confdata.emplace(keys[i], mixed{static_cast<int64_t>(i)});
+  }
+  // the unrelated keys are mixed in the same table
+  for (int64_t i = 0; i < 16; ++i) {
+    confdata.emplace(string{"key_"}.append(i), mixed{i});
+  }
+
+  ConfdataHashIndex index;
+  ASSERT_TRUE(index.build(confdata, resource_));
+  for (size_t i = 0; i < keys.size(); ++i) {
+    const mixed *value = index.find_value(keys[i]);
+    ASSERT_EQ(value, find_in_map(confdata, keys[i]));
+    if (i % 2) {
+      ASSERT_EQ(value, nullptr);
+    } else {
+      ASSERT_NE(value, nullptr);
+      ASSERT_EQ(value->to_int(), static_cast<int64_t>(i));
+    }
+  }
+  for (const auto &element : confdata) {
+    ASSERT_EQ(index.find_value(element.first), &element.second);
+  }
+  index.clear(resource_);
+}
+
+TEST_F(ConfdataHashIndexTest, lookups_fall_back_to_map_without_index) {
+  ConfdataSample sample;
+  sample.init(resource_);
+
+  auto confdata = make_storage();
+  for (int64_t i = 0; i < 1000; ++i) {
+    confdata.emplace(string{"key_"}.append(i), mixed{i});
+  }
+
+  // take all the free memory, so there is no room for the index
+  ScopedSigusr2Ignore sigusr2_ignore;
+  std::vector<void *> taken_pieces;
+  while (void *piece = resource_.allocate(4096)) {
+    taken_pieces.push_back(piece);
+  }
+  const auto &stats = ConfdataGlobalManager::get().get_hash_index_stats();
+  const auto stats_before = stats;
+  sample.reset(std::move(confdata));
+  ASSERT_EQ(stats.built, stats_before.built);
+  ASSERT_EQ(stats.failed, stats_before.failed + 1);
+  ASSERT_EQ(stats.bytes, 0);
+
+  const auto &stored_confdata = sample.get_confdata();
+  ASSERT_EQ(stored_confdata.size(), 1000);
+  ConfdataHashIndex index;
+  ASSERT_FALSE(index.build(stored_confdata, resource_));
+  ASSERT_FALSE(index.is_built());
+  for (const auto &element : stored_confdata) {
+    ASSERT_EQ(sample.find_value(element.first), &element.second);
+  }
+  for (int64_t i = 0; i < 1000; ++i) {
+    ASSERT_EQ(sample.find_value(string{"missing_"}.append(i)), nullptr);
+  }
+
+  for (void *piece : taken_pieces) {
+    resource_.deallocate(piece, 4096);
+  }
+  // the index is built with the next sample
+  auto new_confdata = make_storage();
+  new_confdata.emplace(string{"new_key"}, mixed{1});
+  sample.reset(std::move(new_confdata));
+  ASSERT_EQ(stats.built, stats_before.built + 1);
+  ASSERT_EQ(stats.failed, stats_before.failed + 1);
+  ASSERT_GT(stats.bytes, 0);
+  ASSERT_EQ(sample.find_value(string{"new_key"}), &sample.get_confdata().begin()->second);
+  ASSERT_EQ(sample.find_value(string{"key_1"}), nullptr);
+
+  sample.destroy();
+}
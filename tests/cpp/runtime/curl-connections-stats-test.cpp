@@ -0,0 +1,98 @@
+#include <arpa/inet.h>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "runtime/curl.h"
+
+namespace {
+
+struct StatsSnapshot {
+  uint64_t transfers{0};
+  uint64_t new_connections{0};
+  uint64_t reused_connections{0};
+
+  static StatsSnapshot take() noexcept {
+    const auto &stats = vk::singleton<CurlConnectionsStats>::get();
+    return StatsSnapshot{stats.transfers, stats.new_connections, stats.reused_connections};
+  }
+
+  StatsSnapshot operator-(const StatsSnapshot &other) const noexcept {
+    return StatsSnapshot{transfers - other.transfers, new_connections - other.new_connections, reused_connections - other.reused_connections};
+  }
+};
+
+// the port is bound but not listened, so the connections to it are refused
+class RefusingPort {
+public:
+  RefusingPort() noexcept {
+    fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addr_len = sizeof(addr);
+    if (fd_ >= 0 && bind(fd_, reinterpret_cast<sockaddr *>(&addr), addr_len) == 0
+        && getsockname(fd_, reinterpret_cast<sockaddr *>(&addr), &addr_len) == 0) {
+      port_ = ntohs(addr.sin_port);
+    }
+  }
+
+  ~RefusingPort() {
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+  }
+
+  int port() const noexcept {
+    return port_;
+  }
+
+private:
+  int fd_{-1};
+  int port_{0};
+};
+
+} // namespace
+
+TEST(curl_connections_stats_test, successful_transfers) {
+  const auto before = StatsSnapshot::take();
+  auto &stats = vk::singleton<CurlConnectionsStats>::get();
+  stats.on_transfer_done(1, true);
+  stats.on_transfer_done(0, true);
+  stats.on_transfer_done(0, true);
+  stats.on_transfer_done(2, true);
+
+  const auto diff = StatsSnapshot::take() - before;
+  ASSERT_EQ(diff.transfers, 4);
+  ASSERT_EQ(diff.new_connections, 3);
+  ASSERT_EQ(diff.reused_connections, 2);
+}
+
+TEST(curl_connections_stats_test, failed_transfers_arent_reused) {
+  const auto before = StatsSnapshot::take();
+  auto &stats = vk::singleton<CurlConnectionsStats>::get();
+  stats.on_transfer_done(0, false);
+  stats.on_transfer_done(1, false);
+
+  const auto diff = StatsSnapshot::take() - before;
+  ASSERT_EQ(diff.transfers, 2);
+  ASSERT_EQ(diff.new_connections, 1);
+  ASSERT_EQ(diff.reused_connections, 0);
+}
+
+TEST(curl_connections_stats_test, refused_connection_isnt_reused) {
+  RefusingPort refusing_port;
+  ASSERT_NE(refusing_port.port(), 0);
+
+  const auto before = StatsSnapshot::take();
+  const curl_easy easy_id = f$curl_init(string{"http://127.0.0.1:"}.append(refusing_port.port()).append("/"));
+  ASSERT_NE(easy_id, 0);
+  ASSERT_TRUE(f$curl_exec(easy_id).is_bool());
+  ASSERT_NE(f$curl_errno(easy_id), 0);
+  f$curl_close(easy_id);
+
+  const auto diff = StatsSnapshot::take() - before;
+  ASSERT_EQ(diff.transfers, 1);
+  ASSERT_EQ(diff.reused_connections, 0);
+}
@@ -0,0 +1,341 @@
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <iterator>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+#include "common/crc32.h"
+#include "runtime/instance-cache.h"
+#include "runtime/kphp_core.h"
+#include "runtime/refcountable_php_classes.h"
+#include "server/php-engine-vars.h"
+#include "server/workers-control.h"
+
+namespace {
+
+// mirrors the code generated for a @kphp-serializable php class
+struct C$CachedItem : public refcountable_php_classes<C$CachedItem> {
+  int64_t $id{0};
+  string $name;
+
+  // it's packed as uint64 with the 0xcf prefix
+  static constexpr uint64_t MSGPACK_LAYOUT_HASH = 0x1234567890abcdefULL;
+
+  const char *get_class() const noexcept {
+    return "CachedItem";
+  }
+
+  int get_hash() const noexcept {
+    return 0;
+  }
+
+  template<class Visitor>
+  void generic_accept(Visitor &&visitor) noexcept {
+    visitor("id", $id);
+    visitor("name", $name);
+  }
+
+  void accept(InstanceReferencesCountingVisitor &visitor) noexcept {
+    generic_accept(visitor);
+  }
+
+  void accept(InstanceDeepCopyVisitor &visitor) noexcept {
+    generic_accept(visitor);
+  }
+
+  void accept(InstanceDeepDestroyVisitor &visitor) noexcept {
+    generic_accept(visitor);
+  }
+
+  void msgpack_pack(vk::msgpack::packer<string_buffer> &packer) const noexcept {
+    packer.pack_array(4);
+    packer.pack(1);
+    packer.pack($id);
+    packer.pack(2);
+    packer.pack($name);
+  }
+
+  void msgpack_unpack(const vk::msgpack::object &msgpack_o) {
+    if (msgpack_o.type != vk::msgpack::stored_type::ARRAY || msgpack_o.via.array.size != 4) {
+      throw vk::msgpack::type_error{};
+    }
+    msgpack_o.via.array.ptr[1].convert($id);
+    msgpack_o.via.array.ptr[3].convert($name);
+  }
+};
+
+using CachedItem = class_instance<C$CachedItem>;
+
+constexpr size_t SNAPSHOT_HEADER_SIZE = 16;
+constexpr size_t SNAPSHOT_TRAILER_SIZE = 16;
+
+CachedItem make_item(int64_t id) {
+  CachedItem item;
+  item.alloc();
+  item->$id = id;
+  item->$name = string{"cached item "}.append(id);
+  return item;
+}
+
+string make_key(const char *prefix, int64_t id) {
+  return string{prefix}.append(id);
+}
+
+CachedItem fetch_item(const char *prefix, int64_t id) {
+  return f$instance_cache_fetch<CachedItem>(string{"CachedItem"}, make_key(prefix, id));
+}
+
+size_t replace_all(std::string &content, const std::string &from, const std::string &to) {
+  size_t replaced = 0;
+  for (size_t pos = content.find(from); pos != std::string::npos; pos = content.find(from, pos + to.size())) {
+    content.replace(pos, from.size(), to);
+    ++replaced;
+  }
+  return replaced;
+}
+
+void update_snapshot_crc(std::string &content) {
+  const size_t records_size = content.size() - SNAPSHOT_HEADER_SIZE - sizeof(uint32_t) - SNAPSHOT_TRAILER_SIZE;
+  const uint32_t crc32 = compute_crc32(content.data() + SNAPSHOT_HEADER_SIZE, records_size);
+  std::memcpy(&content[content.size() - SNAPSHOT_TRAILER_SIZE + sizeof(uint64_t)], &crc32, sizeof(crc32));
+}
+
+class InstanceCacheSnapshotTest : public testing::Test {
+protected:
+  static constexpr int64_t ITEMS = 3;
+  static constexpr const char *STORED_KEY = "snapshot_key_";
+
+  void SetUp() final {
+    path_ = testing::TempDir() + "instance-cache-test.snapshot";
+    std::remove(path_.c_str());
+    set_instance_cache_snapshot_path(path_.c_str());
+    set_instance_cache_snapshot_period(0);
+    for (int64_t id = 0; id != ITEMS; ++id) {
+      ASSERT_TRUE(f$instance_cache_store(make_key(STORED_KEY, id), make_item(id)));
+    }
+  }
+
+  void TearDown() final {
+    set_instance_cache_snapshot_path("");
+    std::remove(path_.c_str());
+  }
+
+  // the snapshot is finished by the helper process, the result is taken by one of the next steps
+  void write_snapshot() {
+    const uint64_t written = instance_cache_get_snapshot_stats().snapshots_written;
+    for (int i = 0; i != 1000 && instance_cache_get_snapshot_stats().snapshots_written == written; ++i) {
+      instance_cache_write_snapshot_step();
+      std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+    ASSERT_EQ(instance_cache_get_snapshot_stats().snapshots_written, written + 1);
+  }
+
+  // the records aren't loaded over the existing elements, and the deleted ones are purged only after a minute,
+  // so the stored elements are loaded under other keys of the same length
+  std::string read_snapshot(const char *loaded_key) const {
+    std::ifstream file{path_, std::ios::binary};
+    std::string content{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+    EXPECT_EQ(replace_all(content, STORED_KEY, loaded_key), ITEMS);
+    update_snapshot_crc(content);
+    return content;
+  }
+
+  void rewrite_snapshot(const std::string &content) const {
+    std::ofstream{path_, std::ios::binary | std::ios::trunc} << content;
+  }
+
+  std::string path_;
+};
+
+} // namespace
+
+TEST_F(InstanceCacheSnapshotTest, write_and_load) {
+  write_snapshot();
+  rewrite_snapshot(read_snapshot("loaded_key_1_"));
+
+  const uint64_t loaded = instance_cache_get_snapshot_stats().elements_loaded;
+  instance_cache_load_snapshot();
+  ASSERT_EQ(instance_cache_get_snapshot_stats().elements_loaded, loaded + ITEMS);
+  for (int64_t id = 0; id != ITEMS; ++id) {
+    const CachedItem item = fetch_item("loaded_key_1_", id);
+    ASSERT_FALSE(item.is_null());
+    ASSERT_EQ(item->$id, id);
+    ASSERT_STREQ(item->$name.c_str(), make_item(id)->$name.c_str());
+  }
+}
+
+TEST_F(InstanceCacheSnapshotTest, truncated_file_is_rejected) {
+  write_snapshot();
+  const std::string content = read_snapshot("loaded_key_2_");
+  rewrite_snapshot(content.substr(0, content.size() - SNAPSHOT_TRAILER_SIZE / 2));
+
+  const uint64_t loaded = instance_cache_get_snapshot_stats().elements_loaded;
+  const uint64_t rejected = instance_cache_get_snapshot_stats().elements_rejected;
+  instance_cache_load_snapshot();
+  ASSERT_EQ(instance_cache_get_snapshot_stats().elements_loaded, loaded);
+  ASSERT_EQ(instance_cache_get_snapshot_stats().elements_rejected, rejected);
+  ASSERT_TRUE(fetch_item("loaded_key_2_", 0).is_null());
+}
+
+TEST_F(InstanceCacheSnapshotTest, bad_crc_is_rejected) {
+  write_snapshot();
+  std::string content = read_snapshot("loaded_key_3_");
+  content[SNAPSHOT_HEADER_SIZE + 8] ^= 0x5a;
+  rewrite_snapshot(content);
+
+  const uint64_t loaded = instance_cache_get_snapshot_stats().elements_loaded;
+  const uint64_t rejected = instance_cache_get_snapshot_stats().elements_rejected;
+  instance_cache_load_snapshot();
+  ASSERT_EQ(instance_cache_get_snapshot_stats().elements_loaded, loaded);
+  ASSERT_EQ(instance_cache_get_snapshot_stats().elements_rejected, rejected);
+  ASSERT_TRUE(fetch_item("loaded_key_3_", 0).is_null());
+}
+
+TEST_F(InstanceCacheSnapshotTest, changed_layout_hash_is_rejected) {
+  write_snapshot();
+  std::string content = read_snapshot("loaded_key_4_");
+
+  // as if the records were saved by the binary with another class layout
+  std::string packed_hash{'\xcf'};
+  std::string changed_hash{'\xcf'};
+  for (int shift = 56; shift >= 0; shift -= 8) {
+    packed_hash.push_back(static_cast<char>(C$CachedItem::MSGPACK_LAYOUT_HASH >> shift));
+    changed_hash.push_back(static_cast<char>((C$CachedItem::MSGPACK_LAYOUT_HASH + 1) >> shift));
+  }
+  const size_t records = replace_all(content, packed_hash, changed_hash);
+  ASSERT_GE(records, ITEMS);
+  update_snapshot_crc(content);
+  rewrite_snapshot(content);
+
+  const uint64_t loaded = instance_cache_get_snapshot_stats().elements_loaded;
+  const uint64_t rejected = instance_cache_get_snapshot_stats().elements_rejected;
+  instance_cache_load_snapshot();
+  ASSERT_EQ(instance_cache_get_snapshot_stats().elements_loaded, loaded);
+  ASSERT_EQ(instance_cache_get_snapshot_stats().elements_rejected, rejected + records);
+  for (int64_t id = 0; id != ITEMS; ++id) {
+    ASSERT_TRUE(fetch_item("loaded_key_4_", id).is_null());
+  }
+}
+
+namespace {
+
+constexpr int STRESS_WORKERS = 4;
+constexpr int64_t STRESS_KEYS_PER_WORKER = 256;
+
+string make_stress_key(int worker, int64_t id) {
+  return string{"stress_key_"}.append(static_cast<int64_t>(worker)).append("_").append(id);
+}
+
+// each worker replaces and deletes its own keys, as the elements stored by other processes recently are not replaced,
+// and fetches the keys of all the workers, while their elements and indices are being retired and freed
+void run_stress_worker(int worker) {
+  for (int request = 0; request != 200; ++request) {
+    init_instance_cache_lib();
+    for (int op = 0; op != 64; ++op) {
+      const int64_t id = (request * 64 + op) * 7919 % STRESS_KEYS_PER_WORKER;
+      if (op % 8 == 0) {
+        f$instance_cache_delete(make_stress_key(worker, id));
+      } else if (op % 2 == 0) {
+        f$instance_cache_store(make_stress_key(worker, id), make_item(id));
+      }
+      const int other_worker = (worker + op) % STRESS_WORKERS;
+      const CachedItem item = f$instance_cache_fetch<CachedItem>(string{"CachedItem"}, make_stress_key(other_worker, id));
+      if (!item.is_null()) {
+        ASSERT_EQ(item->$id, id);
+        ASSERT_STREQ(item->$name.c_str(), make_item(id)->$name.c_str());
+      }
+    }
+    free_instance_cache_lib();
+  }
+}
+
+} // namespace
+
+TEST(instance_cache_test, concurrent_store_fetch_delete) {
+  // the worker processes announce their reader epochs in the slots of their logname_id
+  vk::singleton<WorkersControl>::get().set_total_workers_count(STRESS_WORKERS + 1);
+  free_instance_cache_lib();
+
+  std::array<pid_t, STRESS_WORKERS> workers{};
+  for (int worker = 0; worker != STRESS_WORKERS; ++worker) {
+    const pid_t worker_pid = fork();
+    if (!worker_pid) {
+      logname_id = worker + 1;
+      run_stress_worker(worker);
+      _exit(testing::Test::HasFailure());
+    }
+    ASSERT_GT(worker_pid, 0);
+    workers[worker] = worker_pid;
+  }
+  for (pid_t worker_pid : workers) {
+    int status = 0;
+    ASSERT_EQ(waitpid(worker_pid, &status, 0), worker_pid);
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(WEXITSTATUS(status), 0);
+  }
+
+  init_instance_cache_lib();
+  vk::singleton<WorkersControl>::get().set_total_workers_count(1);
+  size_t fetched = 0;
+  for (int worker = 0; worker != STRESS_WORKERS; ++worker) {
+    for (int64_t id = 0; id != STRESS_KEYS_PER_WORKER; ++id) {
+      const CachedItem item = f$instance_cache_fetch<CachedItem>(string{"CachedItem"}, make_stress_key(worker, id));
+      if (!item.is_null()) {
+        ASSERT_EQ(item->$id, id);
+        ++fetched;
+      }
+    }
+  }
+  ASSERT_GT(fetched, 0);
+}
+
+TEST(instance_cache_test, cold_elements_eviction) {
+  constexpr int64_t HOT_ITEMS = 16;
+  constexpr int64_t COLD_ITEMS = 144;
+  const auto make_eviction_key = [](int64_t id) { return string{"eviction_key_"}.append(id); };
+  const auto fetch_eviction_item = [&make_eviction_key](int64_t id) {
+    return f$instance_cache_fetch<CachedItem>(string{"CachedItem"}, make_eviction_key(id));
+  };
+
+  const string payload{128 * 1024, 'x'};
+  for (int64_t id = 0; id != HOT_ITEMS + COLD_ITEMS; ++id) {
+    CachedItem item = make_item(id);
+    item->$name = payload;
+    ASSERT_TRUE(f$instance_cache_store(make_eviction_key(id), item));
+  }
+  // the memory stats used by the eviction are updated by the master cron
+  instance_cache_purge_expired_elements();
+  const auto &memory_stats = instance_cache_get_memory_stats();
+  const uint64_t evicted = instance_cache_get_stats().elements_evicted;
+
+  // the memory usage is below the threshold
+  set_instance_cache_eviction_threshold(0.9);
+  instance_cache_evict_cold_elements();
+  ASSERT_EQ(instance_cache_get_stats().elements_evicted, evicted);
+
+  // at the threshold equal to the hysteresis all the memory is to be freed, so every cold element is evicted
+  set_instance_cache_eviction_threshold(0.05);
+  ASSERT_GE(memory_stats.memory_used, memory_stats.memory_limit * 0.05);
+  // the new elements are given a second chance, the first pass only clears their marks
+  instance_cache_evict_cold_elements();
+  ASSERT_EQ(instance_cache_get_stats().elements_evicted, evicted);
+
+  // the elements fetched in another request are marked as recently used
+  free_instance_cache_lib();
+  init_instance_cache_lib();
+  for (int64_t id = 0; id != HOT_ITEMS; ++id) {
+    ASSERT_FALSE(fetch_eviction_item(id).is_null());
+  }
+  instance_cache_evict_cold_elements();
+  set_instance_cache_eviction_threshold(0.75);
+  ASSERT_GE(instance_cache_get_stats().elements_evicted, evicted + COLD_ITEMS);
+
+  free_instance_cache_lib();
+  init_instance_cache_lib();
+  for (int64_t id = 0; id != HOT_ITEMS + COLD_ITEMS; ++id) {
+    ASSERT_EQ(fetch_eviction_item(id).is_null(), id >= HOT_ITEMS);
+  }
+}
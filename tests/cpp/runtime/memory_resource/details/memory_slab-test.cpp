@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include <set>
+#include <vector>
+
+#include "runtime/memory_resource/details/memory_slab.h"
+
+using memory_resource::details::memory_slab;
+using memory_resource::details::memory_slab_pages;
+
+namespace {
+
+struct alignas(memory_slab::SIZE) SlabMemory {
+  char data[memory_slab::SIZE];
+};
+
+} // namespace
+
+TEST(memory_slab_test, get_all_chunks) {
+  for (size_t chunk_size = 8; chunk_size <= memory_slab::MAX_CHUNK_SIZE; chunk_size += 8) {
+    SlabMemory slab_memory;
+    memory_slab *slab = memory_slab::create(&slab_memory, chunk_size);
+    ASSERT_EQ(memory_slab::from_chunk(slab_memory.data + 100), slab);
+    ASSERT_TRUE(slab->is_empty());
+
+    std::set<char *> chunks;
+    while (void *chunk = slab->get_chunk()) {
+      auto *mem = static_cast<char *>(chunk);
+      ASSERT_GE(mem, reinterpret_cast<char *>(slab + 1));
+      ASSERT_LE(mem + chunk_size, slab_memory.data + memory_slab::SIZE);
+      ASSERT_EQ(reinterpret_cast<uintptr_t>(mem) % 8, 0);
+      ASSERT_TRUE(chunks.insert(mem).second);
+    }
+    ASSERT_TRUE(slab->is_full());
+    // the bitmap overhead is small
+    ASSERT_GE(chunks.size() * chunk_size, memory_slab::SIZE * 9 / 10);
+  }
+}
+
+TEST(memory_slab_test, put_and_get_chunks) {
+  SlabMemory slab_memory;
+  memory_slab *slab = memory_slab::create(&slab_memory, 24);
+
+  std::vector<void *> chunks;
+  while (void *chunk = slab->get_chunk()) {
+    chunks.push_back(chunk);
+  }
+  slab->put_chunk(chunks[600]);
+  slab->put_chunk(chunks[5]);
+  ASSERT_FALSE(slab->is_full());
+  ASSERT_EQ(slab->get_chunk(), chunks[5]);
+  ASSERT_EQ(slab->get_chunk(), chunks[600]);
+  ASSERT_EQ(slab->get_chunk(), nullptr);
+
+  for (void *chunk : chunks) {
+    slab->put_chunk(chunk);
+  }
+  ASSERT_TRUE(slab->is_empty());
+  ASSERT_EQ(slab->get_chunk(), chunks[0]);
+}
+
+TEST(memory_slab_pages_test, epochs) {
+  std::vector<SlabMemory> buffer(4);
+  const size_t marks_size = memory_slab_pages::get_marks_size(buffer.data(), buffer.size() * memory_slab::SIZE);
+  ASSERT_EQ(marks_size, buffer.size());
+  std::vector<uint8_t> marks(marks_size);
+
+  memory_slab_pages pages;
+  ASSERT_FALSE(pages.enabled());
+  ASSERT_FALSE(pages.contains(buffer[1].data));
+
+  pages.init(buffer.data(), marks.data(), marks.size());
+  ASSERT_TRUE(pages.enabled());
+  memory_slab *slab = memory_slab::create(&buffer[1], 8);
+  pages.mark(slab);
+  ASSERT_TRUE(pages.contains(buffer[1].data + 1000));
+  ASSERT_FALSE(pages.contains(buffer[0].data));
+  ASSERT_FALSE(pages.contains(buffer[2].data));
+  ASSERT_FALSE(pages.contains(buffer.data() + buffer.size()));
+
+  for (int i = 0; i < 1000; ++i) {
+    pages.init(buffer.data(), marks.data(), marks.size());
+    ASSERT_FALSE(pages.contains(buffer[1].data + 1000));
+    pages.mark(slab);
+    ASSERT_TRUE(pages.contains(buffer[1].data + 1000));
+  }
+  pages.unmark(slab);
+  ASSERT_FALSE(pages.contains(buffer[1].data + 1000));
+
+  pages.disable();
+  ASSERT_FALSE(pages.enabled());
+}
@@ -1,4 +1,6 @@
 #include <array>
+#include <cstring>
+#include <vector>
 #include <gtest/gtest.h>
 
 #include "runtime/memory_resource/unsynchronized_pool_resource.h"
@@ -292,4 +294,74 @@ TEST(unsynchronized_pool_resource_test, test_auto_defragmentation_small_piece) {
   ASSERT_EQ(mem_stats.small_memory_pieces, 0);
 
   resource.deallocate(mem64, 64);
-}
\ No newline at end of file
+}
+
+TEST(unsynchronized_pool_resource_test, slab_allocation) {
+  std::vector<char> some_memory(1024 * 1024 * 8);
+  memory_resource::unsynchronized_pool_resource resource;
+  resource.init(some_memory.data(), some_memory.size(), 0, true);
+
+  std::vector<void *> pieces;
+  for (size_t i = 0; i < 30000; ++i) {
+    const size_t size = 8 + (i * 7) % 249;
+    void *mem = resource.allocate(size);
+    ASSERT_TRUE(mem);
+    std::memset(mem, static_cast<int>(i), size);
+    pieces.push_back(mem);
+  }
+
+  auto mem_stats = resource.get_memory_stats();
+  size_t slabs = 0;
+  size_t chunks_used = 0;
+  for (const auto &class_stats : mem_stats.slab_classes) {
+    slabs += class_stats.slabs;
+    chunks_used += class_stats.chunks_used;
+  }
+  ASSERT_EQ(chunks_used, pieces.size());
+  ASSERT_GT(slabs, memory_resource::details::memory_slab::SIZE_CLASSES);
+  ASSERT_EQ(mem_stats.small_memory_pieces + mem_stats.huge_memory_pieces, 1); // the gap before the first slab
+  ASSERT_EQ(mem_stats.empty_slabs, 0);
+
+  // the memory of the freed slabs is reused by the other size classes
+  for (size_t i = 0; i < pieces.size(); ++i) {
+    resource.deallocate(pieces[i], 8 + (i * 7) % 249);
+  }
+  mem_stats = resource.get_memory_stats();
+  ASSERT_EQ(mem_stats.memory_used, 0);
+  ASSERT_EQ(mem_stats.empty_slabs + memory_resource::details::memory_slab::SIZE_CLASSES, slabs);
+  const size_t real_memory_used = mem_stats.real_memory_used;
+  pieces.resize(pieces.size() / 2);
+  for (void *&mem : pieces) {
+    mem = resource.allocate(128);
+    ASSERT_TRUE(mem);
+  }
+  ASSERT_EQ(resource.get_memory_stats().real_memory_used, real_memory_used);
+  for (void *mem : pieces) {
+    resource.deallocate(mem, 128);
+  }
+
+  // the empty slabs are merged back by the defragmentation
+  resource.perform_defragmentation();
+  mem_stats = resource.get_memory_stats();
+  ASSERT_EQ(mem_stats.empty_slabs, 0);
+  void *all_mem = resource.allocate(some_memory.size() - 1024 * 1024);
+  ASSERT_TRUE(all_mem);
+  resource.deallocate(all_mem, some_memory.size() - 1024 * 1024);
+}
+
+TEST(unsynchronized_pool_resource_test, slab_pages_after_reinit) {
+  std::vector<char> some_memory(1024 * 1024 * 8);
+  memory_resource::unsynchronized_pool_resource resource;
+  for (int i = 0; i < 300; ++i) {
+    resource.init(some_memory.data(), some_memory.size(), 0, true);
+    // the pieces from the previous init aren't treated as the slab chunks
+    void *huge = resource.allocate(1024 * 1024);
+    ASSERT_TRUE(huge);
+    void *mem = resource.allocate(64);
+    ASSERT_TRUE(mem);
+    resource.deallocate(huge, 1024 * 1024);
+    ASSERT_EQ(resource.get_memory_stats().huge_memory_pieces, 1);
+    resource.deallocate(mem, 64);
+    ASSERT_EQ(resource.get_memory_stats().memory_used, 0);
+  }
+}
@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+
+#include "runtime/kphp_core.h"
+#include "runtime/pdo/pdo_placeholders.h"
+
+namespace {
+
+string rewrite(const char *query, bool backslash_escapes = false) {
+  return pdo::replace_placeholders(string{query}, backslash_escapes, [](const string &name, int64_t position) {
+    return string{"<"}.append(name).append(",").append(position).append(">");
+  });
+}
+
+} // namespace
+
+TEST(pdo_placeholders_test, test_positional_and_named) {
+  ASSERT_STREQ(rewrite("SELECT 1").c_str(), "SELECT 1");
+  ASSERT_STREQ(rewrite("SELECT * FROM t WHERE a = ? AND b = ?").c_str(), "SELECT * FROM t WHERE a = <,0> AND b = <,1>");
+  ASSERT_STREQ(rewrite("UPDATE t SET a = :a_1 WHERE id = :id").c_str(), "UPDATE t SET a = <a_1,0> WHERE id = <id,1>");
+}
+
+TEST(pdo_placeholders_test, test_literals_casts_and_escapes) {
+  ASSERT_STREQ(rewrite("SELECT '?', \":x\", `?` FROM t WHERE a = ?").c_str(), "SELECT '?', \":x\", `?` FROM t WHERE a = <,0>");
+  ASSERT_STREQ(rewrite("SELECT a::text FROM t WHERE b = :b::int").c_str(), "SELECT a::text FROM t WHERE b = <b,0>::int");
+  ASSERT_STREQ(rewrite("SELECT data ?? 'key' FROM t WHERE id = ?").c_str(), "SELECT data ? 'key' FROM t WHERE id = <,0>");
+
+  // a backslash escapes the quote in MySQL only
+  ASSERT_STREQ(rewrite("SELECT 'a\\'?' WHERE a = ?", true).c_str(), "SELECT 'a\\'?' WHERE a = <,0>");
+  ASSERT_STREQ(rewrite("SELECT 'a\\' WHERE a = ?", false).c_str(), "SELECT 'a\\' WHERE a = <,0>");
+}
+
+TEST(pdo_placeholders_test, test_comments) {
+  ASSERT_STREQ(rewrite("SELECT a -- is it :a?\nFROM t WHERE a = ?").c_str(), "SELECT a -- is it :a?\nFROM t WHERE a = <,0>");
+  ASSERT_STREQ(rewrite("SELECT a FROM t -- why?").c_str(), "SELECT a FROM t -- why?");
+  ASSERT_STREQ(rewrite("SELECT /* :a or ? */ a FROM t WHERE a = :a").c_str(), "SELECT /* :a or ? */ a FROM t WHERE a = <a,0>");
+  ASSERT_STREQ(rewrite("SELECT a /* unterminated ?").c_str(), "SELECT a /* unterminated ?");
+
+  // `--` is a comment in MySQL only if it's followed by a whitespace
+  ASSERT_STREQ(rewrite("SELECT a--? FROM t", true).c_str(), "SELECT a--<,0> FROM t");
+  ASSERT_STREQ(rewrite("SELECT a -- ?\nFROM t WHERE a = ?", true).c_str(), "SELECT a -- ?\nFROM t WHERE a = <,0>");
+}
+
+TEST(pdo_placeholders_test, test_dollar_quotes) {
+  ASSERT_STREQ(rewrite("SELECT $$ ? :a $$, ?").c_str(), "SELECT $$ ? :a $$, <,0>");
+  ASSERT_STREQ(rewrite("SELECT $fn$ $$ ? $fn$ WHERE a = :a").c_str(), "SELECT $fn$ $$ ? $fn$ WHERE a = <a,0>");
+  ASSERT_STREQ(rewrite("SELECT $body$ ? :a").c_str(), "SELECT $body$ ? :a");
+
+  // positional pgSQL parameters and identifiers with `$` aren't dollar quotes
+  ASSERT_STREQ(rewrite("SELECT $1, a$b$ FROM t WHERE a = ?").c_str(), "SELECT $1, a$b$ FROM t WHERE a = <,0>");
+  // there are no dollar quotes in MySQL
+  ASSERT_STREQ(rewrite("SELECT '$$', ? $$", true).c_str(), "SELECT '$$', <,0> $$");
+}
+
+TEST(pdo_placeholders_test, test_find_bound_param) {
+  array<mixed> positional;
+  positional.push_back(string{"x"});
+  ASSERT_NE(pdo::find_bound_param(positional, string{}, 0), nullptr);
+  ASSERT_EQ(pdo::find_bound_param(positional, string{}, 1), nullptr);
+
+  array<mixed> named;
+  named.set_value(string{"a"}, 1);
+  named.set_value(string{":b"}, 2);
+  ASSERT_EQ(pdo::find_bound_param(named, string{"a"}, 0)->to_int(), 1);
+  ASSERT_EQ(pdo::find_bound_param(named, string{"b"}, 1)->to_int(), 2);
+  ASSERT_EQ(pdo::find_bound_param(named, string{"c"}, 2), nullptr);
+}
@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+
+#include "runtime/regexp.h"
+
+namespace {
+
+constexpr size_t DEFAULT_MEMORY_LIMIT = 16 * 1024 * 1024;
+
+string make_pattern(const char *prefix, int64_t i) {
+  return string{"/"}.append(prefix).append(i).append("+/");
+}
+
+// starts from the empty worker cache
+void reset_worker_cache(size_t memory_limit) {
+  set_regexp_worker_cache_memory_limit(0);
+  free_regexp_lib();
+  set_regexp_worker_cache_memory_limit(memory_limit);
+}
+
+// compiles the pattern and returns whether it was found in the worker cache
+bool is_cache_hit(const string &pattern) {
+  const auto hits_before = get_regexp_worker_cache_stats().hits;
+  regexp re{pattern};
+  return get_regexp_worker_cache_stats().hits != hits_before;
+}
+
+// the pattern is admitted into the worker cache on its second miss
+void put_into_cache(const string &pattern) {
+  regexp{pattern};
+  regexp{pattern};
+}
+
+// the memory taken by one cached regexp, the patterns of the same shape take the same memory
+size_t get_entry_memory_usage(const string &pattern) {
+  const auto memory_usage_before = get_regexp_worker_cache_stats().memory_usage;
+  put_into_cache(pattern);
+  return get_regexp_worker_cache_stats().memory_usage - memory_usage_before;
+}
+
+} // namespace
+
+TEST(regexp_test, worker_cache_admits_on_second_miss) {
+  reset_worker_cache(DEFAULT_MEMORY_LIMIT);
+  const string pattern{"/admitted+/"};
+  ASSERT_FALSE(is_cache_hit(pattern));
+  ASSERT_FALSE(is_cache_hit(pattern));
+  ASSERT_TRUE(is_cache_hit(pattern));
+
+  // the patterns used once don't get into the cache
+  const auto size_before = get_regexp_worker_cache_stats().size;
+  for (int64_t i = 0; i < 100; ++i) {
+    regexp re{make_pattern("once_", i)};
+    ASSERT_EQ(f$preg_match(re, string{"once_"}.append(i)).val(), 1);
+  }
+  ASSERT_EQ(get_regexp_worker_cache_stats().size, size_before);
+  ASSERT_TRUE(is_cache_hit(pattern));
+
+  free_regexp_lib();
+}
+
+TEST(regexp_test, worker_cache_is_limited_by_memory) {
+  reset_worker_cache(DEFAULT_MEMORY_LIMIT);
+  const size_t entry_memory_usage = get_entry_memory_usage(make_pattern("limited_", 10));
+  ASSERT_GT(entry_memory_usage, 0);
+  set_regexp_worker_cache_memory_limit(entry_memory_usage * 2);
+  const auto stats_before = get_regexp_worker_cache_stats();
+
+  for (int64_t i = 11; i <= 20; ++i) {
+    const string pattern = make_pattern("limited_", i);
+    put_into_cache(pattern);
+    regexp re{pattern};
+    ASSERT_EQ(f$preg_match(re, string{"limited_"}.append(i)).val(), 1);
+  }
+
+  const auto stats = get_regexp_worker_cache_stats();
+  ASSERT_EQ(stats.size, 2);
+  ASSERT_LE(stats.memory_usage, entry_memory_usage * 2);
+  ASSERT_EQ(stats.misses - stats_before.misses, 20);
+  ASSERT_EQ(stats.evictions - stats_before.evictions, 9);
+  free_regexp_lib();
+  set_regexp_worker_cache_memory_limit(DEFAULT_MEMORY_LIMIT);
+}
+
+TEST(regexp_test, worker_cache_keeps_hit_regexps) {
+  reset_worker_cache(DEFAULT_MEMORY_LIMIT);
+  const string hot_pattern = make_pattern("hott_", 0);
+  set_regexp_worker_cache_memory_limit(get_entry_memory_usage(hot_pattern) * 2);
+
+  for (int64_t i = 0; i < 10; ++i) {
+    ASSERT_TRUE(is_cache_hit(hot_pattern));
+    put_into_cache(make_pattern("cold_", i));
+  }
+  ASSERT_TRUE(is_cache_hit(hot_pattern));
+  ASSERT_TRUE(is_cache_hit(make_pattern("cold_", 9)));
+  ASSERT_FALSE(is_cache_hit(make_pattern("cold_", 0)));
+
+  free_regexp_lib();
+  set_regexp_worker_cache_memory_limit(DEFAULT_MEMORY_LIMIT);
+}
+
+TEST(regexp_test, worker_cache_keeps_failed_compilations) {
+  reset_worker_cache(DEFAULT_MEMORY_LIMIT);
+  const string broken_pattern{"/(unclosed+/"};
+  put_into_cache(broken_pattern);
+
+  // the failed compilation is found in the cache and isn't compiled again
+  ASSERT_TRUE(is_cache_hit(broken_pattern));
+  regexp re{broken_pattern};
+  ASSERT_FALSE(f$preg_match(re, string{"unclosed"}).has_value());
+
+  free_regexp_lib();
+}
+
+TEST(regexp_test, evicted_regexp_is_usable_until_request_end) {
+  reset_worker_cache(DEFAULT_MEMORY_LIMIT);
+  const string named_pattern{"/(?<name>evicted+)/"};
+  set_regexp_worker_cache_memory_limit(get_entry_memory_usage(named_pattern));
+  {
+    regexp named{named_pattern};
+    const auto evictions_before = get_regexp_worker_cache_stats().evictions;
+    put_into_cache(make_pattern("other_", 0));
+    put_into_cache(make_pattern("other_", 1));
+    ASSERT_GE(get_regexp_worker_cache_stats().evictions - evictions_before, 1);
+
+    // the evicted regexp is destroyed after the request only
+    mixed matches;
+    ASSERT_EQ(f$preg_match(named, string{"evictedddd"}, matches).val(), 1);
+    ASSERT_EQ(matches.as_array().get_value(string{"name"}).to_string(), string{"evictedddd"});
+    ASSERT_EQ(matches.as_array().get_value(1).to_string(), string{"evictedddd"});
+  }
+  free_regexp_lib();
+  ASSERT_FALSE(is_cache_hit(named_pattern));
+
+  free_regexp_lib();
+  set_regexp_worker_cache_memory_limit(DEFAULT_MEMORY_LIMIT);
+}
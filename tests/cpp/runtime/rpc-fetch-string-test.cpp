@@ -0,0 +1,184 @@
+#include <gtest/gtest.h>
+
+#include "runtime/instance-cache.h"
+#include "runtime/kphp_core.h"
+#include "runtime/refcountable_php_classes.h"
+#include "runtime/rpc.h"
+
+namespace {
+
+constexpr int32_t ANSWER_MAGIC = 0x12345678;
+
+struct C$AnswerItem : public refcountable_php_classes<C$AnswerItem> {
+  string $data;
+
+  const char *get_class() const noexcept {
+    return "AnswerItem";
+  }
+
+  int get_hash() const noexcept {
+    return 0;
+  }
+
+  template<class Visitor>
+  void generic_accept(Visitor &&visitor) noexcept {
+    visitor("data", $data);
+  }
+
+  void accept(InstanceReferencesCountingVisitor &visitor) noexcept {
+    generic_accept(visitor);
+  }
+
+  void accept(InstanceDeepCopyVisitor &visitor) noexcept {
+    generic_accept(visitor);
+  }
+
+  void accept(InstanceDeepDestroyVisitor &visitor) noexcept {
+    generic_accept(visitor);
+  }
+};
+
+using AnswerItem = class_instance<C$AnswerItem>;
+
+string make_payload(int len, char c) {
+  return string{static_cast<string::size_type>(len), c};
+}
+
+// an int magic followed by a TL string, the answer is built in a temporary so that the parser owns it exclusively
+string make_answer(const string &payload) {
+  string answer;
+  answer.append(reinterpret_cast<const char *>(&ANSWER_MAGIC), sizeof(ANSWER_MAGIC));
+  const uint32_t len = payload.size();
+  if (len < 254) {
+    answer.push_back(static_cast<char>(len));
+  } else {
+    answer.push_back(static_cast<char>(254));
+    answer.push_back(static_cast<char>(len & 0xff));
+    answer.push_back(static_cast<char>((len >> 8) & 0xff));
+    answer.push_back(static_cast<char>((len >> 16) & 0xff));
+  }
+  answer.append(payload);
+  while (answer.size() % 4) {
+    answer.push_back('\0');
+  }
+  return answer;
+}
+
+string fetch_answer_string(const string &payload) {
+  EXPECT_TRUE(f$rpc_parse(make_answer(payload)));
+  EXPECT_EQ(f$fetch_int(), ANSWER_MAGIC);
+  return f$fetch_string();
+}
+
+bool is_fetched_in_place(const string &str) {
+  return str.is_reference_counter(ExtraRefCnt::for_rpc_answer);
+}
+
+} // namespace
+
+TEST(rpc_fetch_string_test, large_string_is_fetched_in_place) {
+  const string payload = make_payload(5001, 'a');
+  const string fetched = fetch_answer_string(payload);
+  ASSERT_TRUE(is_fetched_in_place(fetched));
+  ASSERT_EQ(fetched.size(), payload.size());
+  ASSERT_EQ(fetched, payload);
+  ASSERT_EQ(fetched.c_str()[fetched.size()], '\0');
+}
+
+TEST(rpc_fetch_string_test, small_string_is_copied) {
+  const string payload = make_payload(1001, 'b');
+  const string fetched = fetch_answer_string(payload);
+  ASSERT_FALSE(is_fetched_in_place(fetched));
+  ASSERT_EQ(fetched, payload);
+}
+
+TEST(rpc_fetch_string_test, string_without_padding_is_copied) {
+  // there is no padding byte for the terminating zero
+  const string payload = make_payload(8192, 'c');
+  const string fetched = fetch_answer_string(payload);
+  ASSERT_FALSE(is_fetched_in_place(fetched));
+  ASSERT_EQ(fetched, payload);
+}
+
+TEST(rpc_fetch_string_test, shared_answer_is_copied) {
+  const string payload = make_payload(5001, 'd');
+  const string answer = make_answer(payload);
+  ASSERT_TRUE(f$rpc_parse(answer));
+  ASSERT_EQ(f$fetch_int(), ANSWER_MAGIC);
+  const string fetched = f$fetch_string();
+  ASSERT_FALSE(is_fetched_in_place(fetched));
+  ASSERT_EQ(fetched, payload);
+  ASSERT_EQ(answer, make_answer(payload));
+}
+
+TEST(rpc_fetch_string_test, changed_string_is_copied) {
+  const string payload = make_payload(5001, 'e');
+  string fetched = fetch_answer_string(payload);
+  ASSERT_TRUE(is_fetched_in_place(fetched));
+  const string other = fetched;
+  ASSERT_EQ(other.c_str(), fetched.c_str());
+
+  fetched.append("!", 1);
+  ASSERT_FALSE(is_fetched_in_place(fetched));
+  ASSERT_EQ(fetched.get_reference_counter(), 1);
+  ASSERT_NE(fetched.c_str(), other.c_str());
+  ASSERT_EQ(fetched, string{payload}.append("!", 1));
+
+  ASSERT_TRUE(is_fetched_in_place(other));
+  ASSERT_EQ(other, payload);
+}
+
+TEST(rpc_fetch_string_test, rewind_before_pinned_string_is_refused) {
+  const string payload = make_payload(5001, 'f');
+  ASSERT_TRUE(f$rpc_parse(make_answer(payload)));
+  ASSERT_TRUE(rpc_set_pos(0));
+  ASSERT_EQ(f$fetch_int(), ANSWER_MAGIC);
+  const string fetched = f$fetch_string();
+  ASSERT_TRUE(is_fetched_in_place(fetched));
+
+  const int32_t end_pos = rpc_get_pos();
+  ASSERT_FALSE(rpc_set_pos(0));
+  ASSERT_FALSE(rpc_set_pos(1));
+  ASSERT_EQ(rpc_get_pos(), end_pos);
+  ASSERT_TRUE(rpc_set_pos(end_pos));
+  ASSERT_EQ(fetched, payload);
+}
+
+TEST(rpc_fetch_string_test, instance_cache_deep_copies_pinned_string) {
+  const string payload = make_payload(5001, 'g');
+  AnswerItem item;
+  item.alloc();
+  item->$data = fetch_answer_string(payload);
+  ASSERT_TRUE(is_fetched_in_place(item->$data));
+
+  const string key{"rpc_fetch_string_test_key"};
+  ASSERT_TRUE(f$instance_cache_store(key, item));
+  const AnswerItem cached = f$instance_cache_fetch<AnswerItem>(string{"AnswerItem"}, key);
+  ASSERT_FALSE(cached.is_null());
+  ASSERT_TRUE(cached->$data.is_reference_counter(ExtraRefCnt::for_instance_cache));
+  ASSERT_NE(cached->$data.c_str(), item->$data.c_str());
+  ASSERT_EQ(cached->$data, payload);
+  ASSERT_TRUE(f$instance_cache_delete(key));
+}
+
+TEST(rpc_fetch_string_test, pinned_answers_are_limited) {
+  // the pinned answers take at most 1/8 of the script memory limit, the next strings are copied
+  const size_t pinned_limit = dl::get_script_memory_stats().memory_limit / 8;
+  const int len = static_cast<int>(pinned_limit / 3) | 1;
+  const string payload = make_payload(len, 'h');
+
+  array<string> fetched_strings;
+  int pinned = 0;
+  for (int i = 0; i < 8; ++i) {
+    const string fetched = fetch_answer_string(payload);
+    ASSERT_EQ(fetched, payload);
+    if (is_fetched_in_place(fetched)) {
+      ASSERT_EQ(pinned, i);
+      ++pinned;
+    }
+    fetched_strings.push_back(fetched);
+  }
+  ASSERT_GE(pinned, 1);
+  ASSERT_LE(pinned * static_cast<size_t>(len), pinned_limit);
+  ASSERT_LT(pinned, 8);
+}
@@ -1,23 +1,31 @@
 prepend(RUNTIME_TESTS_SOURCES ${BASE_DIR}/tests/cpp/runtime/
         _runtime-tests-env.cpp
+        _runtime-tests-linkage.cpp
         allocator-malloc-replacement-test.cpp
         array-test.cpp
         common-php-functions-test.cpp
         confdata-functions-test.cpp
+        confdata-hash-index-test.cpp
         confdata-key-maker-test.cpp
         confdata-predefined-wildcards-test.cpp
+        curl-connections-stats-test.cpp
         flex-test.cpp
+        instance-cache-test.cpp
         inter-process-mutex-test.cpp
         inter-process-resource-test.cpp
         json-writer-test.cpp
         number-string-comparison.cpp
+        pdo-placeholders-test.cpp
+        regexp-test.cpp
         kphp-type-traits-test.cpp
         msgpack-test.cpp
         memory_resource/details/memory_chunk_list-test.cpp
         memory_resource/details/memory_chunk_tree-test.cpp
         memory_resource/details/memory_ordered_chunk_list-test.cpp
+        memory_resource/details/memory_slab-test.cpp
         memory_resource/extra-memory-pool-test.cpp
         memory_resource/unsynchronized_pool_resource-test.cpp
+        rpc-fetch-string-test.cpp
         string-list-test.cpp
         string-test.cpp
         zstd-test.cpp)
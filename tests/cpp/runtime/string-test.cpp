@@ -158,4 +158,57 @@ TEST(string_test, test_hex_to_int) {
   ASSERT_EQ(hex_to_int('D'), 13);
   ASSERT_EQ(hex_to_int('E'), 14);
   ASSERT_EQ(hex_to_int('F'), 15);
-}
\ No newline at end of file
+}
+
+TEST(string_test, test_hash_cache) {
+  string str1{"hello world, this is a long string key"};
+  const int64_t expected_hash = string_hash(str1.c_str(), str1.size());
+  ASSERT_EQ(str1.hash(), expected_hash);
+
+  string str2 = str1;
+  ASSERT_EQ(str1.hash(), expected_hash);
+  ASSERT_EQ(str2.hash(), expected_hash);
+
+  str2 = string{};
+  str1.append("!");
+  ASSERT_EQ(str1.hash(), string_hash(str1.c_str(), str1.size()));
+
+  str2 = str1;
+  ASSERT_EQ(str2.hash(), string_hash(str1.c_str(), str1.size()));
+}
+
+TEST(string_test, test_hash_is_aligned) {
+  // the cached hash goes first in the string header
+  const auto is_header_aligned = [](const string &str) {
+    return (reinterpret_cast<uintptr_t>(str.c_str()) - string::inner_sizeof()) % alignof(int64_t) == 0;
+  };
+  ASSERT_TRUE(is_header_aligned(string{"hello world, this is a long string key"}));
+  ASSERT_TRUE(is_header_aligned(string{}));
+  ASSERT_TRUE(is_header_aligned(string{1, 'a'}));
+  ASSERT_TRUE(is_header_aligned(string{1, 'b'}));
+  ASSERT_TRUE(is_header_aligned(string{int64_t{7}}));
+  ASSERT_TRUE(is_header_aligned(string{int64_t{1234567}}));
+}
+
+TEST(string_test, test_hash_of_strings_with_extra_ref_cnt) {
+  const auto cached_hash = [](const string &str) {
+    int64_t hash = 0;
+    memcpy(&hash, str.c_str() - string::inner_sizeof(), sizeof(hash));
+    return hash;
+  };
+
+  string str{"hello world, this is a long string key"};
+  str.set_reference_counter_to(ExtraRefCnt::for_instance_cache);
+  // the hash is computed on the first use only
+  ASSERT_EQ(cached_hash(str), 0);
+  ASSERT_EQ(str.hash(), string_hash(str.c_str(), str.size()));
+  ASSERT_EQ(cached_hash(str), str.hash());
+  str.force_destroy(ExtraRefCnt::for_instance_cache);
+
+  // the cached strings are in read only memory, their hash isn't cached
+  const string cached_int{int64_t{42}};
+  ASSERT_EQ(cached_int.hash(), string_hash("42", 2));
+  ASSERT_EQ(cached_hash(cached_int), 0);
+  const string cached_char{1, 'z'};
+  ASSERT_EQ(cached_char.hash(), string_hash("z", 1));
+}
@@ -1,8 +1,10 @@
+#include <algorithm>
 #include <gtest/gtest.h>
 
 #include <zstd.h>
 
 #include "runtime/string_functions.h"
+#include "runtime/zstd.h"
 
 TEST(zstd_test, test_bounds) {
   ASSERT_LE(ZSTD_CStreamOutSize(), PHP_BUF_LEN);
@@ -11,3 +13,104 @@ TEST(zstd_test, test_bounds) {
   ASSERT_LE(ZSTD_DStreamOutSize(), PHP_BUF_LEN);
   ASSERT_LE(ZSTD_DStreamInSize(), PHP_BUF_LEN);
 }
+
+TEST(zstd_test, test_compress_dict_roundtrip) {
+  const string dict{"foo bar baz qux quux corge grault garply waldo fred plugh xyzzy thud"};
+  const string data{"foo bar baz waldo fred foo bar baz waldo fred xyzzy"};
+
+  for (int64_t level : {1, 3, 19}) {
+    const Optional<string> compressed = f$zstd_compress_dict(data, dict, level);
+    ASSERT_TRUE(compressed.has_value());
+    // the digested dictionary and the context are reused, the result must not change
+    ASSERT_EQ(f$zstd_compress_dict(data, dict, level).val(), compressed.val());
+
+    const Optional<string> uncompressed = f$zstd_uncompress_dict(compressed.val(), dict);
+    ASSERT_TRUE(uncompressed.has_value());
+    ASSERT_EQ(uncompressed.val(), data);
+  }
+
+  const Optional<string> compressed = f$zstd_compress(data);
+  ASSERT_TRUE(compressed.has_value());
+  ASSERT_EQ(f$zstd_uncompress(compressed.val()).val(), data);
+  free_zstd_lib();
+}
+
+TEST(zstd_test, test_dict_handle) {
+  const string dict{"first dictionary: alpha beta gamma delta epsilon"};
+  const string other_dict{"second dictionary: one two three four five six"};
+  const string data{"alpha beta gamma delta epsilon alpha beta gamma"};
+
+  const int64_t dict_id = f$zstd_dict_load(dict);
+  const int64_t other_dict_id = f$zstd_dict_load(other_dict);
+  ASSERT_GT(dict_id, 0);
+  ASSERT_GT(other_dict_id, 0);
+  ASSERT_NE(dict_id, other_dict_id);
+
+  const Optional<string> compressed = f$zstd_compress_with_dict(data, dict_id);
+  ASSERT_TRUE(compressed.has_value());
+  ASSERT_EQ(compressed.val(), f$zstd_compress_dict(data, dict).val());
+  ASSERT_EQ(f$zstd_uncompress_with_dict(compressed.val(), dict_id).val(), data);
+  ASSERT_EQ(f$zstd_uncompress_dict(compressed.val(), dict).val(), data);
+
+  free_zstd_lib();
+  ASSERT_FALSE(f$zstd_compress_with_dict(data, dict_id).has_value());
+}
+
+TEST(zstd_test, test_stream_roundtrip) {
+  string data;
+  for (int i = 0; i < 20000; ++i) {
+    data.append("line ").append(static_cast<int64_t>(i)).append(i % 7 ? " foo bar\n" : " baz\n");
+  }
+
+  array<mixed> options;
+  options.set_value(string{"level"}, 5);
+  options.set_value(string{"window_log"}, 20);
+  options.set_value(string{"long_distance_matching"}, true);
+  const auto compressor = f$zstd_stream_init(ZSTD_STREAM_COMPRESS, options);
+  ASSERT_FALSE(compressor.is_null());
+
+  string compressed;
+  const string::size_type chunk_size = 1000;
+  for (string::size_type pos = 0; pos < data.size(); pos += chunk_size) {
+    const Optional<string> output = f$zstd_stream_add(compressor, data.substr(pos, std::min(chunk_size, data.size() - pos)));
+    ASSERT_TRUE(output.has_value());
+    compressed.append(output.val());
+  }
+  const Optional<string> tail = f$zstd_stream_finish(compressor);
+  ASSERT_TRUE(tail.has_value());
+  compressed.append(tail.val());
+  ASSERT_LT(compressed.size(), data.size());
+
+  // the frame is a regular one
+  ASSERT_EQ(f$zstd_uncompress(compressed).val(), data);
+
+  const auto decompressor = f$zstd_stream_init(ZSTD_STREAM_DECOMPRESS);
+  ASSERT_FALSE(decompressor.is_null());
+  string uncompressed;
+  for (string::size_type pos = 0; pos < compressed.size(); pos += 100) {
+    const Optional<string> output = f$zstd_stream_add(decompressor, compressed.substr(pos, std::min(100U, compressed.size() - pos)));
+    ASSERT_TRUE(output.has_value());
+    uncompressed.append(output.val());
+  }
+  const Optional<string> decompressed_tail = f$zstd_stream_finish(decompressor);
+  ASSERT_TRUE(decompressed_tail.has_value());
+  uncompressed.append(decompressed_tail.val());
+  ASSERT_EQ(uncompressed, data);
+
+  // the contexts are ready for the next frame
+  const Optional<string> next_frame = f$zstd_stream_finish(compressor, string{"next frame"});
+  ASSERT_TRUE(next_frame.has_value());
+  ASSERT_EQ(f$zstd_stream_finish(decompressor, next_frame.val()).val(), string{"next frame"});
+}
+
+TEST(zstd_test, test_stream_incomplete_frame) {
+  const Optional<string> compressed = f$zstd_compress(string{"some data to be truncated"});
+  ASSERT_TRUE(compressed.has_value());
+
+  const auto decompressor = f$zstd_stream_init(ZSTD_STREAM_DECOMPRESS);
+  ASSERT_FALSE(decompressor.is_null());
+  ASSERT_FALSE(f$zstd_stream_finish(decompressor, compressed.val().substr(0, compressed.val().size() - 2)).has_value());
+  ASSERT_EQ(f$zstd_stream_finish(decompressor, compressed.val()).val(), string{"some data to be truncated"});
+
+  ASSERT_TRUE(f$zstd_stream_init(42).is_null());
+}
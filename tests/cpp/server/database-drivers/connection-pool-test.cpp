@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "server/database-drivers/connection-pool.h"
+
+using database_drivers::ConnectionPool;
+using database_drivers::PooledConnection;
+
+namespace {
+
+class SocketPairConnection final : public PooledConnection {
+public:
+  SocketPairConnection() noexcept {
+    socketpair(AF_UNIX, SOCK_STREAM, 0, fds_);
+  }
+
+  ~SocketPairConnection() noexcept final {
+    close(fds_[0]);
+    close_server_side();
+  }
+
+  int get_fd() const noexcept final {
+    return fds_[0];
+  }
+
+  void close_server_side() noexcept {
+    if (fds_[1] != -1) {
+      close(fds_[1]);
+      fds_[1] = -1;
+    }
+  }
+
+private:
+  int fds_[2]{-1, -1};
+};
+
+} // namespace
+
+TEST(connection_pool_test, test_acquire_by_key) {
+  auto &pool = vk::singleton<ConnectionPool>::get();
+  pool.clear();
+  pool.set_max_idle_connections(8);
+  pool.set_idle_timeout(60);
+
+  ASSERT_EQ(pool.acquire("mysql:a"), nullptr);
+
+  auto connection = std::make_unique<SocketPairConnection>();
+  const int fd = connection->get_fd();
+  pool.release("mysql:a", std::move(connection));
+  ASSERT_EQ(pool.get_stats().idle_connections, 1);
+
+  ASSERT_EQ(pool.acquire("mysql:b"), nullptr);
+  auto acquired = pool.acquire("mysql:a");
+  ASSERT_NE(acquired, nullptr);
+  ASSERT_EQ(acquired->get_fd(), fd);
+  ASSERT_EQ(pool.get_stats().idle_connections, 0);
+  ASSERT_EQ(pool.acquire("mysql:a"), nullptr);
+}
+
+TEST(connection_pool_test, test_closed_by_server) {
+  auto &pool = vk::singleton<ConnectionPool>::get();
+  pool.clear();
+  pool.set_max_idle_connections(8);
+  pool.set_idle_timeout(60);
+  const auto failures = pool.get_stats().health_check_failures;
+
+  auto connection = std::make_unique<SocketPairConnection>();
+  connection->close_server_side();
+  pool.release("pgsql:a", std::move(connection));
+
+  ASSERT_EQ(pool.acquire("pgsql:a"), nullptr);
+  ASSERT_EQ(pool.get_stats().health_check_failures, failures + 1);
+  ASSERT_EQ(pool.get_stats().idle_connections, 0);
+}
+
+TEST(connection_pool_test, test_session_reset) {
+  auto &pool = vk::singleton<ConnectionPool>::get();
+  pool.clear();
+  pool.set_max_idle_connections(8);
+  pool.set_idle_timeout(60);
+  const auto reset_failures = pool.get_stats().session_reset_failures;
+  const auto health_check_failures = pool.get_stats().health_check_failures;
+
+  auto connection = std::make_unique<SocketPairConnection>();
+  const int fd = connection->get_fd();
+  pool.release("pgsql:a", std::move(connection));
+
+  // the session is reset by the connector after the acquire, so the acquire doesn't touch the server
+  auto acquired = pool.acquire("pgsql:a");
+  ASSERT_NE(acquired, nullptr);
+  ASSERT_EQ(acquired->get_fd(), fd);
+  ASSERT_EQ(pool.get_stats().health_check_failures, health_check_failures);
+  ASSERT_EQ(pool.get_stats().session_reset_failures, reset_failures);
+
+  pool.on_session_reset_failure();
+  ASSERT_EQ(pool.get_stats().session_reset_failures, reset_failures + 1);
+  ASSERT_EQ(pool.get_stats().idle_connections, 0);
+}
+
+TEST(connection_pool_test, test_max_idle_and_timeout) {
+  auto &pool = vk::singleton<ConnectionPool>::get();
+  pool.clear();
+  pool.set_max_idle_connections(2);
+  pool.set_idle_timeout(60);
+
+  for (int i = 0; i < 3; ++i) {
+    pool.release("mysql:a", std::make_unique<SocketPairConnection>());
+  }
+  ASSERT_EQ(pool.get_stats().idle_connections, 2);
+
+  pool.set_idle_timeout(0);
+  usleep(1000);
+  pool.close_expired();
+  ASSERT_EQ(pool.get_stats().idle_connections, 0);
+
+  pool.set_max_idle_connections(0);
+  pool.release("mysql:a", std::make_unique<SocketPairConnection>());
+  ASSERT_EQ(pool.get_stats().idle_connections, 0);
+}
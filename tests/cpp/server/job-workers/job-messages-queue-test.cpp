@@ -0,0 +1,144 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2023 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include <array>
+#include <atomic>
+#include <gtest/gtest.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "common/macos-ports.h"
+
+#include "server/job-workers/job-message.h"
+#include "server/job-workers/job-messages-queue.h"
+
+using namespace job_workers;
+
+namespace {
+
+constexpr uint32_t MESSAGES_COUNT = 100;
+
+// the messages are only counted by the queue, so their memory isn't touched
+JobSharedMessage *get_messages() {
+  static auto *messages = static_cast<JobSharedMessage *>(mmap(nullptr, sizeof(JobSharedMessage) * MESSAGES_COUNT, PROT_NONE,
+                                                               MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0));
+  return messages;
+}
+
+JobMessagesQueue *create_queue(void *mem, uint32_t capacity) {
+  return JobMessagesQueue::create(mem, capacity, get_messages());
+}
+
+} // namespace
+
+TEST(job_messages_queue_test, test_fifo) {
+  std::vector<uint8_t> mem(JobMessagesQueue::get_memory_size(MESSAGES_COUNT) + 64);
+  auto *queue = create_queue(mem.data() + 64 - reinterpret_cast<uintptr_t>(mem.data()) % 64, MESSAGES_COUNT);
+  ASSERT_EQ(queue->capacity(), 128);
+  ASSERT_TRUE(queue->empty());
+  ASSERT_EQ(queue->pop(), nullptr);
+
+  JobSharedMessage *messages = get_messages();
+  for (int lap = 0; lap != 10; ++lap) {
+    for (uint32_t i = 0; i != MESSAGES_COUNT; ++i) {
+      ASSERT_TRUE(queue->push(messages + i));
+    }
+    ASSERT_FALSE(queue->empty());
+    for (uint32_t i = 0; i != MESSAGES_COUNT; ++i) {
+      ASSERT_EQ(queue->pop(), messages + i);
+    }
+    ASSERT_TRUE(queue->empty());
+    ASSERT_EQ(queue->pop(), nullptr);
+  }
+}
+
+TEST(job_messages_queue_test, test_overflow) {
+  std::vector<uint8_t> mem(JobMessagesQueue::get_memory_size(4) + 64);
+  auto *queue = create_queue(mem.data() + 64 - reinterpret_cast<uintptr_t>(mem.data()) % 64, 3);
+  ASSERT_EQ(queue->capacity(), 4);
+
+  JobSharedMessage *messages = get_messages();
+  for (uint32_t i = 0; i != 4; ++i) {
+    ASSERT_TRUE(queue->push(messages + i));
+  }
+  ASSERT_FALSE(queue->push(messages + 4));
+  ASSERT_EQ(queue->pop(), messages);
+  ASSERT_TRUE(queue->push(messages + 4));
+  for (uint32_t i = 1; i != 5; ++i) {
+    ASSERT_EQ(queue->pop(), messages + i);
+  }
+  ASSERT_EQ(queue->pop(), nullptr);
+}
+
+TEST(job_messages_queue_test, test_processes) {
+  constexpr int PRODUCERS = 4;
+  constexpr int CONSUMERS = 4;
+  constexpr uint32_t MESSAGES_PER_PRODUCER = MESSAGES_COUNT / PRODUCERS;
+  constexpr uint32_t ROUNDS = 1000;
+
+  struct SharedState {
+    std::array<std::atomic<uint32_t>, MESSAGES_COUNT> popped{};
+    std::atomic<uint32_t> popped_total{0};
+  };
+  const size_t queue_size = (JobMessagesQueue::get_memory_size(MESSAGES_COUNT) + 63) & ~size_t{63};
+  void *mem = mmap(nullptr, queue_size + sizeof(SharedState), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  ASSERT_NE(mem, MAP_FAILED);
+  auto *queue = create_queue(mem, MESSAGES_COUNT);
+  auto *state = new(static_cast<uint8_t *>(mem) + queue_size) SharedState{};
+
+  std::vector<pid_t> children;
+  for (int producer = 0; producer != PRODUCERS; ++producer) {
+    const pid_t child_pid = fork();
+    if (!child_pid) {
+      prctl(PR_SET_PDEATHSIG, SIGKILL);
+      // each message is pushed again as soon as it's popped, as it's done with the job messages
+      JobSharedMessage *messages = get_messages() + producer * MESSAGES_PER_PRODUCER;
+      for (uint32_t round = 0; round != ROUNDS; ++round) {
+        for (uint32_t i = 0; i != MESSAGES_PER_PRODUCER; ++i) {
+          const uint32_t message_id = producer * MESSAGES_PER_PRODUCER + i;
+          while (state->popped[message_id].load() != round) {
+            sched_yield();
+          }
+          if (!queue->push(messages + i)) {
+            _exit(1);
+          }
+        }
+      }
+      _exit(0);
+    }
+    children.emplace_back(child_pid);
+  }
+
+  for (int consumer = 0; consumer != CONSUMERS; ++consumer) {
+    const pid_t child_pid = fork();
+    if (!child_pid) {
+      prctl(PR_SET_PDEATHSIG, SIGKILL);
+      while (state->popped_total.load() != MESSAGES_COUNT * ROUNDS) {
+        if (JobSharedMessage *message = queue->pop()) {
+          ++state->popped[message - get_messages()];
+          ++state->popped_total;
+        } else {
+          sched_yield();
+        }
+      }
+      _exit(0);
+    }
+    children.emplace_back(child_pid);
+  }
+
+  for (pid_t child_pid : children) {
+    int status = 0;
+    ASSERT_GE(waitpid(child_pid, &status, 0), 0);
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(WEXITSTATUS(status), 0);
+  }
+
+  for (const auto &popped : state->popped) {
+    ASSERT_EQ(popped.load(), ROUNDS);
+  }
+  ASSERT_TRUE(queue->empty());
+  munmap(mem, queue_size + sizeof(SharedState));
+}
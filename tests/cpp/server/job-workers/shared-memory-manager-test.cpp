@@ -119,7 +119,8 @@ TEST(shared_memory_manager_test, test_manager) {
 
   const auto &stats = SHMM::get().get_stats();
   ASSERT_EQ(stats.memory_limit, 256 * 1024 * 1024);
-  ASSERT_GT(stats.unused_memory, 980000); // 1mb == 1 048 576
+  // the control block holds the job results wakeup flag of each worker
+  ASSERT_GT(stats.unused_memory, 970000); // 1mb == 1 048 576
   ASSERT_LT(stats.unused_memory, 1048576);
 
   std::array<pid_t, 5> children{};
@@ -156,4 +157,98 @@ TEST(shared_memory_manager_test, test_manager) {
   ASSERT_BUFFER(stats.extra_memory[5], 2, 0);
   // 64mb
   ASSERT_BUFFER(stats.extra_memory[6], 2, 0);
+
+  // the message sizes are counted on release
+  size_t released_messages = 0;
+  for (const auto &count : stats.message_sizes) {
+    released_messages += count;
+  }
+  ASSERT_EQ(released_messages, 150000);
+  ASSERT_EQ(stats.message_sizes[0], 150000);
+
+  auto *message = SHMM::get().acquire_shared_message<job_workers::JobSharedMessage>();
+  check_new_message(message);
+  // 1mb x 8 and one more, which is taken from 2mb
+  for (int i = 0; i != 9; ++i) {
+    ASSERT_TRUE(SHMM::get().request_extra_memory_for_resource(message->resource, 800 * 1024));
+  }
+  // 64mb x 2, the third one is failed
+  for (int i = 0; i != 3; ++i) {
+    ASSERT_EQ(SHMM::get().request_extra_memory_for_resource(message->resource, 60 * 1024 * 1024), i != 2);
+  }
+  SHMM::get().release_shared_message(message);
+  ASSERT_EQ(stats.extra_memory[0].acquire_fails, 1);
+  ASSERT_EQ(stats.extra_memory[6].acquire_fails, 1);
+
+  SHMM::get().rebalance_extra_memory();
+  // 2mb is split into 1mb x 2
+  ASSERT_EQ(stats.extra_memory[0].count, 10);
+  ASSERT_EQ(stats.extra_memory[1].count, 3);
+  // 32mb x 2 are merged into 64mb
+  ASSERT_EQ(stats.extra_memory[5].count, 0);
+  ASSERT_EQ(stats.extra_memory[6].count, 3);
+
+  message = SHMM::get().acquire_shared_message<job_workers::JobSharedMessage>();
+  for (int i = 0; i != 10; ++i) {
+    ASSERT_TRUE(SHMM::get().request_extra_memory_for_resource(message->resource, 800 * 1024));
+  }
+  for (int i = 0; i != 3; ++i) {
+    ASSERT_TRUE(SHMM::get().request_extra_memory_for_resource(message->resource, 60 * 1024 * 1024));
+  }
+  ASSERT_EQ(stats.extra_memory[0].acquire_fails, 1);
+  ASSERT_EQ(stats.extra_memory[6].acquire_fails, 1);
+  SHMM::get().release_shared_message(message);
+
+  // nothing is lacked since the previous rebalance
+  SHMM::get().rebalance_extra_memory();
+  ASSERT_EQ(stats.extra_memory[0].count, 10);
+  ASSERT_EQ(stats.extra_memory[6].count, 3);
+}
+
+TEST(shared_memory_manager_test, test_requests_take_own_results) {
+  // the manager is initialized by the previous test, all its messages are free
+  const int client_id = logname_id;
+  const size_t retries = SHMM::get().get_stats().messages_retries;
+
+  // the results of the finished jobs hold all the messages
+  int results_held = 0;
+  while (auto *result = SHMM::get().acquire_shared_message_for_reply()) {
+    SHMM::get().detach_shared_message_from_this_proc(result);
+    ASSERT_TRUE(SHMM::get().get_job_results_queue(client_id).push(result));
+    ++results_held;
+  }
+  ASSERT_GT(results_held, 0);
+  const size_t acquire_fails = SHMM::get().get_stats().messages.acquire_fails;
+
+  // the request fails at once, it doesn't wait for the job workers
+  ASSERT_EQ(SHMM::get().acquire_shared_message<JobSharedMessage>(), nullptr);
+  ASSERT_EQ(SHMM::get().get_stats().messages.acquire_fails, acquire_fails + 1);
+
+  int results = 0;
+  auto take_results = [&results, client_id] {
+    bool taken = false;
+    while (auto *result = SHMM::get().get_job_results_queue(client_id).pop()) {
+      SHMM::get().attach_shared_message_to_this_proc(result);
+      SHMM::get().release_shared_message(result);
+      ++results;
+      taken = true;
+    }
+    return taken;
+  };
+  auto *job = SHMM::get().acquire_shared_message<JobSharedMessage>(take_results);
+  ASSERT_NE(job, nullptr);
+  ASSERT_EQ(results, results_held);
+  ASSERT_EQ(SHMM::get().get_stats().messages.acquire_fails, acquire_fails + 1);
+  ASSERT_EQ(SHMM::get().get_stats().messages_retries, retries + 1);
+  SHMM::get().release_shared_message(job);
+
+  // nothing to take, so it fails without retries
+  int taken_calls = 0;
+  while (auto *message = SHMM::get().acquire_shared_message<JobSharedMessage>()) {
+    SHMM::get().detach_shared_message_from_this_proc(message);
+    ASSERT_TRUE(SHMM::get().get_job_results_queue(client_id).push(message));
+  }
+  ASSERT_EQ(SHMM::get().acquire_shared_message<JobSharedMessage>([&taken_calls] { return ++taken_calls, false; }), nullptr);
+  ASSERT_EQ(taken_calls, 1);
+  take_results();
 }
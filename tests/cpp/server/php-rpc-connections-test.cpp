@@ -0,0 +1,328 @@
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <thread>
+
+#include "common/crc32.h"
+#include "common/precise-time.h"
+#include "net/net-connections.h"
+#include "net/net-events.h"
+#include "net/net-msg.h"
+#include "net/net-tcp-rpc-common.h"
+#include "runtime/allocator.h"
+#include "server/php-rpc-connections.h"
+#include "server/slot-ids-factory.h"
+
+namespace {
+
+int fake_check_ready(connection *c) {
+  return c->ready;
+}
+
+// the connections of a target are linked in a cycle, which goes through the target itself
+template<size_t N>
+struct FakeTarget {
+  conn_type_t type;
+  conn_target_t target;
+  std::array<connection, N> conns;
+
+  FakeTarget() {
+    memset(&type, 0, sizeof(type));
+    memset(&target, 0, sizeof(target));
+    memset(conns.data(), 0, sizeof(conns));
+    type.check_ready = fake_check_ready;
+    target.type = &type;
+    auto *sentinel = reinterpret_cast<connection *>(&target);
+    target.first_conn = &conns.front();
+    target.last_conn = &conns.back();
+    for (size_t i = 0; i < N; ++i) {
+      connection &c = conns[i];
+      c.next = i + 1 < N ? &conns[i + 1] : sentinel;
+      c.prev = i > 0 ? &conns[i - 1] : sentinel;
+      c.target = &target;
+      c.type = &type;
+      c.generation = static_cast<int>(i) + 1;
+      c.ready = cr_ok;
+      // the rpc queries are written to the output buffer, and there is no event to flush it
+      c.flags = C_RAWMSG | C_INCONN;
+      rwm_init(&c.out, 0);
+      TCP_RPC_DATA(&c)->custom_crc_partial = crc32_partial_generic;
+    }
+  }
+
+  ~FakeTarget() {
+    for (connection &c : conns) {
+      rwm_free(&c.out);
+    }
+  }
+};
+
+// the queries in flight refer to the fake connections, so they are finished before the connections are destroyed
+class RpcConnectionsTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    get_utime_monotonic();
+    rpc_ids_factory.init();
+  }
+
+  void TearDown() override {
+    hedging().on_script_finished();
+    connections_load().on_script_finished();
+    rpc_ids_factory.clear();
+  }
+
+  static RpcConnectionsLoad &connections_load() {
+    return vk::singleton<RpcConnectionsLoad>::get();
+  }
+
+  static RpcQueriesHedging &hedging() {
+    return vk::singleton<RpcQueriesHedging>::get();
+  }
+};
+
+class RpcQueriesHedgingTest : public RpcConnectionsTest {
+protected:
+  static net_queries_data::rpc_send make_query(int timeout_ms) {
+    net_queries_data::rpc_send query;
+    query.request_size = 8 * sizeof(int);
+    query.request = static_cast<char *>(dl::allocate(query.request_size));
+    memset(query.request, 0, query.request_size);
+    query.timeout_ms = timeout_ms;
+    query.hedging = true;
+    return query;
+  }
+
+  // the samples are taken from a repeated period, so the whole ring of the target samples is overwritten
+  // and has the same distribution, whenever the hedging delay is recalculated
+  void add_latency_samples(int period_ms) {
+    for (int i = 0; i < 320; ++i) {
+      ASSERT_TRUE(hedging().on_answer_received(&fake_.conns[0], -1, (i % period_ms + 1) / 1000.0));
+    }
+  }
+
+  slot_id_t send_query(int timeout_ms = 1000) {
+    const slot_id_t slot_id = rpc_ids_factory.create_slot();
+    connections_load().on_query_sent(&fake_.conns[0], slot_id);
+    hedging().on_query_sent(&fake_.target, &fake_.conns[0], slot_id, make_query(timeout_ms));
+    return slot_id;
+  }
+
+  static double next_timer_delay() {
+    return main_thread_reactor.timer_heap[1]->wakeup_time - precise_now;
+  }
+
+  // the reactor takes the monotonic time, so the timers are waited for, the hedging delay is 1ms in these tests
+  static void run_timers() {
+    std::this_thread::sleep_for(std::chrono::milliseconds{5});
+    get_utime_monotonic();
+    net_reactor_run_timers(&main_thread_reactor);
+  }
+
+  FakeTarget<2> fake_;
+};
+
+} // namespace
+
+TEST_F(RpcQueriesHedgingTest, hedging_delay_is_percentile) {
+  hedging().set_budget(0);
+  const int timers = epoll_timer_heap_size();
+
+  // the samples are 1..32 ms, 8 of each
+  hedging().set_percentile(90);
+  add_latency_samples(32);
+  send_query();
+  ASSERT_EQ(epoll_timer_heap_size(), timers + 1);
+  ASSERT_NEAR(next_timer_delay(), 0.029, 1e-6);
+  hedging().on_script_finished();
+  ASSERT_EQ(epoll_timer_heap_size(), timers);
+
+  hedging().set_percentile(50);
+  add_latency_samples(32);
+  send_query();
+  ASSERT_NEAR(next_timer_delay(), 0.017, 1e-6);
+  hedging().on_script_finished();
+
+  // the delay doesn't fit into the query timeout
+  send_query(10);
+  ASSERT_EQ(epoll_timer_heap_size(), timers);
+}
+
+TEST_F(RpcQueriesHedgingTest, token_bucket) {
+  hedging().set_percentile(50);
+  add_latency_samples(1);
+
+  // the tokens are limited by 10
+  hedging().set_budget(100);
+  send_query();
+  hedging().set_budget(0);
+  const uint64_t hedged_queries = hedging().hedged_queries;
+  for (int i = 0; i < 12; ++i) {
+    run_timers();
+    send_query();
+  }
+  run_timers();
+  ASSERT_EQ(hedging().hedged_queries, hedged_queries + 10);
+  ASSERT_GT(fake_.conns[1].out.total_bytes, 0);
+
+  // each sent query gives the budget ratio of a token
+  hedging().set_budget(0.5);
+  send_query();
+  run_timers();
+  ASSERT_EQ(hedging().hedged_queries, hedged_queries + 10);
+  send_query();
+  run_timers();
+  ASSERT_EQ(hedging().hedged_queries, hedged_queries + 11);
+}
+
+TEST_F(RpcQueriesHedgingTest, hedged_copy_goes_to_other_connection) {
+  hedging().set_percentile(50);
+  hedging().set_budget(100);
+  add_latency_samples(1);
+
+  // there is no other ready connection
+  fake_.conns[1].ready = cr_stopped;
+  const uint64_t hedged_queries = hedging().hedged_queries;
+  send_query();
+  run_timers();
+  ASSERT_EQ(hedging().hedged_queries, hedged_queries);
+  ASSERT_EQ(fake_.conns[1].out.total_bytes, 0);
+
+  fake_.conns[1].ready = cr_ok;
+  send_query();
+  run_timers();
+  ASSERT_EQ(hedging().hedged_queries, hedged_queries + 1);
+  ASSERT_EQ(fake_.conns[0].out.total_bytes, 0);
+  ASSERT_GT(fake_.conns[1].out.total_bytes, 0);
+  ASSERT_EQ(fake_.conns[1].rpc_queries_in_flight, 1);
+}
+
+TEST_F(RpcQueriesHedgingTest, losing_answer_is_dropped) {
+  hedging().set_percentile(50);
+  hedging().set_budget(100);
+  add_latency_samples(1);
+  const uint64_t hedged_queries_won = hedging().hedged_queries_won;
+
+  // the hedged copy wins
+  slot_id_t slot_id = send_query();
+  run_timers();
+  ASSERT_TRUE(hedging().on_answer_received(&fake_.conns[1], slot_id, -1));
+  ASSERT_EQ(hedging().hedged_queries_won, hedged_queries_won + 1);
+  ASSERT_FALSE(hedging().on_answer_received(&fake_.conns[0], slot_id, -1));
+  // the query isn't tracked anymore
+  ASSERT_TRUE(hedging().on_answer_received(&fake_.conns[0], slot_id, -1));
+
+  // the original query wins
+  slot_id = send_query();
+  run_timers();
+  ASSERT_TRUE(hedging().on_answer_received(&fake_.conns[0], slot_id, -1));
+  ASSERT_FALSE(hedging().on_answer_received(&fake_.conns[1], slot_id, -1));
+  ASSERT_EQ(hedging().hedged_queries_won, hedged_queries_won + 1);
+
+  // the query answered before the delay isn't hedged
+  const int timers = epoll_timer_heap_size();
+  const uint64_t hedged_queries = hedging().hedged_queries;
+  slot_id = send_query();
+  ASSERT_EQ(epoll_timer_heap_size(), timers + 1);
+  ASSERT_TRUE(hedging().on_answer_received(&fake_.conns[0], slot_id, -1));
+  ASSERT_EQ(epoll_timer_heap_size(), timers);
+  run_timers();
+  ASSERT_EQ(hedging().hedged_queries, hedged_queries);
+}
+
+namespace {
+
+class RpcConnectionsLoadTest : public RpcConnectionsTest {
+protected:
+  void send_query(int conn_idx, int64_t query_id) {
+    connections_load().on_query_sent(&fake_.conns[conn_idx], query_id);
+  }
+
+  double receive_answer(int conn_idx, int64_t query_id) {
+    return connections_load().on_answer_received(&fake_.conns[conn_idx], query_id);
+  }
+
+  connection *choose_connection(const connection *skipped_conn = nullptr) {
+    return connections_load().choose_connection(&fake_.target, skipped_conn);
+  }
+
+  FakeTarget<3> fake_;
+};
+
+} // namespace
+
+TEST_F(RpcConnectionsLoadTest, least_loaded_ready_connection_is_chosen) {
+  ASSERT_EQ(choose_connection(), &fake_.conns[0]);
+
+  send_query(0, 1);
+  send_query(0, 2);
+  send_query(1, 3);
+  ASSERT_EQ(fake_.conns[0].rpc_queries_in_flight, 2);
+  ASSERT_EQ(fake_.conns[1].rpc_queries_in_flight, 1);
+  ASSERT_EQ(choose_connection(), &fake_.conns[2]);
+  ASSERT_EQ(choose_connection(&fake_.conns[2]), &fake_.conns[1]);
+
+  // the stopped connections are chosen only if there are no ready ones, the most reliable of them
+  fake_.conns[2].ready = cr_stopped;
+  ASSERT_EQ(choose_connection(), &fake_.conns[1]);
+  fake_.conns[0].ready = cr_stopped;
+  fake_.conns[1].ready = cr_stopped;
+  fake_.conns[0].unreliability = 30;
+  fake_.conns[1].unreliability = 20;
+  fake_.conns[2].unreliability = 10;
+  ASSERT_EQ(choose_connection(), &fake_.conns[2]);
+  ASSERT_EQ(choose_connection(&fake_.conns[2]), &fake_.conns[1]);
+  fake_.conns[2].ready = cr_failed;
+  ASSERT_EQ(choose_connection(), &fake_.conns[1]);
+}
+
+TEST_F(RpcConnectionsLoadTest, ties_are_broken_by_response_time) {
+  send_query(0, 1);
+  send_query(1, 2);
+  send_query(2, 3);
+  precise_now += 0.1;
+  ASSERT_NEAR(receive_answer(1, 2), 0.1, 1e-9);
+  precise_now += 0.1;
+  ASSERT_NEAR(receive_answer(2, 3), 0.2, 1e-9);
+  precise_now += 0.1;
+  ASSERT_NEAR(receive_answer(0, 1), 0.3, 1e-9);
+  ASSERT_EQ(choose_connection(), &fake_.conns[1]);
+
+  // a busy connection loses to an idle one whatever its response time is
+  send_query(1, 4);
+  ASSERT_EQ(choose_connection(), &fake_.conns[2]);
+
+  // the response time is smoothed
+  precise_now += 1;
+  ASSERT_NEAR(receive_answer(1, 4), 1, 1e-9);
+  ASSERT_NEAR(fake_.conns[1].rpc_avg_response_time, 0.1 + 0.2 * (1 - 0.1), 1e-9);
+  ASSERT_EQ(choose_connection(), &fake_.conns[2]);
+
+  // the answers to the unknown queries and to the other connections aren't counted
+  send_query(2, 5);
+  ASSERT_LT(receive_answer(2, 6), 0);
+  ASSERT_LT(receive_answer(0, 5), 0);
+  ASSERT_EQ(fake_.conns[2].rpc_queries_in_flight, 1);
+}
+
+TEST_F(RpcConnectionsLoadTest, script_finish_releases_queries) {
+  send_query(0, 1);
+  send_query(0, 2);
+  send_query(1, 3);
+  send_query(2, 4);
+  // the connection is closed and the structure is reused by another one
+  ++fake_.conns[2].generation;
+  fake_.conns[2].rpc_queries_in_flight = 0;
+
+  connections_load().on_script_finished();
+  for (const connection &c : fake_.conns) {
+    ASSERT_EQ(c.rpc_queries_in_flight, 0);
+  }
+  ASSERT_LT(receive_answer(0, 1), 0);
+  ASSERT_LT(receive_answer(1, 3), 0);
+  ASSERT_EQ(fake_.conns[0].rpc_queries_in_flight, 0);
+
+  send_query(1, 5);
+  ASSERT_EQ(fake_.conns[1].rpc_queries_in_flight, 1);
+  ASSERT_EQ(choose_connection(), &fake_.conns[0]);
+}
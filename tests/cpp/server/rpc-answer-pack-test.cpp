@@ -0,0 +1,228 @@
+#include <cstring>
+#include <gtest/gtest.h>
+#include <limits>
+#include <string>
+
+#include "common/pid.h"
+#include "common/rpc-headers.h"
+#include "common/tl/constants/common.h"
+#include "common/tl/methods/compression.h"
+#include "common/tl/methods/rwm.h"
+#include "common/tl/methods/string.h"
+#include "common/tl/parse.h"
+#include "common/tl/query-header.h"
+#include "net/net-msg.h"
+#include "runtime/kphp_core.h"
+#include "runtime/rpc.h"
+
+namespace {
+
+namespace flag = vk::tl::common::rpc_req_result_extra_flags;
+
+constexpr uint32_t FUNCTION_MAGIC = 0x12345678;
+
+template<class T>
+void append_raw(std::string &buf, const T &value) {
+  buf.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+void append_tl_string(std::string &buf, const std::string &str) {
+  buf.push_back(static_cast<char>(str.size()));
+  buf.append(str);
+  while (buf.size() % 4) {
+    buf.push_back('\0');
+  }
+}
+
+std::string make_answer(size_t ints_count) {
+  std::string answer;
+  for (size_t i = 0; i < ints_count; ++i) {
+    append_raw(answer, static_cast<int32_t>(i % 16));
+  }
+  return answer;
+}
+
+std::string zstd_pack_answer(const std::string &answer) {
+  string_buffer buffer;
+  buffer.append(answer.data(), answer.size());
+  EXPECT_TRUE(rpc_zstd_pack_answer(buffer, 0));
+  return std::string(buffer.c_str(), buffer.size());
+}
+
+// reqResultHeader with all the fixed size fields and the stats, the compression version goes after the fixed size fields
+std::string make_answer_header(bool with_compression_version) {
+  process_id pid{};
+  pid.ip = 0x7f000001;
+  pid.port = 1234;
+  pid.pid = 4321;
+  pid.utime = 1000000;
+
+  const uint32_t other_flags = flag::binlog_pos | flag::binlog_time | flag::engine_pid | flag::request_size | flag::failed_subqueries | flag::stats;
+  std::string header;
+  append_raw(header, static_cast<int32_t>(TL_REQ_RESULT_HEADER));
+  append_raw(header, static_cast<int32_t>(with_compression_version ? other_flags | flag::compression_version : other_flags));
+  append_raw(header, static_cast<int64_t>(123456789));
+  append_raw(header, static_cast<int64_t>(987654321));
+  append_raw(header, pid);
+  append_raw(header, static_cast<int32_t>(100));
+  append_raw(header, static_cast<int32_t>(200));
+  append_raw(header, static_cast<int32_t>(3));
+  if (with_compression_version) {
+    append_raw(header, static_cast<int32_t>(COMPRESSION_VERSION_ZSTD));
+  }
+  append_raw(header, static_cast<int32_t>(2));
+  append_tl_string(header, "proxy_got_query_ts");
+  append_tl_string(header, "1600000000." + std::string(52, '1'));
+  append_tl_string(header, "got_answer_from_engine_ts");
+  append_tl_string(header, "1600000000." + std::string(52, '2'));
+  return header;
+}
+
+struct unpacked_answer {
+  bool ok{false};
+  std::string header;
+  std::string body;
+};
+
+unpacked_answer unpack_answer(const std::string &packed, int max_unpacked_size = std::numeric_limits<int>::max()) {
+  unpacked_answer result;
+  raw_message_t msg;
+  rwm_create(&msg, packed.data(), static_cast<int>(packed.size()));
+
+  tlio_push();
+  tl_fetch_init_raw_message(&msg);
+  result.ok = tl_fetch_packed_query_answer_header(result.header, max_unpacked_size);
+  if (result.ok) {
+    result.body.resize(tl_fetch_unread());
+    tl_fetch_raw_data(&result.body[0], static_cast<int>(result.body.size()));
+  }
+  tlio_pop();
+  return result;
+}
+
+} // namespace
+
+TEST(rpc_answer_pack_test, extra_headers_announce_compression) {
+  RpcExtraHeaders extra_headers{};
+  ASSERT_EQ(fill_extra_headers_if_needed(extra_headers, FUNCTION_MAGIC, 0, false), 0);
+
+  // the supported_compression_version tail is sent only if the flag is set
+  extra_headers = {};
+  ASSERT_EQ(fill_extra_headers_if_needed(extra_headers, FUNCTION_MAGIC, 0, true, COMPRESSION_VERSION_ZSTD),
+            sizeof(RpcDestFlagsHeaders) - sizeof(int));
+  ASSERT_EQ(extra_headers.rpc_dest_flags.flags, vk::tl::common::rpc_invoke_req_extra_flags::no_result);
+
+  extra_headers = {};
+  ASSERT_EQ(fill_extra_headers_if_needed(extra_headers, FUNCTION_MAGIC, 0, false, COMPRESSION_VERSION_ZSTD), sizeof(RpcDestFlagsHeaders));
+  extra_headers = {};
+  ASSERT_EQ(fill_extra_headers_if_needed(extra_headers, FUNCTION_MAGIC, 5, true, COMPRESSION_VERSION_ZSTD),
+            sizeof(RpcDestActorFlagsHeaders) - sizeof(int));
+
+  extra_headers = {};
+  const size_t extra_headers_size = fill_extra_headers_if_needed(extra_headers, FUNCTION_MAGIC, 5, false, COMPRESSION_VERSION_ZSTD);
+  ASSERT_EQ(extra_headers_size, sizeof(RpcDestActorFlagsHeaders));
+
+  std::string query;
+  append_raw(query, static_cast<int32_t>(TL_RPC_INVOKE_REQ));
+  append_raw(query, static_cast<int64_t>(42));
+  query.append(reinterpret_cast<const char *>(&extra_headers), extra_headers_size);
+  append_raw(query, FUNCTION_MAGIC);
+
+  tl_query_header_t header{};
+  bool fetched = false;
+  vk::tl::load_from_buffer(query.data(), static_cast<int>(query.size()), [&] { fetched = tl_fetch_query_header(&header); });
+  ASSERT_TRUE(fetched);
+  ASSERT_EQ(header.qid, 42);
+  ASSERT_EQ(header.actor_id, 5);
+  ASSERT_EQ(header.flags, vk::tl::common::rpc_invoke_req_extra_flags::supported_compression_version);
+  ASSERT_EQ(header.supported_compression_version, COMPRESSION_VERSION_ZSTD);
+}
+
+TEST(rpc_answer_pack_test, small_answer_is_not_packed) {
+  string_buffer buffer;
+  const std::string answer = make_answer(2);
+  buffer.append(answer.data(), answer.size());
+  ASSERT_FALSE(rpc_zstd_pack_answer(buffer, 0));
+  ASSERT_EQ(std::string(buffer.c_str(), buffer.size()), answer);
+}
+
+TEST(rpc_answer_pack_test, pack_and_unpack_without_other_flags) {
+  const std::string answer = make_answer(4096);
+  const std::string packed = zstd_pack_answer(answer);
+  ASSERT_LT(packed.size(), answer.size());
+
+  const unpacked_answer unpacked = unpack_answer(packed);
+  ASSERT_TRUE(unpacked.ok);
+  ASSERT_TRUE(unpacked.header.empty());
+  ASSERT_EQ(unpacked.body, answer);
+}
+
+TEST(rpc_answer_pack_test, pack_and_unpack_with_other_flags) {
+  const std::string answer = make_answer(4096);
+  // the packer stores the header with the compression version only, the other fields are added in front of it
+  const std::string packed = zstd_pack_answer(answer);
+  const std::string packed_rest = packed.substr(3 * sizeof(int));
+  const std::string header = make_answer_header(true);
+  ASSERT_GT(header.size(), 200);
+
+  const unpacked_answer unpacked = unpack_answer(header + packed_rest);
+  ASSERT_TRUE(unpacked.ok);
+  ASSERT_EQ(unpacked.header, make_answer_header(false));
+  ASSERT_EQ(unpacked.body, answer);
+
+  tl_query_answer_header_t unpacked_header{};
+  int fetched = -1;
+  vk::tl::load_from_buffer(unpacked.header.data(), static_cast<int>(unpacked.header.size()), [&] {
+    tl_fetch_int();
+    fetched = tl_fetch_query_answer_flags(&unpacked_header);
+  });
+  ASSERT_EQ(fetched, 0);
+  ASSERT_EQ(unpacked_header.flags & flag::compression_version, 0);
+  ASSERT_EQ(unpacked_header.binlog_pos, 123456789);
+  ASSERT_EQ(unpacked_header.failed_subqueries, 3);
+  ASSERT_EQ(unpacked_header.PID.pid, 4321);
+}
+
+TEST(rpc_answer_pack_test, unpacked_answer_is_rejected) {
+  std::string answer;
+  append_raw(answer, static_cast<int32_t>(TL_REQ_RESULT_HEADER));
+  append_raw(answer, static_cast<int32_t>(flag::binlog_pos));
+  append_raw(answer, static_cast<int64_t>(1));
+  answer += make_answer(16);
+
+  const unpacked_answer unpacked = unpack_answer(answer);
+  ASSERT_FALSE(unpacked.ok);
+}
+
+TEST(rpc_answer_pack_test, corrupted_answer_is_rejected) {
+  const std::string answer = make_answer(4096);
+  const std::string packed = zstd_pack_answer(answer);
+  // the header with the compression version is followed by the packed length and the zstd frame
+  const size_t frame_offset = 4 * sizeof(int);
+
+  std::string bad_magic = packed;
+  bad_magic[frame_offset] ^= 0x55;
+  ASSERT_FALSE(unpack_answer(bad_magic).ok);
+
+  std::string truncated = packed;
+  int32_t packed_len = 0;
+  memcpy(&packed_len, &truncated[frame_offset - sizeof(int)], sizeof(packed_len));
+  packed_len /= 2;
+  memcpy(&truncated[frame_offset - sizeof(int)], &packed_len, sizeof(packed_len));
+  ASSERT_FALSE(unpack_answer(truncated).ok);
+
+  std::string bad_len = packed;
+  packed_len = static_cast<int32_t>(packed.size());
+  memcpy(&bad_len[frame_offset - sizeof(int)], &packed_len, sizeof(packed_len));
+  ASSERT_FALSE(unpack_answer(bad_len).ok);
+}
+
+TEST(rpc_answer_pack_test, too_large_answer_is_rejected) {
+  const std::string answer = make_answer(4096);
+  const std::string packed = zstd_pack_answer(answer);
+  ASSERT_FALSE(unpack_answer(packed, static_cast<int>(answer.size()) - 4).ok);
+
+  const unpacked_answer unpacked = unpack_answer(packed, static_cast<int>(answer.size()));
+  ASSERT_TRUE(unpacked.ok);
+  ASSERT_EQ(unpacked.body, answer);
+}
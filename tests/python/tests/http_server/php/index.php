@@ -220,6 +220,8 @@ if (isset($_SERVER["JOB_ID"])) {
   critical_error("Test error");
 } else if ($_SERVER["PHP_SELF"] === "/test_oom_handler") {
   require_once "test_oom_handler.php";
+} else if ($_SERVER["PHP_SELF"] === "/test_globals_reset") {
+  require_once "test_globals_reset.php";
 } else {
     if ($_GET["hints"] === "yes") {
         send_http_103_early_hints(["Content-Type: text/plain or application/json", "Link: </script.js>; rel=preload; as=script"]);
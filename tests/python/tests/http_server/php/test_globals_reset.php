@@ -0,0 +1,24 @@
+<?php
+
+class GlobalsResetCounter {
+  public static $calls = 0;
+}
+
+function touch_globals() {
+  global $touched_global;
+  static $static_calls = 0;
+  $touched_global[] = 1;
+  ++GlobalsResetCounter::$calls;
+  return ++$static_calls;
+}
+
+function read_globals() {
+  global $touched_global;
+  return ["global" => count($touched_global), "class_static" => GlobalsResetCounter::$calls];
+}
+
+if ($_GET["type"] === "touch") {
+  echo json_encode(["static" => touch_globals()] + read_globals());
+} else {
+  echo json_encode(read_globals());
+}
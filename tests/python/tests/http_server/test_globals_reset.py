@@ -0,0 +1,18 @@
+from python.lib.testcase import KphpServerAutoTestCase
+
+
+class TestGlobalsReset(KphpServerAutoTestCase):
+    def _request(self, request_type):
+        resp = self.kphp_server.http_get("/test_globals_reset?type=" + request_type)
+        self.assertEqual(resp.status_code, 200)
+        return resp.json()
+
+    def test_touched_globals_are_reset(self):
+        for _ in range(3):
+            self.assertEqual(self._request("touch"), {"static": 1, "global": 1, "class_static": 1})
+
+    def test_untouched_globals_keep_initial_values(self):
+        self._request("touch")
+        for _ in range(3):
+            self.assertEqual(self._request("read"), {"global": 0, "class_static": 0})
+        self.assertEqual(self._request("touch"), {"static": 1, "global": 1, "class_static": 1})
@@ -0,0 +1,55 @@
+import signal
+import time
+
+import psutil
+
+from python.lib.testcase import KphpServerAutoTestCase
+
+
+class TestZygote(KphpServerAutoTestCase):
+    @classmethod
+    def extra_class_setup(cls):
+        cls.kphp_server.ignore_log_errors()
+        cls.kphp_server.update_options({
+            "--workers-num": 1,
+            "--zygote": True,
+        })
+
+    def _get_worker_pid(self):
+        resp = self.kphp_server.http_get("/pid")
+        self.assertEqual(resp.status_code, 200)
+        self.assertTrue(resp.text.startswith("pid="))
+        return int(resp.text[4:])
+
+    def _get_zygote(self, worker_pid):
+        children = [child for child in self.kphp_server.get_workers() if child.pid != worker_pid]
+        self.assertEqual(len(children), 1)
+        return children[0]
+
+    def test_respawned_worker_serves_requests(self):
+        old_worker_pid = self._get_worker_pid()
+        zygote = self._get_zygote(old_worker_pid)
+        # the zygote doesn't hold the master connections
+        master_ports = {conn.laddr.port for conn in psutil.Process(self.kphp_server.pid).connections() if conn.laddr}
+        self.assertIn(self.kphp_server.master_port, master_ports)
+        self.assertNotIn(self.kphp_server.master_port, {conn.laddr.port for conn in zygote.connections() if conn.laddr})
+
+        psutil.Process(old_worker_pid).send_signal(signal.SIGKILL)
+
+        start = time.time()
+        while True:
+            try:
+                new_worker_pid = self._get_worker_pid()
+                if new_worker_pid != old_worker_pid:
+                    break
+            except Exception:
+                pass
+            self.assertLess(time.time() - start, 10, "the worker isn't respawned")
+            time.sleep(0.1)
+
+        # the new worker is forked from the same zygote and reparented to the master
+        self.assertEqual(psutil.Process(new_worker_pid).ppid(), self.kphp_server.pid)
+        self.assertEqual(self._get_zygote(new_worker_pid).pid, zygote.pid)
+        resp = self.kphp_server.http_get("/")
+        self.assertEqual(resp.status_code, 200)
+        self.assertEqual(resp.text, "Hello world!")
@@ -34,5 +34,7 @@ class TestMessagesReferences(KphpServerAutoTestCase):
                 "pipe_errors_server_read": 0,
                 "pipe_errors_client_write": 0,
                 "pipe_errors_client_read": 0,
+                "queue_full_jobs": 0,
+                "queue_full_job_results": 0,
             })
         self.assertKphpNoTerminatedRequests()
@@ -23,3 +23,28 @@ if(KPHP_TESTS)
     include(tests/cpp/runtime/runtime-tests.cmake)
     include(tests/cpp/server/server-tests.cmake)
 endif()
+
+if(KPHP_BENCHMARKS)
+    function(vk_add_benchmark BENCHMARK_NAME SRC_LIBS)
+        set(BENCHMARK_NAME ${BENCHMARK_NAME}-benchmarks)
+        add_executable(${BENCHMARK_NAME} ${ARGN})
+        target_link_libraries(${BENCHMARK_NAME} PRIVATE benchmark::benchmark ${SRC_LIBS} vk::popular_common)
+        if(NOT CMAKE_SYSTEM_PROCESSOR STREQUAL "x86_64" AND APPLE)
+            target_link_libraries(${BENCHMARK_NAME} PRIVATE /opt/homebrew/lib/libucontext.a)
+        endif()
+        target_link_options(${BENCHMARK_NAME} PRIVATE ${NO_PIE})
+        set_target_properties(${BENCHMARK_NAME} PROPERTIES FOLDER benchmarks)
+
+        # the results are written in json, so they can be compared between releases
+        add_custom_target(run-${BENCHMARK_NAME}
+                          COMMAND ${BENCHMARK_NAME} --benchmark_out=${CMAKE_BINARY_DIR}/${BENCHMARK_NAME}.json --benchmark_out_format=json
+                          DEPENDS ${BENCHMARK_NAME}
+                          USES_TERMINAL)
+    endfunction()
+
+    if(APPLE AND NOT KPHP_TESTS)
+        add_link_options(-undefined dynamic_lookup)
+    endif()
+
+    include(tests/cpp/runtime-benchmarks/runtime-benchmarks.cmake)
+endif()
@@ -3239,6 +3239,7 @@ void php_new_rpc_connection(INTERNAL_FUNCTION_PARAMETERS) {  /* {{{ */
   ADD_CNT (parse);
   START_TIMER (parse);
   VK_ZVAL_API_ARRAY z[6];
+  // the 7th argument $hedging is ignored, the queries aren't hedged here
   int argc = ZEND_NUM_ARGS ();
   if (zend_get_parameters_array_ex (argc > 6 ? 6 : argc < 2 ? 2 : argc, z) == FAILURE) {
     END_TIMER (parse);
@@ -49,7 +49,7 @@ function vk_whitespace_pack(string $text, int $html_opt = 0) : string {
  * @param mixed $reconnect_timeout
  * @return int|null
  */
-function new_rpc_connection($host_name, $port, $default_actor_id = 0, $timeout = 0.3, $connect_timeout = 0.3, $reconnect_timeout = 17.0) {
+function new_rpc_connection($host_name, $port, $default_actor_id = 0, $timeout = 0.3, $connect_timeout = 0.3, $reconnect_timeout = 17.0, $hedging = false) {
   return 0;
 }
 
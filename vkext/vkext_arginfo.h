@@ -1,5 +1,5 @@
 /* This is a generated file, edit the .stub.php file instead.
- * Stub hash: 483315f5e4ee09b477d536fe066baf385afd6afb */
+ * Stub hash: 37bff45f66d61892b327610b414d60d48f120181 */
 
 ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_vk_hello_world, 0, 0, IS_STRING, 0)
 ZEND_END_ARG_INFO()
@@ -43,6 +43,7 @@ ZEND_BEGIN_ARG_INFO_EX(arginfo_new_rpc_connection, 0, 0, 2)
 	ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, timeout, "0.3")
 	ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, connect_timeout, "0.3")
 	ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, reconnect_timeout, "17.0")
+	ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, hedging, "false")
 ZEND_END_ARG_INFO()
 
 ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_rpc_clean, 0, 0, IS_VOID, 0)
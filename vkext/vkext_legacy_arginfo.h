@@ -1,5 +1,5 @@
 /* This is a generated file, edit the .stub.php file instead.
- * Stub hash: 483315f5e4ee09b477d536fe066baf385afd6afb */
+ * Stub hash: 37bff45f66d61892b327610b414d60d48f120181 */
 
 ZEND_BEGIN_ARG_INFO_EX(arginfo_vk_hello_world, 0, 0, 0)
 ZEND_END_ARG_INFO()
@@ -43,6 +43,7 @@ ZEND_BEGIN_ARG_INFO_EX(arginfo_new_rpc_connection, 0, 0, 2)
 	ZEND_ARG_INFO(0, timeout)
 	ZEND_ARG_INFO(0, connect_timeout)
 	ZEND_ARG_INFO(0, reconnect_timeout)
+	ZEND_ARG_INFO(0, hedging)
 ZEND_END_ARG_INFO()
 
 #define arginfo_rpc_clean arginfo_vk_hello_world